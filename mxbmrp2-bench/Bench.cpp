@@ -0,0 +1,79 @@
+
+// Bench.cpp
+
+#include "pch.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Bench.h"
+
+volatile uint64_t Bench::sink_ = 0;
+
+namespace {
+    // Nearest-rank percentile of sorted samples
+    double percentile(const std::vector<double>& sorted, double p) {
+        const size_t rank = static_cast<size_t>(std::ceil(p * static_cast<double>(sorted.size())));
+        return sorted[std::min<size_t>(sorted.size() - 1, rank > 0 ? rank - 1 : 0)];
+    }
+
+    std::string formatNanos(double ns) {
+        char buf[32];
+        if (ns >= 1e6) std::snprintf(buf, sizeof(buf), "%.2f ms", ns / 1e6);
+        else if (ns >= 1e3) std::snprintf(buf, sizeof(buf), "%.2f us", ns / 1e3);
+        else std::snprintf(buf, sizeof(buf), "%.1f ns", ns);
+        return buf;
+    }
+
+    // Names and params are ours, only quotes and backslashes can appear
+    std::string quoted(const std::string& s) {
+        std::string out = "\"";
+        for (char c : s) {
+            if (c == '"' || c == '\\') out += '\\';
+            out += c;
+        }
+        return out + '"';
+    }
+}
+
+Bench::Bench(const Options& options)
+    : options_(options) {
+}
+
+bool Bench::matches(const std::string& name, const std::string& params) const {
+    if (options_.filter.empty()) return true;
+    return (name + "/" + params).find(options_.filter) != std::string::npos;
+}
+
+void Bench::finish(BenchResult result, std::vector<double>& samples) {
+    std::sort(samples.begin(), samples.end());
+    result.p50Ns = percentile(samples, 0.50);
+    result.p99Ns = percentile(samples, 0.99);
+    result.minNs = samples.front();
+
+    print(result);
+    results_.push_back(std::move(result));
+}
+
+void Bench::print(const BenchResult& r) {
+    if (options_.json) {
+        std::printf("{\"name\":%s,\"params\":%s,\"seed\":%u,\"iterations\":%llu,\"batches\":%llu,"
+            "\"ns_per_op_p50\":%.1f,\"ns_per_op_p99\":%.1f,\"ns_per_op_min\":%.1f,"
+            "\"allocs_per_op\":%.2f,\"bytes_per_op\":%.1f}\n",
+            quoted(r.name).c_str(), quoted(r.params).c_str(), options_.seed,
+            static_cast<unsigned long long>(r.iterations), static_cast<unsigned long long>(r.batches),
+            r.p50Ns, r.p99Ns, r.minNs, r.allocationsPerOp, r.bytesPerOp);
+    }
+    else {
+        if (!headerPrinted_) {
+            std::printf("%-30s %-22s %12s %12s %12s %12s %10s %12s\n",
+                "Benchmark", "Params", "iterations", "p50/op", "p99/op", "min/op", "allocs/op", "bytes/op");
+            headerPrinted_ = true;
+        }
+        std::printf("%-30s %-22s %12llu %12s %12s %12s %10.2f %12.1f\n",
+            r.name.c_str(), r.params.c_str(), static_cast<unsigned long long>(r.iterations),
+            formatNanos(r.p50Ns).c_str(), formatNanos(r.p99Ns).c_str(), formatNanos(r.minNs).c_str(),
+            r.allocationsPerOp, r.bytesPerOp);
+    }
+    std::fflush(stdout);
+}
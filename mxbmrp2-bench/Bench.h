@@ -0,0 +1,138 @@
+
+// Bench.h
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "AllocationCounter.h"
+
+// One benchmark's numbers. Timings are per operation, taken from batches
+// sized to run for at least Bench::BATCH_TIME each.
+struct BenchResult {
+    std::string name;
+    std::string params;             // input size, e.g. "combos=1000"
+    uint64_t iterations = 0;
+    uint64_t batches = 0;
+    double p50Ns = 0;
+    double p99Ns = 0;
+    double minNs = 0;
+    double allocationsPerOp = 0;
+    double bytesPerOp = 0;
+};
+
+// Runs benchmarks one after the other and prints each result as it comes,
+// as a table or as one JSON object per line.
+class Bench {
+public:
+    struct Options {
+        std::string filter;                                 // substring of "name/params", empty runs all
+        std::chrono::milliseconds minTime{ 300 };           // per benchmark, batches included
+        bool json = false;
+        uint32_t seed = 1;
+    };
+
+    explicit Bench(const Options& options);
+
+    // Time `op` and report it. The op must be repeatable; what it returns
+    // (a number, pointer or anything with size()) is consumed so the work
+    // isn't optimized away.
+    template <typename Op>
+    void run(const std::string& name, const std::string& params, Op&& op);
+
+    const std::vector<BenchResult>& results() const { return results_; }
+
+    static constexpr auto BATCH_TIME = std::chrono::microseconds(500);
+    static constexpr size_t MIN_BATCHES = 5;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    template <typename Op>
+    static int64_t timeBatch(Op& op, uint64_t ops);
+
+    template <typename T>
+    static void keep(const T& value);
+
+    bool matches(const std::string& name, const std::string& params) const;
+    void finish(BenchResult result, std::vector<double>& samples);
+    void print(const BenchResult& result);
+
+    Options options_;
+    std::vector<BenchResult> results_;
+    bool headerPrinted_ = false;
+
+    static volatile uint64_t sink_;
+};
+
+template <typename T>
+void Bench::keep(const T& value) {
+    if constexpr (std::is_arithmetic_v<T>) {
+        sink_ = sink_ + static_cast<uint64_t>(value);
+    }
+    else if constexpr (std::is_pointer_v<T>) {
+        sink_ = sink_ + reinterpret_cast<uintptr_t>(value);
+    }
+    else {
+        sink_ = sink_ + static_cast<uint64_t>(value.size());
+    }
+}
+
+template <typename Op>
+int64_t Bench::timeBatch(Op& op, uint64_t ops) {
+    const auto start = Clock::now();
+    for (uint64_t i = 0; i < ops; ++i) {
+        if constexpr (std::is_void_v<decltype(op())>) {
+            op();
+        }
+        else {
+            keep(op());
+        }
+    }
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+}
+
+template <typename Op>
+void Bench::run(const std::string& name, const std::string& params, Op&& op) {
+    if (!matches(name, params)) return;
+
+    // Warm up, then grow the batch until it is long enough to time
+    uint64_t batchOps = 1;
+    int64_t batchNs = timeBatch(op, batchOps);
+    const int64_t targetNs = std::chrono::duration_cast<std::chrono::nanoseconds>(BATCH_TIME).count();
+    while (batchNs < targetNs && batchOps < (uint64_t(1) << 30)) {
+        batchOps *= 2;
+        batchNs = timeBatch(op, batchOps);
+    }
+
+    BenchResult result;
+    result.name = name;
+    result.params = params;
+
+    std::vector<double> samples;
+    const int64_t minNs = std::chrono::duration_cast<std::chrono::nanoseconds>(options_.minTime).count();
+    int64_t elapsedNs = 0;
+    AllocationCounter::Totals allocations;
+    while (samples.size() < MIN_BATCHES || elapsedNs < minNs) {
+        const auto before = AllocationCounter::totals();
+        const int64_t ns = timeBatch(op, batchOps);
+        const auto used = AllocationCounter::totals() - before;
+
+        samples.push_back(static_cast<double>(ns) / static_cast<double>(batchOps));
+        allocations.allocations += used.allocations;
+        allocations.bytes += used.bytes;
+        elapsedNs += ns;
+        result.iterations += batchOps;
+    }
+
+    result.batches = samples.size();
+    result.allocationsPerOp = static_cast<double>(allocations.allocations) / static_cast<double>(result.iterations);
+    result.bytesPerOp = static_cast<double>(allocations.bytes) / static_cast<double>(result.iterations);
+    finish(std::move(result), samples);
+}
@@ -0,0 +1,126 @@
+
+// BenchHost.cpp
+
+#include "pch.h"
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+
+#include "BenchHost.h"
+#include "MemReader.h"
+#include "KeyPressHandler.h"
+#include "Tracer.h"
+
+namespace {
+    std::mutex regionsMutex;
+    std::vector<MemoryRegion> syntheticRegions;    // sorted by base
+
+    // What VirtualQuery would report if the synthetic regions were all there was
+    class SyntheticRegionSource : public RegionSource {
+    public:
+        uintptr_t minAddress() const override { return 0; }
+        uintptr_t maxAddress() const override { return UINTPTR_MAX; }
+
+        void enumerate(uintptr_t begin, uintptr_t end, std::vector<MemoryRegion>& out) override {
+            std::lock_guard<std::mutex> lk(regionsMutex);
+            for (const auto& region : syntheticRegions) {
+                if (region.base >= begin && region.base < end) {
+                    out.push_back({ region.base, region.size, 0 });
+                }
+            }
+        }
+    };
+
+    bool isSynthetic(uintptr_t address, size_t size) {
+        std::lock_guard<std::mutex> lk(regionsMutex);
+        return std::any_of(syntheticRegions.begin(), syntheticRegions.end(), [&](const MemoryRegion& r) {
+            return address >= r.base && size <= r.size && address - r.base <= r.size - size;
+        });
+    }
+}
+
+namespace BenchHost {
+
+    void setSyntheticRegions(std::vector<MemoryRegion> regions) {
+        std::sort(regions.begin(), regions.end(),
+            [](const MemoryRegion& a, const MemoryRegion& b) { return a.base < b.base; });
+        std::lock_guard<std::mutex> lk(regionsMutex);
+        syntheticRegions = std::move(regions);
+    }
+
+} // namespace BenchHost
+
+// MemReader: synthetic memory only
+
+MemReader& MemReader::getInstance() {
+    static MemReader instance;
+    return instance;
+}
+
+MemReader::MemReader()
+    : baseAddress_(0),
+      regionMap_(std::make_unique<SyntheticRegionSource>()) {}
+
+MemReader::~MemReader() = default;
+
+void MemReader::initialize(const std::filesystem::path&, const std::filesystem::path&) {}
+
+void MemReader::shutdown() {}
+
+std::optional<unsigned long> MemReader::getOffset(MemoryOffset) const {
+    return std::nullopt;
+}
+
+void MemReader::refreshOffsets() {}
+
+bool MemReader::isMemoryAvailable() {
+    return false;
+}
+
+// The copy MemReader.cpp makes, without the fault handler
+bool MemReader::readInto(bool relative, uintptr_t offset, void* dst, size_t size, const char*) {
+    if (relative || !isSynthetic(offset, size)) return false;
+    std::memcpy(dst, reinterpret_cast<const void*>(offset), size);
+    return true;
+}
+
+std::optional<MemoryRegion> MemReader::findRegion(uintptr_t address) {
+    auto map = regionMap_.snapshot();
+    auto it = std::upper_bound(map->regions.begin(), map->regions.end(), address,
+        [](uintptr_t a, const MemoryRegion& r) { return a < r.base; });
+    if (it == map->regions.begin()) return std::nullopt;
+    --it;
+    if (address >= it->end()) return std::nullopt;
+    return *it;
+}
+
+std::unique_ptr<MemoryScan> MemReader::beginSearch(
+    const std::vector<uint8_t>& pattern,
+    size_t readOffset,
+    size_t readSize,
+    const char* callerName
+) {
+    return std::make_unique<MemoryScan>(*this, regionMap_, pattern, readOffset, readSize, callerName);
+}
+
+// Same as MemReader.cpp, so the bench times the real scan
+std::tuple<uintptr_t, std::string> MemReader::searchMemoryRaw(
+    const std::vector<uint8_t>& pattern,
+    size_t readOffset,
+    size_t readSize,
+    const char* callerName,
+    const std::atomic<bool>* cancel
+) {
+    TRACE_SCOPE("memory", "searchMemoryRaw");
+    MemoryScan scan(*this, regionMap_, pattern, readOffset, readSize, callerName);
+    scan.step(std::chrono::microseconds::zero(), cancel);
+    return scan.result();
+}
+
+// KeyPressHandler: nobody to press the hotkey
+
+KeyPressHandler::KeyPressHandler(HotkeyCallback callback, UINT hotkey)
+    : callback_(std::move(callback)), hotkey_(hotkey) {}
+
+KeyPressHandler::~KeyPressHandler() = default;
@@ -0,0 +1,20 @@
+
+// BenchHost.h
+
+#pragma once
+
+#include <vector>
+
+#include "RegionMap.h"
+
+// The bench links BenchHost.cpp instead of MemReader.cpp and
+// KeyPressHandler.cpp. Its MemReader has no game to read: offsets are
+// unknown, and absolute reads and searches only see the synthetic regions
+// handed to it here, so scan benchmarks run over fixed inputs.
+namespace BenchHost {
+
+    // Memory MemReader may read and search, owned by the caller. Set it
+    // before the first search; the region map is built on first use.
+    void setSyntheticRegions(std::vector<MemoryRegion> regions);
+
+} // namespace BenchHost
@@ -0,0 +1,372 @@
+
+// main.cpp
+//
+// mxbmrp2-bench: times the plugin's hot functions on fixed, seeded inputs,
+// so releases can be compared. Example runs:
+//
+//   mxbmrp2-bench                          everything, as a table
+//   mxbmrp2-bench --json > bench.jsonl     one JSON object per benchmark
+//   mxbmrp2-bench --filter TimeTracker     only names/params containing it
+
+#include "pch.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "Arena.h"
+#include "Bench.h"
+#include "BenchHost.h"
+#include "MXB_interface.h"
+#include "Plugin.h"
+#include "PluginHelpers.h"
+#include "ConfigManager.h"
+#include "JSONWriter.h"
+#include "htmlWriter.h"
+#include "ServerRoster.h"
+#include "MemReader.h"
+#include "timeTracker.h"
+#include "Constants.h"
+#include "Telemetry.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+    // xorshift32, so every run sees the same inputs for a seed
+    class Rng {
+    public:
+        explicit Rng(uint32_t seed) : state_(seed ? seed : 1) {}
+
+        uint32_t next() {
+            state_ ^= state_ << 13;
+            state_ ^= state_ >> 17;
+            state_ ^= state_ << 5;
+            return state_;
+        }
+
+        int between(int lo, int hi) {
+            return lo + static_cast<int>(next() % static_cast<uint32_t>(hi - lo + 1));
+        }
+
+    private:
+        uint32_t state_;
+    };
+
+    std::string randomText(Rng& rng, int minLength, int maxLength) {
+        static constexpr char CHARS[] =
+            "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789 -_.:";
+        std::string s(static_cast<size_t>(rng.between(minLength, maxLength)), ' ');
+        for (char& c : s) c = CHARS[rng.next() % (sizeof(CHARS) - 1)];
+        return s;
+    }
+
+    // Every display key filled in, the way a busy online session looks
+    std::unordered_map<std::string, std::string> makeDataKeys(Rng& rng) {
+        std::unordered_map<std::string, std::string> keys;
+        for (const auto& [key, displayName] : Plugin::configKeyToDisplayNameMap) {
+            keys[key] = randomText(rng, 4, 32);
+        }
+        keys["race_number"] = std::to_string(rng.between(1, 999));
+        return keys;
+    }
+
+    std::vector<ServerRoster::Entry> makeRoster(Rng& rng, int riders) {
+        std::vector<ServerRoster::Entry> roster;
+        for (int slot = 0; slot < riders; ++slot) {
+            roster.push_back({ slot, randomText(rng, 3, 24) });
+        }
+        return roster;
+    }
+
+    void benchDisplayAndExports(Bench& bench, ConfigManager& config, Rng& rng) {
+        const auto dataKeys = makeDataKeys(rng);
+        const auto& order = Plugin::configKeyToDisplayNameMap;
+        const std::string keys = "keys=" + std::to_string(order.size());
+
+        // The lines are reused from one call to the next, as publishDisplay reuses them
+        std::vector<PluginHelpers::DisplayLine> lines;
+        bench.run("buildDisplayStrings", keys, [&] {
+            PluginHelpers::buildDisplayStrings(dataKeys, order, config, lines);
+            return lines.size();
+        });
+
+        // Names from the game are mostly plain; a few carry quotes or control bytes
+        std::string plain = randomText(rng, 256, 256);
+        std::string escapes = plain;
+        for (size_t i = 0; i < escapes.size(); i += 8) {
+            static constexpr char SPECIAL[] = { '"', '\\', '\n', '\t', '\x01' };
+            escapes[i] = SPECIAL[rng.next() % sizeof(SPECIAL)];
+        }
+        bench.run("escapeJson", "bytes=256 plain", [&] { return JsonWriter::escapeJson(plain); });
+        bench.run("escapeJson", "bytes=256 escapes", [&] { return JsonWriter::escapeJson(escapes); });
+
+        // Rendered in an Arena scope, as the periodic tick does
+        const std::pmr::unordered_map<std::string_view, std::string_view> dataKeyViews(dataKeys.begin(), dataKeys.end());
+        for (int riders : { 0, 50 }) {
+            const auto entries = makeRoster(rng, riders);
+            ServerRoster::View roster;
+            for (const auto& entry : entries) {
+                roster.push_back({ entry.slot, entry.name });
+            }
+            const std::string params = keys + " roster=" + std::to_string(riders);
+            bench.run("renderJson", params, [&] {
+                ArenaScope arena;
+                return JsonWriter::renderJson(dataKeyViews, order, config, roster).size();
+            });
+            bench.run("renderHtml", params, [&] {
+                ArenaScope arena;
+                return HtmlWriter::renderHtml(dataKeyViews, order, config, roster).size();
+            });
+        }
+    }
+
+    void benchConfig(Bench& bench, ConfigManager& config, const fs::path& configPath) {
+        bench.run("ConfigManager::loadConfig", "defaults", [&] { config.loadConfig(configPath); });
+        bench.run("ConfigManager::getValue", "bool", [&] { return config.getValue<bool>("server_ping"); });
+        bench.run("ConfigManager::getValue", "float", [&] { return config.getValue<float>("font_size"); });
+        bench.run("ConfigManager::getValue", "ulong", [&] { return config.getValue<unsigned long>("font_color"); });
+        bench.run("ConfigManager::getValue", "string", [&] { return config.getValue<std::string>("font_name"); });
+    }
+
+    void benchTimeTracker(Bench& bench, const fs::path& dir, Rng& rng) {
+        TimeTracker& tracker = TimeTracker::getInstance();
+
+        // initialize() only clears what a file replaces, so every size starts
+        // from a saved file with no combos in it
+        const fs::path empty = dir / "times-empty.dat";
+        fs::remove(empty);
+        tracker.initialize(empty);
+        tracker.save();
+
+        for (int combos : { 10, 1000, 100000 }) {
+            const fs::path path = dir / ("times-" + std::to_string(combos) + ".dat");
+            fs::copy_file(empty, path, fs::copy_options::overwrite_existing);
+            tracker.initialize(path);
+
+            for (int i = 0; i < combos; ++i) {
+                const std::string track = "track_" + std::to_string(i % 97);
+                const std::string bike = "bike_" + std::to_string(i);
+                const int lapMs = rng.between(60000, 120000);
+                tracker.startRun(track, bike, "MX1", "Setup " + std::to_string(i % 7));
+                tracker.recordLap(track, bike, lapMs, { lapMs / 3, lapMs * 2 / 3 });
+                tracker.endRun(track, bike);
+            }
+
+            const std::string params = "combos=" + std::to_string(combos);
+            bench.run("TimeTracker::save", params, [&] { tracker.save(); });
+            bench.run("TimeTracker::load", params, [&] { tracker.initialize(path); });
+
+            if (combos == 1000) {
+                tracker.startRun("track_0", "bike_0", "MX1", "Setup 0");
+                const std::vector<int> splits = { 20000, 40000 };
+                bench.run("TimeTracker::recordLap", params, [&] {
+                    tracker.recordLap("track_0", "bike_0", rng.between(59000, 61000), splits);
+                });
+                tracker.endRun("track_0", "bike_0");
+            }
+        }
+    }
+
+    void benchMemorySearch(Bench& bench, Rng& rng) {
+        constexpr size_t REGIONS = 16;
+        constexpr size_t REGION_SIZE = 4 * 1024 * 1024;
+        constexpr size_t READ_OFFSET = 32;
+        constexpr size_t READ_SIZE = 64;
+
+        // Noise, with one match and the name it points at at the very end
+        std::vector<std::vector<uint8_t>> buffers(REGIONS, std::vector<uint8_t>(REGION_SIZE));
+        std::vector<MemoryRegion> regions;
+        for (auto& buffer : buffers) {
+            for (auto& b : buffer) b = static_cast<uint8_t>(rng.next());
+            regions.push_back({ reinterpret_cast<uintptr_t>(buffer.data()), buffer.size(), 0 });
+        }
+        BenchHost::setSyntheticRegions(regions);
+
+        std::vector<uint8_t> pattern(16);
+        for (auto& b : pattern) b = static_cast<uint8_t>(rng.next());
+        std::vector<uint8_t> absent(pattern.begin(), pattern.end() - 1);
+        absent.push_back(static_cast<uint8_t>(pattern.back() ^ 0xFF));
+
+        // Scans go in address order, so put it in the highest region
+        auto& last = *std::max_element(buffers.begin(), buffers.end(),
+            [](const auto& a, const auto& b) { return a.data() < b.data(); });
+        const size_t at = last.size() - READ_OFFSET - READ_SIZE;
+        std::copy(pattern.begin(), pattern.end(), last.begin() + at);
+        const char name[] = "Bench Server";
+        static_assert(sizeof(name) <= READ_SIZE, "the name must fit in the read");
+        std::memcpy(last.data() + at + READ_OFFSET, name, sizeof(name));
+
+        MemReader& reader = MemReader::getInstance();
+        const std::string size = "mib=" + std::to_string(REGIONS * REGION_SIZE / (1024 * 1024));
+        bench.run("MemReader::searchMemoryRaw", size + " match=end", [&] {
+            return std::get<0>(reader.searchMemoryRaw(pattern, READ_OFFSET, READ_SIZE));
+        });
+        bench.run("MemReader::searchMemoryRaw", size + " match=none", [&] {
+            return std::get<0>(reader.searchMemoryRaw(absent, READ_OFFSET, READ_SIZE));
+        });
+    }
+
+    template <size_t N>
+    void copy(char(&dst)[N], const std::string& src) {
+        std::snprintf(dst, N, "%s", src.c_str());
+    }
+
+    // Starts the plugin as the game does and times the frame Draw builds
+    void benchDraw(Bench& bench, const fs::path& profile, const fs::path& emptyTimes, Rng& rng) {
+        // A fresh profile, with the time tracker emptied of the combos above
+        fs::remove_all(profile);
+        fs::create_directories(profile / PROFILE_DIR);
+        fs::copy_file(emptyTimes, profile / PROFILE_DIR / DAT_FILE);
+
+        std::string savePath = profile.string();
+        Startup(savePath.data());
+        int numSprites = 0, numFonts = 0;
+        char* spriteNames = nullptr;
+        char* fontNames = nullptr;
+        DrawInit(&numSprites, &spriteNames, &numFonts, &fontNames);
+
+        SPluginsBikeEvent_t bikeEvent{};
+        copy(bikeEvent.m_szRiderName, randomText(rng, 8, 24));
+        copy(bikeEvent.m_szBikeID, "bench_bike");
+        copy(bikeEvent.m_szBikeName, randomText(rng, 8, 24));
+        copy(bikeEvent.m_szCategory, "MX1");
+        copy(bikeEvent.m_szTrackID, "bench_track");
+        copy(bikeEvent.m_szTrackName, randomText(rng, 8, 24));
+        bikeEvent.m_fTrackLength = 1800.0f;
+        bikeEvent.m_iType = 1;
+        EventInit(&bikeEvent, sizeof(bikeEvent));
+
+        SPluginsBikeSession_t bikeSession{};
+        bikeSession.m_iSession = 1;
+        RunInit(&bikeSession, sizeof(bikeSession));
+        RunStart();
+
+        // The first frame reports the state change; let the event thread
+        // handle it and everything above before timing
+        int numQuads = 0, numStrings = 0;
+        void* quads = nullptr;
+        void* strings = nullptr;
+        Draw(0, &numQuads, &quads, &numStrings, &strings);
+        std::this_thread::sleep_for(std::chrono::milliseconds(250));
+
+        const size_t lines = Plugin::getInstance().getDisplaySnapshot()->lines.size();
+        bench.run("Draw", "lines=" + std::to_string(lines), [&] {
+            Draw(0, &numQuads, &quads, &numStrings, &strings);
+            return numStrings;
+        });
+
+        // The whole export, as the game thread pays for it
+        SPluginsBikeData_t bike{};
+        bike.m_iRPM = 9000;
+        bike.m_iGear = 3;
+        float time = 0.0f;
+        bench.run("RunTelemetry", "bytes=" + std::to_string(sizeof(bike)), [&] {
+            bike.m_fSpeedometer = static_cast<float>(rng.between(0, 3000)) / 100.0f;
+            time += 0.01f;
+            RunTelemetry(&bike, sizeof(bike), time, std::fmod(time / 60.0f, 1.0f));
+            return bike.m_fSpeedometer;
+        });
+
+        RunStop();
+        RunDeinit();
+        EventDeinit();
+        Shutdown();
+    }
+
+    // The telemetry ring on its own: the producer's copy in, and a reader's copy out
+    void benchTelemetryRing(Bench& bench, Rng& rng) {
+        auto ring = std::make_unique<TelemetryRing>();
+        TelemetrySample sample{};
+        const std::string params = "bytes=" + std::to_string(sizeof(sample));
+
+        bench.run("TelemetryRing::push", params, [&] {
+            sample.bike.m_iRPM = rng.between(2000, 12000);
+            ring->push(sample);
+        });
+
+        // One sample through: pushed, then copied out by a reader that keeps up
+        TelemetryRing::Reader reader(*ring);
+        TelemetrySample out{};
+        bench.run("TelemetryRing::push+next", params, [&] {
+            sample.bike.m_iRPM = rng.between(2000, 12000);
+            ring->push(sample);
+            reader.next(out);
+            return out.bike.m_iRPM;
+        });
+    }
+
+    void printUsage() {
+        std::printf(
+            "Usage: mxbmrp2-bench [options]\n"
+            "  --filter TEXT    only benchmarks whose name/params contain TEXT\n"
+            "  --min-time MS    time spent on each benchmark (default: 300)\n"
+            "  --json           one JSON object per line instead of a table\n"
+            "  --seed N         input seed (default: 1)\n"
+            "  --dir DIR        scratch directory for files (default: bench-data)\n");
+    }
+}
+
+int main(int argc, char** argv) {
+    Bench::Options options;
+    fs::path dir = "bench-data";
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        auto value = [&]() -> const char* {
+            if (i + 1 >= argc) {
+                std::fprintf(stderr, "%s needs a value\n", arg.c_str());
+                std::exit(2);
+            }
+            return argv[++i];
+        };
+
+        if (arg == "--filter") options.filter = value();
+        else if (arg == "--min-time") options.minTime = std::chrono::milliseconds(std::max<int>(1, std::atoi(value())));
+        else if (arg == "--json") options.json = true;
+        else if (arg == "--seed") options.seed = static_cast<uint32_t>(std::strtoul(value(), nullptr, 0));
+        else if (arg == "--dir") dir = value();
+        else {
+            printUsage();
+            return arg == "--help" ? 0 : 2;
+        }
+    }
+
+    fs::create_directories(dir);
+    Bench bench(options);
+
+    // Each group draws from its own stream, so filtering doesn't change the inputs
+    ConfigManager& config = ConfigManager::getInstance();
+    const fs::path configPath = dir / CONFIG_FILE;
+    fs::remove(configPath);
+    config.loadConfig(configPath);
+
+    Rng displayRng(options.seed);
+    benchDisplayAndExports(bench, config, displayRng);
+    benchConfig(bench, config, configPath);
+
+    Rng timesRng(options.seed + 1);
+    benchTimeTracker(bench, dir, timesRng);
+
+    Rng memoryRng(options.seed + 2);
+    benchMemorySearch(bench, memoryRng);
+
+    Rng telemetryRng(options.seed + 4);
+    benchTelemetryRing(bench, telemetryRng);
+
+    Rng drawRng(options.seed + 3);
+    benchDraw(bench, dir / "profile", dir / "times-empty.dat", drawRng);
+
+    if (bench.results().empty()) {
+        std::fprintf(stderr, "No benchmark matches \"%s\"\n", options.filter.c_str());
+        return 1;
+    }
+    return 0;
+}
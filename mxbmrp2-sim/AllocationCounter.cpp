@@ -0,0 +1,136 @@
+
+// AllocationCounter.cpp
+
+#include "pch.h"
+
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <new>
+
+#include "AllocationCounter.h"
+
+namespace {
+    std::atomic<uint64_t> g_allocations{ 0 };
+    std::atomic<uint64_t> g_bytes{ 0 };
+    thread_local uint64_t t_allocations = 0;
+
+    void count(size_t size) {
+        g_allocations.fetch_add(1, std::memory_order_relaxed);
+        g_bytes.fetch_add(size, std::memory_order_relaxed);
+        ++t_allocations;
+    }
+
+    void* allocate(size_t size) {
+        count(size);
+        return std::malloc(size ? size : 1);
+    }
+
+    void* allocateAligned(size_t size, std::align_val_t alignment) {
+        count(size);
+        return _aligned_malloc(size ? size : 1, static_cast<size_t>(alignment));
+    }
+
+    // Scope stats live in a fixed table: recording them must not allocate,
+    // or every scope would
+    constexpr size_t MAX_SCOPES = 16;
+
+    std::mutex g_scopesMutex;
+    std::array<AllocationCounter::ScopeStats, MAX_SCOPES> g_scopes;
+    size_t g_scopeCount = 0;
+    const char* g_countAfter = nullptr;
+    bool g_counting = true;
+}
+
+namespace AllocationCounter {
+
+    Totals totals() {
+        return { g_allocations.load(std::memory_order_relaxed), g_bytes.load(std::memory_order_relaxed) };
+    }
+
+    uint64_t threadAllocations() {
+        return t_allocations;
+    }
+
+    void countScopesAfter(const char* scope) {
+        std::lock_guard<std::mutex> lk(g_scopesMutex);
+        g_countAfter = scope;
+        g_counting = false;
+    }
+
+    std::vector<ScopeStats> steadyStateScopes() {
+        std::lock_guard<std::mutex> lk(g_scopesMutex);
+        return { g_scopes.begin(), g_scopes.begin() + g_scopeCount };
+    }
+
+    void steadyStateScopeEnded(const char* scope, uint64_t allocations) {
+        std::lock_guard<std::mutex> lk(g_scopesMutex);
+        if (!g_counting) {
+            g_counting = std::strcmp(scope, g_countAfter) == 0;
+            return;
+        }
+
+        size_t i = 0;
+        while (i < g_scopeCount && std::strcmp(g_scopes[i].scope, scope) != 0) ++i;
+        if (i == MAX_SCOPES) return;
+        if (i == g_scopeCount) {
+            g_scopes[g_scopeCount++].scope = scope;
+        }
+
+        ScopeStats& stats = g_scopes[i];
+        ++stats.runs;
+        if (allocations > 0) ++stats.allocatingRuns;
+        stats.allocations += allocations;
+    }
+
+} // namespace AllocationCounter
+
+void* operator new(size_t size) {
+    if (void* p = allocate(size)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    return allocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return allocate(size);
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+    if (void* p = allocateAligned(size, alignment)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size, std::align_val_t alignment) {
+    return operator new(size, alignment);
+}
+
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return allocateAligned(size, alignment);
+}
+
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return allocateAligned(size, alignment);
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+
+void operator delete(void* p, std::align_val_t) noexcept { _aligned_free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { _aligned_free(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { _aligned_free(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept { _aligned_free(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { _aligned_free(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { _aligned_free(p); }
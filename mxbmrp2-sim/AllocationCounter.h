@@ -0,0 +1,49 @@
+
+// AllocationCounter.h
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Counts every operator new in the simulator, plugin code included (it is
+// linked into the same executable). AllocationCounter.cpp replaces the
+// global allocation functions.
+//
+// It also backs the plugin's STEADY_STATE_SCOPEs (SteadyState.h): each scope
+// reports what its thread allocated while it ran.
+namespace AllocationCounter {
+
+    struct Totals {
+        uint64_t allocations = 0;
+        uint64_t bytes = 0;
+    };
+
+    Totals totals();
+
+    // operator new calls made by the calling thread so far
+    uint64_t threadAllocations();
+
+    struct ScopeStats {
+        const char* scope;
+        uint64_t runs = 0;
+        uint64_t allocatingRuns = 0;    // runs that allocated at all
+        uint64_t allocations = 0;
+    };
+
+    // Scopes are only counted once `scope` has ended for the first time,
+    // when whatever grows on first use (a lap's splits, a combo's records)
+    // has grown
+    void countScopesAfter(const char* scope);
+
+    // Counted scopes, in the order they first ended
+    std::vector<ScopeStats> steadyStateScopes();
+
+    // As SteadyState.h declares it, called by each scope on exit
+    void steadyStateScopeEnded(const char* scope, uint64_t allocations);
+
+    inline Totals operator-(const Totals& a, const Totals& b) {
+        return { a.allocations - b.allocations, a.bytes - b.bytes };
+    }
+
+} // namespace AllocationCounter
@@ -0,0 +1,191 @@
+
+// CaptureReplayer.cpp
+
+#include "pch.h"
+
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+#include "CaptureReplayer.h"
+#include "AllocationCounter.h"
+#include "MXB_interface.h"
+
+namespace {
+    int64_t nowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+}
+
+CaptureReplayer::CaptureReplayer(std::filesystem::path path, CallbackCapture::ReplaySpeed speed, double drawHz)
+    : path_(std::move(path)),
+      speed_(speed),
+      drawStepNs_(drawHz > 0 ? static_cast<int64_t>(1e9 / drawHz) : 0) {
+}
+
+// Play the whole capture
+SessionStats CaptureReplayer::run() {
+    stats_ = {};
+    records_ = 0;
+    const int64_t startNs = nowNs();
+    replayStart_ = std::chrono::steady_clock::now();
+
+    int64_t lastNs = 0;
+    const int64_t replayed = CallbackCapture::replay(path_, speed_, [&](const CallbackCapture::Record& record) {
+        drawUntil(record.timeNs);
+        handle(record);
+        ++records_;
+        lastNs = record.timeNs;
+    });
+    failed_ = replayed < 0;
+
+    // A capture cut off while riding still counts what was ridden
+    if (riding_) {
+        ++stats_.callbacks;
+        runStop();
+    }
+
+    stats_.wallNs = nowNs() - startNs;
+    stats_.simulatedMs = static_cast<uint64_t>(lastNs / 1000000);
+    return stats_;
+}
+
+// Calls the export the record was captured from
+void CaptureReplayer::handle(const CallbackCapture::Record& record) {
+    if (record.type != CallbackType::StateChange) {
+        ++stats_.callbacks;     // draw() counts its own
+    }
+
+    switch (record.type) {
+    case CallbackType::EventInit: {
+        auto data = record.as<SPluginsBikeEvent_t>();
+        EventInit(&data, sizeof(data));
+        break;
+    }
+    case CallbackType::EventDeinit:         EventDeinit(); break;
+    case CallbackType::RunInit: {
+        auto data = record.as<SPluginsBikeSession_t>();
+        RunInit(&data, sizeof(data));
+        break;
+    }
+    case CallbackType::RunDeinit:           RunDeinit(); break;
+    case CallbackType::RunLap: {
+        auto data = record.as<SPluginsBikeLap_t>();
+        RunLap(&data, sizeof(data));
+        break;
+    }
+    case CallbackType::RunSplit: {
+        auto data = record.as<SPluginsBikeSplit_t>();
+        RunSplit(&data, sizeof(data));
+        break;
+    }
+    case CallbackType::RaceEvent: {
+        auto data = record.as<SPluginsRaceEvent_t>();
+        RaceEvent(&data, sizeof(data));
+        break;
+    }
+    case CallbackType::RaceSession: {
+        auto data = record.as<SPluginsRaceSession_t>();
+        RaceSession(&data, sizeof(data));
+        break;
+    }
+    case CallbackType::RaceSessionState: {
+        auto data = record.as<SPluginsRaceSessionState_t>();
+        RaceSessionState(&data, sizeof(data));
+        break;
+    }
+    case CallbackType::RaceAddEntry: {
+        auto data = record.as<SPluginsRaceAddEntry_t>();
+        RaceAddEntry(&data, sizeof(data));
+        break;
+    }
+    case CallbackType::RaceRemoveEntry: {
+        auto data = record.as<SPluginsRaceRemoveEntry_t>();
+        RaceRemoveEntry(&data, sizeof(data));
+        break;
+    }
+    case CallbackType::RaceCommunication: {
+        auto data = record.as<SPluginsRaceCommunication_t>();
+        RaceCommunication(&data, sizeof(data));
+        break;
+    }
+
+    // The header, the element size, then the entry array if the game sent one
+    case CallbackType::RaceClassification: {
+        auto data = record.as<SPluginsRaceClassification_t>();
+        int32_t elemSize = 0;
+        std::memcpy(&elemSize, record.payload.data() + sizeof(data), sizeof(elemSize));
+        const size_t entriesAt = CallbackCapture::payloadSize(CallbackType::RaceClassification);
+        void* entries = record.payload.size() > entriesAt
+            ? const_cast<char*>(record.payload.data() + entriesAt) : nullptr;
+        RaceClassification(&data, sizeof(data), entries, elemSize);
+        break;
+    }
+
+    case CallbackType::RunTelemetry: {
+        auto bike = record.as<SPluginsBikeData_t>();
+        float time = 0.0f, trackPos = 0.0f;
+        std::memcpy(&time, record.payload.data() + sizeof(bike), sizeof(time));
+        std::memcpy(&trackPos, record.payload.data() + sizeof(bike) + sizeof(time), sizeof(trackPos));
+        RunTelemetry(&bike, sizeof(bike), time, trackPos);
+        break;
+    }
+
+    case CallbackType::StateChange:
+        hasState_ = true;
+        state_ = record.as<int>();
+        nextDrawNs_ = record.timeNs + drawStepNs_;
+        draw(state_);
+        break;
+
+    case CallbackType::RunStart: {
+        RunStart();
+        riding_ = true;
+        const auto allocations = AllocationCounter::totals();
+        ridingAllocationsBefore_ = allocations.allocations;
+        ridingBytesBefore_ = allocations.bytes;
+        ridingCallbacksBefore_ = stats_.callbacks;
+        ridingStartNs_ = nowNs();
+        break;
+    }
+    case CallbackType::RunStop:             runStop(); break;
+    default:
+        break;
+    }
+}
+
+// RunStop, closing the riding stretch if there is one
+void CaptureReplayer::runStop() {
+    if (!riding_) {
+        RunStop();
+        return;
+    }
+    const auto allocations = AllocationCounter::totals();
+    stats_.ridingWallNs += nowNs() - ridingStartNs_;
+    stats_.ridingCallbacks += stats_.callbacks - 1 - ridingCallbacksBefore_;
+    stats_.ridingAllocations += allocations.allocations - ridingAllocationsBefore_;
+    stats_.ridingBytes += allocations.bytes - ridingBytesBefore_;
+    riding_ = false;
+    RunStop();
+}
+
+// The Draw calls the game made between the last record and this one
+void CaptureReplayer::drawUntil(int64_t recordedNs) {
+    if (!hasState_ || drawStepNs_ == 0) return;
+    while (nextDrawNs_ <= recordedNs) {
+        if (speed_ == CallbackCapture::ReplaySpeed::Recorded) {
+            std::this_thread::sleep_until(replayStart_ + std::chrono::nanoseconds(nextDrawNs_));
+        }
+        draw(state_);
+        nextDrawNs_ += drawStepNs_;
+    }
+}
+
+void CaptureReplayer::draw(int state) {
+    int numQuads = 0, numStrings = 0;
+    void* quads = nullptr;
+    void* strings = nullptr;
+    Draw(state, &numQuads, &quads, &numStrings, &strings);
+    ++stats_.callbacks;
+}
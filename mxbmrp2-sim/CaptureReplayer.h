@@ -0,0 +1,55 @@
+
+// CaptureReplayer.h
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+
+#include "SessionGenerator.h"
+#include "CallbackCapture.h"
+
+// Plays a callback capture (enable_capture) back through the plugin's
+// exports, the way SessionGenerator plays a synthetic session, so a real
+// session can be profiled the same way. The capture holds every callback
+// the game made, so the exports throttle and filter them as they did in the
+// game. Draw is called at `drawHz` of recorded time in the state the capture
+// last switched to. Startup/Shutdown are left to the caller.
+class CaptureReplayer {
+public:
+    CaptureReplayer(std::filesystem::path path, CallbackCapture::ReplaySpeed speed, double drawHz);
+
+    SessionStats run();
+
+    // The capture couldn't be opened or had a malformed record
+    bool failed() const { return failed_; }
+
+    uint64_t records() const { return records_; }
+
+private:
+    void handle(const CallbackCapture::Record& record);
+    void runStop();
+    void drawUntil(int64_t recordedNs);
+    void draw(int state);
+
+    std::filesystem::path path_;
+    CallbackCapture::ReplaySpeed speed_;
+    int64_t drawStepNs_;
+
+    std::chrono::steady_clock::time_point replayStart_;    // as CallbackCapture::replay's
+    SessionStats stats_;
+    bool failed_ = false;
+    uint64_t records_ = 0;
+
+    bool hasState_ = false;
+    int state_ = 0;
+    int64_t nextDrawNs_ = 0;
+
+    // RunStart to RunStop
+    bool riding_ = false;
+    int64_t ridingStartNs_ = 0;
+    uint64_t ridingCallbacksBefore_ = 0;
+    uint64_t ridingAllocationsBefore_ = 0;
+    uint64_t ridingBytesBefore_ = 0;
+};
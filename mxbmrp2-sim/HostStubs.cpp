@@ -0,0 +1,66 @@
+
+// HostStubs.cpp
+//
+// Stand-ins for the parts of the plugin that need the game or the desktop.
+// The simulator links these instead of MemReader.cpp and KeyPressHandler.cpp,
+// so the plugin runs as it does on a game build it has no memory offsets
+// for: memory-derived fields stay empty. Discord is left to the profile's
+// enable_discord_rich_presence (off by default); its SDK is delay-loaded,
+// so the DLL is only needed if it's turned on.
+
+#include "pch.h"
+
+#include "MemReader.h"
+#include "KeyPressHandler.h"
+
+// MemReader: no game process to read from
+
+MemReader& MemReader::getInstance() {
+    static MemReader instance;
+    return instance;
+}
+
+MemReader::MemReader()
+    : baseAddress_(0),
+      regionMap_(createProcessRegionSource()) {}
+
+MemReader::~MemReader() = default;
+
+void MemReader::initialize(const std::filesystem::path&, const std::filesystem::path&) {}
+
+void MemReader::shutdown() {}
+
+std::optional<unsigned long> MemReader::getOffset(MemoryOffset) const {
+    return std::nullopt;
+}
+
+void MemReader::refreshOffsets() {}
+
+bool MemReader::isMemoryAvailable() {
+    return false;
+}
+
+bool MemReader::readInto(bool, uintptr_t, void*, size_t, const char*) {
+    return false;
+}
+
+std::optional<MemoryRegion> MemReader::findRegion(uintptr_t) {
+    return std::nullopt;
+}
+
+std::unique_ptr<MemoryScan> MemReader::beginSearch(const std::vector<uint8_t>&, size_t, size_t, const char*) {
+    return nullptr;
+}
+
+std::tuple<uintptr_t, std::string> MemReader::searchMemoryRaw(
+    const std::vector<uint8_t>&, size_t, size_t, const char*, const std::atomic<bool>*)
+{
+    return { 0, {} };
+}
+
+// KeyPressHandler: nobody to press the hotkey
+
+KeyPressHandler::KeyPressHandler(HotkeyCallback callback, UINT hotkey)
+    : callback_(std::move(callback)), hotkey_(hotkey) {}
+
+KeyPressHandler::~KeyPressHandler() = default;
@@ -0,0 +1,297 @@
+
+// SessionGenerator.cpp
+
+#include "pch.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <thread>
+
+#include "SessionGenerator.h"
+#include "AllocationCounter.h"
+#include "MXB_interface.h"
+
+namespace {
+    constexpr int EVENT_TESTING = 1;
+    constexpr int EVENT_RACE = 2;
+    constexpr int SESSION_PRACTICE = 1;
+    constexpr int SESSION_RACE_1 = 6;
+    constexpr int STATE_IN_PROGRESS = 16;
+    constexpr int STATE_COMPLETED = 32;
+    constexpr int GAME_STATE_MENUS = -1;
+    constexpr int GAME_STATE_ON_TRACK = 0;
+
+    constexpr const char* TRACK_ID = "sim_track";
+    constexpr const char* BIKE_ID = "sim_bike";
+    constexpr const char* BIKE_NAME = "Sim Bike 450";
+    constexpr float TRACK_LENGTH = 1800.0f;
+    constexpr double PI = 3.14159265358979323846;
+
+    int64_t nowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    template <size_t N>
+    void copy(char(&dst)[N], const char* src) {
+        std::snprintf(dst, N, "%s", src);
+    }
+
+    std::string riderName(int raceNum) {
+        return "Sim Rider " + std::to_string(raceNum);
+    }
+}
+
+SessionGenerator::SessionGenerator(const SessionOptions& options)
+    : options_(options),
+      rng_(options.seed ? options.seed : 1),
+      session_(options.race ? SESSION_RACE_1 : SESSION_PRACTICE) {
+}
+
+// Play the whole event
+SessionStats SessionGenerator::run() {
+    stats_ = {};
+    const int64_t startNs = nowNs();
+
+    beginEvent();
+    ride();
+    endEvent();
+
+    stats_.wallNs = nowNs() - startNs;
+    return stats_;
+}
+
+// From loading the track to sitting in the pits
+void SessionGenerator::beginEvent() {
+    draw(GAME_STATE_MENUS);
+
+    SPluginsBikeEvent_t bikeEvent{};
+    copy(bikeEvent.m_szRiderName, riderName(1).c_str());
+    copy(bikeEvent.m_szBikeID, BIKE_ID);
+    copy(bikeEvent.m_szBikeName, BIKE_NAME);
+    copy(bikeEvent.m_szCategory, "MX1");
+    copy(bikeEvent.m_szTrackID, TRACK_ID);
+    copy(bikeEvent.m_szTrackName, "Sim Track");
+    bikeEvent.m_fTrackLength = TRACK_LENGTH;
+    bikeEvent.m_iType = options_.race ? EVENT_RACE : EVENT_TESTING;
+    EventInit(&bikeEvent, sizeof(bikeEvent));
+    ++stats_.callbacks;
+
+    SPluginsRaceEvent_t raceEvent{};
+    raceEvent.m_iType = bikeEvent.m_iType;
+    copy(raceEvent.m_szName, "Sim Event");
+    copy(raceEvent.m_szTrackName, "Sim Track");
+    raceEvent.m_fTrackLength = bikeEvent.m_fTrackLength;
+    RaceEvent(&raceEvent, sizeof(raceEvent));
+    ++stats_.callbacks;
+
+    for (int raceNum = 1; raceNum <= options_.riders; ++raceNum) {
+        SPluginsRaceAddEntry_t entry{};
+        entry.m_iRaceNum = raceNum;
+        copy(entry.m_szName, riderName(raceNum).c_str());
+        copy(entry.m_szBikeName, BIKE_NAME);
+        copy(entry.m_szBikeShortName, "SB450");
+        copy(entry.m_szCategory, "MX1");
+        RaceAddEntry(&entry, sizeof(entry));
+        ++stats_.callbacks;
+    }
+
+    SPluginsRaceSession_t raceSession{};
+    raceSession.m_iSession = session_;
+    raceSession.m_iSessionState = STATE_IN_PROGRESS;
+    raceSession.m_iSessionNumLaps = options_.race ? options_.laps : 0;
+    raceSession.m_fAirTemperature = 21.0f;
+    RaceSession(&raceSession, sizeof(raceSession));
+    ++stats_.callbacks;
+}
+
+// RunStart to RunStop, with everything the game calls in between
+void SessionGenerator::ride() {
+    SPluginsBikeSession_t bikeSession{};
+    bikeSession.m_iSession = session_;
+    RunInit(&bikeSession, sizeof(bikeSession));
+    RunStart();
+    stats_.callbacks += 2;
+
+    const auto allocationsBefore = AllocationCounter::totals();
+    const uint64_t callbacksBefore = stats_.callbacks;
+    const int64_t ridingStartNs = nowNs();
+    paceStartNs_ = ridingStartNs;
+
+    constexpr double never = std::numeric_limits<double>::infinity();
+    const double drawStep = options_.drawHz > 0 ? 1000.0 / options_.drawHz : never;
+    const double classificationStep = options_.classificationHz > 0 ? 1000.0 / options_.classificationHz : never;
+    const double telemetryStep = options_.telemetryHz > 0 ? 1000.0 / options_.telemetryHz : never;
+    double nextDraw = 0;
+    double nextClassification = 0;
+    double nextTelemetry = 0;
+    double lapStart = 0;
+    double lapMs = 0;
+
+    // Draw, classification and telemetry keep their own pace until the next split or lap
+    auto advanceTo = [&](double target) {
+        for (;;) {
+            const double next = std::min<double>({ nextDraw, nextClassification, nextTelemetry });
+            if (next > target) break;
+
+            wait(next);
+            if (next == nextTelemetry) {
+                telemetry(nextTelemetry, lapStart, lapMs);
+                nextTelemetry += telemetryStep;
+            }
+            else if (next == nextDraw) {
+                draw(GAME_STATE_ON_TRACK);
+                nextDraw += drawStep;
+            }
+            else {
+                classification(static_cast<int>(nextClassification));
+                nextClassification += classificationStep;
+            }
+        }
+        wait(target);
+    };
+
+    for (int lap = 0; lap < options_.laps; ++lap) {
+        const double jitter = (static_cast<double>(random() % 4001) - 2000.0) / 100000.0;
+        lapMs = options_.lapTimeMs * (1.0 + jitter);
+
+        for (int split = 0; split < options_.splits; ++split) {
+            const double splitMs = lapMs * (split + 1) / (options_.splits + 1);
+            advanceTo(lapStart + splitMs);
+
+            SPluginsBikeSplit_t bikeSplit{};
+            bikeSplit.m_iSplit = split;
+            bikeSplit.m_iSplitTime = static_cast<int>(splitMs);
+            RunSplit(&bikeSplit, sizeof(bikeSplit));
+            ++stats_.callbacks;
+        }
+
+        advanceTo(lapStart + lapMs);
+        lapStart += lapMs;
+
+        SPluginsBikeLap_t bikeLap{};
+        bikeLap.m_iLapNum = lap;
+        bikeLap.m_iLapTime = static_cast<int>(lapMs);
+        RunLap(&bikeLap, sizeof(bikeLap));
+        ++stats_.callbacks;
+
+        for (int raceNum = 1; raceNum <= options_.riders; ++raceNum) {
+            if (random() < options_.penaltyChance * 4294967296.0) {
+                penalty(raceNum, lap);
+            }
+        }
+    }
+
+    const auto allocations = AllocationCounter::totals() - allocationsBefore;
+    stats_.ridingWallNs = nowNs() - ridingStartNs;
+    stats_.ridingCallbacks = stats_.callbacks - callbacksBefore;
+    stats_.ridingAllocations = allocations.allocations;
+    stats_.ridingBytes = allocations.bytes;
+    stats_.simulatedMs = static_cast<uint64_t>(lapStart);
+
+    RunStop();
+    RunDeinit();
+    stats_.callbacks += 2;
+}
+
+// Session over, back to the menus
+void SessionGenerator::endEvent() {
+    SPluginsRaceSessionState_t sessionState{};
+    sessionState.m_iSession = session_;
+    sessionState.m_iSessionState = STATE_COMPLETED;
+    RaceSessionState(&sessionState, sizeof(sessionState));
+
+    for (int raceNum = options_.riders; raceNum >= 1; --raceNum) {
+        SPluginsRaceRemoveEntry_t entry{};
+        entry.m_iRaceNum = raceNum;
+        RaceRemoveEntry(&entry, sizeof(entry));
+        ++stats_.callbacks;
+    }
+
+    EventDeinit();
+    stats_.callbacks += 2;
+    draw(GAME_STATE_MENUS);
+}
+
+void SessionGenerator::draw(int state) {
+    int numQuads = 0, numStrings = 0;
+    void* quads = nullptr;
+    void* strings = nullptr;
+    Draw(state, &numQuads, &quads, &numStrings, &strings);
+    ++stats_.callbacks;
+}
+
+// The entry array isn't read by the plugin, so only the header is sent
+void SessionGenerator::classification(int sessionTimeMs) {
+    SPluginsRaceClassification_t raceClassification{};
+    raceClassification.m_iSession = session_;
+    raceClassification.m_iSessionState = STATE_IN_PROGRESS;
+    raceClassification.m_iSessionTime = sessionTimeMs;
+    raceClassification.m_iNumEntries = options_.riders;
+    RaceClassification(&raceClassification, sizeof(raceClassification), nullptr, 0);
+    ++stats_.callbacks;
+}
+
+// The bike going round an oval at the lap's pace, faster on the straights,
+// with some noise on top as bumps and the rider's inputs would add
+void SessionGenerator::telemetry(double simulatedMs, double lapStartMs, double lapMs) {
+    const double trackPos = std::min<double>(0.999999, (simulatedMs - lapStartMs) / lapMs);
+    const double angle = 2.0 * PI * trackPos;
+    const double averageSpeed = TRACK_LENGTH / (lapMs / 1000.0);
+    const double speed = averageSpeed * (1.0 + 0.3 * std::cos(2.0 * angle)) + noise(0.5);
+
+    SPluginsBikeData_t bike{};
+    bike.m_fSpeedometer = static_cast<float>(speed);
+    bike.m_afWheelSpeed[0] = bike.m_afWheelSpeed[1] = bike.m_fSpeedometer;
+    bike.m_iGear = std::min<int>(5, 1 + static_cast<int>(speed / 10.0));
+    bike.m_iRPM = 4000 + static_cast<int>(speed * 250.0 + noise(150.0)) % 8000;
+    bike.m_fEngineTemperature = bike.m_fWaterTemperature = 85.0f;
+    bike.m_fFuel = 6.0f;
+    bike.m_fThrottle = bike.m_fInputThrottle = static_cast<float>(std::clamp(0.5 - 0.5 * std::sin(2.0 * angle) + noise(0.05), 0.0, 1.0));
+    bike.m_fFrontBrake = bike.m_fRearBrake = 1.0f - bike.m_fThrottle;
+    bike.m_fPosX = static_cast<float>(std::cos(angle) * TRACK_LENGTH / (2.0 * PI));
+    bike.m_fPosY = static_cast<float>(2.0 + noise(0.3));
+    bike.m_fPosZ = static_cast<float>(std::sin(angle) * TRACK_LENGTH / (2.0 * PI));
+    bike.m_fYaw = static_cast<float>(std::fmod(angle * 180.0 / PI + 90.0, 360.0) - 180.0);
+    bike.m_aafRot[0][0] = bike.m_aafRot[1][1] = bike.m_aafRot[2][2] = 1.0f;
+    bike.m_aiWheelMaterial[0] = bike.m_aiWheelMaterial[1] = 1;
+
+    RunTelemetry(&bike, sizeof(bike), static_cast<float>(simulatedMs / 1000.0), static_cast<float>(trackPos));
+    ++stats_.callbacks;
+}
+
+// A cut penalty, as the game reports it
+void SessionGenerator::penalty(int raceNum, int lap) {
+    SPluginsRaceCommunication_t raceCommunication{};
+    raceCommunication.m_iSession = session_;
+    raceCommunication.m_iRaceNum = raceNum;
+    raceCommunication.m_iCommunication = 2;
+    raceCommunication.m_iOffence = 2;
+    raceCommunication.m_iLap = lap;
+    raceCommunication.m_iTime = 1 + static_cast<int>(random() % 3);
+    RaceCommunication(&raceCommunication, sizeof(raceCommunication));
+    ++stats_.callbacks;
+}
+
+// Only sleeps when keeping the simulated pace, which starts at RunStart
+void SessionGenerator::wait(double simulatedMs) {
+    if (!options_.realTime) return;
+    std::this_thread::sleep_until(std::chrono::steady_clock::time_point(
+        std::chrono::nanoseconds(paceStartNs_ + static_cast<int64_t>(simulatedMs * 1e6))));
+}
+
+// Uniform in [-amplitude, amplitude]
+double SessionGenerator::noise(double amplitude) {
+    return (static_cast<double>(random()) / 4294967295.0 * 2.0 - 1.0) * amplitude;
+}
+
+// xorshift32, so runs with the same seed are identical
+uint32_t SessionGenerator::random() {
+    rng_ ^= rng_ << 13;
+    rng_ ^= rng_ >> 17;
+    rng_ ^= rng_ << 5;
+    return rng_;
+}
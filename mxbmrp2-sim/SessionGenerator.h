@@ -0,0 +1,61 @@
+
+// SessionGenerator.h
+
+#pragma once
+
+#include <cstdint>
+
+// What a synthetic session looks like
+struct SessionOptions {
+    bool race = false;              // race event (Race 1) instead of testing
+    int riders = 1;                 // entries, the first is the local rider
+    int laps = 10;                  // laps ridden by the local rider
+    int splits = 3;                 // split points per lap
+    int lapTimeMs = 60000;          // average, each lap varies by up to 2%
+    double classificationHz = 10;   // RaceClassification calls per simulated second
+    double drawHz = 60;             // Draw calls per simulated second
+    double telemetryHz = 10;        // RunTelemetry calls per simulated second
+    double penaltyChance = 0.01;    // chance of a cut penalty per rider and lap
+    bool realTime = false;          // keep the simulated pace instead of running flat out
+    uint32_t seed = 1;
+};
+
+struct SessionStats {
+    uint64_t callbacks = 0;         // export calls, Draw included
+    uint64_t simulatedMs = 0;
+    int64_t wallNs = 0;             // from EventInit to EventDeinit returning
+    int64_t ridingWallNs = 0;       // RunStart to RunStop
+    uint64_t ridingCallbacks = 0;
+    uint64_t ridingAllocations = 0;
+    uint64_t ridingBytes = 0;
+};
+
+// Plays a synthetic event through the plugin's exports, the way the game
+// calls them: event and entries, a run of laps with splits, classification
+// and Draw interleaved by simulated time, then the run and event closing.
+// Startup/Shutdown are left to the caller.
+class SessionGenerator {
+public:
+    explicit SessionGenerator(const SessionOptions& options);
+
+    SessionStats run();
+
+private:
+    void beginEvent();
+    void ride();
+    void endEvent();
+
+    void draw(int state);
+    void classification(int sessionTimeMs);
+    void telemetry(double simulatedMs, double lapStartMs, double lapMs);
+    void penalty(int raceNum, int lap);
+    void wait(double simulatedMs);
+    uint32_t random();
+    double noise(double amplitude);
+
+    SessionOptions options_;
+    SessionStats stats_;
+    uint32_t rng_;
+    int session_;
+    int64_t paceStartNs_ = 0;
+};
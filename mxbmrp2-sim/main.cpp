@@ -0,0 +1,291 @@
+
+// main.cpp
+//
+// mxbmrp2-sim: runs the plugin without the game, feeding it a synthetic
+// session through the same exports the game calls, and reports how it
+// coped. Example runs:
+//
+//   mxbmrp2-sim --laps 10000                              long practice
+//   mxbmrp2-sim --race --riders 40 --classification-hz 100
+//   mxbmrp2-sim --replay mxbmrp2-capture.bin --max-speed  a captured session
+
+#include "pch.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "SessionGenerator.h"
+#include "CaptureReplayer.h"
+#include "AllocationCounter.h"
+#include "MXB_interface.h"
+#include "Metrics.h"
+#include "Logger.h"
+#include "Telemetry.h"
+#include "TelemetryFile.h"
+#include "Constants.h"
+
+namespace {
+    void printUsage() {
+        std::printf(
+            "Usage: mxbmrp2-sim [options]\n"
+            "  --race                   race event (default: testing)\n"
+            "  --riders N               entries, the first one is you (default: 1)\n"
+            "  --laps N                 laps to ride (default: 10)\n"
+            "  --splits N               split points per lap (default: 3)\n"
+            "  --lap-time MS            average lap time (default: 60000)\n"
+            "  --classification-hz HZ   RaceClassification rate (default: 10)\n"
+            "  --draw-hz HZ             Draw rate (default: 60)\n"
+            "  --telemetry-hz HZ        RunTelemetry rate (default: the one Startup returns)\n"
+            "  --penalty-chance P       cut penalty chance per rider and lap (default: 0.01)\n"
+            "  --realtime               keep the simulated pace (default: flat out)\n"
+            "  --seed N                 random seed (default: 1)\n"
+            "  --profile DIR            save path passed to Startup (default: sim-profile)\n"
+            "  --set KEY=VALUE          set an mxbmrp2.ini value in the profile first (repeatable)\n"
+            "  --replay FILE            play a callback capture (enable_capture) instead,\n"
+            "                           at the recorded pace; only --draw-hz and --profile apply\n"
+            "  --max-speed              replay the capture back to back\n");
+    }
+
+    // Replace or add `key=value` lines in the profile's mxbmrp2.ini; the
+    // plugin fills in the keys the file doesn't have
+    void applySettings(const std::filesystem::path& configPath, const std::vector<std::string>& settings) {
+        std::vector<std::string> lines;
+        std::ifstream in(configPath);
+        for (std::string line; std::getline(in, line);) {
+            lines.push_back(line);
+        }
+        in.close();
+
+        for (const std::string& setting : settings) {
+            const std::string prefix = setting.substr(0, setting.find('=') + 1);
+            auto it = std::find_if(lines.begin(), lines.end(),
+                [&](const std::string& line) { return line.compare(0, prefix.size(), prefix) == 0; });
+            if (it != lines.end()) *it = setting;
+            else lines.push_back(setting);
+        }
+
+        std::filesystem::create_directories(configPath.parent_path());
+        std::ofstream out(configPath, std::ios::trunc);
+        for (const std::string& line : lines) {
+            out << line << '\n';
+        }
+    }
+
+    double seconds(int64_t nanos) {
+        return static_cast<double>(nanos) / 1e9;
+    }
+
+    void printLatencies() {
+        const Metrics& metrics = Metrics::getInstance();
+        std::printf("\n%-30s %10s %12s %12s %12s %12s\n", "Latency", "count", "p50", "p90", "p99", "max");
+        for (size_t i = 0; i < static_cast<size_t>(Histogram::Count); ++i) {
+            const Histogram histogram = static_cast<Histogram>(i);
+            const Metrics::Summary s = metrics.summarize(histogram);
+            if (s.count == 0) continue;
+
+            std::printf("%-30s %10llu %12s %12s %12s %12s\n", Metrics::name(histogram),
+                static_cast<unsigned long long>(s.count),
+                Metrics::formatMicros(s.p50).c_str(), Metrics::formatMicros(s.p90).c_str(),
+                Metrics::formatMicros(s.p99).c_str(), Metrics::formatMicros(s.max).c_str());
+        }
+    }
+
+    // Returns false if any steady-state scope allocated
+    bool printSteadyState() {
+        const auto scopes = AllocationCounter::steadyStateScopes();
+        if (scopes.empty()) {
+            std::printf("\nSteady-state allocations: not checked, no lap was completed\n");
+            return true;
+        }
+
+        bool clean = true;
+        std::printf("\n%-30s %10s %12s %12s\n", "Steady state (after lap 1)", "runs", "allocating", "allocations");
+        for (const auto& s : scopes) {
+            std::printf("%-30s %10llu %12llu %12llu\n", s.scope,
+                static_cast<unsigned long long>(s.runs),
+                static_cast<unsigned long long>(s.allocatingRuns),
+                static_cast<unsigned long long>(s.allocations));
+            clean = clean && s.allocations == 0;
+        }
+        if (!clean) {
+            std::printf("FAILED: steady-state code allocated\n");
+        }
+        return clean;
+    }
+
+    // The newest telemetry recording, if enable_telemetry_recording is on,
+    // read back a lap at a time
+    void printRecording(const std::filesystem::path& dir) {
+        std::error_code ec;
+        std::filesystem::path newest;
+        std::filesystem::file_time_type newestTime{};
+        for (const auto& entry : std::filesystem::directory_iterator(dir, ec)) {
+            if (entry.path().extension() != TELEMETRY_FILE_EXTENSION) continue;
+            if (newest.empty() || entry.last_write_time() > newestTime) {
+                newest = entry.path();
+                newestTime = entry.last_write_time();
+            }
+        }
+        if (newest.empty()) return;
+
+        TelemetryFile::Reader reader;
+        if (!reader.open(newest)) {
+            std::printf("\nTelemetry recording %s could not be read\n", newest.filename().string().c_str());
+            return;
+        }
+
+        const double bytesPerSample = reader.samples() ? static_cast<double>(reader.fileSize()) / reader.samples() : 0.0;
+        std::printf("\nTelemetry recording %s\n", newest.filename().string().c_str());
+        std::printf("%llu samples, %zu laps, %.1f KB (%.2f bytes per sample, %.1f MB per hour at %u Hz)\n",
+            static_cast<unsigned long long>(reader.samples()), reader.laps().size(),
+            static_cast<double>(reader.fileSize()) / 1024.0, bytesPerSample,
+            bytesPerSample * reader.info().rateHz * 3600.0 / (1024.0 * 1024.0), reader.info().rateHz);
+
+        std::vector<TelemetryFile::Row> rows;
+        uint64_t rowsRead = 0;
+        bool intact = true;
+        const int64_t start = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+        for (size_t lap = 0; lap < reader.laps().size(); ++lap) {
+            intact = reader.readLap(lap, rows) && intact;
+            rowsRead += rows.size();
+        }
+        const int64_t elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count() - start;
+
+        std::printf("Read back every lap in %.3f ms%s\n", static_cast<double>(elapsed) / 1e6,
+            intact && rowsRead == reader.samples() ? "" : ", FAILED: samples missing or damaged");
+    }
+}
+
+int main(int argc, char** argv) {
+    SessionOptions options;
+    std::string profile = "sim-profile";
+    double telemetryHz = -1;    // the rate Startup returns unless given
+    std::filesystem::path replayPath;
+    bool maxSpeed = false;
+    std::vector<std::string> settings;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        auto value = [&]() -> const char* {
+            if (i + 1 >= argc) {
+                std::fprintf(stderr, "%s needs a value\n", arg.c_str());
+                std::exit(2);
+            }
+            return argv[++i];
+        };
+
+        if (arg == "--race") options.race = true;
+        else if (arg == "--riders") options.riders = std::max<int>(1, std::atoi(value()));
+        else if (arg == "--laps") options.laps = std::max<int>(0, std::atoi(value()));
+        else if (arg == "--splits") options.splits = std::max<int>(0, std::atoi(value()));
+        else if (arg == "--lap-time") options.lapTimeMs = std::max<int>(1, std::atoi(value()));
+        else if (arg == "--classification-hz") options.classificationHz = std::atof(value());
+        else if (arg == "--draw-hz") options.drawHz = std::atof(value());
+        else if (arg == "--telemetry-hz") telemetryHz = std::atof(value());
+        else if (arg == "--penalty-chance") options.penaltyChance = std::atof(value());
+        else if (arg == "--realtime") options.realTime = true;
+        else if (arg == "--seed") options.seed = static_cast<uint32_t>(std::strtoul(value(), nullptr, 0));
+        else if (arg == "--profile") profile = value();
+        else if (arg == "--replay") replayPath = value();
+        else if (arg == "--max-speed") maxSpeed = true;
+        else if (arg == "--set") {
+            settings.push_back(value());
+            if (settings.back().find('=') == std::string::npos) {
+                std::fprintf(stderr, "--set needs KEY=VALUE\n");
+                return 2;
+            }
+        }
+        else {
+            printUsage();
+            return arg == "--help" ? 0 : 2;
+        }
+    }
+
+    std::filesystem::create_directories(profile);
+    if (!settings.empty()) {
+        applySettings(std::filesystem::path(profile) / PROFILE_DIR / CONFIG_FILE, settings);
+    }
+
+    // Startup truncates the profile's own capture when enable_capture is on
+    std::error_code ec;
+    if (!replayPath.empty() && std::filesystem::equivalent(replayPath,
+        std::filesystem::path(profile) / PROFILE_DIR / CAPTURE_FILE, ec))
+    {
+        std::fprintf(stderr, "Copy %s out of the profile before replaying it\n", replayPath.string().c_str());
+        return 2;
+    }
+
+    // Startup to Shutdown, as the game does it
+    AllocationCounter::countScopesAfter("lap");
+    const auto allocationsBefore = AllocationCounter::totals();
+    const int telemetryRate = Startup(profile.data());
+    options.telemetryHz = telemetryHz >= 0 ? telemetryHz : Telemetry::rateHz(telemetryRate);
+
+    int numSprites = 0, numFonts = 0;
+    char* spriteNames = nullptr;
+    char* fontNames = nullptr;
+    DrawInit(&numSprites, &spriteNames, &numFonts, &fontNames);
+
+    SessionStats stats;
+    bool replayFailed = false;
+    uint64_t replayRecords = 0;
+    if (replayPath.empty()) {
+        SessionGenerator generator(options);
+        stats = generator.run();
+    }
+    else {
+        CaptureReplayer replayer(replayPath,
+            maxSpeed ? CallbackCapture::ReplaySpeed::Maximum : CallbackCapture::ReplaySpeed::Recorded, options.drawHz);
+        stats = replayer.run();
+        replayFailed = replayer.failed();
+        replayRecords = replayer.records();
+    }
+
+    Shutdown();
+    const auto allocations = AllocationCounter::totals() - allocationsBefore;
+
+    if (replayPath.empty()) {
+        std::printf("%s, %d rider%s, %d laps, %d splits/lap, %.0f Hz classification, %.0f Hz draw, %.0f Hz telemetry%s\n",
+            options.race ? "Race" : "Testing", options.riders, options.riders == 1 ? "" : "s",
+            options.laps, options.splits, options.classificationHz, options.drawHz, options.telemetryHz,
+            options.realTime ? ", real time" : "");
+    }
+    else {
+        std::printf("Replay of %s, %llu records, %.0f Hz draw, %s\n", replayPath.string().c_str(),
+            static_cast<unsigned long long>(replayRecords), options.drawHz,
+            maxSpeed ? "back to back" : "recorded pace");
+    }
+
+    std::printf("\nSimulated %.1f s in %.3f s of wall time\n",
+        static_cast<double>(stats.simulatedMs) / 1000.0, seconds(stats.wallNs));
+    std::printf("Callbacks: %llu, %.0f per second\n",
+        static_cast<unsigned long long>(stats.callbacks),
+        stats.wallNs > 0 ? static_cast<double>(stats.callbacks) / seconds(stats.wallNs) : 0.0);
+    std::printf("Allocations while riding: %llu (%.2f per callback), %llu bytes\n",
+        static_cast<unsigned long long>(stats.ridingAllocations),
+        stats.ridingCallbacks ? static_cast<double>(stats.ridingAllocations) / stats.ridingCallbacks : 0.0,
+        static_cast<unsigned long long>(stats.ridingBytes));
+    std::printf("Allocations in total: %llu, %llu bytes\n",
+        static_cast<unsigned long long>(allocations.allocations),
+        static_cast<unsigned long long>(allocations.bytes));
+
+    printLatencies();
+    const bool steady = printSteadyState();
+    printRecording(std::filesystem::path(profile) / PROFILE_DIR / TELEMETRY_DIR);
+    std::printf("\nLog messages dropped: %llu\n", static_cast<unsigned long long>(Logger::getInstance().droppedCount()));
+
+    if (replayFailed) {
+        std::printf("FAILED: the capture could not be read to the end\n");
+        return 1;
+    }
+    return steady ? 0 : 3;
+}
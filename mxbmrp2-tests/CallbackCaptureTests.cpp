@@ -0,0 +1,121 @@
+
+// CallbackCaptureTests.cpp
+
+#include "pch.h"
+
+#include <fstream>
+
+#include "Test.h"
+#include "CallbackCapture.h"
+
+using namespace CallbackCapture;
+
+namespace {
+    // Stands in for the game's classification entries, whose layout the plugin doesn't use
+    struct Entry {
+        int raceNum;
+        int state;
+        int bestLap;
+    };
+
+    std::vector<Record> readAll(const std::filesystem::path& path, bool& failed) {
+        std::vector<Record> records;
+        Reader reader;
+        failed = !reader.open(path);
+        Record record;
+        while (!failed && reader.next(record)) {
+            records.push_back(record);
+        }
+        failed = failed || reader.failed();
+        return records;
+    }
+}
+
+// Everything the exports are given comes back, the entry array included
+TEST(CallbackCapture_roundTripKeepsPayloads) {
+    const auto path = Test::scratchDir() / "capture.bin";
+
+    SPluginsRaceClassification_t classification{};
+    classification.m_iSessionTime = 61500;
+    classification.m_iNumEntries = 3;
+    const Entry entries[3] = { { 7, 0, 60100 }, { 12, 0, 60800 }, { 3, 1, 0 } };
+
+    SPluginsRaceCommunication_t communication{};
+    communication.m_iCommunication = 1;     // not a penalty, still recorded
+
+    SPluginsBikeData_t bike{};
+    bike.m_iRPM = 9500;
+
+    Writer writer;
+    REQUIRE(writer.open(path));
+    writer.writeClassification(classification, entries, static_cast<int>(sizeof(Entry)));
+    writer.write(CallbackType::RaceCommunication, &communication, sizeof(communication));
+    writer.writeTelemetry(bike, 12.5f, 0.25f);
+    writer.write(CallbackType::RunStop, nullptr, 0);
+    CHECK_EQ(writer.close(), size_t(4));
+
+    bool failed = false;
+    const auto records = readAll(path, failed);
+    CHECK(!failed);
+    REQUIRE(records.size() == 4u);
+
+    REQUIRE(records[0].type == CallbackType::RaceClassification);
+    CHECK_EQ(records[0].as<SPluginsRaceClassification_t>().m_iSessionTime, 61500);
+    REQUIRE(records[0].payload.size() == payloadSize(CallbackType::RaceClassification) + sizeof(entries));
+    Entry third{};
+    std::memcpy(&third, records[0].payload.data() + payloadSize(CallbackType::RaceClassification) + 2 * sizeof(Entry), sizeof(Entry));
+    CHECK_EQ(third.raceNum, 3);
+
+    CHECK(records[1].type == CallbackType::RaceCommunication);
+    CHECK_EQ(records[1].as<SPluginsRaceCommunication_t>().m_iCommunication, 1);
+
+    REQUIRE(records[2].type == CallbackType::RunTelemetry);
+    CHECK_EQ(records[2].as<SPluginsBikeData_t>().m_iRPM, 9500);
+    float trackPos = 0.0f;
+    std::memcpy(&trackPos, records[2].payload.data() + sizeof(SPluginsBikeData_t) + sizeof(float), sizeof(float));
+    CHECK_EQ(trackPos, 0.25f);
+
+    CHECK(records[3].type == CallbackType::RunStop);
+    CHECK(records[3].payload.empty());
+    CHECK(records[3].timeNs >= records[0].timeNs);
+}
+
+// The simulator sends no entry array
+TEST(CallbackCapture_classificationWithoutEntries) {
+    const auto path = Test::scratchDir() / "capture.bin";
+
+    SPluginsRaceClassification_t classification{};
+    classification.m_iNumEntries = 20;
+
+    Writer writer;
+    REQUIRE(writer.open(path));
+    writer.writeClassification(classification, nullptr, 0);
+    writer.close();
+
+    bool failed = false;
+    const auto records = readAll(path, failed);
+    CHECK(!failed);
+    REQUIRE(records.size() == 1u);
+    CHECK_EQ(records[0].payload.size(), payloadSize(CallbackType::RaceClassification));
+    CHECK_EQ(records[0].as<SPluginsRaceClassification_t>().m_iNumEntries, 20);
+}
+
+// Version 1 held the records after the plugin had filtered them
+TEST(CallbackCapture_rejectsOtherVersions) {
+    const auto path = Test::scratchDir() / "old.bin";
+    {
+        Writer writer;
+        REQUIRE(writer.open(path));
+        writer.write(CallbackType::RunStart, nullptr, 0);
+        writer.close();
+    }
+
+    std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+    file.seekp(sizeof(MAGIC));
+    const uint32_t version = 1;
+    file.write(reinterpret_cast<const char*>(&version), sizeof(version));
+    file.close();
+
+    Reader reader;
+    CHECK(!reader.open(path));
+}
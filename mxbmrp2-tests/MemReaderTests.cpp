@@ -0,0 +1,112 @@
+
+// MemReaderTests.cpp
+
+#include "pch.h"
+
+#include <array>
+#include <cstring>
+
+#include "Test.h"
+#include "AllocationCounter.h"
+#include "MemReader.h"
+#include "ConfigManager.h"
+#include "SteadyState.h"
+
+namespace {
+    struct Sample {
+        uint32_t id;
+        float speed;
+        uint16_t ping;
+    };
+
+    // A stand-in for game memory, read with relative = false
+    struct Memory {
+        Sample sample{ 7, 91.5f, 42 };
+        char name[32] = "Sunday Practice";
+        char unterminated[8] = { 'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H' };
+        std::array<uint8_t, 16> raw{};
+    };
+
+    uintptr_t address(const void* p) {
+        return reinterpret_cast<uintptr_t>(p);
+    }
+
+    // Everything the plugin reads on its hot paths, once
+    void readAll(MemReader& reader, const Memory& memory, bool& ok) {
+        auto sample = reader.read<Sample>(false, address(&memory.sample));
+        ok = ok && sample && sample->id == 7 && sample->ping == 42;
+
+        auto name = reader.readString<32>(false, address(memory.name));
+        ok = ok && name.len == std::strlen(memory.name);
+
+        auto truncated = reader.readString<8>(false, address(memory.unterminated));
+        ok = ok && truncated.len == 8;
+
+        std::array<uint8_t, 16> raw;
+        ok = ok && reader.readInto(false, address(memory.raw.data()), raw);
+
+        uint8_t bytes[4];
+        ok = ok && reader.readInto(false, address(&memory.sample.id), bytes, sizeof(bytes));
+
+        auto offset = reader.getOffset(MemoryOffset::RemoteServerName);
+        ok = ok && offset.has_value();
+    }
+}
+
+TEST(MemReader_readsLocalMemory) {
+    MemReader& reader = MemReader::getInstance();
+    Memory memory;
+    for (size_t i = 0; i < memory.raw.size(); ++i) memory.raw[i] = static_cast<uint8_t>(i * 3);
+
+    auto sample = reader.read<Sample>(false, address(&memory.sample));
+    REQUIRE(sample.has_value());
+    CHECK_EQ(sample->id, 7u);
+    CHECK_EQ(sample->speed, 91.5f);
+    CHECK_EQ(sample->ping, 42);
+
+    auto name = reader.readString<32>(false, address(memory.name));
+    CHECK_EQ(std::string(name.c_str()), std::string("Sunday Practice"));
+
+    // All N bytes when the game's buffer isn't terminated within them
+    auto truncated = reader.readString<8>(false, address(memory.unterminated));
+    CHECK_EQ(std::string(truncated.c_str()), std::string("ABCDEFGH"));
+
+    std::array<uint8_t, 16> raw{};
+    CHECK(reader.readInto(false, address(memory.raw.data()), raw));
+    CHECK(raw == memory.raw);
+}
+
+TEST(MemReader_offsetsFallBackToConfigOnlyWhenNotScannable) {
+    MemReader& reader = MemReader::getInstance();
+    reader.refreshOffsets();
+
+    // Nothing vouches for scannable offsets without initialize()
+    CHECK(!reader.getOffset(MemoryOffset::LocalServerName));
+    CHECK(!reader.getOffset(MemoryOffset::RemoteServerSockaddr));
+    CHECK(!reader.isMemoryAvailable());
+
+    auto name = reader.getOffset(MemoryOffset::RemoteServerName);
+    REQUIRE(name.has_value());
+    CHECK_EQ(*name, ConfigManager::getInstance().getValue<unsigned long>("remote_server_name_offset"));
+}
+
+// The reads the handlers and the memory watcher make must not allocate
+TEST(MemReader_readsDoNotAllocate) {
+    MemReader& reader = MemReader::getInstance();
+    reader.refreshOffsets();
+    Memory memory;
+
+    bool ok = true;
+    readAll(reader, memory, ok);     // warm up
+    REQUIRE(ok);
+
+    const uint64_t before = AllocationCounter::threadAllocations();
+    {
+        STEADY_STATE_SCOPE("memory reads");
+        for (int i = 0; i < 100; ++i) {
+            readAll(reader, memory, ok);
+        }
+    }
+    CHECK(ok);
+    CHECK_EQ(AllocationCounter::threadAllocations() - before, 0u);
+}
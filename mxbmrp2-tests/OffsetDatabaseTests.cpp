@@ -0,0 +1,116 @@
+
+// OffsetDatabaseTests.cpp
+
+#include "pch.h"
+
+#include <fstream>
+
+#include "Test.h"
+#include "OffsetDatabase.h"
+
+using namespace OffsetDatabase;
+using OffsetScanner::BuildFingerprint;
+using OffsetScanner::Cache;
+using OffsetScanner::OffsetMap;
+
+namespace {
+    const BuildFingerprint RUNNING = { 0x5F3A1C22, 0x01A4F000 };
+    const BuildFingerprint PREVIOUS = { 0x5E000000, 0x01A40000 };
+
+    // mxbmrp2.ini with its defaults, as MemReader passes it in
+    OffsetMap configuredDefaults() {
+        OffsetMap configured;
+        for (const auto& entry : REFERENCE_BUILD.offsets) {
+            configured[entry.key] = entry.value;
+        }
+        OffsetMap scannable;
+        for (const auto& key : OffsetScanner::SCANNABLE_OFFSETS) {
+            scannable[key] = configured.at(key);
+        }
+        return scannable;
+    }
+
+    Cache cacheFor(const BuildFingerprint& build, bool withSignatures) {
+        Cache cache;
+        cache.build = build;
+        cache.reference = true;
+        cache.offsets = { { "local_server_name_offset", 0x9D7768 } };
+        if (withSignatures) {
+            cache.signatures["local_server_name_offset"] =
+                *OffsetScanner::Signature::parse("48 8D 0D ?? ?? ?? ?? E8|3|7");
+        }
+        return cache;
+    }
+}
+
+// A fresh install: no override file and no offsets cache
+TEST(OffsetDatabase_firstStartUsesConfiguredOffsets) {
+    const auto overrides = loadOverrides(Test::scratchDir() / "mxbmrp2-offsets.ini", RUNNING);
+    CHECK(overrides.offsets.empty());
+    CHECK(!overrides.useConfigured);
+
+    const OffsetMap configured = configuredDefaults();
+    auto selection = selectForBuild(RUNNING, overrides, std::nullopt, configured, "mxbmrp2-offsets.ini");
+
+    CHECK(selection.buildOffsets == configured);
+    CHECK(selection.trusted == configured);
+    CHECK(selection.discover);
+    CHECK(!selection.cache);
+    CHECK_EQ(selection.buildOffsets.at("local_server_name_offset"), 0x9D6768ul);
+    CHECK_EQ(selection.buildOffsets.at("remote_server_sockaddr_offset"), 0x58B2BCul);
+}
+
+TEST(OffsetDatabase_firstStartKeepsOverrides) {
+    const auto path = Test::scratchDir() / "mxbmrp2-offsets.ini";
+    std::ofstream(path) << "[" << RUNNING.toString() << "]\nremote_server_ping_offset = 0x58B540\n";
+    const auto overrides = loadOverrides(path, RUNNING);
+    REQUIRE(overrides.offsets.size() == 1u);
+
+    auto selection = selectForBuild(RUNNING, overrides, std::nullopt, configuredDefaults(), "mxbmrp2-offsets.ini");
+    CHECK_EQ(selection.trusted.at("remote_server_ping_offset"), 0x58B540ul);
+    CHECK_EQ(selection.trusted.at("local_server_name_offset"), 0x9D6768ul);
+    CHECK(selection.buildOffsets.count("remote_server_ping_offset") == 0);
+    CHECK(selection.discover);
+}
+
+// Written by a version that saved no offsets: the same as no cache
+TEST(OffsetDatabase_unverifiedCacheCountsAsFirstStart) {
+    Cache legacy = cacheFor(PREVIOUS, true);
+    legacy.offsets.clear();
+
+    auto selection = selectForBuild(RUNNING, {}, legacy, configuredDefaults(), "mxbmrp2-offsets.ini");
+    CHECK(selection.buildOffsets == configuredDefaults());
+    CHECK(selection.discover);
+    CHECK(!selection.cache);
+}
+
+TEST(OffsetDatabase_laterStartUsesCache) {
+    auto selection = selectForBuild(RUNNING, {}, cacheFor(RUNNING, true), configuredDefaults(), "mxbmrp2-offsets.ini");
+    REQUIRE(selection.buildOffsets.size() == 1u);
+    CHECK_EQ(selection.buildOffsets.at("local_server_name_offset"), 0x9D7768ul);
+    CHECK(!selection.discover);
+}
+
+// After a game update only the signatures are trusted, not mxbmrp2.ini
+TEST(OffsetDatabase_changedBuildRelocates) {
+    auto selection = selectForBuild(RUNNING, {}, cacheFor(PREVIOUS, true), configuredDefaults(), "mxbmrp2-offsets.ini");
+    CHECK(selection.buildOffsets.empty());
+    CHECK(selection.trusted.empty());
+    CHECK(selection.discover);
+    REQUIRE(selection.cache.has_value());
+    CHECK(selection.cache->build == PREVIOUS);
+
+    auto noSignatures = selectForBuild(RUNNING, {}, cacheFor(PREVIOUS, false), configuredDefaults(), "mxbmrp2-offsets.ini");
+    CHECK(noSignatures.buildOffsets.empty());
+    CHECK(!noSignatures.discover);
+}
+
+TEST(OffsetDatabase_useConfiguredVouchesOnChangedBuild) {
+    Overrides overrides;
+    overrides.useConfigured = true;
+
+    auto selection = selectForBuild(RUNNING, overrides, cacheFor(PREVIOUS, true), configuredDefaults(), "mxbmrp2-offsets.ini");
+    CHECK(selection.trusted == configuredDefaults());
+    CHECK(selection.buildOffsets.empty());     // published from mxbmrp2.ini directly
+    CHECK(selection.discover);
+}
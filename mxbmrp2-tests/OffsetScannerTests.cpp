@@ -0,0 +1,292 @@
+
+// OffsetScannerTests.cpp
+
+#include "pch.h"
+
+#include <atomic>
+#include <cstring>
+
+#include "Test.h"
+#include "OffsetScanner.h"
+
+using namespace OffsetScanner;
+
+namespace {
+    constexpr uintptr_t IMAGE_BASE = 0x140000000;
+    constexpr uintptr_t CODE_RVA = 0x1000;
+
+    // One instruction with a [rip+disp32] operand
+    struct Reference {
+        std::vector<uint8_t> opcode;    // up to and including ModRM
+        size_t immediateSize;
+        const char* key;
+    };
+
+    const Reference REFERENCES[] = {
+        { { 0x48, 0x8D, 0x0D }, 0, "local_server_name_offset" },         // lea rcx, [rip+d]
+        { { 0x0F, 0xB7, 0x05 }, 0, "remote_server_sockaddr_offset" },    // movzx eax, word [rip+d]
+        { { 0x83, 0x3D }, 1, "remote_server_ping_offset" },              // cmp dword [rip+d], imm8
+        { { 0xC7, 0x05 }, 4, "track_deformation_offset" },               // mov dword [rip+d], imm32
+    };
+
+    const OffsetMap DATA_V1 = {
+        { "local_server_name_offset", 0x9D6768 },
+        { "remote_server_sockaddr_offset", 0x58B2BC },
+        { "remote_server_ping_offset", 0x58B534 },
+        { "track_deformation_offset", 0x58B708 },
+    };
+
+    // A build of the executable's code: filler, then each reference followed
+    // by a call whose target differs between builds
+    struct Build {
+        size_t codeShift = 0;           // bytes inserted before the first reference
+        uintptr_t dataShift = 0;        // added to every data offset
+        uint32_t callSalt = 0;          // changes every call's rel32
+        size_t copies = 1;              // times the first reference is emitted
+    };
+
+    // Filler that is the same in every build, so only what a Build changes moves
+    std::vector<uint8_t> filler(uint32_t seed, size_t size) {
+        std::vector<uint8_t> out(size);
+        uint32_t x = seed * 2654435761u + 1;
+        for (auto& b : out) {
+            x = x * 1664525u + 1013904223u;
+            b = static_cast<uint8_t>(x >> 24);
+        }
+        return out;
+    }
+
+    void append(std::vector<uint8_t>& code, const void* data, size_t size) {
+        const auto* p = static_cast<const uint8_t*>(data);
+        code.insert(code.end(), p, p + size);
+    }
+
+    void emitReference(std::vector<uint8_t>& code, const Reference& ref, uintptr_t target, uint32_t callSalt) {
+        append(code, ref.opcode.data(), ref.opcode.size());
+        const uintptr_t rip = IMAGE_BASE + CODE_RVA + code.size() + 4 + ref.immediateSize;
+        const int32_t disp = static_cast<int32_t>(static_cast<intptr_t>(target - rip));
+        append(code, &disp, sizeof(disp));
+        const std::vector<uint8_t> imm(ref.immediateSize, 0x01);
+        append(code, imm.data(), imm.size());
+
+        // call rel32, then test eax, eax
+        code.push_back(0xE8);
+        const uint32_t rel = 0x00012340 + callSalt;
+        append(code, &rel, sizeof(rel));
+        const uint8_t test[] = { 0x85, 0xC0 };
+        append(code, test, sizeof(test));
+    }
+
+    CodeSection buildSection(const Build& build) {
+        CodeSection section;
+        section.address = IMAGE_BASE + CODE_RVA;
+        std::vector<uint8_t>& code = section.bytes;
+
+        const auto shift = filler(99, build.codeShift);
+        append(code, shift.data(), shift.size());
+
+        uint32_t seed = 1;
+        for (const Reference& ref : REFERENCES) {
+            const size_t copies = &ref == &REFERENCES[0] ? build.copies : 1;
+            for (size_t i = 0; i < copies; ++i) {
+                // Copies only differ in their displacement
+                const auto before = filler(seed, 48);
+                const auto tail = filler(seed + 500, 48);
+                append(code, before.data(), before.size());
+                emitReference(code, ref, IMAGE_BASE + DATA_V1.at(ref.key) + build.dataShift, build.callSalt);
+                append(code, tail.data(), tail.size());
+            }
+            const auto after = filler(seed + 1000, 48);
+            append(code, after.data(), after.size());
+            ++seed;
+        }
+        return section;
+    }
+
+    std::atomic<bool> g_noCancel{ false };
+}
+
+TEST(OffsetScanner_fingerprintRoundTrip) {
+    BuildFingerprint fp;
+    fp.timeDateStamp = 0x5F3A1C22;
+    fp.sizeOfImage = 0x01A4F000;
+    CHECK_EQ(fp.toString(), std::string("5F3A1C22-01A4F000"));
+
+    auto parsed = BuildFingerprint::parse(fp.toString());
+    REQUIRE(parsed.has_value());
+    CHECK(*parsed == fp);
+
+    CHECK(!BuildFingerprint::parse("5F3A1C22").has_value());
+    CHECK(!BuildFingerprint::parse("5F3A1C22-01A4F00G").has_value());
+    CHECK(!BuildFingerprint::parse("-").has_value());
+}
+
+TEST(OffsetScanner_signatureRoundTrip) {
+    const std::string text = "48 8B 05 ?? ?? ?? ?? E8 ?? ?? ?? ?? 85 C0|3|7";
+    auto sig = Signature::parse(text);
+    REQUIRE(sig.has_value());
+    CHECK_EQ(sig->bytes.size(), size_t(14));
+    CHECK_EQ(sig->dispPos, size_t(3));
+    CHECK_EQ(sig->nextInstrPos, size_t(7));
+    CHECK_EQ(int(sig->mask[3]), 0);
+    CHECK_EQ(int(sig->bytes[12]), 0x85);
+    CHECK_EQ(sig->toString(), text);
+
+    auto again = Signature::parse(sig->toString());
+    REQUIRE(again.has_value());
+    CHECK(again->bytes == sig->bytes && again->mask == sig->mask);
+}
+
+TEST(OffsetScanner_signatureRejectsMalformed) {
+    CHECK(!Signature::parse("48 8B 05 ?? ?? ?? ??").has_value());          // no positions
+    CHECK(!Signature::parse("48 8B 05 ?? ?? ?? ??|3").has_value());
+    CHECK(!Signature::parse("48 8B 05 ?? ?? ??|3|7").has_value());         // disp32 past the end
+    CHECK(!Signature::parse("48 8B 05 ?? ?? ?? ??|3|5").has_value());      // RIP inside the disp32
+    CHECK(!Signature::parse("?? ?? ?? ?? ?? ?? ??|3|7").has_value());      // nothing to anchor on
+    CHECK(!Signature::parse("48 8G 05 ?? ?? ?? ??|3|7").has_value());
+    CHECK(!Signature::parse("48 180 05 ?? ?? ?? ??|3|7").has_value());
+    CHECK(!Signature::parse("48 8B 05 ?? ?? ?? ??|x|7").has_value());
+}
+
+TEST(OffsetScanner_findPatternWildcards) {
+    const uint8_t data[] = { 0xAA, 0xBB, 0xCC, 0xAA, 0xBB, 0xDD, 0xAA, 0x11, 0xCC, 0xAA };
+
+    Signature sig;
+    sig.bytes = { 0xAA, 0x00, 0xCC };
+    sig.mask = { 1, 0, 1 };
+
+    auto all = findPattern(data, sizeof(data), sig, 10);
+    REQUIRE(all.size() == 2);
+    CHECK_EQ(all[0], size_t(0));
+    CHECK_EQ(all[1], size_t(6));
+
+    // Stops at maxMatches
+    auto first = findPattern(data, sizeof(data), sig, 1);
+    REQUIRE(first.size() == 1);
+    CHECK_EQ(first[0], size_t(0));
+    CHECK(findPattern(data, sizeof(data), sig, 0).empty());
+
+    // Leading wildcard: anchors on the first concrete byte
+    Signature leading;
+    leading.bytes = { 0x00, 0xBB };
+    leading.mask = { 0, 1 };
+    auto bb = findPattern(data, sizeof(data), leading, 10);
+    REQUIRE(bb.size() == 2);
+    CHECK_EQ(bb[0], size_t(0));
+    CHECK_EQ(bb[1], size_t(3));
+
+    // A match may end on the last byte, but not run past it
+    Signature tail;
+    tail.bytes = { 0xCC, 0xAA };
+    tail.mask = { 1, 1 };
+    auto end = findPattern(data, sizeof(data), tail, 10);
+    REQUIRE(end.size() == 2);
+    CHECK_EQ(end[1], size_t(8));
+    tail.bytes = { 0xAA, 0x00 };
+    tail.mask = { 1, 0 };
+    CHECK_EQ(findPattern(data, sizeof(data), tail, 10).size(), size_t(3));
+
+    CHECK(findPattern(data, 2, sig, 10).empty());
+}
+
+TEST(OffsetScanner_learnThenResolveAcrossBuilds) {
+    const std::vector<CodeSection> v1 = { buildSection({}) };
+    auto signatures = learnSignatures(v1, IMAGE_BASE, DATA_V1, g_noCancel);
+    CHECK_EQ(signatures.size(), DATA_V1.size());
+
+    // The learned signatures resolve the build they came from...
+    auto same = resolveOffsets(v1, IMAGE_BASE, signatures, g_noCancel);
+    for (const auto& [key, offset] : DATA_V1) {
+        CHECK_EQ(same[key], offset);
+    }
+
+    // ...and one where the code moved, the data moved and calls changed
+    Build updated;
+    updated.codeShift = 0x123;
+    updated.dataShift = 0x40;
+    updated.callSalt = 0x777;
+    const std::vector<CodeSection> v2 = { buildSection(updated) };
+    auto moved = resolveOffsets(v2, IMAGE_BASE, signatures, g_noCancel);
+    CHECK_EQ(moved.size(), DATA_V1.size());
+    for (const auto& [key, offset] : DATA_V1) {
+        CHECK_EQ(moved[key], offset + 0x40);
+    }
+}
+
+TEST(OffsetScanner_learnSkipsOffsetsWithoutUniqueReference) {
+    // The first offset is only referenced from two identical places
+    Build duplicated;
+    duplicated.copies = 2;
+    const std::vector<CodeSection> sections = { buildSection(duplicated) };
+
+    auto signatures = learnSignatures(sections, IMAGE_BASE, DATA_V1, g_noCancel);
+    CHECK(signatures.count("local_server_name_offset") == 0);
+    CHECK_EQ(signatures.size(), DATA_V1.size() - 1);
+}
+
+TEST(OffsetScanner_resolveSkipsSignaturesMatchingTwice) {
+    const std::vector<CodeSection> v1 = { buildSection({}) };
+    auto signatures = learnSignatures(v1, IMAGE_BASE, DATA_V1, g_noCancel);
+    REQUIRE(signatures.count("local_server_name_offset") == 1);
+
+    // In the next build the same code appears twice: ambiguous, so dropped
+    Build duplicated;
+    duplicated.copies = 2;
+    duplicated.codeShift = 0x10;
+    const std::vector<CodeSection> v2 = { buildSection(duplicated) };
+    auto resolved = resolveOffsets(v2, IMAGE_BASE, signatures, g_noCancel);
+    CHECK(resolved.count("local_server_name_offset") == 0);
+    CHECK_EQ(resolved.size(), DATA_V1.size() - 1);
+}
+
+TEST(OffsetScanner_cacheRoundTrip) {
+    Cache cache;
+    cache.build.timeDateStamp = 0x5F3A1C22;
+    cache.build.sizeOfImage = 0x01A4F000;
+    cache.reference = true;
+    cache.offsets = DATA_V1;
+    cache.signatures = learnSignatures({ buildSection({}) }, IMAGE_BASE, DATA_V1, g_noCancel);
+    REQUIRE(cache.signatures.size() == DATA_V1.size());
+
+    const auto path = Test::scratchDir() / "mxbmrp2-offsets.cache";
+    saveCache(path, cache);
+    CHECK(!std::filesystem::exists(path.string() + ".tmp"));
+
+    auto loaded = loadCache(path);
+    REQUIRE(loaded.has_value());
+    CHECK(loaded->build == cache.build);
+    CHECK(loaded->reference);
+    CHECK(loaded->offsets == cache.offsets);
+    REQUIRE(loaded->signatures.size() == cache.signatures.size());
+    for (const auto& [key, sig] : cache.signatures) {
+        CHECK_EQ(loaded->signatures.at(key).toString(), sig.toString());
+    }
+}
+
+TEST(OffsetScanner_cacheFixtures) {
+    auto valid = loadCache(Test::fixture("offsets-valid.cache"));
+    REQUIRE(valid.has_value());
+    CHECK_EQ(valid->build.toString(), std::string("5F3A1C22-01A4F000"));
+    CHECK(valid->reference);
+    CHECK_EQ(valid->offsets.size(), size_t(2));
+    CHECK_EQ(valid->offsets["remote_server_sockaddr_offset"], 0x58B2BCul);
+    CHECK_EQ(valid->signatures.size(), size_t(2));
+
+    // Cut off in the middle of the last line: what's complete is kept
+    auto truncated = loadCache(Test::fixture("offsets-truncated.cache"));
+    REQUIRE(truncated.has_value());
+    CHECK(!truncated->reference);
+    CHECK_EQ(truncated->offsets.size(), size_t(2));
+    CHECK_EQ(truncated->signatures.size(), size_t(1));
+    CHECK(truncated->signatures.count("remote_server_sockaddr_offset") == 0);
+
+    // No readable build line: not a cache
+    CHECK(!loadCache(Test::fixture("offsets-corrupt.cache")).has_value());
+    CHECK(!loadCache(Test::fixture("missing.cache")).has_value());
+
+    // Written before `source` existed, by a first run that saved no offsets
+    auto legacy = loadCache(Test::fixture("offsets-legacy.cache"));
+    REQUIRE(legacy.has_value());
+    CHECK(legacy->offsets.empty());
+    CHECK(legacy->reference);
+}
@@ -0,0 +1,290 @@
+
+// RegionMapTests.cpp
+
+#include "pch.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <utility>
+
+#include "Test.h"
+#include "RegionMap.h"
+
+namespace {
+    // Regions of a pretend process; the test changes them between refreshes
+    struct FakeProcess {
+        std::vector<MemoryRegion> regions;
+        std::vector<std::pair<uintptr_t, uintptr_t>> queries;   // every enumerate() range
+        int refreshes = 0;              // beginRefresh() calls
+        bool refreshing = false;
+        bool queriedOutsideRefresh = false;
+
+        void add(uintptr_t base, size_t size) {
+            regions.push_back({ base, size, 0 });
+            std::sort(regions.begin(), regions.end(),
+                [](const MemoryRegion& a, const MemoryRegion& b) { return a.base < b.base; });
+        }
+
+        void remove(uintptr_t base) {
+            regions.erase(std::remove_if(regions.begin(), regions.end(),
+                [&](const MemoryRegion& r) { return r.base == base; }), regions.end());
+        }
+
+        void resize(uintptr_t base, size_t size) {
+            for (auto& r : regions) {
+                if (r.base == base) r.size = size;
+            }
+        }
+    };
+
+    class FakeRegionSource : public RegionSource {
+    public:
+        explicit FakeRegionSource(FakeProcess& process) : process_(process) {}
+
+        uintptr_t minAddress() const override { return 0x10000; }
+        uintptr_t maxAddress() const override { return 0x100000; }
+
+        void beginRefresh() override {
+            ++process_.refreshes;
+            process_.refreshing = true;
+        }
+
+        void endRefresh() override {
+            process_.refreshing = false;
+        }
+
+        void enumerate(uintptr_t begin, uintptr_t end, std::vector<MemoryRegion>& out) override {
+            process_.queries.emplace_back(begin, end);
+            process_.queriedOutsideRefresh |= !process_.refreshing;
+            for (const auto& r : process_.regions) {
+                if (r.base >= begin && r.base < end) out.push_back(r);
+            }
+        }
+
+    private:
+        FakeProcess& process_;
+    };
+
+    RegionMap makeMap(FakeProcess& process, std::chrono::milliseconds rescanInterval = std::chrono::hours(1)) {
+        return RegionMap(std::make_unique<FakeRegionSource>(process), rescanInterval);
+    }
+
+    const MemoryRegion* findBase(const RegionMap::Snapshot& map, uintptr_t base) {
+        for (const auto& r : map.regions) {
+            if (r.base == base) return &r;
+        }
+        return nullptr;
+    }
+
+    bool queried(const FakeProcess& process, uintptr_t begin, uintptr_t end) {
+        return std::find(process.queries.begin(), process.queries.end(), std::make_pair(begin, end))
+            != process.queries.end();
+    }
+}
+
+// Captured from a Linux process, plus a thread stack, its guard page and a shared mapping
+TEST(RegionMap_parseProcMapsKeepsAnonymousPrivateReadWrite) {
+    std::ifstream in(Test::fixture("proc-self-maps.txt"));
+    REQUIRE(in.is_open());
+
+    std::vector<MemoryRegion> regions;
+    parseProcMaps(in, 0, UINTPTR_MAX, regions);
+
+    // File-backed rw-p (.data of cat, libc, ld.so), rw-s, ---p, [vvar] and
+    // the code mappings are all left out
+    const std::pair<uintptr_t, uintptr_t> expected[] = {
+        { 0x5576b5904000, 0x5576b5925000 },     // [heap]
+        { 0x7fe722e93000, 0x7fe723693000 },     // thread stack
+        { 0x7fe723e93000, 0x7fe723eb8000 },
+        { 0x7fe72408d000, 0x7fe72409a000 },
+        { 0x7fe7240a7000, 0x7fe7240a9000 },
+        { 0x7fffcc907000, 0x7fffcc928000 },     // [stack]
+    };
+    REQUIRE(regions.size() == std::size(expected));
+    for (size_t i = 0; i < regions.size(); ++i) {
+        CHECK_EQ(regions[i].base, expected[i].first);
+        CHECK_EQ(regions[i].end(), expected[i].second);
+        CHECK_EQ(regions[i].generation, 0u);
+    }
+}
+
+TEST(RegionMap_parseProcMapsFiltersByStart) {
+    std::ifstream in(Test::fixture("proc-self-maps.txt"));
+    REQUIRE(in.is_open());
+
+    // Regions that start in [begin, end) only, wherever they end
+    std::vector<MemoryRegion> regions;
+    parseProcMaps(in, 0x7fe723000000, 0x7fe7240a7000, regions);
+    REQUIRE(regions.size() == 2u);
+    CHECK_EQ(regions[0].base, uintptr_t(0x7fe723e93000));
+    CHECK_EQ(regions[1].base, uintptr_t(0x7fe72408d000));
+}
+
+TEST(RegionMap_parseProcMapsSkipsMalformedLines) {
+    std::istringstream in(
+        "\n"
+        "not a maps line\n"
+        "7fe7240a7000 rw-p 00000000 00:00 0\n"              // no dash
+        "zz-7fe7240a9000 rw-p 00000000 00:00 0\n"           // not hex
+        "7fe7240a9000-7fe7240a7000 rw-p 00000000 00:00 0\n" // ends before it starts
+        "7fe7240a7000-7fe7240a9000 rw-p 00000000 00:00\n"   // no inode
+        "7fe72408d000-7fe72409a000 rw-p 00000000 00:00 0\n");
+
+    std::vector<MemoryRegion> regions;
+    parseProcMaps(in, 0, UINTPTR_MAX, regions);
+    REQUIRE(regions.size() == 1u);
+    CHECK_EQ(regions[0].base, uintptr_t(0x7fe72408d000));
+}
+
+TEST(RegionMap_firstRefreshScansEverything) {
+    FakeProcess process;
+    process.add(0x20000, 0x1000);
+    process.add(0x40000, 0x2000);
+    RegionMap map = makeMap(process);
+
+    CHECK(map.snapshot()->regions.empty());
+
+    auto snapshot = map.refresh();
+    CHECK_EQ(snapshot->generation, 1u);
+    REQUIRE(snapshot->regions.size() == 2u);
+    CHECK_EQ(snapshot->regions[0].generation, 1u);
+    CHECK_EQ(snapshot->regions[1].generation, 1u);
+    CHECK(queried(process, 0x10000, 0x100000));
+    CHECK(map.snapshot() == snapshot);
+}
+
+TEST(RegionMap_unchangedRefreshKeepsSnapshot) {
+    FakeProcess process;
+    process.add(0x20000, 0x1000);
+    process.add(0x40000, 0x2000);
+    RegionMap map = makeMap(process);
+    auto first = map.refresh();
+
+    // Within the rescan interval only the known regions are queried
+    process.queries.clear();
+    auto second = map.refresh();
+    CHECK(second == first);
+    REQUIRE(process.queries.size() == 2u);
+    CHECK(queried(process, 0x20000, 0x21000));
+    CHECK(queried(process, 0x40000, 0x42000));
+
+    // A gap walk that finds nothing new doesn't make a new generation either
+    auto third = map.refresh(true);
+    CHECK(third == first);
+}
+
+TEST(RegionMap_newRegionsOnlyFoundByGapRescan) {
+    FakeProcess process;
+    process.add(0x20000, 0x1000);
+    process.add(0x40000, 0x2000);
+    RegionMap map = makeMap(process);
+    auto first = map.refresh();
+
+    process.add(0x30000, 0x1000);
+    process.add(0x80000, 0x4000);
+    CHECK(map.refresh() == first);
+
+    process.queries.clear();
+    auto rescanned = map.refresh(true);
+    CHECK_EQ(rescanned->generation, 2u);
+    REQUIRE(rescanned->regions.size() == 4u);
+
+    // The gaps around the known regions, up to maxAddress
+    CHECK(queried(process, 0x10000, 0x20000));
+    CHECK(queried(process, 0x21000, 0x40000));
+    CHECK(queried(process, 0x42000, 0x100000));
+
+    // Regions already known keep the generation they were first seen in
+    CHECK_EQ(findBase(*rescanned, 0x20000)->generation, 1u);
+    CHECK_EQ(findBase(*rescanned, 0x30000)->generation, 2u);
+    CHECK_EQ(findBase(*rescanned, 0x40000)->generation, 1u);
+    CHECK_EQ(findBase(*rescanned, 0x80000)->generation, 2u);
+
+    // The old snapshot is untouched for scans still holding it
+    CHECK_EQ(first->generation, 1u);
+    CHECK_EQ(first->regions.size(), 2u);
+}
+
+TEST(RegionMap_changedRegionsGetNewGeneration) {
+    FakeProcess process;
+    process.add(0x20000, 0x1000);
+    process.add(0x40000, 0x2000);
+    process.add(0x60000, 0x1000);
+    RegionMap map = makeMap(process);
+    map.refresh();
+
+    process.resize(0x40000, 0x8000);
+    process.remove(0x60000);
+    auto snapshot = map.refresh();
+    CHECK_EQ(snapshot->generation, 2u);
+    REQUIRE(snapshot->regions.size() == 2u);
+    CHECK_EQ(findBase(*snapshot, 0x20000)->generation, 1u);
+
+    const MemoryRegion* grown = findBase(*snapshot, 0x40000);
+    REQUIRE(grown != nullptr);
+    CHECK_EQ(grown->size, size_t(0x8000));
+    CHECK_EQ(grown->generation, 2u);
+    CHECK(findBase(*snapshot, 0x60000) == nullptr);
+}
+
+TEST(RegionMap_rescanIntervalForcesGapWalk) {
+    FakeProcess process;
+    process.add(0x20000, 0x1000);
+    RegionMap map = makeMap(process, std::chrono::milliseconds(0));
+    map.refresh();
+
+    process.add(0x50000, 0x1000);
+    auto snapshot = map.refresh();
+    CHECK_EQ(snapshot->generation, 2u);
+    CHECK_EQ(snapshot->regions.size(), 2u);
+}
+
+TEST(RegionMap_invalidateStartsOver) {
+    FakeProcess process;
+    process.add(0x20000, 0x1000);
+    RegionMap map = makeMap(process);
+    map.refresh();
+
+    map.invalidate();
+    CHECK(map.snapshot()->regions.empty());
+    CHECK_EQ(map.snapshot()->generation, 2u);
+
+    // An empty map always walks everything
+    process.add(0x50000, 0x1000);
+    auto snapshot = map.refresh();
+    CHECK_EQ(snapshot->generation, 3u);
+    REQUIRE(snapshot->regions.size() == 2u);
+    CHECK_EQ(snapshot->regions[0].generation, 3u);
+}
+
+// Every query of a refresh comes between one beginRefresh and endRefresh
+TEST(RegionMap_refreshBracketsQueries) {
+    FakeProcess process;
+    process.add(0x20000, 0x1000);
+    process.add(0x40000, 0x2000);
+    RegionMap map = makeMap(process);
+
+    map.refresh();
+    CHECK_EQ(process.refreshes, 1);
+    map.refresh(true);
+    CHECK_EQ(process.refreshes, 2);
+    CHECK(process.queries.size() > 2u);
+    CHECK(!process.refreshing);
+    CHECK(!process.queriedOutsideRefresh);
+}
+
+// The real source, reading the process's map once per refresh
+TEST(RegionMap_processSourceFindsLargeAllocation) {
+    std::vector<uint8_t> buffer(8 * 1024 * 1024, 1);
+    const uintptr_t address = reinterpret_cast<uintptr_t>(buffer.data());
+
+    RegionMap map(createProcessRegionSource());
+    for (int i = 0; i < 2; ++i) {
+        auto snapshot = map.refresh(i == 1);
+        const bool found = std::any_of(snapshot->regions.begin(), snapshot->regions.end(),
+            [&](const MemoryRegion& r) { return r.base <= address && address < r.end(); });
+        CHECK(found);
+    }
+}
@@ -0,0 +1,98 @@
+
+// ServerRosterTests.cpp
+
+#include "pch.h"
+
+#include <cstring>
+
+#include "Test.h"
+#include "Arena.h"
+#include "ServerRoster.h"
+
+namespace {
+    using Block = std::array<uint8_t, SIZE_SERVER_CLIENTS>;
+
+    void setName(Block& block, size_t slot, const char* name) {
+        uint8_t* at = block.data() + slot * SIZE_SERVER_CLIENTS_BLOCK;
+        std::memset(at, 0, SIZE_SERVER_CLIENTS_BLOCK);
+        std::memcpy(at, name, std::strlen(name));
+    }
+}
+
+// Every byte of a slot is compared, whichever 16-byte lane it falls in
+TEST(ServerRoster_diffSlotsSeesEveryLane) {
+    const Block zero{};
+    for (size_t slot : { size_t(0), size_t(17), ServerRoster::SLOT_COUNT - 1 }) {
+        for (size_t lane = 0; lane < 4; ++lane) {
+            for (size_t byte : { size_t(0), size_t(15) }) {
+                Block changed{};
+                changed[slot * SIZE_SERVER_CLIENTS_BLOCK + lane * 16 + byte] = 0x01;
+                CHECK_EQ(ServerRoster::diffSlots(zero.data(), changed.data()), uint64_t{ 1 } << slot);
+            }
+        }
+    }
+    CHECK_EQ(ServerRoster::diffSlots(zero.data(), zero.data()), uint64_t{ 0 });
+}
+
+// A byte past the name's terminator isn't a roster change
+TEST(ServerRoster_ignoresBytesAfterTheName) {
+    Block before{};
+    setName(before, 3, "Rider A");
+    Block after = before;
+    after[3 * SIZE_SERVER_CLIENTS_BLOCK + 40] = 0x7F;
+
+    CHECK_EQ(ServerRoster::diffSlots(before.data(), after.data()), uint64_t{ 1 } << 3);
+    CHECK(!ServerRoster::namesDiffer(before.data(), after.data()));
+
+    ServerRoster roster;
+    CHECK(roster.update(before.data(), before.size()));
+    CHECK(!roster.update(after.data(), after.size()));
+    REQUIRE(roster.entries().size() == 1u);
+    CHECK_EQ(roster.entries()[0].name, std::string("Rider A"));
+
+    setName(after, 3, "Rider B");
+    CHECK(ServerRoster::namesDiffer(before.data(), after.data()));
+    CHECK(roster.update(after.data(), after.size()));
+    CHECK_EQ(roster.entries()[0].name, std::string("Rider B"));
+}
+
+// A name filling the whole slot has no terminator and stops at the slot's end
+TEST(ServerRoster_unterminatedNameStopsAtSlotEnd) {
+    Block block{};
+    std::memset(block.data() + 5 * SIZE_SERVER_CLIENTS_BLOCK, 'x', SIZE_SERVER_CLIENTS_BLOCK);
+    setName(block, 6, "Next");
+
+    ServerRoster roster;
+    CHECK(roster.update(block.data(), block.size()));
+    REQUIRE(roster.entries().size() == 2u);
+    CHECK_EQ(roster.entries()[0].slot, 5);
+    CHECK_EQ(roster.entries()[0].name, std::string(SIZE_SERVER_CLIENTS_BLOCK, 'x'));
+    CHECK_EQ(roster.entries()[1].name, std::string("Next"));
+}
+
+TEST(ServerRoster_countIncludesLocalPlayer) {
+    ServerRoster roster;
+    CHECK_EQ(roster.count(), 1);
+
+    Block block{};
+    setName(block, 0, "First");
+    setName(block, 9, "Second");
+    CHECK(roster.update(block.data(), block.size()));
+    CHECK_EQ(roster.count(), 3);
+
+    // Too short a read is ignored
+    CHECK(!roster.update(block.data(), block.size() - 1));
+
+    {
+        ArenaScope arena;
+        ServerRoster::View view(Arena::resource());
+        roster.copyEntries(view);
+        REQUIRE(view.size() == 2u);
+        CHECK_EQ(view[1].slot, 9);
+        CHECK(view[1].name == "Second");
+    }
+
+    roster.clear();
+    CHECK_EQ(roster.count(), 1);
+    CHECK(roster.entries().empty());
+}
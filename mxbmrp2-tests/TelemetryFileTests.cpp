@@ -0,0 +1,162 @@
+
+// TelemetryFileTests.cpp
+
+#include "pch.h"
+
+#include <cmath>
+
+#include "Test.h"
+#include "TelemetryFile.h"
+
+using namespace TelemetryFile;
+
+namespace {
+    Row makeRow(size_t i) {
+        const float t = static_cast<float>(i) * 0.01f;
+        Row row{};
+        row.time = 120.0f + t;
+        row.speed = 20.0f + 10.0f * std::sin(t);
+        row.rpm = 6000 + static_cast<int32_t>(i % 4000);
+        row.gear = static_cast<int32_t>(i / 1000) % 6;
+        row.throttle = 0.5f + 0.5f * std::sin(3.0f * t);
+        row.brake = 0.5f - 0.5f * std::sin(3.0f * t);
+        row.posX = -1500.0f + 300.0f * std::cos(t);
+        row.posY = 12.5f + std::sin(7.0f * t);
+        row.posZ = 800.0f + 300.0f * std::sin(t);
+        row.distance = std::fmod(static_cast<float>(i) * 0.25f, 1800.0f);
+        return row;
+    }
+
+    Info makeInfo() {
+        Info info;
+        info.trackId = "sim_track";
+        info.bikeId = "sim_bike";
+        info.trackLength = 1800.0f;
+        info.rateHz = 100;
+        return info;
+    }
+
+    bool near(float a, float b, float tolerance) {
+        return std::fabs(a - b) <= tolerance;
+    }
+}
+
+// Two laps across three chunks, read back to the stored precision
+TEST(TelemetryFile_roundTripWithinPrecision) {
+    const auto path = Test::scratchDir() / "run.mxbtel";
+    const size_t lapSamples = CHUNK_SAMPLES + 1000;
+
+    Writer writer;
+    REQUIRE(writer.open(path, makeInfo()));
+    for (size_t i = 0; i < 2 * lapSamples; ++i) {
+        if (i == lapSamples) writer.beginLap();
+        writer.append(makeRow(i));
+    }
+    CHECK_EQ(writer.close(), uint64_t(2 * lapSamples));
+
+    Reader reader;
+    REQUIRE(reader.open(path));
+    CHECK_EQ(reader.info().trackId, std::string("sim_track"));
+    CHECK_EQ(reader.info().rateHz, 100u);
+    REQUIRE(reader.laps().size() == 2u);
+    CHECK_EQ(reader.laps()[1].firstSample, uint64_t(lapSamples));
+
+    std::vector<Row> rows;
+    size_t mismatches = 0;
+    for (size_t lap = 0; lap < 2; ++lap) {
+        REQUIRE(reader.readLap(lap, rows));
+        REQUIRE(rows.size() == lapSamples);
+        for (size_t j = 0; j < rows.size(); ++j) {
+            const Row expected = makeRow(lap * lapSamples + j);
+            const Row& row = rows[j];
+            // Half a step, plus the float rounding of a value on a tie
+            const bool ok = near(row.time, expected.time, 0.0006f)
+                && near(row.speed, expected.speed, 0.006f)
+                && row.rpm == expected.rpm
+                && row.gear == expected.gear
+                && near(row.throttle, expected.throttle, 0.6f / 65535.0f)
+                && near(row.brake, expected.brake, 0.6f / 65535.0f)
+                && near(row.posX, expected.posX, 0.0006f)
+                && near(row.posY, expected.posY, 0.0006f)
+                && near(row.posZ, expected.posZ, 0.0006f)
+                && near(row.distance, expected.distance, 0.0006f);
+            if (!ok) ++mismatches;
+        }
+    }
+    CHECK_EQ(mismatches, size_t(0));
+}
+
+// Values outside a column's range are clamped, not wrapped
+TEST(TelemetryFile_clampsToColumnRange) {
+    const auto path = Test::scratchDir() / "extremes.mxbtel";
+
+    Row low{};
+    low.time = 1.0f;
+    low.speed = -3.0f;
+    low.rpm = -1;
+    low.gear = -200;
+    low.throttle = -0.5f;
+    low.brake = NAN;
+    low.posX = -1.0e7f;
+
+    Row high{};
+    high.time = 1.01f;
+    high.speed = 1000.0f;
+    high.rpm = 100000;
+    high.gear = 200;
+    high.throttle = 1.5f;
+    high.brake = 1.0f;
+    high.posX = 1.0e7f;
+
+    Writer writer;
+    REQUIRE(writer.open(path, makeInfo()));
+    writer.append(low);
+    writer.append(high);
+    writer.append(low);
+    writer.close();
+
+    Reader reader;
+    REQUIRE(reader.open(path));
+    std::vector<Row> rows;
+    REQUIRE(reader.readLap(0, rows));
+    REQUIRE(rows.size() == 3u);
+
+    CHECK_EQ(rows[0].speed, 0.0f);
+    CHECK_EQ(rows[0].rpm, 0);
+    CHECK_EQ(rows[0].gear, -128);
+    CHECK_EQ(rows[0].throttle, 0.0f);
+    CHECK_EQ(rows[0].brake, 0.0f);
+    CHECK(near(rows[0].posX, -2147483.648f, 0.5f));
+
+    CHECK(near(rows[1].speed, 655.35f, 0.005f));
+    CHECK_EQ(rows[1].rpm, 65535);
+    CHECK_EQ(rows[1].gear, 127);
+    CHECK_EQ(rows[1].throttle, 1.0f);
+    CHECK_EQ(rows[1].brake, 1.0f);
+    CHECK(near(rows[1].posX, 2147483.647f, 0.5f));
+
+    // Full-range jumps wrap within the column width and decode exactly
+    CHECK_EQ(rows[2].gear, -128);
+    CHECK_EQ(rows[2].rpm, 0);
+    CHECK(near(rows[2].posX, -2147483.648f, 0.5f));
+}
+
+TEST(TelemetryFile_rejectsOtherVersions) {
+    const auto path = Test::scratchDir() / "old.mxbtel";
+    {
+        Writer writer;
+        REQUIRE(writer.open(path, makeInfo()));
+        writer.append(makeRow(0));
+        writer.close();
+    }
+
+    // Version 1 stored every column as 32-bit floats
+    std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+    file.seekp(sizeof(MAGIC));
+    const uint32_t version = 1;
+    file.write(reinterpret_cast<const char*>(&version), sizeof(version));
+    file.close();
+
+    Reader reader;
+    CHECK(!reader.open(path));
+}
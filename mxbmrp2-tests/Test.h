@@ -0,0 +1,66 @@
+
+// Test.h
+
+#pragma once
+
+#include <cstdio>
+#include <filesystem>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Minimal test registry for mxbmrp2-tests. A test is a function declared
+// with TEST; CHECK and CHECK_EQ record a failure and carry on, REQUIRE
+// stops the test.
+//
+//   TEST(OffsetScanner_findPattern) {
+//       CHECK_EQ(matches.size(), 2u);
+//   }
+namespace Test {
+
+    struct Case {
+        const char* name;
+        void (*run)();
+    };
+
+    std::vector<Case>& cases();
+
+    struct Registrar {
+        Registrar(const char* name, void (*run)()) { cases().push_back({ name, run }); }
+    };
+
+    // Thrown by REQUIRE to end the current test
+    struct Abort {};
+
+    void fail(const char* file, int line, const std::string& message);
+
+    // Checked-in test data (mxbmrp2-tests/fixtures)
+    std::filesystem::path fixture(const std::string& name);
+
+    // Empty scratch directory for the current test
+    std::filesystem::path scratchDir();
+
+    template <typename A, typename B>
+    bool checkEqual(const A& a, const B& b, const char* expr, const char* file, int line) {
+        if (a == b) return true;
+        std::ostringstream message;
+        message << expr << " (" << a << " != " << b << ")";
+        fail(file, line, message.str());
+        return false;
+    }
+
+} // namespace Test
+
+#define TEST(name) \
+    static void name(); \
+    static const Test::Registrar name##_registrar(#name, name); \
+    static void name()
+
+#define CHECK(cond) \
+    ((cond) ? true : (Test::fail(__FILE__, __LINE__, #cond), false))
+
+#define CHECK_EQ(a, b) \
+    Test::checkEqual((a), (b), #a " == " #b, __FILE__, __LINE__)
+
+#define REQUIRE(cond) \
+    do { if (!CHECK(cond)) throw Test::Abort{}; } while (0)
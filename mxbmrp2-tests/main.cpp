@@ -0,0 +1,88 @@
+
+// main.cpp
+//
+// mxbmrp2-tests: unit tests for the parts of the plugin that can be checked
+// without the game. Exits with 1 if any test failed.
+//
+//   mxbmrp2-tests                       every test
+//   mxbmrp2-tests --filter RegionMap    tests whose name contains it
+
+#include "pch.h"
+
+#include <cstdio>
+#include <string>
+
+#include "Test.h"
+
+namespace {
+    std::filesystem::path g_fixtures = std::filesystem::path(__FILE__).parent_path() / "fixtures";
+    std::filesystem::path g_scratch = "tests-scratch";
+    const char* g_current = "";
+    int g_failures = 0;
+}
+
+namespace Test {
+
+    std::vector<Case>& cases() {
+        static std::vector<Case> all;
+        return all;
+    }
+
+    void fail(const char* file, int line, const std::string& message) {
+        std::printf("  FAILED %s:%d: %s\n", std::filesystem::path(file).filename().string().c_str(), line, message.c_str());
+        ++g_failures;
+    }
+
+    std::filesystem::path fixture(const std::string& name) {
+        return g_fixtures / name;
+    }
+
+    std::filesystem::path scratchDir() {
+        const std::filesystem::path dir = g_scratch / g_current;
+        std::filesystem::remove_all(dir);
+        std::filesystem::create_directories(dir);
+        return dir;
+    }
+
+} // namespace Test
+
+int main(int argc, char** argv) {
+    std::string filter;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (i + 1 < argc && arg == "--filter") filter = argv[++i];
+        else if (i + 1 < argc && arg == "--fixtures") g_fixtures = argv[++i];
+        else if (i + 1 < argc && arg == "--scratch") g_scratch = argv[++i];
+        else {
+            std::printf(
+                "Usage: mxbmrp2-tests [options]\n"
+                "  --filter TEXT    only tests whose name contains TEXT\n"
+                "  --fixtures DIR   test data (default: next to this source file)\n"
+                "  --scratch DIR    directory for files tests write (default: tests-scratch)\n");
+            return arg == "--help" ? 0 : 2;
+        }
+    }
+
+    int run = 0;
+    int failed = 0;
+    for (const Test::Case& test : Test::cases()) {
+        if (!filter.empty() && std::string(test.name).find(filter) == std::string::npos) continue;
+
+        g_current = test.name;
+        const int failuresBefore = g_failures;
+        std::printf("%s\n", test.name);
+        try {
+            test.run();
+        }
+        catch (const Test::Abort&) {
+        }
+        catch (const std::exception& e) {
+            Test::fail(__FILE__, __LINE__, std::string("exception: ") + e.what());
+        }
+        ++run;
+        if (g_failures != failuresBefore) ++failed;
+    }
+
+    std::printf("\n%d tests, %d failed\n", run, failed);
+    return failed == 0 && run > 0 ? 0 : 1;
+}
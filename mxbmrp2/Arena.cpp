@@ -0,0 +1,72 @@
+
+// Arena.cpp
+
+#include "pch.h"
+
+#include <cstring>
+#include <memory>
+#include <optional>
+
+#include "Arena.h"
+#include "Metrics.h"
+
+namespace {
+    // Where an arena goes once its buffer is used up
+    class OverflowResource : public std::pmr::memory_resource {
+        void* do_allocate(size_t bytes, size_t alignment) override {
+            Metrics::getInstance().add(Counter::ArenaOverflowBytes, bytes);
+            return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+        }
+
+        void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+            std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+        }
+
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+            return this == &other;
+        }
+    };
+
+    struct ThreadArena {
+        ThreadArena() { rewind(); }
+
+        // Rebuilt rather than release()d: not every standard library
+        // rewinds a monotonic_buffer_resource to its initial buffer
+        void rewind() { resource.emplace(buffer.get(), Arena::CAPACITY, &overflow); }
+
+        std::unique_ptr<std::byte[]> buffer = std::make_unique<std::byte[]>(Arena::CAPACITY);
+        OverflowResource overflow;
+        std::optional<std::pmr::monotonic_buffer_resource> resource;
+        int depth = 0;
+    };
+
+    // Created by the thread's first ArenaScope
+    thread_local std::unique_ptr<ThreadArena> t_arena;
+}
+
+namespace Arena {
+    std::pmr::memory_resource* resource() {
+        if (!t_arena || t_arena->depth == 0) return std::pmr::get_default_resource();
+        return &*t_arena->resource;
+    }
+
+    std::string_view copy(std::string_view text) {
+        if (text.empty()) return {};
+        char* p = static_cast<char*>(resource()->allocate(text.size(), alignof(char)));
+        std::memcpy(p, text.data(), text.size());
+        return { p, text.size() };
+    }
+}
+
+ArenaScope::ArenaScope() {
+    if (!t_arena) {
+        t_arena = std::make_unique<ThreadArena>();
+    }
+    t_arena->depth++;
+}
+
+ArenaScope::~ArenaScope() {
+    if (--t_arena->depth == 0) {
+        t_arena->rewind();
+    }
+}
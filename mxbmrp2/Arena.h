@@ -0,0 +1,37 @@
+
+// Arena.h
+
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+#include <string_view>
+
+// Scratch memory for what a callback, periodic tick or background job
+// builds and throws away: export bodies, connect URIs, search candidates.
+// Each thread bumps through its own buffer and the outermost ArenaScope
+// hands it all back when it ends, so this traffic never reaches the heap
+// the game allocates from. Past CAPACITY the arena borrows from the heap,
+// counted as arena_overflow_bytes.
+//
+// Containers on Arena::resource() must not outlive the scope they were
+// made in.
+namespace Arena {
+    constexpr size_t CAPACITY = 64 * 1024;     // per thread
+
+    // The calling thread's arena inside an ArenaScope, the heap outside one
+    std::pmr::memory_resource* resource();
+
+    // Copy of `text` that lives until the scope ends (inside an ArenaScope only)
+    std::string_view copy(std::string_view text);
+}
+
+// One callback, tick or job. Nested scopes end with the outermost one.
+class ArenaScope {
+public:
+    ArenaScope();
+    ~ArenaScope();
+
+    ArenaScope(const ArenaScope&) = delete;
+    ArenaScope& operator=(const ArenaScope&) = delete;
+};
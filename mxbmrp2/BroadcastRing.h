@@ -0,0 +1,115 @@
+
+// BroadcastRing.h
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// Bounded lock-free ring with one producer and any number of readers, each
+// following at its own pace. The producer never waits: once the ring is
+// full it overwrites the oldest element, and a reader that fell that far
+// behind skips ahead, counting what it missed. Every slot is stamped with
+// the number of the element in it (a per-slot seqlock), so a reader can
+// tell a clean copy from one the producer overwrote halfway through.
+template <typename T, size_t Capacity>
+class BroadcastRing {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+        "Capacity must be a power of two");
+    static_assert(std::is_trivially_copyable_v<T>,
+        "Elements are copied while the producer may be writing them");
+
+public:
+    BroadcastRing() = default;
+
+    BroadcastRing(const BroadcastRing&) = delete;
+    BroadcastRing& operator=(const BroadcastRing&) = delete;
+
+    // Producer thread only
+    void push(const T& value) {
+        const uint64_t n = written_.load(std::memory_order_relaxed);
+        Slot& slot = slots_[n & MASK];
+
+        slot.stamp.store(0, std::memory_order_relaxed);     // being written
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(&slot.value, &value, sizeof(T));
+        slot.stamp.store(n + 1, std::memory_order_release);
+        written_.store(n + 1, std::memory_order_release);
+    }
+
+    // Elements pushed so far
+    uint64_t written() const {
+        return written_.load(std::memory_order_acquire);
+    }
+
+    // Copies element `index` (0 is the first ever pushed). False if it
+    // hasn't been pushed yet or has been overwritten.
+    bool read(uint64_t index, T& out) const {
+        const Slot& slot = slots_[index & MASK];
+        if (slot.stamp.load(std::memory_order_acquire) != index + 1) return false;
+
+        std::memcpy(&out, &slot.value, sizeof(T));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return slot.stamp.load(std::memory_order_relaxed) == index + 1;
+    }
+
+    // Copies the newest element, false if nothing has been pushed
+    bool latest(T& out) const {
+        for (;;) {
+            const uint64_t n = written();
+            if (n == 0) return false;
+            if (read(n - 1, out)) return true;
+        }
+    }
+
+    // One consumer's position, used from a single thread
+    class Reader {
+    public:
+        // Starts at the next element pushed
+        explicit Reader(const BroadcastRing& ring)
+            : ring_(&ring), next_(ring.written()) {}
+
+        // Copies the oldest element not read yet, false once caught up
+        bool next(T& out) {
+            for (;;) {
+                const uint64_t written = ring_->written();
+                if (next_ == written) return false;
+
+                if (written - next_ > Capacity) {
+                    skipped_ += written - Capacity - next_;
+                    next_ = written - Capacity;
+                }
+                if (ring_->read(next_++, out)) return true;
+                ++skipped_;     // overwritten while being copied
+            }
+        }
+
+        // Number of the next element to read
+        uint64_t position() const { return next_; }
+
+        // Elements overwritten before this reader got to them
+        uint64_t skipped() const { return skipped_; }
+
+    private:
+        const BroadcastRing* ring_;
+        uint64_t next_;
+        uint64_t skipped_ = 0;
+    };
+
+    static constexpr size_t capacity() { return Capacity; }
+
+private:
+    static constexpr size_t MASK = Capacity - 1;
+
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> stamp{ 0 };   // element number + 1, 0 while written
+        T value;
+    };
+
+    std::array<Slot, Capacity> slots_;
+    alignas(64) std::atomic<uint64_t> written_{ 0 };
+};
@@ -0,0 +1,251 @@
+
+// CallbackCapture.cpp
+
+#include "pch.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+#include "CallbackCapture.h"
+#include "Logger.h"
+
+namespace {
+    constexpr size_t HEADER_SIZE = sizeof(CallbackCapture::MAGIC) + 2 * sizeof(uint32_t);
+    constexpr size_t RECORD_HEADER_SIZE = 4 * sizeof(uint8_t) + sizeof(uint32_t) + sizeof(int64_t);
+    constexpr size_t WRITE_BUFFER_SIZE = 64 * 1024;
+    constexpr size_t MAX_PAYLOAD_SIZE = 1024 * 1024;   // well above any entry array; a corrupt size fails instead
+
+    // Both targets are little-endian, so values are stored as they are in memory
+    template <typename T>
+    void put(char*& p, T value) {
+        std::memcpy(p, &value, sizeof(T));
+        p += sizeof(T);
+    }
+
+    template <typename T>
+    T get(const char*& p) {
+        T value;
+        std::memcpy(&value, p, sizeof(T));
+        p += sizeof(T);
+        return value;
+    }
+
+    int64_t nowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+}
+
+namespace CallbackCapture {
+
+    size_t payloadSize(CallbackType type) {
+        switch (type) {
+        case CallbackType::EventInit:           return sizeof(SPluginsBikeEvent_t);
+        case CallbackType::RunInit:             return sizeof(SPluginsBikeSession_t);
+        case CallbackType::RunLap:              return sizeof(SPluginsBikeLap_t);
+        case CallbackType::RunSplit:            return sizeof(SPluginsBikeSplit_t);
+        case CallbackType::RaceEvent:           return sizeof(SPluginsRaceEvent_t);
+        case CallbackType::RaceSession:         return sizeof(SPluginsRaceSession_t);
+        case CallbackType::RaceSessionState:    return sizeof(SPluginsRaceSessionState_t);
+        case CallbackType::RaceAddEntry:        return sizeof(SPluginsRaceAddEntry_t);
+        case CallbackType::RaceRemoveEntry:     return sizeof(SPluginsRaceRemoveEntry_t);
+        case CallbackType::RaceClassification:  return sizeof(SPluginsRaceClassification_t) + sizeof(int32_t);
+        case CallbackType::RaceCommunication:   return sizeof(SPluginsRaceCommunication_t);
+        case CallbackType::StateChange:         return sizeof(int);
+        case CallbackType::RunTelemetry:        return sizeof(SPluginsBikeData_t) + 2 * sizeof(float);
+        default:                                return 0;   // no payload
+        }
+    }
+
+    // Writer
+
+    Writer::~Writer() {
+        close();
+    }
+
+    bool Writer::open(const std::filesystem::path& path) {
+        close();
+
+        // Set before opening, or the stream may ignore it
+        buffer_.resize(WRITE_BUFFER_SIZE);
+        out_.rdbuf()->pubsetbuf(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+        out_.open(path, std::ios::binary | std::ios::trunc);
+        if (!out_) {
+            LOG_ERROR(IO, "Unable to write callback capture: " + path.string());
+            return false;
+        }
+
+        char header[HEADER_SIZE];
+        char* p = header;
+        std::memcpy(p, MAGIC, sizeof(MAGIC));
+        p += sizeof(MAGIC);
+        put<uint32_t>(p, VERSION);
+        put<uint32_t>(p, 0);
+        out_.write(header, sizeof(header));
+
+        firstNs_ = -1;
+        records_ = 0;
+        return true;
+    }
+
+    void Writer::writeHeader(CallbackType type, size_t size) {
+        const int64_t now = nowNs();
+        if (firstNs_ < 0) firstNs_ = now;
+
+        char header[RECORD_HEADER_SIZE];
+        char* p = header;
+        put<uint8_t>(p, static_cast<uint8_t>(type));
+        put<uint8_t>(p, 0);
+        put<uint16_t>(p, 0);
+        put<uint32_t>(p, static_cast<uint32_t>(size));
+        put<int64_t>(p, now - firstNs_);
+        out_.write(header, sizeof(header));
+        ++records_;
+    }
+
+    void Writer::write(CallbackType type, const void* payload, size_t size) {
+        if (!out_.is_open()) return;
+        writeHeader(type, size);
+        out_.write(static_cast<const char*>(payload), static_cast<std::streamsize>(size));
+    }
+
+    void Writer::writeTelemetry(const SPluginsBikeData_t& bike, float time, float trackPos) {
+        if (!out_.is_open()) return;
+        writeHeader(CallbackType::RunTelemetry, payloadSize(CallbackType::RunTelemetry));
+        out_.write(reinterpret_cast<const char*>(&bike), sizeof(bike));
+        out_.write(reinterpret_cast<const char*>(&time), sizeof(time));
+        out_.write(reinterpret_cast<const char*>(&trackPos), sizeof(trackPos));
+    }
+
+    void Writer::writeClassification(const SPluginsRaceClassification_t& classification,
+        const void* entries, int elemSize)
+    {
+        if (!out_.is_open()) return;
+
+        // Without an array (the simulator sends none) only the header is kept
+        const int32_t storedElemSize = entries ? (std::max<int32_t>)(elemSize, 0) : 0;
+        const size_t entriesSize = static_cast<size_t>(storedElemSize)
+            * static_cast<size_t>((std::max<int>)(classification.m_iNumEntries, 0));
+
+        writeHeader(CallbackType::RaceClassification, payloadSize(CallbackType::RaceClassification) + entriesSize);
+        out_.write(reinterpret_cast<const char*>(&classification), sizeof(classification));
+        out_.write(reinterpret_cast<const char*>(&storedElemSize), sizeof(storedElemSize));
+        if (entriesSize > 0) {
+            out_.write(static_cast<const char*>(entries), static_cast<std::streamsize>(entriesSize));
+        }
+    }
+
+    size_t Writer::close() {
+        if (!out_.is_open()) return 0;
+
+        out_.close();
+        if (out_.fail()) {
+            LOG_ERROR(IO, "Callback capture may be incomplete, the write failed");
+        }
+        out_.clear();
+        return records_;
+    }
+
+    // Reader
+
+    bool Reader::open(const std::filesystem::path& path) {
+        in_.open(path, std::ios::binary);
+        if (!in_) {
+            LOG_ERROR(IO, "Unable to open callback capture: " + path.string());
+            return false;
+        }
+
+        char header[HEADER_SIZE];
+        if (!in_.read(header, sizeof(header)) || std::memcmp(header, MAGIC, sizeof(MAGIC)) != 0) {
+            LOG_ERROR(IO, "Not a callback capture: " + path.string());
+            return false;
+        }
+
+        const char* p = header + sizeof(MAGIC);
+        const uint32_t version = get<uint32_t>(p);
+        if (version != VERSION) {
+            LOG_ERROR(IO, "Unsupported callback capture version " + std::to_string(version) + ": " + path.string());
+            return false;
+        }
+        return true;
+    }
+
+    bool Reader::next(Record& record) {
+        char header[RECORD_HEADER_SIZE];
+        if (!in_.read(header, sizeof(header))) {
+            // A record cut short by a crash is dropped quietly
+            return false;
+        }
+
+        const char* p = header;
+        const uint8_t type = get<uint8_t>(p);
+        get<uint8_t>(p);
+        get<uint16_t>(p);
+        const uint32_t size = get<uint32_t>(p);
+        const int64_t timeNs = get<int64_t>(p);
+
+        if (type >= static_cast<uint8_t>(CallbackType::Count)
+            || size < payloadSize(static_cast<CallbackType>(type)) || size > MAX_PAYLOAD_SIZE) {
+            LOG_ERROR(IO, "Malformed callback capture record (type " + std::to_string(type)
+                + ", " + std::to_string(size) + " bytes)");
+            failed_ = true;
+            return false;
+        }
+
+        record.type = static_cast<CallbackType>(type);
+        record.timeNs = timeNs;
+        record.payload.resize(size);
+        if (!in_.read(record.payload.data(), size)) return false;
+
+        if (!valid(record)) {
+            LOG_ERROR(IO, "Malformed callback capture record (type " + std::to_string(type)
+                + ", " + std::to_string(size) + " bytes)");
+            failed_ = true;
+            return false;
+        }
+        return true;
+    }
+
+    // Only RaceClassification is longer than payloadSize, by its entry array
+    bool Reader::valid(const Record& record) const {
+        const size_t fixed = payloadSize(record.type);
+        if (record.type != CallbackType::RaceClassification) {
+            return record.payload.size() == fixed;
+        }
+
+        const auto classification = record.as<SPluginsRaceClassification_t>();
+        int32_t elemSize = 0;
+        std::memcpy(&elemSize, record.payload.data() + sizeof(classification), sizeof(elemSize));
+        const size_t entriesSize = record.payload.size() - fixed;
+        if (elemSize == 0) return entriesSize == 0;
+        return elemSize > 0 && classification.m_iNumEntries >= 0
+            && entriesSize == static_cast<size_t>(elemSize) * static_cast<size_t>(classification.m_iNumEntries);
+    }
+
+    // Replay
+
+    int64_t replay(const std::filesystem::path& path, ReplaySpeed speed,
+        const std::function<void(const Record&)>& handle)
+    {
+        Reader reader;
+        if (!reader.open(path)) return -1;
+
+        const auto start = std::chrono::steady_clock::now();
+        int64_t replayed = 0;
+
+        Record record;
+        while (reader.next(record)) {
+            if (speed == ReplaySpeed::Recorded) {
+                std::this_thread::sleep_until(start + std::chrono::nanoseconds(record.timeNs));
+            }
+            handle(record);
+            ++replayed;
+        }
+
+        LOG_INFO(IO, "Replayed " + std::to_string(replayed) + " callbacks from " + path.string());
+        return reader.failed() ? -1 : replayed;
+    }
+
+} // namespace CallbackCapture
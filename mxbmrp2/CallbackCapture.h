@@ -0,0 +1,113 @@
+
+// CallbackCapture.h
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <vector>
+
+#include "EventDispatcher.h"
+
+// Binary recording of the game callbacks of a session, so it can be played
+// back into the plugin without the game. Only standard C++, so a capture
+// taken in-game can be replayed on any machine.
+//
+// The exports write the records on the game thread, as the game made the
+// callbacks and before they drop any (the classification throttle, the
+// communications that aren't penalties), so a replay through the exports
+// filters them the same way. Draw is only recorded when its state changes.
+//
+// Layout, little-endian:
+//   header   char[8] "MXBCAP\0\0", uint32 version, uint32 reserved
+//   record   uint8 type, uint8[3] reserved, uint32 payload size,
+//            int64 nanoseconds since the first record, payload bytes
+//
+// The payload is the raw game struct for the callback type (an int for
+// Draw state changes), so the reader rejects records whose size doesn't
+// match the struct it was built with. RunTelemetry adds the time and track
+// position, RaceClassification the element size and the entry array.
+namespace CallbackCapture {
+
+    inline constexpr char MAGIC[8] = { 'M', 'X', 'B', 'C', 'A', 'P', '\0', '\0' };
+    inline constexpr uint32_t VERSION = 2;
+
+    // Payload bytes stored for a callback type, before RaceClassification's
+    // entry array
+    size_t payloadSize(CallbackType type);
+
+    // A record as read back
+    struct Record {
+        CallbackType type = CallbackType::Count;
+        int64_t timeNs = 0;             // since the first record
+        std::vector<char> payload;
+
+        // The payload's leading struct
+        template <typename T>
+        T as() const {
+            T value;
+            std::memcpy(&value, payload.data(), sizeof(T));
+            return value;
+        }
+    };
+
+    class Writer {
+    public:
+        Writer() = default;
+        ~Writer();
+        Writer(const Writer&) = delete;
+        Writer& operator=(const Writer&) = delete;
+
+        bool open(const std::filesystem::path& path);
+        bool isOpen() const { return out_.is_open(); }
+
+        // Timestamped with the steady clock. `size` must be the type's payloadSize.
+        void write(CallbackType type, const void* payload, size_t size);
+        void writeTelemetry(const SPluginsBikeData_t& bike, float time, float trackPos);
+        // `entries` may be null, the game's array otherwise
+        void writeClassification(const SPluginsRaceClassification_t& classification,
+            const void* entries, int elemSize);
+
+        // Returns the number of records written
+        size_t close();
+
+    private:
+        void writeHeader(CallbackType type, size_t size);
+
+        std::ofstream out_;
+        std::vector<char> buffer_;
+        int64_t firstNs_ = -1;
+        size_t records_ = 0;
+    };
+
+    class Reader {
+    public:
+        bool open(const std::filesystem::path& path);
+
+        // The next record. False at the end of the file or on a malformed
+        // record.
+        bool next(Record& record);
+
+        bool failed() const { return failed_; }
+
+    private:
+        bool valid(const Record& record) const;
+
+        std::ifstream in_;
+        bool failed_ = false;
+    };
+
+    enum class ReplaySpeed {
+        Recorded,   // keep the original spacing between callbacks
+        Maximum     // back to back
+    };
+
+    // Feed every record of a capture to `handle`. Returns the number of
+    // records replayed, or -1 if the file couldn't be read.
+    int64_t replay(const std::filesystem::path& path, ReplaySpeed speed,
+        const std::function<void(const Record&)>& handle);
+
+} // namespace CallbackCapture
@@ -11,10 +11,21 @@
 
 #include "Constants.h"
 #include "ConfigManager.h"
+#include "OffsetDatabase.h"
 #include "Logger.h"
 
+// Adds the memory offsets of the build this release targets
+static std::unordered_map<std::string, ConfigManager::ConfigOption> withOffsetDefaults(
+    std::unordered_map<std::string, ConfigManager::ConfigOption> options)
+{
+    for (const auto& entry : OffsetDatabase::REFERENCE_BUILD.offsets) {
+        options.emplace(entry.key, ConfigManager::ConfigOption{ ConfigManager::ConfigType::ULONG, entry.value });
+    }
+    return options;
+}
+
 // Definition of configOptions_
-const std::unordered_map<std::string, ConfigManager::ConfigOption> ConfigManager::configOptions_ = {
+const std::unordered_map<std::string, ConfigManager::ConfigOption> ConfigManager::configOptions_ = withOffsetDefaults({
     // Draw configuration
     {"plugin_banner", {ConfigType::BOOL, true}},
     {"race_number", {ConfigType::BOOL, true}},
@@ -48,6 +59,11 @@ const std::unordered_map<std::string, ConfigManager::ConfigOption> ConfigManager
     {"combo_laps", { ConfigType::BOOL, false }},
     {"total_laps", { ConfigType::BOOL, false }},
     {"discord_status", { ConfigType::BOOL, false }},
+    {"perf_draw_p99", { ConfigType::BOOL, false }},
+    {"perf_tick_p99", { ConfigType::BOOL, false }},
+    {"perf_log_dropped", { ConfigType::BOOL, false }},
+    {"top_speed", { ConfigType::BOOL, false }},
+    {"live_delta", { ConfigType::BOOL, false }},
 
     // GUI configuration
     {"default_enabled", {ConfigType::BOOL, true}},
@@ -59,37 +75,36 @@ const std::unordered_map<std::string, ConfigManager::ConfigOption> ConfigManager
     {"font_color", {ConfigType::ULONG, 0xFFFFFFFFUL}},
     {"background_color", {ConfigType::ULONG, 0x7F000000UL}},
 
+    // Telemetry
+    { "telemetry_rate", {ConfigType::ULONG, 10UL }},
+    { "enable_telemetry_recording", {ConfigType::BOOL, false }},
+
     // Discord integration
     { "enable_discord_rich_presence", {ConfigType::BOOL, false }},
 
     // HTML/JSON export
     { "enable_html_export", {ConfigType::BOOL, false }},
     { "enable_json_export", {ConfigType::BOOL, false }},
-
-    // Memory configuration
-    {"local_server_name_offset",{ConfigType::ULONG,0x9D6768UL}},
-    {"local_server_password_offset",{ConfigType::ULONG,0x9D67ACUL}},
-    {"local_server_location_offset",{ConfigType::ULONG,0x9D67CCUL}},
-    {"local_server_clients_max_offset",{ConfigType::ULONG,0x9D6820UL}},
-
-    {"remote_server_sockaddr_offset",{ConfigType::ULONG,0x58B2BCUL}},
-    {"remote_server_password_offset",{ConfigType::ULONG,0x9BDE04UL}},
-    {"remote_server_name_offset",{ConfigType::ULONG,0x1BUL}},
-    {"remote_server_location_offset",{ConfigType::ULONG,0x75UL}},
-    {"remote_server_ping_offset",{ConfigType::ULONG,0x58B534UL}},
-    {"remote_server_clients_max_offset",{ConfigType::ULONG,0x5DUL}},
-
-    {"local_server_remaining_tearoffs_offset",{ConfigType::ULONG,0x9D78BCUL}},
-    {"remote_server_remaining_tearoffs_offset",{ConfigType::ULONG,0x108BE0CUL}},
-
-    {"track_deformation_offset",{ConfigType::ULONG,0x58B708UL}},
-
-    {"server_categories_offset",{ConfigType::ULONG,0x58B634UL}},
-    {"server_track_id_offset",{ConfigType::ULONG,0x58B5D4UL}},
-    {"server_clients_offset",{ConfigType::ULONG,0xE49F28UL}},
-
-    {"connection_string_offset",{ConfigType::ULONG,0x559DC0UL}},
-};
+    { "json_metrics", {ConfigType::BOOL, false }},
+
+    // Prometheus endpoint
+    { "metrics_port", {ConfigType::ULONG, 0UL }},
+
+    // Memory scans
+    { "memory_scan_budget_us", {ConfigType::ULONG, 0UL }},
+
+    // Logging
+    { "log_general", {ConfigType::STRING, std::string("info") }},
+    { "log_memory", {ConfigType::STRING, std::string("info") }},
+    { "log_callbacks", {ConfigType::STRING, std::string("info") }},
+    { "log_discord", {ConfigType::STRING, std::string("info") }},
+    { "log_io", {ConfigType::STRING, std::string("info") }},
+    { "log_max_size_mb", {ConfigType::FLOAT, 5.0f }},
+    { "log_archives", {ConfigType::ULONG, 5UL }},
+    { "log_max_total_mb", {ConfigType::FLOAT, 25.0f }},
+    { "enable_trace", {ConfigType::BOOL, false }},
+    { "enable_capture", {ConfigType::BOOL, false }}
+});
 
 // Singleton instance
 ConfigManager& ConfigManager::getInstance() {
@@ -189,7 +204,7 @@ void ConfigManager::loadConfig(const std::filesystem::path& cfgPath) {
     std::lock_guard<std::mutex> lk(mutex_);
 
     if (!std::filesystem::exists(cfgPath)) {
-        Logger::getInstance().log("Config not found, creating defaults: " + cfgPath.string());
+        LOG_INFO(IO, "Config not found, creating defaults: " + cfgPath.string());
         writeDefaultConfig(cfgPath);
     }
 
@@ -197,7 +212,7 @@ void ConfigManager::loadConfig(const std::filesystem::path& cfgPath) {
 
     std::ifstream configFile(cfgPath);
     if (configFile.is_open()) {
-        Logger::getInstance().log("Loading config file: " + cfgPath.string());
+        LOG_INFO(IO, "Loading config file: " + cfgPath.string());
         std::string line;
         int lineNumber = 0;
         while (std::getline(configFile, line)) {
@@ -215,7 +230,7 @@ void ConfigManager::loadConfig(const std::filesystem::path& cfgPath) {
             // Skip malformed lines
             size_t delimiterPos = line.find('=');
             if (delimiterPos == std::string::npos) {
-                Logger::getInstance().log("Malformed line " + std::to_string(lineNumber) + ": " + line);
+                LOG_WARNING(IO, "Malformed line " + std::to_string(lineNumber) + ": " + line);
                 continue;
             }
 
@@ -272,7 +287,7 @@ void ConfigManager::loadConfig(const std::filesystem::path& cfgPath) {
                         if (key == "font_name") {
                             std::filesystem::path fontPath = std::filesystem::path("plugins") / DATA_DIR / value;
                             if (!std::filesystem::exists(fontPath) || !std::filesystem::is_regular_file(fontPath)) {
-                                Logger::getInstance().log("Font file missing: " + fontPath.string() + ". Text rendering not work properly.");
+                                LOG_WARNING(IO, "Font file missing: " + fontPath.string() + ". Text rendering not work properly.");
                                 config_[key] = value;
                                 continue;
                             }
@@ -287,24 +302,24 @@ void ConfigManager::loadConfig(const std::filesystem::path& cfgPath) {
                 catch (const std::exception& e) {
                     // On failure, use default value
                     config_[key] = option.defaultValue;
-                    Logger::getInstance().log("Error parsing key '" + key + "' on line " + std::to_string(lineNumber) + ": " + e.what() + ". Using default value.");
+                    LOG_WARNING(IO, "Error parsing key '" + key + "' on line " + std::to_string(lineNumber) + ": " + e.what() + ". Using default value.");
                 }
             }
             else {
                 // Unknown key, ignore or log
-                Logger::getInstance().log("Unknown configuration key on line " + std::to_string(lineNumber) + ": " + key);
+                LOG_WARNING(IO, "Unknown configuration key on line " + std::to_string(lineNumber) + ": " + key);
             }
         }
     }
     else {
-        Logger::getInstance().log("Failed to open config file: " + cfgPath.string());
+        LOG_ERROR(IO, "Failed to open config file: " + cfgPath.string());
     }
 
     // Fill missing keys with default values
     for (const auto& [key, option] : configOptions_) {
         if (config_.find(key) == config_.end()) {
             config_[key] = option.defaultValue;
-            Logger::getInstance().log("Missing configuration key '" + key + "'. Using default value.");
+            LOG_WARNING(IO, "Missing configuration key '" + key + "'. Using default value.");
         }
     }
 }
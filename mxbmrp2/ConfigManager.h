@@ -59,13 +59,13 @@ public:
                 return *val;
             }
             else {
-                Logger::getInstance().log(
+                LOG_RATE_LIMITED(LogLevel::Warning, IO, 1, 5,
                     "Type mismatch for key '" + key + "', using default value."
                 );
             }
         }
         else {
-            Logger::getInstance().log(
+            LOG_RATE_LIMITED(LogLevel::Warning, IO, 1, 5,
                 "Key '" + key + "' not found, using default value."
             );
         }
@@ -77,7 +77,7 @@ public:
                 return std::get<T>(optIt->second.defaultValue);
             }
             catch (const std::bad_variant_access&) {
-                Logger::getInstance().log(
+                LOG_WARNING(IO,
                     "Default value type mismatch for key '" + key +
                     "'. Returning default-constructed value."
                 );
@@ -23,6 +23,12 @@ inline const std::filesystem::path CONFIG_FILE = "mxbmrp2.ini";
 inline const std::filesystem::path DAT_FILE = "mxbmrp2.dat";
 inline const std::filesystem::path HTML_FILE = "mxbmrp2.html";
 inline const std::filesystem::path JSON_FILE = "mxbmrp2.json";
+inline const std::filesystem::path OFFSETS_CACHE_FILE = "mxbmrp2-offsets.cache";
+inline const std::filesystem::path OFFSETS_OVERRIDE_FILE = "mxbmrp2-offsets.ini";
+inline const std::filesystem::path TRACE_FILE = "mxbmrp2-trace.json";
+inline const std::filesystem::path CAPTURE_FILE = "mxbmrp2-capture.bin";
+inline const std::filesystem::path TELEMETRY_DIR = "telemetry";
+inline constexpr const char* TELEMETRY_FILE_EXTENSION = ".mxbtel";
 
 inline constexpr UINT HOTKEY = 'R';
 inline constexpr float LINE_HEIGHT_MULTIPLIER = 1.1f;
@@ -30,8 +36,13 @@ inline constexpr size_t MAX_STRING_LENGTH = 48;
 inline constexpr uint32_t SETUP_DEFAULT_HIGHLIGHT_MS = 5000;
 
 inline constexpr int PERIODIC_TASK_INTERVAL = 1000;
+inline constexpr int WATCH_INTERVAL_PING = 250;
+inline constexpr int WATCH_INTERVAL_SERVER_CLIENTS = 1000;
+inline constexpr int WATCH_INTERVAL_TEAROFFS = 250;
+inline constexpr int SCAN_STEP_INTERVAL = 16;
+inline constexpr int TELEMETRY_RECORD_INTERVAL = 100;
 inline constexpr const char* DEFAULT_PLAYER_ACTIVITY = "In Menus";
-inline constexpr bool LOG_MEMORY_VALUES = true;
+inline constexpr const char* RESOLVING_PLACEHOLDER = "Resolving...";
 
 // Discord RP
 inline constexpr uint64_t DISCORD_APP_ID = 1286928297288011817ULL;
@@ -40,7 +51,8 @@ inline constexpr uint64_t DISCORD_APP_ID = 1286928297288011817ULL;
 inline constexpr const char* MOD_ID = "mxbikes";
 inline constexpr int MOD_DATA_VERSION = 8;
 inline constexpr int INTERFACE_VERSION = 9;
-inline constexpr int REFRESH_RATE = 3;
+inline constexpr std::size_t TELEMETRY_RING_CAPACITY = 1024;  // 10 s at 100 Hz
+inline constexpr float LIVE_DELTA_STEP = 1.0f;                // meters between the best lap's grid points
 
 // Memory sizes
 inline constexpr std::size_t SIZE_LOCAL_SERVER_NAME = 64;
@@ -97,6 +109,11 @@ alltime_pb={{alltime_pb}}
 combo_laps={{combo_laps}}
 total_laps={{total_laps}}
 discord_status={{discord_status}}
+perf_draw_p99={{perf_draw_p99}}
+perf_tick_p99={{perf_tick_p99}}
+perf_log_dropped={{perf_log_dropped}}
+top_speed={{top_speed}}
+live_delta={{live_delta}}
 
 # HUD visibility and placement
 default_enabled={{default_enabled}}
@@ -109,12 +126,50 @@ font_size={{font_size}}
 font_color={{font_color}}
 background_color={{background_color}}
 
+# Bike telemetry samples per second: 100, 50, 20 or 10 (0 disables,
+# takes effect when the game is restarted)
+telemetry_rate={{telemetry_rate}}
+
+# Record each run's telemetry to the telemetry folder (one .mxbtel file per run)
+enable_telemetry_recording={{enable_telemetry_recording}}
+
 # Discord Rich Presence
 enable_discord_rich_presence={{enable_discord_rich_presence}}
 
 # HTML/JSON Export
 enable_html_export={{enable_html_export}}
 enable_json_export={{enable_json_export}}
+# Add the plugin's own timings and counters to the JSON export
+json_metrics={{json_metrics}}
+
+# Serve Prometheus metrics at http://127.0.0.1:<port>/metrics (0 disables)
+metrics_port={{metrics_port}}
+
+# Memory scans: 0 runs them on a background thread, otherwise they are
+# split into steps of at most this many microseconds
+memory_scan_budget_us={{memory_scan_budget_us}}
+
+# Logging: debug, info, warning, error or off, per category
+# (debug messages are only compiled into debug builds)
+log_general={{log_general}}
+log_memory={{log_memory}}
+log_callbacks={{log_callbacks}}
+log_discord={{log_discord}}
+log_io={{log_io}}
+
+# Log rotation: a new mxbmrp2.log is started at this size, keeping this many
+# compressed archives (mxbmrp2.1.log.lz4 is the newest) within a total size
+log_max_size_mb={{log_max_size_mb}}
+log_archives={{log_archives}}
+log_max_total_mb={{log_max_total_mb}}
+
+# Record a timeline of plugin work to mxbmrp2-trace.json (written when the
+# game closes; open it in chrome://tracing or ui.perfetto.dev)
+enable_trace={{enable_trace}}
+
+# Record every game callback to mxbmrp2-capture.bin, for replaying the
+# session without the game (overwritten each time the game starts)
+enable_capture={{enable_capture}}
 
 # Memory addresses (don't touch!)
 local_server_name_offset={{local_server_name_offset}}
@@ -24,7 +24,7 @@ bool DiscordManager::initialize(uint64_t appId) {
         }();
 
     if (!sdkDll) {
-        Logger::getInstance().log("Failed to load discord_game_sdk.dll, disabling Discord Rich Presence");
+        LOG_WARNING(Discord, "Failed to load discord_game_sdk.dll, disabling Discord Rich Presence");
         connState_ = ConnectionState::LoadFailed;
         return false;
     }
@@ -52,7 +52,7 @@ bool DiscordManager::createCore() {
         &raw
     );
     if (result != discord::Result::Ok || !raw) {
-        Logger::getInstance().log(
+        LOG_WARNING(Discord,
             "Discord Core creation failed: " +
             std::to_string(static_cast<int>(result))
         );
@@ -62,18 +62,18 @@ bool DiscordManager::createCore() {
     core_.reset(raw);
     core_->SetLogHook(discord::LogLevel::Debug,
         [](discord::LogLevel lvl, const char* msg) {
-            Logger::getInstance().log(
+            LOG_INFO(Discord,
                 "[Discord] (" + std::to_string((int)lvl) + ") " + msg
             );
         }
     );
-    Logger::getInstance().log("Discord Core created");
+    LOG_INFO(Discord, "Discord Core created");
     return true;
 }
 
 void DiscordManager::tick(
-    const std::string& details,
-    const std::string& state,
+    const char* details,
+    const char* state,
     int partySize,
     int partyMax)
 {
@@ -83,16 +83,16 @@ void DiscordManager::tick(
     case ConnectionState::Waiting: {
         auto now = clock::now();
         if (now >= nextAttempt_) {
-            Logger::getInstance().log("Attempting Discord reconnect...");
+            LOG_INFO(Discord, "Attempting Discord reconnect...");
             if (createCore()) {
-                Logger::getInstance().log("Reconnected to Discord");
+                LOG_INFO(Discord, "Reconnected to Discord");
                 backoffSec_ = 5;
                 connState_ = ConnectionState::Connected;
             }
             else {
                 backoffSec_ = std::min<int>(backoffSec_ * 2, 60);
                 nextAttempt_ = now + std::chrono::seconds(backoffSec_);
-                Logger::getInstance().log(
+                LOG_INFO(Discord,
                     "Reconnect failed; next attempt in " +
                     std::to_string(backoffSec_) + "s"
                 );
@@ -114,7 +114,7 @@ void DiscordManager::tick(
     // 3) pump callbacks
     auto cbRes = core_->RunCallbacks();
     if (cbRes != discord::Result::Ok) {
-        Logger::getInstance().log(
+        LOG_RATE_LIMITED(LogLevel::Warning, Discord, 0.2, 3,
             "Discord RunCallbacks error: " +
             std::to_string(static_cast<int>(cbRes))
         );
@@ -130,12 +130,12 @@ void DiscordManager::tick(
 
     act.SetType(discord::ActivityType::Playing);
 
-    if (!details.empty()) {
-        act.SetDetails(details.c_str());
+    if (*details) {
+        act.SetDetails(details);
     }
 
-    if (!state.empty()) {
-        act.SetState(state.c_str());
+    if (*state) {
+        act.SetState(state);
     }
 
     if (partyMax > 0) {
@@ -161,7 +161,7 @@ void DiscordManager::scheduleReconnect(discord::Result why) {
     core_.reset();
     if (!allowReconnect_) return;
 
-    Logger::getInstance().log(
+    LOG_WARNING(Discord,
         "Discord Connection lost (" + std::to_string(static_cast<int>(why)) +
         "); will attempt to reconnect in " + std::to_string(backoffSec_) + "s"
     );
@@ -183,7 +183,7 @@ void DiscordManager::finalize() {
     core_.reset();
 }
 
-std::string DiscordManager::getConnectionStateString() const {
+const char* DiscordManager::getConnectionStateString() const {
     switch (connState_) {
     case ConnectionState::Disconnected: return "Disconnected";
     case ConnectionState::Waiting: return "Waiting";
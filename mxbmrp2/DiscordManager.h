@@ -20,8 +20,8 @@ public:
 
     // Pump callbacks, update presence, and possibly reconnect
     void tick(
-        const std::string& details,
-        const std::string& state,
+        const char* details,
+        const char* state,
         int partySize = 0,
         int partyMax = 0);
 
@@ -29,7 +29,7 @@ public:
     void finalize();
 
     /// Returns status
-    std::string getConnectionStateString() const;
+    const char* getConnectionStateString() const;
 
 private:
     // Internal helper to create the Core object
@@ -0,0 +1,173 @@
+
+// EventDispatcher.cpp
+
+#include "pch.h"
+
+#include "EventDispatcher.h"
+#include "Arena.h"
+#include "CallbackCapture.h"
+#include "Plugin.h"
+#include "Logger.h"
+#include "Tracer.h"
+#include "Metrics.h"
+
+namespace {
+    constexpr const char* CALLBACK_NAMES[] = {
+        "EventInit", "EventDeinit", "RunInit", "RunDeinit", "RunStart", "RunStop", "RunLap", "RunSplit",
+        "RaceEvent", "RaceSession", "RaceSessionState", "RaceAddEntry", "RaceRemoveEntry",
+        "RaceClassification", "RaceCommunication", "StateChange", "RunTelemetry"
+    };
+    static_assert(std::size(CALLBACK_NAMES) == static_cast<size_t>(CallbackType::Count));
+
+    int64_t nowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // How long the exports kept the game waiting, for the log
+    void logExportLatency() {
+        const Metrics& metrics = Metrics::getInstance();
+        for (auto h = static_cast<size_t>(Histogram::CallbackEventInit);
+            h <= static_cast<size_t>(Histogram::CallbackRunTelemetry); ++h) {
+            const Metrics::Summary s = metrics.summarize(static_cast<Histogram>(h));
+            if (s.count == 0) continue;
+
+            LOG_INFO(Callbacks, std::string("Export latency of ") + Metrics::name(static_cast<Histogram>(h))
+                + ": p99 " + Metrics::formatMicros(s.p99).str() + ", max " + Metrics::formatMicros(s.max).str()
+                + " over " + std::to_string(s.count) + " calls");
+        }
+    }
+}
+
+// Singleton instance
+EventDispatcher& EventDispatcher::getInstance() {
+    static EventDispatcher instance;
+    return instance;
+}
+
+EventDispatcher::~EventDispatcher() {
+    stop();
+}
+
+const char* EventDispatcher::name(CallbackType type) {
+    return CALLBACK_NAMES[static_cast<size_t>(type)];
+}
+
+// Start the worker
+void EventDispatcher::start() {
+    if (running_.exchange(true)) return;
+    thread_ = std::thread(&EventDispatcher::run, this);
+}
+
+// Open the capture file
+bool EventDispatcher::startCapture(const std::filesystem::path& path) {
+    if (running_) return false;
+
+    auto capture = std::make_unique<CallbackCapture::Writer>();
+    if (!capture->open(path)) return false;
+
+    capture_ = std::move(capture);
+    LOG_INFO(Callbacks, "Capturing callbacks to " + path.string());
+    return true;
+}
+
+// Stop the worker once the queue is empty
+void EventDispatcher::stop() {
+    {
+        std::lock_guard<std::mutex> lk(wakeMutex_);
+        if (!running_.exchange(false)) return;
+    }
+    wake_.notify_one();
+
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    logExportLatency();
+
+    if (capture_) {
+        size_t records = capture_->close();
+        capture_.reset();
+        LOG_INFO(Callbacks, "Captured " + std::to_string(records) + " callbacks");
+    }
+}
+
+// Queue an event for the worker
+void EventDispatcher::post(CallbackEvent& event) {
+    event.postedNs = nowNs();
+    if (!running_.load(std::memory_order_relaxed)) {
+        dispatch(event);
+        return;
+    }
+
+    if (queue_.tryPush(event)) return;
+
+    // The worker is stuck behind a slow handler. Wait rather than drop or
+    // reorder callbacks; the game thread stalls until there is room.
+    Metrics::getInstance().add(Counter::EventQueueFull);
+    LOG_RATE_LIMITED(LogLevel::Warning, Callbacks, 0.1, 1,
+        std::string("Callback queue full, game thread waiting to queue ") + name(event.type));
+    while (!queue_.tryPush(event)) {
+        std::this_thread::yield();
+    }
+}
+
+// Worker loop
+void EventDispatcher::run() {
+    Tracer::getInstance().nameThread("Callback events");
+    LOG_INFO(Callbacks, "Callback event thread started");
+
+    std::unique_lock<std::mutex> lk(wakeMutex_);
+    while (running_) {
+        lk.unlock();
+        drain();
+        lk.lock();
+        wake_.wait_for(lk, POLL_INTERVAL, [this] { return !running_; });
+    }
+    lk.unlock();
+
+    // Whatever was queued before stop() still gets handled
+    size_t remaining = drain();
+    LOG_INFO(Callbacks, "Callback event thread stopped (" + std::to_string(remaining) + " events handled on the way out)");
+}
+
+// Handle all queued events, returns how many
+size_t EventDispatcher::drain() {
+    size_t handled = 0;
+    while (CallbackEvent* event = queue_.front()) {
+        Metrics::getInstance().record(Histogram::EventQueueDelay, static_cast<uint64_t>(nowNs() - event->postedNs));
+        {
+            METRICS_TIME(Histogram::EventDispatch);
+            dispatch(*event);
+        }
+        queue_.pop();
+        ++handled;
+    }
+    return handled;
+}
+
+// Call the Plugin handler for one event
+void EventDispatcher::dispatch(const CallbackEvent& event) {
+    TRACE_SCOPE("event", "dispatch");
+    ArenaScope arena;
+    Plugin& plugin = Plugin::getInstance();
+
+    switch (event.type) {
+    case CallbackType::EventInit:           plugin.onEventInit(event.bikeEvent); break;
+    case CallbackType::EventDeinit:         plugin.onEventDeinit(); break;
+    case CallbackType::RunInit:             plugin.onRunInit(event.bikeSession); break;
+    case CallbackType::RunDeinit:           plugin.onRunDeinit(); break;
+    case CallbackType::RunStart:            plugin.onRunStart(); break;
+    case CallbackType::RunStop:             plugin.onRunStop(); break;
+    case CallbackType::RunLap:              plugin.onRunLap(event.bikeLap); break;
+    case CallbackType::RunSplit:            plugin.onRunSplit(event.bikeSplit); break;
+    case CallbackType::RaceEvent:           plugin.onRaceEvent(event.raceEvent); break;
+    case CallbackType::RaceSession:         plugin.onRaceSession(event.raceSession); break;
+    case CallbackType::RaceSessionState:    plugin.onRaceSessionState(event.raceSessionState); break;
+    case CallbackType::RaceAddEntry:        plugin.onRaceAddEntry(event.raceAddEntry); break;
+    case CallbackType::RaceRemoveEntry:     plugin.onRaceRemoveEntry(event.raceRemoveEntry); break;
+    case CallbackType::RaceClassification:  plugin.onRaceClassification(event.raceClassification); break;
+    case CallbackType::RaceCommunication:   plugin.onRaceCommunication(event.raceCommunication); break;
+    case CallbackType::StateChange:         plugin.onStateChange(event.state); break;
+    default: break;
+    }
+}
@@ -0,0 +1,111 @@
+
+// EventDispatcher.h
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "MXB_interface.h"
+#include "SpscQueue.h"
+
+namespace CallbackCapture { class Writer; }
+
+enum class CallbackType : uint8_t {
+    EventInit,
+    EventDeinit,
+    RunInit,
+    RunDeinit,
+    RunStart,
+    RunStop,
+    RunLap,
+    RunSplit,
+    RaceEvent,
+    RaceSession,
+    RaceSessionState,
+    RaceAddEntry,
+    RaceRemoveEntry,
+    RaceClassification,
+    RaceCommunication,
+    StateChange,            // Draw's game state changed
+    RunTelemetry,           // only captured, the export doesn't queue it
+
+    Count
+};
+
+// A game callback and a copy of its payload
+struct CallbackEvent {
+    CallbackType type;
+    int64_t postedNs = 0;   // steady_clock, set by post()
+    union {
+        SPluginsBikeEvent_t bikeEvent;
+        SPluginsBikeSession_t bikeSession;
+        SPluginsBikeLap_t bikeLap;
+        SPluginsBikeSplit_t bikeSplit;
+        SPluginsRaceEvent_t raceEvent;
+        SPluginsRaceSession_t raceSession;
+        SPluginsRaceSessionState_t raceSessionState;
+        SPluginsRaceAddEntry_t raceAddEntry;
+        SPluginsRaceRemoveEntry_t raceRemoveEntry;
+        SPluginsRaceClassification_t raceClassification;
+        SPluginsRaceCommunication_t raceCommunication;
+        int state;
+    };
+};
+
+// Hands game callbacks to the Plugin on a worker thread, in the order the
+// game made them. The exports only copy the payload into a ring, so the
+// game thread never waits on the Plugin locks, memory reads or disk I/O.
+//
+// The worker polls instead of being signalled: waking it would cost the
+// game thread a system call per callback, while polling costs at most
+// POLL_INTERVAL of delay before a callback is handled.
+class EventDispatcher {
+public:
+    static EventDispatcher& getInstance();
+
+    void start();
+
+    // Record every callback to a capture file, call before start()
+    bool startCapture(const std::filesystem::path& path);
+
+    // The capture the exports write to, null when not capturing. Game thread only.
+    CallbackCapture::Writer* capture() { return capture_.get(); }
+
+    // Handle everything still queued, then stop the worker
+    void stop();
+
+    // Game thread only. Until start() (and after stop()) the event is
+    // handled before returning.
+    void post(CallbackEvent& event);
+
+    static const char* name(CallbackType type);
+
+private:
+    static constexpr size_t QUEUE_CAPACITY = 1024;
+    static constexpr auto POLL_INTERVAL = std::chrono::milliseconds(2);
+
+    EventDispatcher() = default;
+    ~EventDispatcher();
+    EventDispatcher(const EventDispatcher&) = delete;
+    EventDispatcher& operator=(const EventDispatcher&) = delete;
+
+    void run();
+    size_t drain();
+    static void dispatch(const CallbackEvent& event);
+
+    SpscQueue<CallbackEvent, QUEUE_CAPACITY> queue_;
+
+    std::thread thread_;
+    std::atomic<bool> running_{ false };
+    std::mutex wakeMutex_;
+    std::condition_variable wake_;      // only signalled by stop()
+
+    std::unique_ptr<CallbackCapture::Writer> capture_;     // written on the game thread
+};
@@ -0,0 +1,57 @@
+
+// FixedString.h
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Fixed-capacity string that lives on the stack. Appends past the capacity
+// are cut off, like the HUD cuts its lines.
+template <std::size_t N>
+struct FixedString {
+    std::array<char, N + 1> buf{};
+    std::size_t len = 0;
+
+    std::string_view view() const { return { buf.data(), len }; }
+    operator std::string_view() const { return view(); }
+    const char* c_str() const { return buf.data(); }
+    bool empty() const { return len == 0; }
+    std::string str() const { return std::string(view()); }
+
+    FixedString& append(std::string_view s) {
+        const std::size_t n = std::min<std::size_t>(s.size(), N - len);
+        s.copy(buf.data() + len, n);
+        len += n;
+        buf[len] = '\0';
+        return *this;
+    }
+
+    FixedString& append(char c) {
+        if (len < N) {
+            buf[len++] = c;
+            buf[len] = '\0';
+        }
+        return *this;
+    }
+
+    // Decimal, the digits zero-padded to at least `width`
+    FixedString& appendNumber(long long value, int width = 0) {
+        char digits[24];
+        const auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        std::string_view text(digits, static_cast<std::size_t>(result.ptr - digits));
+
+        if (!text.empty() && text.front() == '-') {
+            append('-');
+            text.remove_prefix(1);
+        }
+        for (int i = static_cast<int>(text.size()); i < width; ++i) {
+            append('0');
+        }
+        return append(text);
+    }
+};
@@ -3,19 +3,20 @@
 
 #include "pch.h"
 
-#include <sstream>
 #include <fstream>
-#include <iomanip>
 
 #include "Constants.h"
 #include "ConfigManager.h"
 #include "JSONWriter.h"
+#include "Arena.h"
+#include "Tracer.h"
+#include "Metrics.h"
 
-namespace JsonWriter {
-    std::string escapeJson(std::string_view s)
+namespace {
+    template <typename String>
+    void appendEscaped(String& out, std::string_view s)
     {
-        std::string out;
-        out.reserve(s.size());
+        static constexpr char HEX[] = "0123456789abcdef";
         for (unsigned char c : s)
         {
             switch (c)
@@ -29,27 +30,41 @@ namespace JsonWriter {
             case '\t': out += "\\t";  break;
             default:
                 if (c < 0x20) {
-                    std::ostringstream tmp;
-                    tmp << "\\u"
-                        << std::hex << std::setw(4) << std::setfill('0')
-                        << static_cast<int>(c);
-                    out += tmp.str();
+                    out += "\\u00";
+                    out += HEX[c >> 4];
+                    out += HEX[c & 0xF];
                 }
                 else
-                    out += c;
+                    out += static_cast<char>(c);
             }
         }
+    }
+}
+
+namespace JsonWriter {
+    std::string escapeJson(std::string_view s)
+    {
+        std::string out;
+        out.reserve(s.size());
+        appendEscaped(out, s);
         return out;
     }
 
-    std::string renderJson(
-        const std::unordered_map<std::string, std::string>& all,
+    std::pmr::string renderJson(
+        const std::pmr::unordered_map<std::string_view, std::string_view>& all,
         const std::vector<std::pair<std::string, std::string>>& order,
-        ConfigManager& cfg)
+        ConfigManager& cfg,
+        const ServerRoster::View& roster,
+        std::string_view metrics)
     {
-        std::ostringstream out;
-        out << "{\n";
+        std::pmr::string out(Arena::resource());
+        out += "{\n";
         bool first = true;
+        auto member = [&out, &first](std::string_view name) {
+            if (!first) out += ",\n";
+            first = false;
+            out.append("  \"").append(name).append("\": ");
+            };
 
         for (const auto& [key, /*displayName*/ _] : order)
         {
@@ -57,12 +72,33 @@ namespace JsonWriter {
             auto it = all.find(key);
             if (it == all.end() || it->second.empty()) continue;
 
-            if (!first) out << ",\n";
-            first = false;
-            out << "  \"" << key << "\": \"" << escapeJson(it->second) << "\"";
+            member(key);
+            out += '"';
+            appendEscaped(out, it->second);
+            out += '"';
         }
-        out << "\n}\n";
-        return out.str();
+
+        // Remote clients by slot, shown along with server_clients
+        if (!roster.empty() && cfg.getValue<bool>("server_clients")) {
+            member("server_roster");
+            out += '[';
+            for (size_t i = 0; i < roster.size(); ++i) {
+                out.append(i ? ",\n" : "\n")
+                    .append("    { \"slot\": ").append(std::to_string(roster[i].slot))
+                    .append(", \"name\": \"");
+                appendEscaped(out, roster[i].name);
+                out += "\" }";
+            }
+            out += "\n  ]";
+        }
+
+        // Plugin performance counters, see Metrics::renderJson()
+        if (!metrics.empty()) {
+            member("metrics");
+            out.append("{\n").append(metrics).append("\n  }");
+        }
+        out += "\n}\n";
+        return out;
     }
 
     std::string renderNoData() {
@@ -71,14 +107,17 @@ namespace JsonWriter {
 
 
     void atomicWrite(const std::filesystem::path& path,
-        const std::string& data)
+        std::string_view data)
     {
+        TRACE_SCOPE("io", "JsonWriter::atomicWrite");
         auto tmp = path;
         tmp += ".tmp";
         std::ofstream ofs(tmp, std::ios::binary | std::ios::trunc);
         ofs.write(data.data(), static_cast<std::streamsize>(data.size()));
         ofs.close();
         std::filesystem::rename(tmp, path);
+        Metrics::getInstance().add(Counter::JsonWrites);
+        Metrics::getInstance().add(Counter::JsonBytesWritten, data.size());
     }
 
 } // namespace JsonWriter
@@ -2,26 +2,33 @@
 // JSONWriter.h
 
 #pragma once
+#include <memory_resource>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 #include <filesystem>
 
+#include "ServerRoster.h"
+
 class ConfigManager;
 
 namespace JsonWriter {
 
     std::string escapeJson(std::string_view s);
 
-    std::string renderJson(
-        const std::unordered_map<std::string, std::string>& all,
+    // Rendered in the calling thread's Arena
+    std::pmr::string renderJson(
+        const std::pmr::unordered_map<std::string_view, std::string_view>& all,
         const std::vector<std::pair<std::string, std::string>>& order,
-        ConfigManager& cfg);
+        ConfigManager& cfg,
+        const ServerRoster::View& roster = {},
+        std::string_view metrics = {});
 
     std::string renderNoData();
 
     void atomicWrite(const std::filesystem::path& path,
-        const std::string& data);
+        std::string_view data);
 
 }
 
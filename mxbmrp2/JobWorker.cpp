@@ -0,0 +1,84 @@
+
+// JobWorker.cpp
+
+#include "pch.h"
+
+#include "JobWorker.h"
+#include "Arena.h"
+#include "Logger.h"
+#include "Tracer.h"
+
+// Destructor
+JobWorker::~JobWorker() {
+    stop();
+}
+
+// Start the worker thread
+void JobWorker::start() {
+    std::lock_guard<std::mutex> lk(mutex_);
+    if (running_) return;
+
+    running_ = true;
+    thread_ = std::thread(&JobWorker::run, this);
+}
+
+// Cancel outstanding work and wait for the thread to exit
+void JobWorker::stop() {
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        running_ = false;
+    }
+    cancel();
+    cv_.notify_one();
+
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+// Queue a job, superseding any other
+void JobWorker::submit(Job job) {
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        if (activeCancelled_) *activeCancelled_ = true;
+
+        pending_ = std::move(job);
+        pendingCancelled_ = std::make_shared<std::atomic<bool>>(false);
+    }
+    cv_.notify_one();
+}
+
+// Cancel the running job and drop the pending one
+void JobWorker::cancel() {
+    std::lock_guard<std::mutex> lk(mutex_);
+    if (activeCancelled_) *activeCancelled_ = true;
+    pending_ = nullptr;
+    pendingCancelled_.reset();
+}
+
+// Worker loop
+void JobWorker::run() {
+    Tracer::getInstance().nameThread("Background jobs");
+    std::unique_lock<std::mutex> lk(mutex_);
+    while (true) {
+        cv_.wait(lk, [this] { return !running_ || pending_; });
+        if (!running_) break;
+
+        Job job = std::move(pending_);
+        pending_ = nullptr;
+        activeCancelled_ = std::move(pendingCancelled_);
+        auto cancelled = activeCancelled_;
+
+        lk.unlock();
+        try {
+            ArenaScope arena;
+            job(*cancelled);
+        }
+        catch (const std::exception& e) {
+            LOG_ERROR(General, std::string("Background job failed: ") + e.what());
+        }
+        lk.lock();
+
+        activeCancelled_.reset();
+    }
+}
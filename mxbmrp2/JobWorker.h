@@ -0,0 +1,44 @@
+
+// JobWorker.h
+
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+// Runs jobs one at a time on a background thread. Only the latest job
+// matters: submitting cancels the job in progress and replaces any job
+// that hasn't started yet.
+class JobWorker {
+public:
+    // `cancelled` is set once the job has been superseded or the worker stops
+    using Job = std::function<void(const std::atomic<bool>& cancelled)>;
+
+    JobWorker() = default;
+    ~JobWorker();
+
+    JobWorker(const JobWorker&) = delete;
+    JobWorker& operator=(const JobWorker&) = delete;
+
+    void start();
+    void stop();
+
+    void submit(Job job);
+    void cancel();
+
+private:
+    void run();
+
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool running_ = false;
+
+    Job pending_;
+    std::shared_ptr<std::atomic<bool>> pendingCancelled_;
+    std::shared_ptr<std::atomic<bool>> activeCancelled_;
+};
@@ -0,0 +1,256 @@
+
+// LiveDelta.cpp
+
+#include "pch.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#include "LiveDelta.h"
+#include "Constants.h"
+#include "Metrics.h"
+#include "Tracer.h"
+#include "SteadyState.h"
+
+void LiveDelta::Lap::restart(bool atLine) {
+    filled = 0;
+    lastDistance = 0.0f;
+    lastTime = 0.0f;
+    fromLine = atLine;
+    endSample = 0;
+}
+
+// Fill every grid point up to `distance`, interpolating from the last sample
+void LiveDelta::Lap::add(float distance, float time, float step, float trackLength) {
+    if (!fromLine) return;
+    if (filled > 0 && distance <= lastDistance) return;     // stopped or going backwards
+
+    const float span = distance - lastDistance;
+    while (filled < times.size()) {
+        const float at = std::min<float>(filled * step, trackLength);
+        if (at > distance) break;
+        times[filled++] = span > 0.0f
+            ? lastTime + (time - lastTime) * (at - lastDistance) / span
+            : time;
+    }
+    lastDistance = distance;
+    lastTime = time;
+}
+
+LiveDelta::LiveDelta(const TelemetryRing& ring)
+    : ring_(ring), reader_(ring) {
+    requests_.reserve(8);
+    applying_.reserve(8);
+}
+
+LiveDelta::~LiveDelta() {
+    stop();
+}
+
+// Start the delta thread
+void LiveDelta::start(int rateHz, DeltaHandler handler) {
+    std::lock_guard<std::mutex> lk(mutex_);
+    if (running_ || rateHz <= 0) return;
+
+    rateHz_ = rateHz;
+    handler_ = std::move(handler);
+    reader_ = TelemetryRing::Reader(ring_);
+    running_ = true;
+    thread_ = std::thread(&LiveDelta::run, this);
+}
+
+void LiveDelta::stop() {
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        if (!running_) return;
+        running_ = false;
+    }
+    cv_.notify_one();
+
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void LiveDelta::beginRun(float trackLength) {
+    std::lock_guard<std::mutex> lk(mutex_);
+    if (!running_) return;
+    requests_.push_back({ ring_.written(), RequestType::BeginRun, trackLength });
+}
+
+void LiveDelta::endRun() {
+    std::lock_guard<std::mutex> lk(mutex_);
+    if (!running_) return;
+    requests_.push_back({ ring_.written(), RequestType::EndRun, 0.0f });
+}
+
+void LiveDelta::newBest() {
+    std::lock_guard<std::mutex> lk(mutex_);
+    if (!running_) return;
+    requests_.push_back({ ring_.written(), RequestType::NewBest, 0.0f });
+}
+
+void LiveDelta::clearBest() {
+    std::lock_guard<std::mutex> lk(mutex_);
+    if (!running_) return;
+    requests_.push_back({ ring_.written(), RequestType::ClearBest, 0.0f });
+}
+
+// Delta loop, once per telemetry sample period
+void LiveDelta::run() {
+    Tracer::getInstance().nameThread("Live delta");
+
+    // The handler's locks are timed; take this thread's metrics shard now
+    // rather than with the first delta, once riding
+    Metrics::getInstance().add(Counter::TelemetrySkipped, 0);
+    const auto interval = std::chrono::microseconds(1000000 / rateHz_);
+
+    std::unique_lock<std::mutex> lk(mutex_);
+    while (running_) {
+        lk.unlock();
+        drain();
+        lk.lock();
+        cv_.wait_for(lk, interval, [this] { return !running_; });
+    }
+}
+
+// Process every sample pushed since the last call, applying requests at the
+// samples they were made at, then report the newest delta
+void LiveDelta::drain() {
+    TRACE_SCOPE("telemetry", "delta");
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        applying_.swap(requests_);
+    }
+
+    const uint64_t skippedBefore = reader_.skipped();
+    TelemetrySample sample;
+    for (const Request& request : applying_) {
+        while (reader_.position() < request.atSample && reader_.next(sample)) {
+            process(sample, reader_.position() - 1);
+        }
+        apply(request);
+    }
+    applying_.clear();
+
+    {
+        STEADY_STATE_SCOPE("delta");
+        while (reader_.next(sample)) {
+            process(sample, reader_.position() - 1);
+        }
+
+        const bool unchanged = delta_ == reported_ || (std::isnan(delta_) && std::isnan(reported_));
+        if (!unchanged) {
+            reported_ = delta_;
+            handler_(delta_);
+        }
+    }
+
+    if (reader_.skipped() != skippedBefore) {
+        Metrics::getInstance().add(Counter::TelemetrySkipped, reader_.skipped() - skippedBefore);
+    }
+}
+
+void LiveDelta::process(const TelemetrySample& sample, uint64_t index) {
+    if (!riding_) return;
+
+    const float pos = std::clamp<float>(sample.trackPos, 0.0f, 1.0f);
+    if (firstSample_) {
+        // Out of the pits the bike joins somewhere along the track, that
+        // lap can't be compared. Runs that start at the line (the
+        // simulator's) count from the first sample.
+        firstSample_ = false;
+        lapStart_ = sample.time;
+        current_.restart(pos < 0.01f);
+    }
+    else if (pos + 0.5f < lastTrackPos_) {
+        // Crossed the line between the last sample and this one
+        const float before = 1.0f - lastTrackPos_;
+        const float crossing = lastSampleTime_ + (sample.time - lastSampleTime_) * before / (before + pos);
+        current_.add(trackLength_, crossing - lapStart_, LIVE_DELTA_STEP, trackLength_);
+        finishLap(index);
+        lapStart_ = crossing;
+    }
+    lastTrackPos_ = pos;
+    lastSampleTime_ = sample.time;
+
+    const float distance = pos * trackLength_;
+    const float lapTime = sample.time - lapStart_;
+    current_.add(distance, lapTime, LIVE_DELTA_STEP, trackLength_);
+
+    delta_ = current_.fromLine && best_.complete()
+        ? lapTime - bestTimeAt(distance)
+        : std::numeric_limits<float>::quiet_NaN();
+}
+
+void LiveDelta::apply(const Request& request) {
+    switch (request.type) {
+    case RequestType::BeginRun: {
+        riding_ = request.trackLength > 0.0f;
+        if (!riding_) break;
+
+        // Grids only change size with the track, never while riding
+        if (request.trackLength != trackLength_) {
+            trackLength_ = request.trackLength;
+            const size_t points = static_cast<size_t>(std::ceil(trackLength_ / LIVE_DELTA_STEP)) + 1;
+            current_.times.resize(points);
+            finished_.times.resize(points);
+            best_.times.resize(points);
+            best_.restart(false);
+        }
+        finished_.restart(false);
+        firstSample_ = true;
+        promoteBefore_ = 0;
+        break;
+    }
+    case RequestType::EndRun:
+        riding_ = false;
+        break;
+
+    case RequestType::NewBest: {
+        // The game may report the lap just before or just after the sample
+        // that crosses the line, allow a second either way
+        const uint64_t window = static_cast<uint64_t>(rateHz_);
+        if (finished_.complete() && request.atSample <= finished_.endSample + window) {
+            std::swap(best_, finished_);
+            finished_.restart(false);
+        }
+        else {
+            promoteBefore_ = request.atSample + window;
+        }
+        break;
+    }
+    case RequestType::ClearBest:
+        best_.restart(false);
+        promoteBefore_ = 0;
+        break;
+    }
+
+    if (!riding_ || !best_.complete()) {
+        delta_ = std::numeric_limits<float>::quiet_NaN();
+    }
+}
+
+// Keep the lap that just ended until it's known whether it was a best
+void LiveDelta::finishLap(uint64_t index) {
+    current_.endSample = index;
+    std::swap(current_, finished_);
+    current_.restart(true);
+
+    if (index < promoteBefore_ && finished_.complete()) {
+        std::swap(best_, finished_);
+        finished_.restart(false);
+    }
+    promoteBefore_ = 0;
+}
+
+// The best lap's time at `distance`, between the two grid points around it
+float LiveDelta::bestTimeAt(float distance) const {
+    const std::vector<float>& times = best_.times;
+    const size_t i = std::min<size_t>(static_cast<size_t>(distance / LIVE_DELTA_STEP), times.size() - 2);
+    const float from = i * LIVE_DELTA_STEP;
+    const float to = std::min<float>((i + 1) * LIVE_DELTA_STEP, trackLength_);
+    const float fraction = to > from ? std::clamp<float>((distance - from) / (to - from), 0.0f, 1.0f) : 0.0f;
+    return times[i] + (times[i + 1] - times[i]) * fraction;
+}
@@ -0,0 +1,102 @@
+
+// LiveDelta.h
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Telemetry.h"
+
+// Time gained or lost against the session's best lap at the same distance
+// along the track, worked out for every telemetry sample on a thread that
+// follows the telemetry ring.
+//
+// Each lap is laid onto a grid of the time it reached every LIVE_DELTA_STEP
+// meters as it is ridden, so a finished lap is already a profile and a
+// lookup is an index and one interpolation. Three grids are swapped around,
+// never reallocated while riding: the lap in progress, the last finished
+// one (until it is known whether it was a best) and the best.
+//
+// Runs, bests and resets are requested from the callback handlers and tied
+// to the number of samples pushed at the time, as with TelemetryRecorder.
+class LiveDelta {
+public:
+    // Called on the delta thread when the delta changes, in seconds
+    // (negative is ahead), NaN while there is nothing to compare against
+    using DeltaHandler = std::function<void(float delta)>;
+
+    explicit LiveDelta(const TelemetryRing& ring);
+    ~LiveDelta();
+
+    LiveDelta(const LiveDelta&) = delete;
+    LiveDelta& operator=(const LiveDelta&) = delete;
+
+    // Checks for new samples `rateHz` times a second
+    void start(int rateHz, DeltaHandler handler);
+    void stop();
+
+    void beginRun(float trackLength);
+    void endRun();
+    void newBest();         // the lap just completed is the session's best
+    void clearBest();       // session over
+
+private:
+    enum class RequestType { BeginRun, EndRun, NewBest, ClearBest };
+
+    struct Request {
+        uint64_t atSample;
+        RequestType type;
+        float trackLength;
+    };
+
+    // Seconds from the line at every grid point, filled in as the lap goes
+    struct Lap {
+        std::vector<float> times;
+        size_t filled = 0;
+        float lastDistance = 0.0f;      // last sample, from the line
+        float lastTime = 0.0f;
+        bool fromLine = false;          // not out of the pits
+        uint64_t endSample = 0;
+
+        void restart(bool atLine);
+        void add(float distance, float time, float step, float trackLength);
+        bool complete() const { return fromLine && filled == times.size(); }
+    };
+
+    void run();
+    void drain();
+    void process(const TelemetrySample& sample, uint64_t index);
+    void apply(const Request& request);
+    void finishLap(uint64_t index);
+    float bestTimeAt(float distance) const;
+
+    const TelemetryRing& ring_;
+    TelemetryRing::Reader reader_;
+
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool running_ = false;
+    std::vector<Request> requests_;     // guarded by mutex_
+
+    // Delta thread only
+    int rateHz_ = 0;
+    DeltaHandler handler_;
+    std::vector<Request> applying_;
+    Lap current_, finished_, best_;
+    float trackLength_ = 0.0f;
+    bool riding_ = false;
+    bool firstSample_ = false;
+    float lapStart_ = 0.0f;             // sample time at the line
+    float lastTrackPos_ = 0.0f;
+    float lastSampleTime_ = 0.0f;
+    uint64_t promoteBefore_ = 0;        // the next lap is a best if it ends before this
+    float delta_ = std::numeric_limits<float>::quiet_NaN();
+    float reported_ = std::numeric_limits<float>::quiet_NaN();
+};
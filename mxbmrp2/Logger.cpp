@@ -3,12 +3,15 @@
 #include "pch.h"
 
 #include <mutex>
-#include <iomanip>
+#include <algorithm>
+#include <iterator>
+#include <vector>
 #ifdef _DEBUG
 #include <iostream>
 #endif
 
 #include "Logger.h"
+#include "Lz4.h"
 
 // Singleton instance
 Logger& Logger::getInstance() {
@@ -16,54 +19,317 @@ Logger& Logger::getInstance() {
     return instance;
 }
 
+namespace {
+    constexpr const char* LEVEL_NAMES[] = { "debug", "info", "warning", "error", "off" };
+    constexpr const char* CATEGORY_NAMES[] = { "general", "memory", "callbacks", "discord", "io" };
+    static_assert(std::size(CATEGORY_NAMES) == static_cast<size_t>(LogCategory::Count));
+
+    int64_t steadyNowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+}
+
+// Rate limiter
+LogRateLimiter::LogRateLimiter(double perSecond, int burst)
+    : intervalNs_(static_cast<int64_t>(1e9 / perSecond)),
+      toleranceNs_(intervalNs_ * (std::max<int>(burst, 1) - 1)) {
+}
+
+// Take a token if one is available
+bool LogRateLimiter::allow(uint32_t& suppressed) {
+    const int64_t now = steadyNowNs();
+    int64_t due = dueNs_.load(std::memory_order_relaxed);
+    while (true) {
+        int64_t start = std::max<int64_t>(due, now);
+        if (start - now > toleranceNs_) {
+            suppressed_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        if (dueNs_.compare_exchange_weak(due, start + intervalNs_, std::memory_order_relaxed)) {
+            break;
+        }
+    }
+    suppressed = suppressed_.exchange(0, std::memory_order_relaxed);
+    return true;
+}
+
 // Constructor
-Logger::Logger() = default;
+Logger::Logger() {
+    for (auto& level : minLevels_) {
+        level.store(LogLevel::Info, std::memory_order_relaxed);
+    }
+}
 
 // Destructor
 Logger::~Logger() {
+    shutdown();
     if (logFile_.is_open()) {
         logFile_.close();
     }
 }
 
 // Opens the log file
-void Logger::openLogFile() {
+void Logger::openLogFile(bool append) {
     if (logFile_.is_open()) {
         logFile_.close();
     }
-    logFile_.open(logFilePath_, std::ios::out | std::ios::trunc);
+    logFile_.open(logFilePath_, std::ios::out | (append ? std::ios::app : std::ios::trunc));
     if (!logFile_) {
         // Handle the error as needed
     }
 }
 
-// Logs a message to the log file
-void Logger::log(const std::string& message, bool newline) {
-    // get current time
-    auto now = std::chrono::system_clock::now();
-    auto t = std::chrono::system_clock::to_time_t(now);
-    std::tm tm{};
-    localtime_s(&tm, &t);
+// Queues a message for the flusher
+void Logger::log(LogLevel level, LogCategory category, std::string message, bool newline) {
+    push({ std::chrono::system_clock::now(), std::move(message), newline, level, category });
+}
 
-    std::lock_guard<std::mutex> lk(mutex_);
+// Queues a message that a rate limiter let through
+void Logger::logLimited(uint32_t suppressed, LogLevel level, LogCategory category,
+    std::string message, bool newline)
+{
+    push({ std::chrono::system_clock::now(), std::move(message), newline, level, category, suppressed });
+}
 
-#ifdef _DEBUG
-    std::cout
-        << std::put_time(&tm, "[%H:%M:%S] ")
-        << message
-        << (newline ? "\n" : "");
-#endif
+// Hands a record to the flusher, or writes it directly after shutdown
+void Logger::push(Record&& record) {
+    if (stopped_.load(std::memory_order_acquire)) {
+        std::lock_guard<std::mutex> lk(mutex_);
+        drain();
+        write(record);
+        if (logFile_.is_open()) logFile_.flush();
+        return;
+    }
 
-    if (!logFile_.is_open()) return;
-    logFile_
-        << std::put_time(&tm, "[%H:%M:%S] ")
-        << message;
-    if (newline) logFile_ << std::endl;
+    if (!queue_.tryPush(std::move(record))) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        droppedTotal_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+// Sets the minimum level logged for a category
+void Logger::setLevel(LogCategory category, LogLevel level) {
+    minLevels_[static_cast<size_t>(category)].store(level, std::memory_order_relaxed);
+}
+
+// Parses a level name from the config
+std::optional<LogLevel> Logger::parseLevel(const std::string& name) {
+    std::string lower = name;
+    std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+    for (size_t i = 0; i < std::size(LEVEL_NAMES); ++i) {
+        if (lower == LEVEL_NAMES[i]) return static_cast<LogLevel>(i);
+    }
+    return std::nullopt;
+}
+
+// Config key for a category's level
+std::string Logger::configKey(LogCategory category) {
+    return std::string("log_") + CATEGORY_NAMES[static_cast<size_t>(category)];
 }
 
 // Sets the log file name
 void Logger::setLogFileName(const std::filesystem::path& filePath) {
     std::lock_guard<std::mutex> lk(mutex_);
     logFilePath_ = filePath;
+
+    // Keep the previous session's log; the flusher compresses it
+    std::error_code ec;
+    uint64_t previousBytes = std::filesystem::file_size(logFilePath_, ec);
+    if (ec) previousBytes = 0;
+
+    if (std::filesystem::exists(rotatedPath(), ec)) {
+        // Left behind by a session that died mid-rotation. Only one file
+        // can wait, so that one goes first and the previous log is carried
+        // on until it fills up.
+        archivePending_ = true;
+        openLogFile(true);
+        fileBytes_ = previousBytes;
+    }
+    else {
+        if (previousBytes > 0) {
+            std::filesystem::rename(logFilePath_, rotatedPath(), ec);
+            archivePending_ = !ec;
+        }
+        openLogFile();
+        fileBytes_ = 0;
+    }
+
+    if (!running_ && !stopped_) {
+        running_ = true;
+        flusher_ = std::thread(&Logger::run, this);
+    }
+}
+
+// Sets the rotation limits
+void Logger::setRotation(uint64_t maxFileBytes, size_t generations, uint64_t totalBytes) {
+    std::lock_guard<std::mutex> lk(mutex_);
+    maxFileBytes_ = std::max<uint64_t>(maxFileBytes, 64 * 1024);
+    generations_ = generations;
+    totalBytes_ = totalBytes;
+}
+
+// Drains the queue and stops the flusher
+void Logger::shutdown() {
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        running_ = false;
+    }
+    cv_.notify_one();
+
+    if (flusher_.joinable()) {
+        flusher_.join();
+    }
+
+    std::lock_guard<std::mutex> lk(mutex_);
+    stopped_ = true;
+    drain();
+}
+
+// Flusher loop: batch-write whatever was queued, once per interval
+void Logger::run() {
+    std::unique_lock<std::mutex> lk(mutex_);
+    while (running_) {
+        cv_.wait_for(lk, FLUSH_INTERVAL, [this] { return !running_; });
+        drain();
+    }
+}
+
+// Writes out all queued records
+void Logger::drain() {
+    Record record;
+    bool wrote = false;
+    while (queue_.tryPop(record)) {
+        write(record);
+        wrote = true;
+        if (fileBytes_ >= maxFileBytes_) rotate();
+    }
+
+    if (uint64_t dropped = dropped_.exchange(0, std::memory_order_relaxed)) {
+        write({ std::chrono::system_clock::now(),
+            "Logger queue full, dropped " + std::to_string(dropped) + " messages",
+            true, LogLevel::Warning });
+        wrote = true;
+    }
+
+    if (wrote && logFile_.is_open()) logFile_.flush();
+
+    if (archivePending_) archiveRotated();
+}
+
+// mxbmrp2.log -> mxbmrp2.<generation>.log.lz4
+std::filesystem::path Logger::archivePath(size_t generation) const {
+    auto name = logFilePath_.stem().string() + "." + std::to_string(generation)
+        + logFilePath_.extension().string() + ".lz4";
+    return logFilePath_.parent_path() / name;
+}
+
+// Where a full log waits to be compressed
+std::filesystem::path Logger::rotatedPath() const {
+    auto path = logFilePath_;
+    path += ".rotated";
+    return path;
+}
+
+// Moves the full log aside and starts a new one. Compression happens at the
+// end of the drain, so this only costs a rename.
+void Logger::rotate() {
+    if (archivePending_) archiveRotated();
+
+    logFile_.close();
+    std::error_code ec;
+    std::filesystem::rename(logFilePath_, rotatedPath(), ec);
+    archivePending_ = !ec;
+
     openLogFile();
+    fileBytes_ = 0;
+}
+
+// Compresses the rotated log into generation 1, shifting older archives up
+void Logger::archiveRotated() {
+    archivePending_ = false;
+    const auto src = rotatedPath();
+    std::error_code ec;
+
+    if (generations_ > 0) {
+        std::ifstream in(src, std::ios::binary);
+        std::vector<uint8_t> raw((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        in.close();
+
+        std::vector<uint8_t> packed;
+        packed.reserve(raw.size() / 4);
+        Lz4::compressFrame(raw.data(), raw.size(), packed);
+
+        std::filesystem::remove(archivePath(generations_), ec);
+        for (size_t i = generations_; i > 1; --i) {
+            std::filesystem::rename(archivePath(i - 1), archivePath(i), ec);
+        }
+
+        std::ofstream out(archivePath(1), std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(packed.data()), packed.size());
+    }
+
+    std::filesystem::remove(src, ec);
+    enforceTotalSize();
+}
+
+// Deletes archives beyond the generation count, then the oldest ones until
+// the archives plus a full log fit in the total size
+void Logger::enforceTotalSize() {
+    std::error_code ec;
+    std::vector<uint64_t> sizes;
+    for (size_t i = 1; std::filesystem::exists(archivePath(i), ec); ++i) {
+        if (i > generations_) {
+            std::filesystem::remove(archivePath(i), ec);
+            continue;
+        }
+        auto size = std::filesystem::file_size(archivePath(i), ec);
+        sizes.push_back(ec ? 0 : size);
+    }
+
+    uint64_t total = maxFileBytes_;
+    for (auto size : sizes) total += size;
+
+    for (size_t i = sizes.size(); i > 0 && total > totalBytes_; --i) {
+        std::filesystem::remove(archivePath(i), ec);
+        total -= sizes[i - 1];
+    }
+}
+
+// Writes a single record with its timestamp
+void Logger::write(const Record& record) {
+    std::time_t t = std::chrono::system_clock::to_time_t(record.time);
+    if (t != stampTime_ || stamp_[0] == '\0') {
+        std::tm tm{};
+        localtime_s(&tm, &t);
+        std::strftime(stamp_, sizeof(stamp_), "[%H:%M:%S] ", &tm);
+        stampTime_ = t;
+    }
+
+    // [12:34:56] [memory] Warning: text (+3 suppressed)
+    std::string prefix = stamp_;
+    if (record.category != LogCategory::General) {
+        prefix += '[';
+        prefix += CATEGORY_NAMES[static_cast<size_t>(record.category)];
+        prefix += "] ";
+    }
+    switch (record.level) {
+    case LogLevel::Debug:   prefix += "Debug: "; break;
+    case LogLevel::Warning: prefix += "Warning: "; break;
+    case LogLevel::Error:   prefix += "Error: "; break;
+    default: break;
+    }
+    std::string suffix;
+    if (record.suppressed) {
+        suffix = " (+" + std::to_string(record.suppressed) + " suppressed)";
+    }
+
+#ifdef _DEBUG
+    std::cout << prefix << record.text << suffix << (record.newline ? "\n" : "");
+#endif
+
+    if (!logFile_.is_open()) return;
+    logFile_ << prefix << record.text << suffix;
+    if (record.newline) logFile_ << '\n';
+    fileBytes_ += prefix.size() + record.text.size() + suffix.size() + (record.newline ? 1 : 0);
 }
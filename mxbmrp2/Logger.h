@@ -8,19 +8,114 @@
 #include <filesystem>
 #include <chrono>
 #include <ctime>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
+#include <string>
+#include <array>
+#include <optional>
+
+#include "MpscQueue.h"
+
+enum class LogLevel : uint8_t {
+    Debug,
+    Info,
+    Warning,
+    Error,
+    Off
+};
+
+enum class LogCategory : uint8_t {
+    General,
+    Memory,     // memory reads, scans and offsets
+    Callbacks,  // game callbacks
+    Discord,
+    IO,         // config, stats and export files
+    Count
+};
+
+#ifdef _DEBUG
+inline constexpr bool LOG_DEBUG_BUILD = true;
+#else
+inline constexpr bool LOG_DEBUG_BUILD = false;
+#endif
+
+// Per-call-site token bucket. It is kept as the time the next message is
+// due (GCRA), so a check is a single CAS and needs no refill timer.
+class LogRateLimiter {
+public:
+    LogRateLimiter(double perSecond, int burst);
+
+    // True if a message may be logged now. `suppressed` gets the number of
+    // messages refused since the last one that was allowed.
+    bool allow(uint32_t& suppressed);
+
+private:
+    const int64_t intervalNs_;
+    const int64_t toleranceNs_;
+    std::atomic<int64_t> dueNs_{ 0 };
+    std::atomic<uint32_t> suppressed_{ 0 };
+};
 
 class Logger {
 public:
     // Retrieves the singleton instance of Logger
     static Logger& getInstance();
 
-    // Logs a message to the log file
-    void log(const std::string& message, bool newline = true);
+    // Queues a message for the log file. Never blocks; if the queue is full
+    // the message is dropped and counted. Use the LOG_* macros rather than
+    // calling this directly, so filtered messages are never formatted.
+    void log(LogLevel level, LogCategory category, std::string message, bool newline = true);
+
+    // As log(), noting how many messages a rate limiter refused before this one
+    void logLimited(uint32_t suppressed, LogLevel level, LogCategory category,
+        std::string message, bool newline = true);
+
+    bool isEnabled(LogLevel level, LogCategory category) const {
+        return level >= minLevels_[static_cast<size_t>(category)].load(std::memory_order_relaxed);
+    }
+
+    void setLevel(LogCategory category, LogLevel level);
+
+    // "debug", "info", "warning", "error" or "off"
+    static std::optional<LogLevel> parseLevel(const std::string& name);
+
+    // INI key holding the level of `category`, e.g. "log_memory"
+    static std::string configKey(LogCategory category);
 
-    // Set the log file name (must be called before any logging)
+    // Set the log file name and start the flusher (must be called before any logging).
+    // A log left by the previous session is archived rather than overwritten.
     void setLogFileName(const std::filesystem::path& filePath);
 
+    // Start a new file once the log reaches `maxFileBytes`. Full files are
+    // compressed on the flusher thread into `generations` numbered archives
+    // (mxbmrp2.1.log.lz4 is the newest), oldest deleted first to keep the
+    // log and its archives within `totalBytes`.
+    void setRotation(uint64_t maxFileBytes, size_t generations, uint64_t totalBytes);
+
+    // Write out everything queued and stop the flusher. Later messages are
+    // written synchronously.
+    void shutdown();
+
+    // Messages dropped because the queue was full, since startup
+    uint64_t droppedCount() const { return droppedTotal_.load(std::memory_order_relaxed); }
+
 private:
+    struct Record {
+        std::chrono::system_clock::time_point time;
+        std::string text;
+        bool newline = true;
+        LogLevel level = LogLevel::Info;
+        LogCategory category = LogCategory::General;
+        uint32_t suppressed = 0;
+    };
+
+    static constexpr size_t QUEUE_CAPACITY = 4096;
+    static constexpr std::chrono::milliseconds FLUSH_INTERVAL{ 100 };
+    static constexpr uint64_t DEFAULT_MAX_FILE_BYTES = 5ULL * 1024 * 1024;
+    static constexpr size_t DEFAULT_GENERATIONS = 5;
+    static constexpr uint64_t DEFAULT_TOTAL_BYTES = 25ULL * 1024 * 1024;
+
     // Private constructor to enforce singleton pattern
     Logger();
 
@@ -35,7 +130,78 @@ private:
     std::ofstream logFile_;
 
     // Internal helper to open the log file
-    void openLogFile();
+    void openLogFile(bool append = false);
+
+    // Flusher thread
+    void run();
+
+    // Write all queued records and flush the file (mutex_ held)
+    void drain();
+    void write(const Record& record);
+
+    // Rotation (mutex_ held)
+    std::filesystem::path archivePath(size_t generation) const;
+    std::filesystem::path rotatedPath() const;
+    void rotate();
+    void archiveRotated();
+    void enforceTotalSize();
+
+    uint64_t maxFileBytes_ = DEFAULT_MAX_FILE_BYTES;
+    size_t generations_ = DEFAULT_GENERATIONS;
+    uint64_t totalBytes_ = DEFAULT_TOTAL_BYTES;
+    uint64_t fileBytes_ = 0;
+    bool archivePending_ = false;   // rotatedPath() is waiting to be compressed
 
+    void push(Record&& record);
+
+    std::array<std::atomic<LogLevel>, static_cast<size_t>(LogCategory::Count)> minLevels_;
+
+    MpscQueue<Record, QUEUE_CAPACITY> queue_;
+    std::atomic<bool> stopped_{ false };
+    std::atomic<uint64_t> dropped_{ 0 };       // not yet reported in the log
+    std::atomic<uint64_t> droppedTotal_{ 0 };
+
+    // Timestamp prefix of the last record written, redone once per second
+    std::time_t stampTime_ = 0;
+    char stamp_[16] = {};
+
+    std::thread flusher_;
+    bool running_ = false;
+    std::condition_variable cv_;
     std::mutex mutex_;
 };
+
+#define LOG_AT(level, category, ...)                                                \
+    do {                                                                            \
+        Logger& logger_ = Logger::getInstance();                                    \
+        if (logger_.isEnabled(level, LogCategory::category)) {                      \
+            logger_.log(level, LogCategory::category, __VA_ARGS__);                 \
+        }                                                                           \
+    } while (0)
+
+// Arguments are only evaluated if the level is enabled for the category
+#define LOG_INFO(category, ...)     LOG_AT(LogLevel::Info, category, __VA_ARGS__)
+#define LOG_WARNING(category, ...)  LOG_AT(LogLevel::Warning, category, __VA_ARGS__)
+#define LOG_ERROR(category, ...)    LOG_AT(LogLevel::Error, category, __VA_ARGS__)
+
+// Compiled out of Release builds; still type-checked there
+#define LOG_DEBUG(category, ...)                                                    \
+    do {                                                                            \
+        if constexpr (LOG_DEBUG_BUILD) {                                            \
+            LOG_AT(LogLevel::Debug, category, __VA_ARGS__);                         \
+        }                                                                           \
+    } while (0)
+
+// At most `perSecond` messages from this call site, with bursts of `burst`
+#define LOG_RATE_LIMITED(level, category, perSecond, burst, ...)                    \
+    do {                                                                            \
+        Logger& logger_ = Logger::getInstance();                                    \
+        if (logger_.isEnabled(level, LogCategory::category)) {                      \
+            static LogRateLimiter limiter_(perSecond, burst);                       \
+            uint32_t suppressed_ = 0;                                               \
+            if (limiter_.allow(suppressed_)) {                                      \
+                logger_.logLimited(suppressed_, level, LogCategory::category,       \
+                    __VA_ARGS__);                                                   \
+            }                                                                       \
+        }                                                                           \
+    } while (0)
@@ -0,0 +1,222 @@
+
+// Lz4.cpp
+
+#include "pch.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+#include "Lz4.h"
+
+namespace {
+    constexpr size_t MIN_MATCH = 4;
+    constexpr size_t LAST_LITERALS = 5;     // a block always ends with this many literals
+    constexpr size_t MF_LIMIT = 12;         // and its last match starts at least this far from the end
+    constexpr size_t MAX_DISTANCE = 65535;
+    constexpr int HASH_BITS = 12;
+    constexpr uint32_t NO_POSITION = UINT32_MAX;
+
+    constexpr uint32_t FRAME_MAGIC = 0x184D2204;
+    constexpr uint8_t FRAME_FLG = 0x60;     // version 01, independent blocks
+    constexpr uint8_t FRAME_BD = 0x40;      // 64 KiB max block size
+    constexpr uint32_t UNCOMPRESSED_BLOCK = 0x80000000;
+
+    uint32_t read32(const uint8_t* p) {
+        uint32_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    void put32(std::vector<uint8_t>& out, uint32_t v) {
+        for (int i = 0; i < 4; ++i) {
+            out.push_back(static_cast<uint8_t>(v >> (8 * i)));
+        }
+    }
+
+    uint32_t rotl(uint32_t v, int r) {
+        return (v << r) | (v >> (32 - r));
+    }
+
+    uint32_t hashSequence(uint32_t v) {
+        return (v * 2654435761U) >> (32 - HASH_BITS);
+    }
+
+    // Lengths of 15 or more continue in 255-valued bytes after the token
+    bool getExtraLength(const uint8_t*& p, const uint8_t* end, size_t& len) {
+        uint8_t b;
+        do {
+            if (p == end) return false;
+            b = *p++;
+            len += b;
+        } while (b == 255);
+        return true;
+    }
+
+    void putExtraLength(std::vector<uint8_t>& out, size_t len) {
+        for (; len >= 255; len -= 255) out.push_back(255);
+        out.push_back(static_cast<uint8_t>(len));
+    }
+
+    void putLiterals(std::vector<uint8_t>& out, const uint8_t* lit, size_t litLen, size_t matchCode) {
+        out.push_back(static_cast<uint8_t>((std::min<size_t>(litLen, 15) << 4) | std::min<size_t>(matchCode, 15)));
+        if (litLen >= 15) putExtraLength(out, litLen - 15);
+        out.insert(out.end(), lit, lit + litLen);
+    }
+}
+
+// Greedy LZ4 block compression
+bool Lz4::compressBlock(const uint8_t* src, size_t size, std::vector<uint8_t>& out) {
+    const size_t start = out.size();
+    size_t anchor = 0;
+
+    if (size > MF_LIMIT) {
+        std::array<uint32_t, size_t{ 1 } << HASH_BITS> table;
+        table.fill(NO_POSITION);
+
+        const size_t matchStartLimit = size - MF_LIMIT;
+        const size_t matchEndLimit = size - LAST_LITERALS;
+        size_t ip = 0;
+
+        while (ip < matchStartLimit) {
+            const uint32_t sequence = read32(src + ip);
+            uint32_t& slot = table[hashSequence(sequence)];
+            size_t ref = slot;
+            slot = static_cast<uint32_t>(ip);
+
+            if (ref == NO_POSITION || ip - ref > MAX_DISTANCE || read32(src + ref) != sequence) {
+                ++ip;
+                continue;
+            }
+
+            while (ip > anchor && ref > 0 && src[ip - 1] == src[ref - 1]) {
+                --ip;
+                --ref;
+            }
+            size_t len = MIN_MATCH;
+            while (ip + len < matchEndLimit && src[ip + len] == src[ref + len]) {
+                ++len;
+            }
+
+            const size_t offset = ip - ref;
+            const size_t matchCode = len - MIN_MATCH;
+            putLiterals(out, src + anchor, ip - anchor, matchCode);
+            out.push_back(static_cast<uint8_t>(offset));
+            out.push_back(static_cast<uint8_t>(offset >> 8));
+            if (matchCode >= 15) putExtraLength(out, matchCode - 15);
+
+            ip += len;
+            anchor = ip;
+        }
+    }
+
+    putLiterals(out, src + anchor, size - anchor, 0);
+
+    if (out.size() - start >= size) {
+        out.resize(start);
+        return false;
+    }
+    return true;
+}
+
+// Decoding checks every length against both buffers, blocks may come from disk
+bool Lz4::decompressBlock(const uint8_t* src, size_t size, uint8_t* dst, size_t dstSize) {
+    const uint8_t* ip = src;
+    const uint8_t* const end = src + size;
+    size_t op = 0;
+
+    while (ip < end) {
+        const uint8_t token = *ip++;
+
+        size_t litLen = token >> 4;
+        if (litLen == 15 && !getExtraLength(ip, end, litLen)) return false;
+        if (litLen > static_cast<size_t>(end - ip) || litLen > dstSize - op) return false;
+        std::memcpy(dst + op, ip, litLen);
+        ip += litLen;
+        op += litLen;
+
+        // The last sequence is literals only
+        if (ip == end) break;
+
+        if (end - ip < 2) return false;
+        const size_t offset = ip[0] | (static_cast<size_t>(ip[1]) << 8);
+        ip += 2;
+        if (offset == 0 || offset > op) return false;
+
+        size_t matchLen = token & 15;
+        if (matchLen == 15 && !getExtraLength(ip, end, matchLen)) return false;
+        matchLen += MIN_MATCH;
+        if (matchLen > dstSize - op) return false;
+
+        // Byte by byte, a match may overlap what it produces
+        for (size_t i = 0; i < matchLen; ++i, ++op) {
+            dst[op] = dst[op - offset];
+        }
+    }
+    return op == dstSize;
+}
+
+// LZ4 frame: header, size-prefixed blocks, end mark
+void Lz4::compressFrame(const uint8_t* src, size_t size, std::vector<uint8_t>& out) {
+    put32(out, FRAME_MAGIC);
+    const uint8_t descriptor[] = { FRAME_FLG, FRAME_BD };
+    out.insert(out.end(), descriptor, descriptor + sizeof(descriptor));
+    out.push_back(static_cast<uint8_t>(xxh32(descriptor, sizeof(descriptor), 0) >> 8));
+
+    for (size_t pos = 0; pos < size; pos += BLOCK_SIZE) {
+        const size_t len = std::min<size_t>(BLOCK_SIZE, size - pos);
+        const size_t sizeAt = out.size();
+        put32(out, 0);
+
+        uint32_t blockSize;
+        if (compressBlock(src + pos, len, out)) {
+            blockSize = static_cast<uint32_t>(out.size() - sizeAt - 4);
+        }
+        else {
+            out.insert(out.end(), src + pos, src + pos + len);
+            blockSize = static_cast<uint32_t>(len) | UNCOMPRESSED_BLOCK;
+        }
+        for (int i = 0; i < 4; ++i) {
+            out[sizeAt + i] = static_cast<uint8_t>(blockSize >> (8 * i));
+        }
+    }
+
+    put32(out, 0);
+}
+
+// xxHash32
+uint32_t Lz4::xxh32(const uint8_t* data, size_t size, uint32_t seed) {
+    constexpr uint32_t P1 = 2654435761U, P2 = 2246822519U, P3 = 3266489917U, P4 = 668265263U, P5 = 374761393U;
+
+    const uint8_t* p = data;
+    const uint8_t* end = data + size;
+    uint32_t h;
+
+    if (size >= 16) {
+        uint32_t v[4] = { seed + P1 + P2, seed + P2, seed, seed - P1 };
+        for (; p + 16 <= end; p += 16) {
+            for (int i = 0; i < 4; ++i) {
+                v[i] = rotl(v[i] + read32(p + 4 * i) * P2, 13) * P1;
+            }
+        }
+        h = rotl(v[0], 1) + rotl(v[1], 7) + rotl(v[2], 12) + rotl(v[3], 18);
+    }
+    else {
+        h = seed + P5;
+    }
+
+    h += static_cast<uint32_t>(size);
+    for (; p + 4 <= end; p += 4) {
+        h = rotl(h + read32(p) * P3, 17) * P4;
+    }
+    for (; p < end; ++p) {
+        h = rotl(h + *p * P5, 11) * P1;
+    }
+
+    h ^= h >> 15;
+    h *= P2;
+    h ^= h >> 13;
+    h *= P3;
+    h ^= h >> 16;
+    return h;
+}
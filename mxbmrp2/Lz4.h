@@ -0,0 +1,31 @@
+
+// Lz4.h
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Minimal LZ4 codec for log archives and telemetry recordings. Frames are
+// standard (independent 64 KiB blocks, no content checksum), so archives
+// open with the stock lz4 tool. Greedy single-probe matching: fast, not the
+// best ratio.
+namespace Lz4 {
+
+    inline constexpr size_t BLOCK_SIZE = 64 * 1024;
+
+    // Compress one block into `out` (appended). Returns false if it didn't
+    // shrink, in which case nothing is appended.
+    bool compressBlock(const uint8_t* src, size_t size, std::vector<uint8_t>& out);
+
+    // Decompress one block into exactly `dstSize` bytes. False if the block
+    // is malformed or doesn't decode to that size.
+    bool decompressBlock(const uint8_t* src, size_t size, uint8_t* dst, size_t dstSize);
+
+    // Append a frame header, `size` bytes as blocks, and the end mark
+    void compressFrame(const uint8_t* src, size_t size, std::vector<uint8_t>& out);
+
+    // xxHash32, used for the frame header checksum
+    uint32_t xxh32(const uint8_t* data, size_t size, uint32_t seed);
+}
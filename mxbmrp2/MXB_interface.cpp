@@ -7,11 +7,30 @@
 #include "MXB_interface.h"
 #include "Logger.h"
 #include "Plugin.h"
+#include "Tracer.h"
+#include "Metrics.h"
+#include "EventDispatcher.h"
+#include "CallbackCapture.h"
+#include "SteadyState.h"
 
 namespace {
     static std::vector<char>            g_fontNameBuf;
     static std::vector<SPluginQuad_t>   g_quadsBuf;
     static std::vector<SPluginString_t> g_strsBuf;
+
+    // Record a callback as the game made it, before it's filtered or queued
+    template <typename T>
+    void capture(CallbackType type, const T& payload) {
+        if (auto* writer = EventDispatcher::getInstance().capture()) {
+            writer->write(type, &payload, sizeof(payload));
+        }
+    }
+
+    void capture(CallbackType type) {
+        if (auto* writer = EventDispatcher::getInstance().capture()) {
+            writer->write(type, nullptr, 0);
+        }
+    }
 }
 
 // Exported functions
@@ -34,23 +53,39 @@ __declspec(dllexport) int GetInterfaceVersion() {
 // Startup: Called when software is started
 __declspec(dllexport) int Startup(char* _szSavePath) {
     Plugin::getInstance().onStartup(_szSavePath);
-    return REFRESH_RATE;
+
+    // From here on the callbacks below are handled on the event thread
+    EventDispatcher::getInstance().start();
+
+    // Telemetry rate: 0 = 100 Hz, 1 = 50 Hz, 2 = 20 Hz, 3 = 10 Hz, -1 = none
+    return Plugin::getInstance().getTelemetryRate();
 }
 
 // Shutdown: Called when software is closed
 __declspec(dllexport) void Shutdown() {
+    EventDispatcher::getInstance().stop();
     Plugin::getInstance().onShutdown();
 }
 
 // EventInit: Called when event is initialized (Testing/Race)
 __declspec(dllexport) void EventInit(void* _pData, int _iDataSize) {
-    SPluginsBikeEvent_t* psEventData = (SPluginsBikeEvent_t*)_pData;
-    Plugin::getInstance().onEventInit(*psEventData);
+    TRACE_SCOPE("callback", "EventInit");
+    METRICS_TIME(Histogram::CallbackEventInit);
+    CallbackEvent event{};
+    event.type = CallbackType::EventInit;
+    event.bikeEvent = *static_cast<const SPluginsBikeEvent_t*>(_pData);
+    capture(event.type, event.bikeEvent);
+    EventDispatcher::getInstance().post(event);
 }
 
 // EventDeinit: Called when event is closed
 __declspec(dllexport) void EventDeinit() {
-    Plugin::getInstance().onEventDeinit();
+    TRACE_SCOPE("callback", "EventDeinit");
+    METRICS_TIME(Histogram::CallbackEventDeinit);
+    CallbackEvent event{};
+    event.type = CallbackType::EventDeinit;
+    capture(event.type);
+    EventDispatcher::getInstance().post(event);
 }
 
 // DrawInit: called when software is started.
@@ -78,24 +113,32 @@ __declspec(dllexport) int DrawInit(int* outNumSprites,
 
 // Draw: Called every frame
 __declspec(dllexport) void Draw(int state, int* outNumQuads, void** outQuads, int* outNumStrings, void** outStrings) {
+    TRACE_SCOPE("callback", "Draw");
+    METRICS_TIME(Histogram::Draw);
+    STEADY_STATE_SCOPE("draw");
     // only update on state change
     static int lastState = -1;
     auto& plugin = Plugin::getInstance();
     if (state != lastState) {
-        plugin.onStateChange(state);
+        CallbackEvent event{};
+        event.type = CallbackType::StateChange;
+        event.state = state;
+        capture(event.type, event.state);
+        EventDispatcher::getInstance().post(event);
         lastState = state;
     }
 
     // get what we should display
-    const auto display = plugin.getDisplayKeys();
-    if (display.empty()) {
+    const auto snapshot = plugin.getDisplaySnapshot();
+    if (!snapshot || snapshot->lines.empty()) {
         *outNumQuads = 0; *outQuads = nullptr;
         *outNumStrings = 0; *outStrings = nullptr;
         return;
     }
 
     // Cache frequently-used config values
-    const auto& cfg = plugin.displayConfig_;
+    const auto& display = snapshot->lines;
+    const auto& cfg = snapshot->config;
     const float x0 = cfg.positionX;
     const float y0 = cfg.positionY;
     const float lineH = cfg.lineHeight;
@@ -130,13 +173,13 @@ __declspec(dllexport) void Draw(int state, int* outNumQuads, void** outQuads, in
 
     // Build the string buffer
     g_strsBuf.clear();
-    g_strsBuf.reserve(display.size() + 1); // +1 if a line is split
+    g_strsBuf.reserve(Plugin::configKeyToDisplayNameMap.size() + 1); // room for every key, +1 if a line is split
 
     for (size_t row = 0; row < display.size(); ++row) {
-        const std::string& line = display[row];
+        const PluginHelpers::DisplayLine& line = display[row];
 
         // Special-case: split "Setup Name: Default"
-        if (line == "Setup Name: Default") {
+        if (line.view() == "Setup Name: Default") {
             // How long since we went on-track?
             uint64_t startMs = plugin.lastRunInitMs_.load(std::memory_order_relaxed);
             uint64_t nowMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
@@ -150,7 +193,7 @@ __declspec(dllexport) void Draw(int state, int* outNumQuads, void** outQuads, in
 
         // Normal path, with optional banner colour on the first row
         uint32_t colour = cfg.fontColor;
-        if (row == 0 && line.rfind("mxbmrp2", 0) == 0)
+        if (row == 0 && line.view().rfind("mxbmrp2", 0) == 0)
             colour = 0xFF0081CC; // orange
 
         pushString(row, line.c_str(), colour);
@@ -163,84 +206,169 @@ __declspec(dllexport) void Draw(int state, int* outNumQuads, void** outQuads, in
 
 // RunInit: Called when bike goes to track
 __declspec(dllexport) void RunInit(void* _pData, int _iDataSize) {
-    SPluginsBikeSession_t* psSessionData = (SPluginsBikeSession_t*)_pData;
-    Plugin::getInstance().onRunInit(*psSessionData);
+    TRACE_SCOPE("callback", "RunInit");
+    METRICS_TIME(Histogram::CallbackRunInit);
+    CallbackEvent event{};
+    event.type = CallbackType::RunInit;
+    event.bikeSession = *static_cast<const SPluginsBikeSession_t*>(_pData);
+    capture(event.type, event.bikeSession);
+    EventDispatcher::getInstance().post(event);
+}
+
+// RunTelemetry: Called at the rate Startup returned while the bike is on track.
+// Not queued: the sample goes straight into the telemetry ring.
+__declspec(dllexport) void RunTelemetry(void* _pData, int _iDataSize, float _fTime, float _fPos) {
+    TRACE_SCOPE("callback", "RunTelemetry");
+    METRICS_TIME(Histogram::CallbackRunTelemetry);
+    STEADY_STATE_SCOPE("telemetry");
+    if (auto* writer = EventDispatcher::getInstance().capture()) {
+        writer->writeTelemetry(*static_cast<const SPluginsBikeData_t*>(_pData), _fTime, _fPos);
+    }
+    TelemetrySample sample;
+    sample.bike = *static_cast<const SPluginsBikeData_t*>(_pData);
+    sample.time = _fTime;
+    sample.trackPos = _fPos;
+    Plugin::getInstance().onRunTelemetry(sample);
 }
 
 // RunDeInit: Called when bike leaves the track
 __declspec(dllexport) void RunDeinit() {
-    Plugin::getInstance().onRunDeinit();
+    TRACE_SCOPE("callback", "RunDeinit");
+    METRICS_TIME(Histogram::CallbackRunDeinit);
+    CallbackEvent event{};
+    event.type = CallbackType::RunDeinit;
+    capture(event.type);
+    EventDispatcher::getInstance().post(event);
 }
 
 // RaceSession: Called when Session Starts
 __declspec(dllexport) void RaceSession(void* _pData, int _iDataSize) {
-    SPluginsRaceSession_t* psRaceSession = (SPluginsRaceSession_t*)_pData;
-    Plugin::getInstance().onRaceSession(*psRaceSession);
+    TRACE_SCOPE("callback", "RaceSession");
+    METRICS_TIME(Histogram::CallbackRaceSession);
+    CallbackEvent event{};
+    event.type = CallbackType::RaceSession;
+    event.raceSession = *static_cast<const SPluginsRaceSession_t*>(_pData);
+    capture(event.type, event.raceSession);
+    EventDispatcher::getInstance().post(event);
 }
 
 // RaceSessionState: Called when Session Ends
 __declspec(dllexport) void RaceSessionState(void* _pData, int _iDataSize) {
-    SPluginsRaceSessionState_t* psRaceSessionState = (SPluginsRaceSessionState_t*)_pData;
-    Plugin::getInstance().onRaceSessionState(*psRaceSessionState);
+    TRACE_SCOPE("callback", "RaceSessionState");
+    METRICS_TIME(Histogram::CallbackRaceSessionState);
+    CallbackEvent event{};
+    event.type = CallbackType::RaceSessionState;
+    event.raceSessionState = *static_cast<const SPluginsRaceSessionState_t*>(_pData);
+    capture(event.type, event.raceSessionState);
+    EventDispatcher::getInstance().post(event);
 }
 
 // RaceEvent: Called when a race or replay is initialized
 __declspec(dllexport) void RaceEvent(void* _pData, int _iDataSize) {
-    SPluginsRaceEvent_t* psRaceEvent = (SPluginsRaceEvent_t*)_pData;
-    Plugin::getInstance().onRaceEvent(*psRaceEvent);
+    TRACE_SCOPE("callback", "RaceEvent");
+    METRICS_TIME(Histogram::CallbackRaceEvent);
+    CallbackEvent event{};
+    event.type = CallbackType::RaceEvent;
+    event.raceEvent = *static_cast<const SPluginsRaceEvent_t*>(_pData);
+    capture(event.type, event.raceEvent);
+    EventDispatcher::getInstance().post(event);
 }
 
 // RaceAddEntry: Called when a new entry is added to the race
 __declspec(dllexport) void RaceAddEntry(void* _pData, int _iDataSize) {
-    SPluginsRaceAddEntry_t* psRaceAddEntry = (SPluginsRaceAddEntry_t*)_pData;
-    Plugin::getInstance().onRaceAddEntry(*psRaceAddEntry);
+    TRACE_SCOPE("callback", "RaceAddEntry");
+    METRICS_TIME(Histogram::CallbackRaceAddEntry);
+    CallbackEvent event{};
+    event.type = CallbackType::RaceAddEntry;
+    event.raceAddEntry = *static_cast<const SPluginsRaceAddEntry_t*>(_pData);
+    capture(event.type, event.raceAddEntry);
+    EventDispatcher::getInstance().post(event);
 }
 
 // RaceRemoveEntry: Called when a race entry is removed
 __declspec(dllexport) void RaceRemoveEntry(void* _pData, int _iDataSize) {
-    SPluginsRaceRemoveEntry_t* psRaceRemoveEntry = (SPluginsRaceRemoveEntry_t*)_pData;
-    Plugin::getInstance().onRaceRemoveEntry(*psRaceRemoveEntry);
+    TRACE_SCOPE("callback", "RaceRemoveEntry");
+    METRICS_TIME(Histogram::CallbackRaceRemoveEntry);
+    CallbackEvent event{};
+    event.type = CallbackType::RaceRemoveEntry;
+    event.raceRemoveEntry = *static_cast<const SPluginsRaceRemoveEntry_t*>(_pData);
+    capture(event.type, event.raceRemoveEntry);
+    EventDispatcher::getInstance().post(event);
 }
 
 __declspec(dllexport) void RunStart() {
-    Plugin::getInstance().onRunStart();
+    TRACE_SCOPE("callback", "RunStart");
+    METRICS_TIME(Histogram::CallbackRunStart);
+    CallbackEvent event{};
+    event.type = CallbackType::RunStart;
+    capture(event.type);
+    EventDispatcher::getInstance().post(event);
 }
 
 __declspec(dllexport) void RunStop() {
-    Plugin::getInstance().onRunStop();
+    TRACE_SCOPE("callback", "RunStop");
+    METRICS_TIME(Histogram::CallbackRunStop);
+    CallbackEvent event{};
+    event.type = CallbackType::RunStop;
+    capture(event.type);
+    EventDispatcher::getInstance().post(event);
 }
 
 // RaceClassification
 __declspec(dllexport) void RaceClassification(void* _pData, int   _iDataSize, void* _pArray, int   _iElemSize) {
+    TRACE_SCOPE("callback", "RaceClassification");
+    METRICS_TIME(Histogram::CallbackRaceClassification);
     SPluginsRaceClassification_t* psRaceClassification =
         (SPluginsRaceClassification_t*)_pData;
+    if (auto* writer = EventDispatcher::getInstance().capture()) {
+        writer->writeClassification(*psRaceClassification, _pArray, _iElemSize);
+    }
 
     // Dont flood the plugin
     static int lastSecond = -1;
     int curSecond = psRaceClassification->m_iSessionTime / 1000;
     if (curSecond != lastSecond) {
         lastSecond = curSecond;
-        Plugin::getInstance().onRaceClassification(*psRaceClassification);
+        CallbackEvent event{};
+        event.type = CallbackType::RaceClassification;
+        event.raceClassification = *psRaceClassification;
+        EventDispatcher::getInstance().post(event);
     }
 }
 
 // RunLap
 __declspec(dllexport) void RunLap(void* _pData, int _iDataSize) {
-    SPluginsBikeLap_t* psLapData = (SPluginsBikeLap_t*)_pData;
-    Plugin::getInstance().onRunLap(*psLapData);
+    TRACE_SCOPE("callback", "RunLap");
+    METRICS_TIME(Histogram::CallbackRunLap);
+    CallbackEvent event{};
+    event.type = CallbackType::RunLap;
+    event.bikeLap = *static_cast<const SPluginsBikeLap_t*>(_pData);
+    capture(event.type, event.bikeLap);
+    EventDispatcher::getInstance().post(event);
 }
 
 // RunSplit: Called when a split is crossed
 __declspec(dllexport) void RunSplit(void* _pData, int _iDataSize) {
-    SPluginsBikeSplit_t* psSplitData = (SPluginsBikeSplit_t*)_pData;
-    Plugin::getInstance().onRunSplit(*psSplitData);
+    TRACE_SCOPE("callback", "RunSplit");
+    METRICS_TIME(Histogram::CallbackRunSplit);
+    CallbackEvent event{};
+    event.type = CallbackType::RunSplit;
+    event.bikeSplit = *static_cast<const SPluginsBikeSplit_t*>(_pData);
+    capture(event.type, event.bikeSplit);
+    EventDispatcher::getInstance().post(event);
 }
 
 // RaceCommunication: Called when a penalty or state change occurs
 __declspec(dllexport) void RaceCommunication(void* _pData, int _iDataSize) {
+    TRACE_SCOPE("callback", "RaceCommunication");
+    METRICS_TIME(Histogram::CallbackRaceCommunication);
     SPluginsRaceCommunication_t* psRaceCommunication = (SPluginsRaceCommunication_t*)_pData;
+    capture(CallbackType::RaceCommunication, *psRaceCommunication);
 
     if (psRaceCommunication->m_iCommunication == 2 && psRaceCommunication->m_iOffence == 2 && psRaceCommunication->m_iTime > 0) {
-        Plugin::getInstance().onRaceCommunication(*psRaceCommunication);
+        CallbackEvent event{};
+        event.type = CallbackType::RaceCommunication;
+        event.raceCommunication = *psRaceCommunication;
+        EventDispatcher::getInstance().post(event);
     }
 }
@@ -36,6 +36,35 @@ extern "C" {
         char m_szSetupFileName[100];
     } SPluginsBikeSession_t;
 
+    // RunTelemetry
+    typedef struct {
+        int m_iRPM;                         // engine rpm
+        float m_fEngineTemperature;         // degrees Celsius
+        float m_fWaterTemperature;          // degrees Celsius
+        int m_iGear;                        // 0 = Neutral
+        float m_fFuel;                      // liters
+        float m_fSpeedometer;               // meters/second
+        float m_fPosX, m_fPosY, m_fPosZ;    // world position of a reference point attached to chassis (not CG)
+        float m_fVelocityX, m_fVelocityY, m_fVelocityZ;             // velocity of CG in world coordinates, meters/second
+        float m_fAccelerationX, m_fAccelerationY, m_fAccelerationZ; // acceleration of CG local to chassis rotation, in G, averaged over 10 ms
+        float m_aafRot[3][3];               // rotation matrix of the chassis
+        float m_fYaw, m_fPitch, m_fRoll;    // degrees, -180 to 180
+        float m_fYawVelocity, m_fPitchVelocity, m_fRollVelocity;    // degrees/second
+        float m_afSuspLength[2];            // shocks length, 0 = front, 1 = rear, meters
+        float m_afSuspVelocity[2];          // shocks velocity, 0 = front, 1 = rear, meters/second
+        int m_iCrashed;                     // 1 = rider is detached from bike
+        float m_fSteer;                     // degrees, negative = right
+        float m_fInputThrottle;             // 0 to 1
+        float m_fThrottle;                  // 0 to 1
+        float m_fFrontBrake;                // 0 to 1
+        float m_fRearBrake;                 // 0 to 1
+        float m_fClutch;                    // 0 to 1, 0 = fully engaged
+        float m_afWheelSpeed[2];            // meters/second, 0 = front, 1 = rear
+        int m_aiWheelMaterial[2];           // material index, 0 = not in contact
+        float m_afBrakePressure[2];         // kPa
+        float m_fSteerTorque;               // Nm
+    } SPluginsBikeData_t;
+
     // DrawInit
     typedef struct {
         float m_aafPos[4][2];
@@ -165,6 +194,7 @@ extern "C" {
     __declspec(dllexport) void RaceRemoveEntry(void* _pData, int _iDataSize);
     __declspec(dllexport) void RunStart();
     __declspec(dllexport) void RunStop();
+    __declspec(dllexport) void RunTelemetry(void* _pData, int _iDataSize, float _fTime, float _fPos);
     __declspec(dllexport) void RaceClassification(void* _pData, int _iDataSize, void* _pArray, int   _iElemSize);
    __declspec(dllexport) void RunLap(void* _pData, int _iDataSize);
    __declspec(dllexport) void RunSplit(void* _pData, int _iDataSize);
@@ -11,8 +11,14 @@
 #include <chrono>
 
 #include "MemReader.h"
+#include "MemReaderHelpers.h"
+#include "OffsetScanner.h"
+#include "OffsetDatabase.h"
+#include "ConfigManager.h"
 #include "Logger.h"
 #include "Constants.h"
+#include "Tracer.h"
+#include "Metrics.h"
 
 // Singleton Instance
 MemReader& MemReader::getInstance() {
@@ -21,76 +27,93 @@ MemReader& MemReader::getInstance() {
 }
 
 // Constructor
-MemReader::MemReader() : baseAddress_(0) {}
+MemReader::MemReader()
+    : baseAddress_(0),
+      regionMap_(createProcessRegionSource()) {
+    for (auto& offset : offsets_) {
+        offset.store(UNKNOWN_OFFSET, std::memory_order_relaxed);
+    }
+}
 
 // Destructor
-MemReader::~MemReader() = default;
-
-// Helper to convert an integer to a hexadecimal string
-std::string addressToHex(uintptr_t address) {
-    std::ostringstream oss;
-    oss << "0x" << std::hex << std::uppercase << address;
-    return oss.str();
+MemReader::~MemReader() {
+    shutdown();
 }
 
 // Initialize MemReader
-void MemReader::initialize() {
+void MemReader::initialize(
+    const std::filesystem::path& offsetsCachePath,
+    const std::filesystem::path& offsetsOverridePath)
+{
     HMODULE hModule = GetModuleHandle(nullptr);
     if (hModule == nullptr) {
-        Logger::getInstance().log("Failed to get module handle");
+        LOG_ERROR(Memory, "Failed to get module handle");
         return;
     }
     baseAddress_ = reinterpret_cast<uintptr_t>(hModule);
 
     // Use addressToHex to convert the base address to a string
-    Logger::getInstance().log("MemReader initialized with base address: " + addressToHex(baseAddress_));
-}
+    LOG_INFO(Memory, "MemReader initialized with base address: " + MemReaderHelpers::addressToHex(baseAddress_));
 
-// Helper to validate server name
-static bool isValid(const std::string& s) {
-    auto pos = s.find('\0');
-    // must have at least three ASCII chars before the NUL, and at least one NUL
-    if (pos == std::string::npos || pos < 3) return false;
+    offsetsCachePath_ = offsetsCachePath;
+    selectOffsets(offsetsOverridePath);
+    publishOffsets();
+}
 
-    // all bytes before pos must be printable ASCII
-    if (!std::all_of(s.begin(), s.begin() + pos,
-        [](unsigned char c) { return c >= 32 && c <= 125; }))
-        return false;
+// Stop offset discovery
+void MemReader::shutdown() {
+    cancelDiscovery_ = true;
+    if (discoveryThread_.joinable()) {
+        discoveryThread_.join();
+    }
+}
 
-    // all bytes from pos to end must be NUL
-	// Disabled this check since non-dedicated servers may have trailing NULs in the result
-    //if (!std::all_of(s.begin() + pos, s.end(),
-    //    [](unsigned char c) { return c == '\0'; }))
-    //    return false;
+// Returns the offset published for this build
+std::optional<unsigned long> MemReader::getOffset(MemoryOffset offset) const {
+    uint64_t value = offsets_[static_cast<size_t>(offset)].load(std::memory_order_relaxed);
+    if (value == UNKNOWN_OFFSET) return std::nullopt;
+    return static_cast<unsigned long>(value);
+}
 
-    return true;
+void MemReader::refreshOffsets() {
+    publishOffsets();
 }
 
-// Helper to convert a byte buffer to a hex string
-static std::string bufferToHex(const std::vector<uint8_t>& buf) {
-    std::ostringstream oss;
-    for (uint8_t b : buf) {
-        oss << std::hex << std::setw(2) << std::setfill('0')
-            << std::uppercase << static_cast<int>(b);
+// Resolve every offset once, so reads don't look up keys or take a lock:
+// overrides, then the build's offsets, then mxbmrp2.ini for the offsets
+// nothing else covers (scannable ones only if the override file says so)
+void MemReader::publishOffsets() {
+    std::array<std::optional<unsigned long>, OffsetDatabase::OFFSET_COUNT> resolved;
+    std::array<bool, OffsetDatabase::OFFSET_COUNT> configured{};
+    {
+        std::lock_guard<std::mutex> lk(offsetsMutex_);
+        for (size_t i = 0; i < OffsetDatabase::OFFSET_COUNT; ++i) {
+            const std::string key = OffsetDatabase::OFFSET_KEYS[i];
+            if (auto it = overrideOffsets_.find(key); it != overrideOffsets_.end()) {
+                resolved[i] = it->second;
+            }
+            else if (auto it = buildOffsets_.find(key); it != buildOffsets_.end()) {
+                resolved[i] = it->second;
+            }
+            else {
+                configured[i] = useConfiguredOffsets_ ||
+                    std::find(OffsetScanner::SCANNABLE_OFFSETS.begin(), OffsetScanner::SCANNABLE_OFFSETS.end(), key)
+                        == OffsetScanner::SCANNABLE_OFFSETS.end();
+            }
+        }
     }
-    return oss.str();
-}
 
-// Hex-dump logging helper
-static void logHexDump(
-    const char* fnName,
-    uintptr_t addr,
-    const std::vector<uint8_t>& buf,
-    const char* suffix = nullptr
-) {
-    std::ostringstream oss;
-    oss << fnName << "() @ " << addressToHex(addr)
-        << " [" << std::dec << buf.size() << " bytes]";
-    if (suffix) {
-        oss << " " << suffix;
+    for (size_t i = 0; i < OffsetDatabase::OFFSET_COUNT; ++i) {
+        if (configured[i]) {
+            resolved[i] = ConfigManager::getInstance().getValue<unsigned long>(OffsetDatabase::OFFSET_KEYS[i]);
+        }
+        offsets_[i].store(resolved[i] ? *resolved[i] : UNKNOWN_OFFSET, std::memory_order_relaxed);
     }
-    oss << ": " << bufferToHex(buf);
-    Logger::getInstance().log(oss.str());
+}
+
+// Connection detection needs both the local server name and the remote socket address
+bool MemReader::isMemoryAvailable() {
+    return getOffset(MemoryOffset::LocalServerName) && getOffset(MemoryOffset::RemoteServerSockaddr);
 }
 
 static bool safeMemcpy(void* dst, const void* src, size_t bytes) {
@@ -105,27 +128,49 @@ static bool safeMemcpy(void* dst, const void* src, size_t bytes) {
     }
 }
 
-// Read raw bytes at a specific memory offset
-std::vector<uint8_t> MemReader::readRawBytesAtAddress(
+// Copy raw bytes at a specific memory offset into caller-owned storage
+bool MemReader::readInto(
     bool        relative,
     uintptr_t   offset,
+    void*       dst,
     size_t      size,
     const char* callerName
 ) {
     const uintptr_t targetAddress = relative ? (baseAddress_ + offset) : offset;
-    std::vector<uint8_t> buffer(size);
 
-    if (!safeMemcpy(buffer.data(),
+    if (!safeMemcpy(dst,
         reinterpret_cast<const void*>(targetAddress),
         size))
     {
-        return {};
+        return false;
     }
 
-    if (LOG_MEMORY_VALUES && callerName) {
-        logHexDump(callerName, targetAddress, buffer);
+    if (callerName) {
+        LOG_RATE_LIMITED(LogLevel::Info, Memory, 20, 50,
+            MemReaderHelpers::formatHexDump(callerName, targetAddress, static_cast<const uint8_t*>(dst), size));
     }
-    return buffer;
+    return true;
+}
+
+// Look up the region containing an address
+std::optional<MemoryRegion> MemReader::findRegion(uintptr_t address) {
+    auto map = regionMap_.snapshot();
+    auto it = std::upper_bound(map->regions.begin(), map->regions.end(), address,
+        [](uintptr_t a, const MemoryRegion& r) { return a < r.base; });
+    if (it == map->regions.begin()) return std::nullopt;
+    --it;
+    if (address >= it->end()) return std::nullopt;
+    return *it;
+}
+
+// Start a resumable scan; see MemoryScan::step
+std::unique_ptr<MemoryScan> MemReader::beginSearch(
+    const std::vector<uint8_t>& pattern,
+    size_t readOffset,
+    size_t readSize,
+    const char* callerName
+) {
+    return std::make_unique<MemoryScan>(*this, regionMap_, pattern, readOffset, readSize, callerName);
 }
 
 // Search process memory for a pattern and return address, value
@@ -134,129 +179,188 @@ MemReader::searchMemoryRaw(
     const std::vector<uint8_t>& pattern,
     size_t                      readOffset,
     size_t                      readSize,
-    const char* callerName
+    const char* callerName,
+    const std::atomic<bool>* cancel
 ) {
-    auto t_start = std::chrono::high_resolution_clock::now();
+    TRACE_SCOPE("memory", "searchMemoryRaw");
+    MemoryScan scan(*this, regionMap_, pattern, readOffset, readSize, callerName);
+    scan.step(std::chrono::microseconds::zero(), cancel);
+    return scan.result();
+}
+
+// Read the PE fingerprint of the game executable
+static std::optional<OffsetScanner::BuildFingerprint> readFingerprint(MemReader& reader) {
+    auto dos = reader.read<IMAGE_DOS_HEADER>(true, 0);
+    if (!dos || dos->e_magic != IMAGE_DOS_SIGNATURE) return std::nullopt;
+
+    auto nt = reader.read<IMAGE_NT_HEADERS>(true, static_cast<uintptr_t>(dos->e_lfanew));
+    if (!nt || nt->Signature != IMAGE_NT_SIGNATURE) return std::nullopt;
 
-    if (pattern.empty()) {
-        if (LOG_MEMORY_VALUES && callerName) {
-                Logger::getInstance().log(std::string(callerName) + " Empty pattern");
+    OffsetScanner::BuildFingerprint fp;
+    fp.timeDateStamp = nt->FileHeader.TimeDateStamp;
+    fp.sizeOfImage = nt->OptionalHeader.SizeOfImage;
+    return fp;
+}
+
+// Copy every executable section of the game executable
+static std::vector<OffsetScanner::CodeSection> readCodeSections(MemReader& reader, uintptr_t baseAddress) {
+    std::vector<OffsetScanner::CodeSection> sections;
+
+    auto dos = reader.read<IMAGE_DOS_HEADER>(true, 0);
+    if (!dos) return sections;
+    auto nt = reader.read<IMAGE_NT_HEADERS>(true, static_cast<uintptr_t>(dos->e_lfanew));
+    if (!nt) return sections;
+
+    uintptr_t sectionOffset = static_cast<uintptr_t>(dos->e_lfanew)
+        + offsetof(IMAGE_NT_HEADERS, OptionalHeader)
+        + nt->FileHeader.SizeOfOptionalHeader;
+
+    for (WORD i = 0; i < nt->FileHeader.NumberOfSections; ++i) {
+        auto sh = reader.read<IMAGE_SECTION_HEADER>(true, sectionOffset + i * sizeof(IMAGE_SECTION_HEADER));
+        if (!sh) break;
+        if (!(sh->Characteristics & IMAGE_SCN_MEM_EXECUTE) || sh->Misc.VirtualSize == 0) continue;
+
+        OffsetScanner::CodeSection section;
+        section.address = baseAddress + sh->VirtualAddress;
+        section.bytes.resize(sh->Misc.VirtualSize);
+        if (reader.readInto(true, sh->VirtualAddress, section.bytes.data(), section.bytes.size())) {
+            sections.push_back(std::move(section));
         }
-        return { 0, {} };
     }
+    return sections;
+}
 
-    // build KMP lps
-    std::vector<size_t> lps(pattern.size(), 0);
-    for (size_t i = 1, len = 0; i < pattern.size(); ) {
-        if (pattern[i] == pattern[len]) {
-            lps[i++] = ++len;
-        }
-        else if (len > 0) {
-            len = lps[len - 1];
-        }
-        else {
-            lps[i++] = 0;
-        }
+// Pick the offsets for the running build (see OffsetDatabase::selectForBuild)
+// and start discovery if they need signatures learned or relocating
+void MemReader::selectOffsets(const std::filesystem::path& offsetsOverridePath) {
+    {
+        std::lock_guard<std::mutex> lk(offsetsMutex_);
+        overrideOffsets_.clear();
+        buildOffsets_.clear();
+        useConfiguredOffsets_ = false;
     }
 
-    SYSTEM_INFO si;
-    GetSystemInfo(&si);
-    uintptr_t addr = reinterpret_cast<uintptr_t>(si.lpMinimumApplicationAddress);
-    uintptr_t end = reinterpret_cast<uintptr_t>(si.lpMaximumApplicationAddress);
-
-    const size_t CHUNK_SIZE = 8 * 1024 * 1024; // 8 MiB
-    const size_t minRegionSize = pattern.size() + readOffset + readSize;
-    size_t totalBytesRead = 0;
-
-    while (addr < end) {
-        MEMORY_BASIC_INFORMATION mbi;
-        if (VirtualQuery(reinterpret_cast<LPCVOID>(addr), &mbi, sizeof(mbi)) == 0)
-            break;
-
-        if (mbi.State != MEM_COMMIT ||
-            mbi.Type != MEM_PRIVATE ||
-            mbi.Protect != PAGE_READWRITE ||
-            (mbi.Protect & PAGE_GUARD) ||
-            mbi.RegionSize < minRegionSize)
-        {
-            addr = reinterpret_cast<uintptr_t>(mbi.BaseAddress) + mbi.RegionSize;
-            continue;
+    auto fingerprint = readFingerprint(*this);
+    if (!fingerprint) {
+        LOG_WARNING(Memory, "Unable to read executable headers, memory fields disabled");
+        return;
+    }
+    LOG_INFO(Memory, "Executable build: " + fingerprint->toString());
+
+    auto overrides = OffsetDatabase::loadOverrides(offsetsOverridePath, *fingerprint);
+    if (!overrides.offsets.empty()) {
+        LOG_INFO(Memory, "Loaded " + std::to_string(overrides.offsets.size()) + " offset overrides for this build");
+    }
+
+    std::optional<OffsetScanner::Cache> cache;
+    try {
+        cache = OffsetScanner::loadCache(offsetsCachePath_);
+    }
+    catch (const std::exception& e) {
+        LOG_WARNING(Memory, std::string("Offset cache read failed: ") + e.what());
+    }
+
+    OffsetScanner::OffsetMap configured;
+    for (const auto& key : OffsetScanner::SCANNABLE_OFFSETS) {
+        configured[key] = ConfigManager::getInstance().getValue<unsigned long>(key);
+    }
+
+    auto selection = OffsetDatabase::selectForBuild(
+        *fingerprint, overrides, std::move(cache), configured, offsetsOverridePath.filename().string());
+
+    {
+        std::lock_guard<std::mutex> lk(offsetsMutex_);
+        fingerprint_ = *fingerprint;
+        overrideOffsets_ = overrides.offsets;
+        useConfiguredOffsets_ = overrides.useConfigured;
+        buildOffsets_ = selection.buildOffsets;
+    }
+    if (!selection.discover) return;
+
+    cancelDiscovery_ = false;
+    if (!discoveryThread_.joinable()) {
+        discoveryThread_ = std::thread(&MemReader::discoverOffsets, this,
+            std::move(selection.cache), std::move(selection.trusted));
+    }
+}
+
+// Locate module-relative offsets for the running build, once per build
+//
+// On a build whose offsets are vouched for (`trusted`), a unique code
+// signature is learned for each one. When the executable changes, those
+// signatures are searched for in the new code and the RIP-relative
+// displacements decoded into new offsets. Results are cached per build, so
+// later starts on the same build do no scanning.
+void MemReader::discoverOffsets(std::optional<OffsetScanner::Cache> cache, OffsetScanner::OffsetMap trusted) {
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_BELOW_NORMAL);
+    auto t_start = std::chrono::high_resolution_clock::now();
+
+    OffsetScanner::BuildFingerprint fingerprint;
+    {
+        std::lock_guard<std::mutex> lk(offsetsMutex_);
+        fingerprint = fingerprint_;
+    }
+
+    auto sections = readCodeSections(*this, baseAddress_);
+    if (sections.empty()) {
+        LOG_WARNING(Memory, "Offset discovery: no code sections found");
+        return;
+    }
+
+    OffsetScanner::Cache updated;
+    updated.build = fingerprint;
+    updated.reference = !trusted.empty();
+
+    OffsetScanner::OffsetMap reference;
+    if (trusted.empty()) {
+        // New build: relocate the offsets by signature
+        updated.offsets = OffsetScanner::resolveOffsets(sections, baseAddress_, cache->signatures, cancelDiscovery_);
+        reference = updated.offsets;
+
+        LOG_INFO(Memory, "Build changed since " + cache->build.toString() + ", resolved "
+            + std::to_string(updated.offsets.size()) + "/" + std::to_string(cache->signatures.size())
+            + " offsets by signature");
+        for (const auto& key : OffsetScanner::SCANNABLE_OFFSETS) {
+            if (cache->signatures.count(key) && !updated.offsets.count(key)) {
+                LOG_WARNING(Memory, "Signature not found for " + key + ", disabled for this build");
+            }
         }
+        if (updated.offsets.empty()) return;    // keep the signatures for the next build
 
-        size_t regionSize = mbi.RegionSize;
-        for (size_t regionOff = 0; regionOff < regionSize; regionOff += CHUNK_SIZE) {
-            size_t bytesLeft = regionSize - regionOff;
-            size_t toRead = std::min<size_t>(CHUNK_SIZE + pattern.size() - 1, bytesLeft);
-
-            auto chunk = readRawBytesAtAddress(false, addr + regionOff, toRead);
-            totalBytesRead += chunk.size();
-            if (chunk.empty()) break;
-
-            size_t R = chunk.size(), P = pattern.size();
-            size_t i = 0, j = 0;
-            while (i < R) {
-                if (chunk[i] == pattern[j]) {
-                    ++i; ++j;
-                    if (j == P) {
-                        uintptr_t foundAddr = addr + regionOff + (i - j);
-                        uintptr_t blobAddr = foundAddr + readOffset;
-
-                        if (blobAddr + readSize <= addr + regionSize) {
-                            auto blob = readRawBytesAtAddress(false, blobAddr, readSize);
-                            totalBytesRead += blob.size();
-
-                            if (LOG_MEMORY_VALUES && callerName) {
-                                logHexDump(callerName, blobAddr, blob, "candidate");
-                            }
-
-                            std::string candidate(
-                                reinterpret_cast<const char*>(blob.data()),
-                                static_cast<std::string::size_type>(blob.size())
-                            );
-
-                            if (isValid(candidate)) {
-                                if (LOG_MEMORY_VALUES && callerName) {
-                                    logHexDump(callerName, blobAddr, blob, "valid");
-                                }
-
-                                if (LOG_MEMORY_VALUES && callerName) {
-                                    double mb = totalBytesRead / (1024.0 * 1024.0);
-                                    auto t_end = std::chrono::high_resolution_clock::now();
-                                    auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(
-                                        t_end - t_start
-                                    ).count();
-
-                                    std::ostringstream oss;
-                                    oss << "Read " << mb << " MB, Time elapsed: "
-                                        << elapsedMs << " ms";
-                                    Logger::getInstance().log(oss.str());
-                                }
-
-                                if (auto pos = candidate.find('\0'); pos != std::string::npos)
-                                    candidate.resize(pos);
-
-                                return { foundAddr, candidate };
-                            }
-                        }
-
-                        j = lps[j - 1];
-                    }
-                }
-                else if (j > 0) {
-                    j = lps[j - 1];
-                }
-                else {
-                    ++i;
-                }
+        {
+            std::lock_guard<std::mutex> lk(offsetsMutex_);
+            buildOffsets_ = updated.offsets;
+        }
+        publishOffsets();
+    }
+    else {
+        for (const auto& key : OffsetScanner::SCANNABLE_OFFSETS) {
+            if (auto it = trusted.find(key); it != trusted.end()) {
+                updated.offsets[key] = it->second;
             }
         }
+        reference = updated.offsets;
+    }
 
-        addr = reinterpret_cast<uintptr_t>(mbi.BaseAddress) + regionSize;
+    // (Re-)learn signatures from this build, keeping old ones that weren't resolved
+    updated.signatures = OffsetScanner::learnSignatures(sections, baseAddress_, reference, cancelDiscovery_);
+    if (cache) {
+        for (const auto& [key, sig] : cache->signatures) {
+            updated.signatures.emplace(key, sig);
+        }
     }
 
-    if (LOG_MEMORY_VALUES && callerName) {
-        Logger::getInstance().log(std::string(callerName) + " Pattern not found");
+    if (cancelDiscovery_) return;
+
+    try {
+        OffsetScanner::saveCache(offsetsCachePath_, updated);
+    }
+    catch (const std::exception& e) {
+        LOG_WARNING(Memory, std::string("Offset cache write failed: ") + e.what());
     }
 
-    return { 0, {} };
+    auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::high_resolution_clock::now() - t_start).count();
+    LOG_INFO(Memory, "Offset discovery finished: " + std::to_string(updated.signatures.size())
+        + " signatures, " + std::to_string(elapsedMs) + " ms");
 }
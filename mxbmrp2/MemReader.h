@@ -4,33 +4,187 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <cstdint>
+#include <cstring>
 #include <vector>
+#include <array>
+#include <tuple>
+#include <optional>
+#include <type_traits>
+#include <filesystem>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+#include <memory>
+#include <chrono>
+
+#include "OffsetScanner.h"
+#include "OffsetDatabase.h"
+#include "RegionMap.h"
+#include "FixedString.h"
+
+class MemReader;
+
+// Resumable pattern search over the process region map. Each step() scans
+// chunks until the budget runs out; progress is kept between steps.
+class MemoryScan {
+public:
+    enum class Status { Running, Found, NotFound, Cancelled };
+
+    struct Stats {
+        size_t steps = 0;
+        size_t bytesRead = 0;
+        int64_t busyUs = 0;         // sum of step durations
+        int64_t worstStepUs = 0;    // longest single step
+        int64_t wallUs = 0;         // first step start to last step end
+    };
+
+    MemoryScan(
+        MemReader& reader,
+        RegionMap& regions,
+        std::vector<uint8_t> pattern,
+        size_t readOffset,
+        size_t readSize,
+        const char* callerName = nullptr
+    );
+
+    // Advance for at most `budget` (zero runs to completion)
+    Status step(std::chrono::microseconds budget, const std::atomic<bool>* cancel = nullptr);
+
+    Status status() const { return status_; }
+    const Stats& stats() const { return stats_; }
+
+    // Address of the match and the string read at readOffset, or {0, ""}
+    std::tuple<uintptr_t, std::string> result() const;
+
+private:
+    static constexpr size_t CHUNK_SIZE = 256 * 1024;
+
+    bool scanChunk(const MemoryRegion& region);
+    void logStats() const;
+
+    MemReader& reader_;
+    RegionMap& regions_;
+    std::vector<uint8_t> pattern_;
+    size_t readOffset_;
+    size_t readSize_;
+    const char* callerName_;
+
+    std::vector<size_t> lps_;
+    std::vector<uint8_t> chunk_;
+    std::vector<uint8_t> blob_;
+
+    // Progress
+    Status status_ = Status::Running;
+    std::shared_ptr<const RegionMap::Snapshot> map_;
+    uint64_t minGeneration_ = 0;    // nonzero once rescanning for new regions
+    size_t regionIndex_ = 0;
+    size_t regionOffset_ = 0;
+
+    uintptr_t resultAddress_ = 0;
+    std::string resultValue_;
+
+    Stats stats_;
+    std::chrono::steady_clock::time_point startTime_;
+};
 
 class MemReader {
 public:
     // Singleton Instance
     static MemReader& getInstance();
 
-    // Initialize the MemReader
-    void initialize();
+    // Initialize the MemReader and select the offsets for the running build
+    void initialize(
+        const std::filesystem::path& offsetsCachePath,
+        const std::filesystem::path& offsetsOverridePath
+    );
+
+    // Stop offset discovery (call before the plugin unloads)
+    void shutdown();
+
+    // Offset for this build, or nullopt if it is unknown. Lock-free, safe
+    // on any thread.
+    std::optional<unsigned long> getOffset(MemoryOffset offset) const;
+
+    // Re-resolve the offsets that fall back to mxbmrp2.ini (after a config reload)
+    void refreshOffsets();
 
-    // Read a value from a specific memory offset
-    std::vector<uint8_t> readRawBytesAtAddress(
+    // False while the running build has no usable offsets for the connection state
+    bool isMemoryAvailable();
+
+    // Copy `size` bytes at a memory offset into caller-owned storage
+    bool readInto(
         bool relative,
         uintptr_t offset,
+        void* dst,
         size_t size,
         const char* callerName = nullptr
     );
 
-    // Search memory for a specific string pattern
-    std::tuple<uintptr_t, std::string> searchMemoryRaw(
+    template <std::size_t N>
+    bool readInto(
+        bool relative,
+        uintptr_t offset,
+        std::array<uint8_t, N>& dst,
+        const char* callerName = nullptr
+    ) {
+        return readInto(relative, offset, dst.data(), N, callerName);
+    }
+
+    // Read a trivially copyable value at a memory offset
+    template <typename T>
+    std::optional<T> read(
+        bool relative,
+        uintptr_t offset,
+        const char* callerName = nullptr
+    ) {
+        static_assert(std::is_trivially_copyable_v<T>,
+            "MemReader::read<T>: T must be trivially copyable");
+
+        T value;
+        if (!readInto(relative, offset, &value, sizeof(T), callerName)) {
+            return std::nullopt;
+        }
+        return value;
+    }
+
+    // Read a null-terminated string of up to N bytes
+    template <std::size_t N>
+    FixedString<N> readString(
+        bool relative,
+        uintptr_t offset,
+        const char* callerName = nullptr
+    ) {
+        FixedString<N> out;
+        if (readInto(relative, offset, out.buf.data(), N, callerName)) {
+            out.len = strnlen(out.buf.data(), N);
+        }
+        out.buf[out.len] = '\0';
+        return out;
+    }
+
+    // Scannable region containing `address`, from the shared region map
+    std::optional<MemoryRegion> findRegion(uintptr_t address);
+
+    // Start a search that the caller advances in time slices
+    std::unique_ptr<MemoryScan> beginSearch(
         const std::vector<uint8_t>& pattern,
         size_t readOffset,
         size_t readSize,
         const char* callerName = nullptr
     );
 
+    // Search memory for a specific string pattern (gives up once `cancel` is set)
+    std::tuple<uintptr_t, std::string> searchMemoryRaw(
+        const std::vector<uint8_t>& pattern,
+        size_t readOffset,
+        size_t readSize,
+        const char* callerName = nullptr,
+        const std::atomic<bool>* cancel = nullptr
+    );
+
     // Destructor
     ~MemReader();
 
@@ -43,4 +197,25 @@ private:
     MemReader& operator=(const MemReader&) = delete;
 
     uintptr_t baseAddress_;
+
+    // Eligible regions for searchMemoryRaw, shared across scans
+    RegionMap regionMap_;
+
+    // Offset selection (see OffsetDatabase) and discovery (see OffsetScanner)
+    void selectOffsets(const std::filesystem::path& offsetsOverridePath);
+    void discoverOffsets(std::optional<OffsetScanner::Cache> cache, OffsetScanner::OffsetMap trusted);
+    void publishOffsets();
+    std::filesystem::path offsetsCachePath_;
+    std::thread discoveryThread_;
+    std::atomic<bool> cancelDiscovery_{ false };
+
+    std::mutex offsetsMutex_;
+    OffsetScanner::BuildFingerprint fingerprint_;
+    OffsetScanner::OffsetMap overrideOffsets_;  // mxbmrp2-offsets.ini
+    OffsetScanner::OffsetMap buildOffsets_;     // from selectForBuild, or discovered
+    bool useConfiguredOffsets_ = false;         // the override file vouches for mxbmrp2.ini
+
+    // What getOffset returns, resolved from the above by publishOffsets
+    static constexpr uint64_t UNKNOWN_OFFSET = UINT64_MAX;
+    std::array<std::atomic<uint64_t>, OffsetDatabase::OFFSET_COUNT> offsets_;
 };
@@ -3,21 +3,27 @@
 
 #pragma once
 
+#include <atomic>
 #include <cstdint>
+#include <memory>
 #include <string>
 #include <vector>
 #include <tuple>
 
+#include "MemReader.h"
+
 namespace MemReaderHelpers {
 
-    // Reads a null-terminated string of up to `size` bytes
+    // Reads a null-terminated string of up to `N` bytes
     // at `offset` (relative to baseAddress_ if relative=true).
+    template <std::size_t N>
     std::string readNullTermString(
         bool relative,
         std::uintptr_t offset,
-        std::size_t size,
         const char* callerName = nullptr
-    );
+    ) {
+        return MemReader::getInstance().readString<N>(relative, offset, callerName).str();
+    }
 
     using ByteBuf = std::vector<uint8_t>;
 
@@ -29,7 +35,11 @@ namespace MemReaderHelpers {
     std::string getLocalServerLocation();
     int getLocalServerClientsMax();
     ByteBuf getRemoteServerSocketAddress();
-    std::tuple<uintptr_t, std::string> getRemoteServerNameAndAddress(const ByteBuf& remoteIPv6Hex);
+    std::tuple<uintptr_t, std::string> getRemoteServerNameAndAddress(
+        const ByteBuf& remoteIPv6Hex,
+        const std::atomic<bool>* cancel = nullptr
+    );
+    std::unique_ptr<MemoryScan> beginRemoteServerNameSearch(const ByteBuf& remoteIPv6Hex);
     std::string getRemoteServerPassword();
     std::string getRemoteServerLocation(uintptr_t remoteIPv6MemoryAddress);
     std::string getTrackDeformation();
@@ -37,4 +47,19 @@ namespace MemReaderHelpers {
     std::string getRemoteServerPing();
     int getServerClientsCount();
     std::string getRemainingTearoffs(const std::string& connectionType);
+
+    // Decoders shared with the memory watches in Plugin
+    std::string formatRemoteServerPing(uint16_t ping);
+    int countServerClients(const uint8_t* raw, size_t size);
+    MemoryOffset getRemainingTearoffsOffset(const std::string& connectionType);
+
+    // Formatting for the memory read logs
+    std::string addressToHex(uintptr_t address);
+    std::string formatHexDump(
+        const char* fnName,
+        uintptr_t addr,
+        const uint8_t* data,
+        size_t size,
+        const char* suffix = nullptr
+    );
 }
@@ -0,0 +1,232 @@
+
+// MemoryScan.cpp
+
+#include "pch.h"
+
+#include <cstring>
+#include <sstream>
+#include <algorithm>
+#include <vector>
+#include <chrono>
+
+#include "MemReader.h"
+#include "MemReaderHelpers.h"
+#include "Logger.h"
+#include "Tracer.h"
+#include "Metrics.h"
+
+// Helper to validate server name
+static bool isValid(const uint8_t* data, size_t size) {
+    const uint8_t* end = data + size;
+    const uint8_t* nul = std::find(data, end, 0);
+    // must have at least three ASCII chars before the NUL, and at least one NUL
+    if (nul == end || nul - data < 3) return false;
+
+    // all bytes before the NUL must be printable ASCII
+    if (!std::all_of(data, nul,
+        [](unsigned char c) { return c >= 32 && c <= 125; }))
+        return false;
+
+    // all bytes from the NUL to end must be NUL
+	// Disabled this check since non-dedicated servers may have trailing NULs in the result
+    //if (!std::all_of(nul, end,
+    //    [](unsigned char c) { return c == '\0'; }))
+    //    return false;
+
+    return true;
+}
+
+// Constructor
+MemoryScan::MemoryScan(
+    MemReader& reader,
+    RegionMap& regions,
+    std::vector<uint8_t> pattern,
+    size_t readOffset,
+    size_t readSize,
+    const char* callerName
+)
+    : reader_(reader),
+      regions_(regions),
+      pattern_(std::move(pattern)),
+      readOffset_(readOffset),
+      readSize_(readSize),
+      callerName_(callerName),
+      lps_(pattern_.size(), 0),
+      blob_(readSize)
+{
+    if (pattern_.empty()) {
+        if (callerName_) {
+            LOG_WARNING(Memory, std::string(callerName_) + " Empty pattern");
+        }
+        status_ = Status::NotFound;
+        return;
+    }
+
+    // build KMP lps
+    for (size_t i = 1, len = 0; i < pattern_.size(); ) {
+        if (pattern_[i] == pattern_[len]) {
+            lps_[i++] = ++len;
+        }
+        else if (len > 0) {
+            len = lps_[len - 1];
+        }
+        else {
+            lps_[i++] = 0;
+        }
+    }
+
+    // Scratch buffer is allocated once per scan and reused for every chunk
+    chunk_.resize(CHUNK_SIZE + pattern_.size() - 1);
+}
+
+// Advance the scan
+MemoryScan::Status MemoryScan::step(std::chrono::microseconds budget, const std::atomic<bool>* cancel) {
+    TRACE_SCOPE("memory", "MemoryScan::step");
+    if (status_ != Status::Running) return status_;
+
+    const auto stepStart = std::chrono::steady_clock::now();
+    if (stats_.steps == 0) {
+        startTime_ = stepStart;
+    }
+    stats_.steps++;
+
+    // Known regions first; on a miss, look for regions that appeared since
+    if (!map_) {
+        map_ = regions_.refresh();
+    }
+
+    const size_t minRegionSize = pattern_.size() + readOffset_ + readSize_;
+    while (status_ == Status::Running) {
+        if (cancel && *cancel) {
+            status_ = Status::Cancelled;
+            break;
+        }
+
+        if (regionIndex_ >= map_->regions.size()) {
+            auto rescanned = (minGeneration_ == 0) ? regions_.refresh(true) : map_;
+            if (rescanned->generation != map_->generation) {
+                minGeneration_ = map_->generation;
+                map_ = std::move(rescanned);
+                regionIndex_ = 0;
+                regionOffset_ = 0;
+            }
+            else {
+                status_ = Status::NotFound;
+            }
+            continue;
+        }
+
+        const MemoryRegion& region = map_->regions[regionIndex_];
+        if (region.generation <= minGeneration_ || region.size < minRegionSize || !scanChunk(region)) {
+            regionIndex_++;
+            regionOffset_ = 0;
+        }
+
+        if (budget.count() > 0 && std::chrono::steady_clock::now() - stepStart >= budget) {
+            break;
+        }
+    }
+
+    const auto stepEnd = std::chrono::steady_clock::now();
+    const auto stepUs = std::chrono::duration_cast<std::chrono::microseconds>(stepEnd - stepStart).count();
+    stats_.busyUs += stepUs;
+    stats_.worstStepUs = std::max<int64_t>(stats_.worstStepUs, stepUs);
+    stats_.wallUs = std::chrono::duration_cast<std::chrono::microseconds>(stepEnd - startTime_).count();
+
+    if (status_ != Status::Running) {
+        Metrics::getInstance().record(Histogram::MemoryScan, static_cast<uint64_t>(stats_.busyUs) * 1000);
+        logStats();
+    }
+    return status_;
+}
+
+// Scan the next chunk of `region`; false once the region is exhausted or a match is found
+bool MemoryScan::scanChunk(const MemoryRegion& region) {
+    const uintptr_t addr = region.base;
+    const size_t regionSize = region.size;
+    if (regionOffset_ >= regionSize) return false;
+
+    size_t bytesLeft = regionSize - regionOffset_;
+    size_t toRead = std::min<size_t>(CHUNK_SIZE + pattern_.size() - 1, bytesLeft);
+
+    if (!reader_.readInto(false, addr + regionOffset_, chunk_.data(), toRead)) return false;
+    stats_.bytesRead += toRead;
+
+    size_t R = toRead, P = pattern_.size();
+    size_t i = 0, j = 0;
+    while (i < R) {
+        if (chunk_[i] == pattern_[j]) {
+            ++i; ++j;
+            if (j == P) {
+                uintptr_t foundAddr = addr + regionOffset_ + (i - j);
+                uintptr_t blobAddr = foundAddr + readOffset_;
+
+                if (blobAddr + readSize_ <= addr + regionSize) {
+                    if (!reader_.readInto(false, blobAddr, blob_.data(), readSize_)) {
+                        j = lps_[j - 1];
+                        continue;
+                    }
+                    stats_.bytesRead += readSize_;
+
+                    // Every pattern hit is dumped, which can be thousands per scan
+                    if (callerName_) {
+                        LOG_RATE_LIMITED(LogLevel::Info, Memory, 10, 20,
+                            MemReaderHelpers::formatHexDump(callerName_, blobAddr, blob_.data(), readSize_, "candidate"));
+                    }
+
+                    if (isValid(blob_.data(), readSize_)) {
+                        if (callerName_) {
+                            LOG_INFO(Memory, MemReaderHelpers::formatHexDump(callerName_, blobAddr, blob_.data(), readSize_, "valid"));
+                        }
+
+                        const char* name = reinterpret_cast<const char*>(blob_.data());
+                        resultAddress_ = foundAddr;
+                        resultValue_.assign(name, strnlen(name, readSize_));
+                        status_ = Status::Found;
+                        return false;
+                    }
+                }
+
+                j = lps_[j - 1];
+            }
+        }
+        else if (j > 0) {
+            j = lps_[j - 1];
+        }
+        else {
+            ++i;
+        }
+    }
+
+    regionOffset_ += CHUNK_SIZE;
+    return regionOffset_ < regionSize;
+}
+
+// Result of a finished scan (address 0 unless found)
+std::tuple<uintptr_t, std::string> MemoryScan::result() const {
+    if (status_ != Status::Found) return { 0, {} };
+    return { resultAddress_, resultValue_ };
+}
+
+// Log read volume and timing once the scan has finished
+void MemoryScan::logStats() const {
+    if (!callerName_ || !Logger::getInstance().isEnabled(LogLevel::Info, LogCategory::Memory)) return;
+
+    if (status_ == Status::NotFound) {
+        LOG_INFO(Memory, std::string(callerName_) + " Pattern not found");
+    }
+    else if (status_ == Status::Cancelled) {
+        LOG_INFO(Memory, std::string(callerName_) + " Scan cancelled");
+    }
+
+    // Busy time is what callers actually waited for; wall time includes the gaps between steps
+    std::ostringstream oss;
+    oss << "Read " << stats_.bytesRead / (1024.0 * 1024.0) << " MB"
+        << ", Time elapsed: " << stats_.wallUs / 1000 << " ms"
+        << " (busy " << stats_.busyUs / 1000 << " ms in " << stats_.steps << " steps"
+        << ", worst step " << stats_.worstStepUs << " us)";
+    if (map_) {
+        oss << ", Regions: " << map_->regions.size() << " (generation " << map_->generation << ")";
+    }
+    LOG_INFO(Memory, oss.str());
+}
@@ -0,0 +1,128 @@
+
+// MemoryWatcher.cpp
+
+#include "pch.h"
+
+#include <cstring>
+#include <algorithm>
+
+#include "MemoryWatcher.h"
+#include "MemReader.h"
+#include "Logger.h"
+
+// Destructor
+MemoryWatcher::~MemoryWatcher() {
+    stop();
+}
+
+// Register a watch (call before start)
+MemoryWatcher::WatchId MemoryWatcher::addWatch(
+    MemoryOffset offset,
+    size_t size,
+    std::chrono::milliseconds interval,
+    Comparator comparator)
+{
+    std::lock_guard<std::mutex> lk(mutex_);
+
+    Watch w;
+    w.offset = offset;
+    w.size = size;
+    w.interval = interval;
+    w.comparator = std::move(comparator);
+    w.last.resize(size);
+    w.scratch.resize(size);
+
+    watches_.push_back(std::move(w));
+    return watches_.size() - 1;
+}
+
+// Enable or disable a watch
+void MemoryWatcher::setEnabled(WatchId id, bool enabled) {
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        if (id >= watches_.size()) return;
+
+        Watch& w = watches_[id];
+        if (w.enabled == enabled) return;
+        w.enabled = enabled;
+        w.hasValue = false;
+        w.nextPoll = std::chrono::steady_clock::now();
+        wakeRequested_ = true;
+    }
+    wake_.notify_one();
+}
+
+// Start polling
+void MemoryWatcher::start(ChangeHandler handler) {
+    std::lock_guard<std::mutex> lk(mutex_);
+    if (running_) return;
+
+    handler_ = std::move(handler);
+    running_ = true;
+    thread_ = std::thread(&MemoryWatcher::pollLoop, this);
+}
+
+// Stop polling and wait for the thread to exit
+void MemoryWatcher::stop() {
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        running_ = false;
+    }
+    wake_.notify_one();
+
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+// Poll due watches, report changes, sleep until the next one is due
+void MemoryWatcher::pollLoop() {
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_BELOW_NORMAL);
+    LOG_INFO(Memory, "Memory watcher started with " + std::to_string(watches_.size()) + " watches");
+
+    auto& memReader = MemReader::getInstance();
+    std::vector<Change> changes;
+    changes.reserve(watches_.size());
+
+    std::unique_lock<std::mutex> lk(mutex_);
+    while (running_) {
+        const auto now = std::chrono::steady_clock::now();
+        auto nextWake = now + std::chrono::seconds(1);
+
+        changes.clear();
+        for (WatchId id = 0; id < watches_.size(); ++id) {
+            Watch& w = watches_[id];
+            if (!w.enabled) continue;
+
+            if (now >= w.nextPoll) {
+                w.nextPoll = now + w.interval;
+
+                auto offset = memReader.getOffset(w.offset);
+                if (offset && memReader.readInto(true, *offset, w.scratch.data(), w.size)) {
+                    bool changed = !w.hasValue || (w.comparator
+                        ? w.comparator(w.last.data(), w.scratch.data(), w.size)
+                        : std::memcmp(w.last.data(), w.scratch.data(), w.size) != 0);
+
+                    if (changed) {
+                        w.last.swap(w.scratch);
+                        w.hasValue = true;
+                        changes.push_back({ id, w.last });
+                    }
+                }
+            }
+            nextWake = std::min<std::chrono::steady_clock::time_point>(nextWake, w.nextPoll);
+        }
+
+        // Only this thread writes `last`, so the handler can read it unlocked
+        if (!changes.empty()) {
+            lk.unlock();
+            handler_(changes);
+            lk.lock();
+        }
+
+        wake_.wait_until(lk, nextWake, [this] { return !running_ || wakeRequested_; });
+        wakeRequested_ = false;
+    }
+
+    LOG_INFO(Memory, "Memory watcher stopped");
+}
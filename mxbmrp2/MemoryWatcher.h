@@ -0,0 +1,80 @@
+
+// MemoryWatcher.h
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <functional>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "OffsetDatabase.h"
+
+// Polls registered memory offsets on a dedicated low-priority thread and
+// reports only the ones whose bytes changed, batched once per pass.
+class MemoryWatcher {
+public:
+    using WatchId = size_t;
+
+    // Returns true if `curr` should be reported as a change from `prev`
+    using Comparator = std::function<bool(const uint8_t* prev, const uint8_t* curr, size_t size)>;
+
+    struct Change {
+        WatchId id;
+        const std::vector<uint8_t>& bytes;
+    };
+
+    // Called on the watcher thread with every change found in one pass
+    using ChangeHandler = std::function<void(const std::vector<Change>& changes)>;
+
+    MemoryWatcher() = default;
+    ~MemoryWatcher();
+
+    MemoryWatcher(const MemoryWatcher&) = delete;
+    MemoryWatcher& operator=(const MemoryWatcher&) = delete;
+
+    // Watch `size` bytes at the module-relative `offset`,
+    // read every `interval`. Watches start disabled.
+    WatchId addWatch(
+        MemoryOffset offset,
+        size_t size,
+        std::chrono::milliseconds interval,
+        Comparator comparator = nullptr
+    );
+
+    // Enabling arms the watch, so its current value is reported on the next
+    // poll. Setting the state it already has does nothing.
+    void setEnabled(WatchId id, bool enabled);
+
+    void start(ChangeHandler handler);
+    void stop();
+
+private:
+    struct Watch {
+        MemoryOffset offset;
+        size_t size;
+        std::chrono::milliseconds interval;
+        Comparator comparator;
+
+        bool enabled = false;
+        bool hasValue = false;
+        std::chrono::steady_clock::time_point nextPoll;
+        std::vector<uint8_t> last;
+        std::vector<uint8_t> scratch;
+    };
+
+    void pollLoop();
+
+    std::vector<Watch> watches_;
+    ChangeHandler handler_;
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool running_ = false;
+    bool wakeRequested_ = false;
+    std::thread thread_;
+};
@@ -0,0 +1,218 @@
+
+// Metrics.cpp
+
+#include "pch.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#include "Metrics.h"
+#include "Arena.h"
+#include "Logger.h"
+
+namespace {
+    constexpr const char* HISTOGRAM_NAMES[] = {
+        "draw", "display_keys_wait", "periodic_tick", "memory_scan",
+        "event_queue_delay", "event_dispatch",
+        "lock_session_hold", "lock_server_hold", "lock_display_hold", "lock_export_hold",
+        "callback_event_init", "callback_event_deinit",
+        "callback_run_init", "callback_run_deinit", "callback_run_start", "callback_run_stop",
+        "callback_run_lap", "callback_run_split",
+        "callback_race_event", "callback_race_session", "callback_race_session_state",
+        "callback_race_add_entry", "callback_race_remove_entry",
+        "callback_race_classification", "callback_race_communication",
+        "callback_run_telemetry"
+    };
+    static_assert(std::size(HISTOGRAM_NAMES) == static_cast<size_t>(Histogram::Count));
+
+    constexpr const char* COUNTER_NAMES[] = {
+        "json_writes", "json_bytes_written", "html_writes", "html_bytes_written",
+        "stats_writes", "stats_bytes_written", "event_queue_full",
+        "arena_overflow_bytes", "telemetry_samples", "telemetry_skipped"
+    };
+    static_assert(std::size(COUNTER_NAMES) == static_cast<size_t>(Counter::Count));
+
+    int highestBit(uint64_t v) {
+#ifdef _MSC_VER
+        // _BitScanReverse64 isn't available in Win32 builds
+        unsigned long index;
+        if (_BitScanReverse(&index, static_cast<unsigned long>(v >> 32))) {
+            return static_cast<int>(index) + 32;
+        }
+        _BitScanReverse(&index, static_cast<unsigned long>(v));
+        return static_cast<int>(index);
+#else
+        return 63 - __builtin_clzll(v);
+#endif
+    }
+
+    // Single-writer increment: only the owning thread stores to its shard
+    void bump(std::atomic<uint64_t>& v, uint64_t amount) {
+        v.store(v.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    void appendNumber(std::pmr::string& out, uint64_t value) {
+        char digits[24];
+        const auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        out.append(digits, result.ptr);
+    }
+
+    // Nanoseconds as microseconds with one decimal
+    void appendMicros(std::pmr::string& out, uint64_t nanos) {
+        appendNumber(out, nanos / 1000);
+        out += '.';
+        appendNumber(out, nanos % 1000 / 100);
+    }
+}
+
+// Singleton instance
+Metrics& Metrics::getInstance() {
+    static Metrics instance;
+    return instance;
+}
+
+const char* Metrics::name(Histogram histogram) {
+    return HISTOGRAM_NAMES[static_cast<size_t>(histogram)];
+}
+
+const char* Metrics::name(Counter counter) {
+    return COUNTER_NAMES[static_cast<size_t>(counter)];
+}
+
+// Exact below SUB_BUCKETS, then SUB_BUCKETS per power of two
+size_t Metrics::bucketIndex(uint64_t value) {
+    if (value < SUB_BUCKETS) return static_cast<size_t>(value);
+
+    int exponent = highestBit(value);
+    if (exponent >= MAX_EXPONENT) return BUCKETS - 1;
+
+    size_t sub = static_cast<size_t>(value >> (exponent - SUB_BITS)) & (SUB_BUCKETS - 1);
+    return SUB_BUCKETS + static_cast<size_t>(exponent - SUB_BITS) * SUB_BUCKETS + sub;
+}
+
+// Largest value that lands in bucket `index`
+uint64_t Metrics::bucketUpperBound(size_t index) {
+    if (index < SUB_BUCKETS) return index;
+
+    size_t k = index - SUB_BUCKETS;
+    int shift = static_cast<int>(k / SUB_BUCKETS);
+    uint64_t lower = static_cast<uint64_t>(SUB_BUCKETS + k % SUB_BUCKETS) << shift;
+    return lower + (uint64_t{ 1 } << shift) - 1;
+}
+
+// The calling thread's shard, created on first use
+Metrics::Shard& Metrics::localShard() {
+    thread_local Shard* shard = nullptr;
+    if (!shard) {
+        auto created = std::make_unique<Shard>();
+        shard = created.get();
+
+        std::lock_guard<std::mutex> lk(shardsMutex_);
+        shards_.push_back(std::move(created));
+    }
+    return *shard;
+}
+
+// Record one value
+void Metrics::record(Histogram histogram, uint64_t value) {
+    HistogramShard& h = localShard().histograms[static_cast<size_t>(histogram)];
+    bump(h.buckets[bucketIndex(value)], 1);
+    bump(h.sum, value);
+    if (value > h.max.load(std::memory_order_relaxed)) {
+        h.max.store(value, std::memory_order_relaxed);
+    }
+}
+
+// Add to a counter
+void Metrics::add(Counter counter, uint64_t amount) {
+    bump(localShard().counters[static_cast<size_t>(counter)], amount);
+}
+
+// Merge all shards of a histogram
+Metrics::Summary Metrics::summarize(Histogram histogram) const {
+    std::array<uint64_t, BUCKETS> merged{};
+    Summary s;
+
+    {
+        std::lock_guard<std::mutex> lk(shardsMutex_);
+        for (const auto& shard : shards_) {
+            const HistogramShard& h = shard->histograms[static_cast<size_t>(histogram)];
+            for (size_t i = 0; i < BUCKETS; ++i) {
+                merged[i] += h.buckets[i].load(std::memory_order_relaxed);
+            }
+            s.sum += h.sum.load(std::memory_order_relaxed);
+            s.max = std::max<uint64_t>(s.max, h.max.load(std::memory_order_relaxed));
+        }
+    }
+
+    // Count from the merged buckets so percentiles are consistent with it
+    for (uint64_t n : merged) s.count += n;
+    if (s.count == 0) return s;
+
+    auto percentile = [&](double p) {
+        uint64_t rank = static_cast<uint64_t>(std::ceil(p * static_cast<double>(s.count)));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < BUCKETS; ++i) {
+            seen += merged[i];
+            if (seen >= rank) return std::min<uint64_t>(bucketUpperBound(i), s.max);
+        }
+        return s.max;
+    };
+    s.p50 = percentile(0.50);
+    s.p90 = percentile(0.90);
+    s.p99 = percentile(0.99);
+    return s;
+}
+
+// Merge all shards of a counter
+uint64_t Metrics::total(Counter counter) const {
+    std::lock_guard<std::mutex> lk(shardsMutex_);
+    uint64_t sum = 0;
+    for (const auto& shard : shards_) {
+        sum += shard->counters[static_cast<size_t>(counter)].load(std::memory_order_relaxed);
+    }
+    return sum;
+}
+
+// Members of the "metrics" JSON object, one per line
+std::pmr::string Metrics::renderJson(std::string_view indent) const {
+    std::pmr::string out(Arena::resource());
+    auto line = [&]() -> std::pmr::string& {
+        if (!out.empty()) out += ",\n";
+        return out.append(indent);
+    };
+
+    for (size_t i = 0; i < HISTOGRAM_COUNT; ++i) {
+        Summary s = summarize(static_cast<Histogram>(i));
+        line().append("\"").append(HISTOGRAM_NAMES[i]).append("_us\": { \"count\": ");
+        appendNumber(out, s.count);
+        out.append(", \"p50\": ");
+        appendMicros(out, s.p50);
+        out.append(", \"p90\": ");
+        appendMicros(out, s.p90);
+        out.append(", \"p99\": ");
+        appendMicros(out, s.p99);
+        out.append(", \"max\": ");
+        appendMicros(out, s.max);
+        out.append(" }");
+    }
+    for (size_t i = 0; i < COUNTER_COUNT; ++i) {
+        line().append("\"").append(COUNTER_NAMES[i]).append("\": ");
+        appendNumber(out, total(static_cast<Counter>(i)));
+    }
+    line().append("\"log_dropped\": ");
+    appendNumber(out, Logger::getInstance().droppedCount());
+    return out;
+}
+
+// HUD text for a duration
+FixedString<23> Metrics::formatMicros(uint64_t nanos) {
+    FixedString<23> text;
+    text.appendNumber(static_cast<long long>(nanos / 1000)).append('.')
+        .appendNumber(static_cast<long long>(nanos % 1000 / 100)).append(" us");
+    return text;
+}
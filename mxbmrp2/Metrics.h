@@ -0,0 +1,174 @@
+
+// Metrics.h
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "FixedString.h"
+
+// Latency histograms, in nanoseconds
+enum class Histogram : uint8_t {
+    Draw,
+    DisplayKeysWait,        // Draw waiting for the display snapshot
+    PeriodicTick,
+    MemoryScan,             // busy time of a finished scan
+    EventQueueDelay,        // callback export to the start of its handling
+    EventDispatch,          // Plugin handler run by EventDispatcher
+
+    // How long each Plugin lock domain is held
+    LockSessionHold,
+    LockServerHold,
+    LockDisplayHold,
+    LockExportHold,
+
+    // Time the exports keep the game waiting
+    CallbackEventInit,
+    CallbackEventDeinit,
+    CallbackRunInit,
+    CallbackRunDeinit,
+    CallbackRunStart,
+    CallbackRunStop,
+    CallbackRunLap,
+    CallbackRunSplit,
+    CallbackRaceEvent,
+    CallbackRaceSession,
+    CallbackRaceSessionState,
+    CallbackRaceAddEntry,
+    CallbackRaceRemoveEntry,
+    CallbackRaceClassification,
+    CallbackRaceCommunication,
+    CallbackRunTelemetry,
+
+    Count
+};
+
+enum class Counter : uint8_t {
+    JsonWrites,
+    JsonBytesWritten,
+    HtmlWrites,
+    HtmlBytesWritten,
+    StatsWrites,
+    StatsBytesWritten,
+    EventQueueFull,         // exports that had to wait for room in the queue
+    ArenaOverflowBytes,     // scratch memory that didn't fit a thread's Arena
+    TelemetrySamples,
+    TelemetrySkipped,       // samples a reader lost to the ring wrapping around
+
+    Count
+};
+
+// Process-wide counters and histograms. Each thread records into its own
+// shard, written only by that thread, so recording is a handful of
+// uncontended relaxed stores; readers merge the shards.
+//
+// Histogram buckets are HDR-style: exact below 8, then 8 sub-buckets per
+// power of two, so any reported percentile is within 12.5% of the truth.
+class Metrics {
+public:
+    struct Summary {
+        uint64_t count = 0;
+        uint64_t sum = 0;
+        uint64_t max = 0;
+        uint64_t p50 = 0;
+        uint64_t p90 = 0;
+        uint64_t p99 = 0;
+    };
+
+    static Metrics& getInstance();
+
+    void record(Histogram histogram, uint64_t value);
+    void add(Counter counter, uint64_t amount = 1);
+
+    Summary summarize(Histogram histogram) const;
+    uint64_t total(Counter counter) const;
+
+    // snake_case names used in the exports, e.g. "draw"
+    static const char* name(Histogram histogram);
+    static const char* name(Counter counter);
+
+    // Body of the JSON export's "metrics" object (times in microseconds),
+    // in the calling thread's Arena
+    std::pmr::string renderJson(std::string_view indent) const;
+
+    // "123.4 us" style text for HUD fields
+    static FixedString<23> formatMicros(uint64_t nanos);
+
+private:
+    static constexpr int SUB_BITS = 3;
+    static constexpr size_t SUB_BUCKETS = size_t{ 1 } << SUB_BITS;
+    static constexpr int MAX_EXPONENT = 40;     // ~18 minutes in ns
+    static constexpr size_t BUCKETS = SUB_BUCKETS + (MAX_EXPONENT - SUB_BITS) * SUB_BUCKETS;
+
+    static constexpr size_t HISTOGRAM_COUNT = static_cast<size_t>(Histogram::Count);
+    static constexpr size_t COUNTER_COUNT = static_cast<size_t>(Counter::Count);
+
+    struct HistogramShard {
+        std::array<std::atomic<uint64_t>, BUCKETS> buckets{};
+        std::atomic<uint64_t> sum{ 0 };
+        std::atomic<uint64_t> max{ 0 };
+    };
+
+    struct Shard {
+        std::array<HistogramShard, HISTOGRAM_COUNT> histograms;
+        std::array<std::atomic<uint64_t>, COUNTER_COUNT> counters{};
+    };
+
+    static size_t bucketIndex(uint64_t value);
+    static uint64_t bucketUpperBound(size_t index);
+
+    Metrics() = default;
+    Metrics(const Metrics&) = delete;
+    Metrics& operator=(const Metrics&) = delete;
+
+    Shard& localShard();
+
+    mutable std::mutex shardsMutex_;    // taken once per thread, and by readers
+    std::vector<std::unique_ptr<Shard>> shards_;
+};
+
+// Records the lifetime of the scope into a histogram
+class ScopedTimer {
+public:
+    explicit ScopedTimer(Histogram histogram)
+        : histogram_(histogram), start_(std::chrono::steady_clock::now()) {}
+
+    ~ScopedTimer() {
+        Metrics::getInstance().record(histogram_, static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_).count()));
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    Histogram histogram_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+// lock_guard that records how long the lock was held (not the wait for it)
+class TimedLock {
+public:
+    TimedLock(std::mutex& mutex, Histogram histogram)
+        : lock_(mutex), timer_(histogram) {}
+
+    TimedLock(const TimedLock&) = delete;
+    TimedLock& operator=(const TimedLock&) = delete;
+
+private:
+    std::lock_guard<std::mutex> lock_;
+    ScopedTimer timer_;     // destroyed first, so the unlock isn't counted
+};
+
+#define METRICS_CONCAT_(a, b) a##b
+#define METRICS_CONCAT(a, b) METRICS_CONCAT_(a, b)
+#define METRICS_TIME(histogram) ScopedTimer METRICS_CONCAT(scopedTimer_, __LINE__)(histogram)
@@ -0,0 +1,197 @@
+
+// MetricsServer.cpp
+
+#include "pch.h"
+
+#include <algorithm>
+#include <climits>
+
+#include "MetricsServer.h"
+#include "Logger.h"
+#include "Tracer.h"
+
+namespace {
+    constexpr long ACCEPT_POLL_MS = 250;        // how quickly stop() is noticed
+    constexpr DWORD REQUEST_TIMEOUT_MS = 1000;
+    constexpr size_t MAX_REQUEST_SIZE = 8192;
+    constexpr size_t PAGE_CAPACITY = 64 * 1024;
+
+    bool sendAll(SOCKET s, const char* data, size_t size) {
+        while (size > 0) {
+            int sent = send(s, data, static_cast<int>(std::min<size_t>(size, INT_MAX)), 0);
+            if (sent <= 0) return false;
+            data += sent;
+            size -= static_cast<size_t>(sent);
+        }
+        return true;
+    }
+
+    void sendResponse(SOCKET s, const char* status, const char* contentType, const std::string& body) {
+        std::string header = std::string("HTTP/1.1 ") + status + "\r\n"
+            + "Content-Type: " + contentType + "\r\n"
+            + "Content-Length: " + std::to_string(body.size()) + "\r\n"
+            + "Connection: close\r\n\r\n";
+        if (sendAll(s, header.data(), header.size())) {
+            sendAll(s, body.data(), body.size());
+        }
+    }
+}
+
+MetricsServer::~MetricsServer() {
+    stop();
+}
+
+// Bind, listen and start the accept thread
+bool MetricsServer::start(unsigned short port) {
+    if (isRunning()) return true;
+
+    WSADATA wsaData;
+    if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
+        LOG_ERROR(IO, "Metrics endpoint: WSAStartup failed");
+        return false;
+    }
+
+    listener_ = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (listener_ == INVALID_SOCKET) {
+        LOG_ERROR(IO, "Metrics endpoint: unable to create socket");
+        WSACleanup();
+        return false;
+    }
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+
+    if (bind(listener_, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) == SOCKET_ERROR
+        || listen(listener_, SOMAXCONN) == SOCKET_ERROR) {
+        LOG_ERROR(IO, "Metrics endpoint: unable to listen on 127.0.0.1:" + std::to_string(port));
+        closesocket(listener_);
+        listener_ = INVALID_SOCKET;
+        WSACleanup();
+        return false;
+    }
+
+    for (auto& page : pages_) {
+        if (!page) {
+            page = std::make_shared<std::string>();
+            page->reserve(PAGE_CAPACITY);
+        }
+    }
+
+    port_ = port;
+    running_ = true;
+    thread_ = std::thread(&MetricsServer::run, this);
+
+    LOG_INFO(IO, "Serving metrics at http://127.0.0.1:" + std::to_string(port) + "/metrics");
+    return true;
+}
+
+// Stop accepting and wait for the thread to exit
+void MetricsServer::stop() {
+    if (!running_.exchange(false)) return;
+
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    closesocket(listener_);
+    listener_ = INVALID_SOCKET;
+    WSACleanup();
+
+    LOG_INFO(IO, "Metrics endpoint stopped");
+}
+
+// Replace the page served to subsequent scrapes
+void MetricsServer::publish(std::string_view page) {
+    // A buffer only pages_ holds is neither served nor being sent. The fence
+    // pairs with a scrape's release of its reference.
+    std::shared_ptr<std::string> next;
+    {
+        std::lock_guard<std::mutex> lk(pageMutex_);
+        for (const auto& buffer : pages_) {
+            if (buffer && buffer.use_count() == 1) {
+                next = buffer;
+                break;
+            }
+        }
+    }
+    if (!next) return;      // a slow scrape: the current page is served a tick longer
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    next->assign(page.data(), page.size());
+    std::lock_guard<std::mutex> lk(pageMutex_);
+    page_ = std::move(next);
+}
+
+// Accept and answer one connection at a time
+void MetricsServer::run() {
+    Tracer::getInstance().nameThread("Metrics endpoint");
+
+    while (running_) {
+        fd_set readable;
+        FD_ZERO(&readable);
+        FD_SET(listener_, &readable);
+        timeval timeout{ 0, ACCEPT_POLL_MS * 1000 };
+
+        int ready = select(static_cast<int>(listener_ + 1), &readable, nullptr, nullptr, &timeout);
+        if (ready <= 0) continue;
+
+        SOCKET client = accept(listener_, nullptr, nullptr);
+        if (client == INVALID_SOCKET) continue;
+
+        serve(client);
+        closesocket(client);
+    }
+}
+
+// Answer a single HTTP request
+void MetricsServer::serve(SOCKET client) {
+    TRACE_SCOPE("io", "MetricsServer::serve");
+
+    DWORD timeoutMs = REQUEST_TIMEOUT_MS;
+    setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&timeoutMs), sizeof(timeoutMs));
+
+    // Read the whole header so closing doesn't reset the connection
+    std::string request;
+    char buf[1024];
+    while (request.find("\r\n\r\n") == std::string::npos) {
+        if (request.size() >= MAX_REQUEST_SIZE) {
+            sendResponse(client, "431 Request Header Fields Too Large", "text/plain", "");
+            return;
+        }
+        int received = recv(client, buf, sizeof(buf), 0);
+        if (received <= 0) return;
+        request.append(buf, static_cast<size_t>(received));
+    }
+
+    // "GET /metrics?x HTTP/1.1"
+    const std::string line = request.substr(0, request.find("\r\n"));
+    const size_t pathStart = line.find(' ');
+    const size_t pathEnd = line.find(' ', pathStart + 1);
+    const std::string method = line.substr(0, pathStart);
+    std::string path = pathStart == std::string::npos ? "" : line.substr(pathStart + 1, pathEnd - pathStart - 1);
+    path = path.substr(0, path.find('?'));
+
+    if (method != "GET") {
+        sendResponse(client, "405 Method Not Allowed", "text/plain", "Only GET is supported\n");
+    }
+    else if (path != "/metrics") {
+        sendResponse(client, "404 Not Found", "text/plain", "Try /metrics\n");
+    }
+    else {
+        std::shared_ptr<const std::string> page;
+        {
+            std::lock_guard<std::mutex> lk(pageMutex_);
+            page = page_;
+        }
+
+        if (page) {
+            sendResponse(client, "200 OK", "text/plain; version=0.0.4; charset=utf-8", *page);
+        }
+        else {
+            sendResponse(client, "503 Service Unavailable", "text/plain", "No metrics yet\n");
+        }
+    }
+
+    shutdown(client, SD_SEND);
+}
@@ -0,0 +1,50 @@
+
+// MetricsServer.h
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+
+// Serves the last published page at http://127.0.0.1:<port>/metrics on its
+// own thread. Scrapes only copy a pointer to the page, so they never wait
+// on plugin state; the page is rendered and published by the periodic tasks.
+class MetricsServer {
+public:
+    MetricsServer() = default;
+    ~MetricsServer();
+
+    MetricsServer(const MetricsServer&) = delete;
+    MetricsServer& operator=(const MetricsServer&) = delete;
+
+    // Listen on the loopback interface only. Returns false if the port can't be bound.
+    bool start(unsigned short port);
+    void stop();
+
+    bool isRunning() const { return running_.load(std::memory_order_relaxed); }
+    unsigned short port() const { return port_; }
+
+    // Copies `page` into the buffer no scrape is reading and serves it from
+    // then on. Doesn't allocate unless the page outgrows the buffers.
+    void publish(std::string_view page);
+
+private:
+    void run();
+    void serve(SOCKET client);
+
+    std::thread thread_;
+    std::atomic<bool> running_{ false };
+    SOCKET listener_ = INVALID_SOCKET;
+    unsigned short port_ = 0;
+
+    // Two pages, allocated by start(): the one being served and the one
+    // publish writes next. A scrape holds a reference while it sends.
+    std::mutex pageMutex_;      // guards the pointers only, never held while sending
+    std::array<std::shared_ptr<std::string>, 2> pages_;
+    std::shared_ptr<const std::string> page_;
+};
@@ -0,0 +1,82 @@
+
+// MpscQueue.h
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+// Bounded lock-free multi-producer / single-consumer queue (Vyukov's
+// sequenced ring). Producers claim a cell with one CAS on the enqueue
+// position and publish it through the cell's sequence number, so a push
+// never blocks; it fails instead when the ring is full.
+template <typename T, size_t Capacity>
+class MpscQueue {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+        "Capacity must be a power of two");
+
+public:
+    MpscQueue() {
+        for (size_t i = 0; i < Capacity; ++i) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    // Any thread. `value` is left untouched if the queue is full.
+    bool tryPush(T&& value) {
+        size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+        while (true) {
+            Cell& cell = cells_[pos & MASK];
+            size_t seq = cell.sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+
+            if (diff == 0) {
+                if (enqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.value = std::move(value);
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0) {
+                return false;   // full: the consumer hasn't freed this cell yet
+            }
+            else {
+                pos = enqueuePos_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Consumer thread only
+    bool tryPop(T& out) {
+        Cell& cell = cells_[dequeuePos_ & MASK];
+        size_t seq = cell.sequence.load(std::memory_order_acquire);
+        if (static_cast<intptr_t>(seq) - static_cast<intptr_t>(dequeuePos_ + 1) < 0) {
+            return false;       // empty, or the producer hasn't published yet
+        }
+
+        out = std::move(cell.value);
+        cell.sequence.store(dequeuePos_ + Capacity, std::memory_order_release);
+        ++dequeuePos_;
+        return true;
+    }
+
+    static constexpr size_t capacity() { return Capacity; }
+
+private:
+    static constexpr size_t MASK = Capacity - 1;
+
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    std::array<Cell, Capacity> cells_;
+    alignas(64) std::atomic<size_t> enqueuePos_{ 0 };
+    alignas(64) size_t dequeuePos_ = 0;
+};
@@ -0,0 +1,175 @@
+
+// OffsetDatabase.cpp
+
+#include "pch.h"
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <string>
+
+#include "OffsetDatabase.h"
+#include "Logger.h"
+
+namespace OffsetDatabase {
+
+    const KnownBuild* findKnownBuild(const OffsetScanner::BuildFingerprint& fingerprint) {
+        for (const auto& build : KNOWN_BUILDS) {
+            if (build.timeDateStamp == fingerprint.timeDateStamp &&
+                build.sizeOfImage == fingerprint.sizeOfImage)
+            {
+                return &build;
+            }
+        }
+        return nullptr;
+    }
+
+    bool isOffsetKey(std::string_view key) {
+        for (const char* offsetKey : OFFSET_KEYS) {
+            if (key == offsetKey) return true;
+        }
+        return false;
+    }
+
+    Overrides loadOverrides(
+        const std::filesystem::path& path,
+        const OffsetScanner::BuildFingerprint& fingerprint)
+    {
+        Overrides out;
+
+        std::ifstream in(path);
+        if (!in) return out;
+
+        const std::string wanted = "[" + fingerprint.toString() + "]";
+        bool inSection = false;
+        std::string line;
+        int lineNumber = 0;
+
+        while (std::getline(in, line)) {
+            lineNumber++;
+
+            line.erase(0, line.find_first_not_of(" \t\r"));
+            line.erase(line.find_last_not_of(" \t\r") + 1);
+            if (line.empty() || line[0] == '#') continue;
+
+            if (line[0] == '[') {
+                inSection = (line == wanted);
+                continue;
+            }
+            if (!inSection) continue;
+
+            size_t delimiterPos = line.find('=');
+            if (delimiterPos == std::string::npos) continue;
+
+            std::string key = line.substr(0, delimiterPos);
+            std::string value = line.substr(delimiterPos + 1);
+            key.erase(key.find_last_not_of(" \t") + 1);
+            value.erase(0, value.find_first_not_of(" \t"));
+
+            if (key == "use_configured_offsets") {
+                std::transform(value.begin(), value.end(), value.begin(),
+                    [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+                out.useConfigured = (value == "true");
+                continue;
+            }
+            if (!isOffsetKey(key)) {
+                LOG_WARNING(Memory, "Unknown offset override on line " + std::to_string(lineNumber) + ": " + key);
+                continue;
+            }
+
+            try {
+                size_t pos = 0;
+                unsigned long v = std::stoul(value, &pos, 0);
+                if (pos != value.size()) throw std::invalid_argument("trailing characters");
+                out.offsets[key] = v;
+            }
+            catch (const std::exception& e) {
+                LOG_WARNING(Memory, "Invalid offset override on line " + std::to_string(lineNumber) + ": " + e.what());
+            }
+        }
+        return out;
+    }
+
+    Selection selectForBuild(
+        const OffsetScanner::BuildFingerprint& fingerprint,
+        const Overrides& overrides,
+        std::optional<OffsetScanner::Cache> cache,
+        const OffsetScanner::OffsetMap& configured,
+        std::string_view overrideFileName)
+    {
+        Selection out;
+
+        if (const auto* known = findKnownBuild(fingerprint)) {
+            for (const auto& entry : known->offsets) {
+                out.trusted[entry.key] = entry.value;
+                out.buildOffsets[entry.key] = entry.value;
+            }
+            LOG_INFO(Memory, std::string("Using bundled offsets for ") + known->label);
+        }
+        else if (overrides.useConfigured) {
+            for (const auto& key : OffsetScanner::SCANNABLE_OFFSETS) {
+                if (auto it = configured.find(key); it != configured.end()) {
+                    out.trusted[key] = it->second;
+                }
+            }
+            LOG_INFO(Memory, "Using configured offsets for this build (use_configured_offsets)");
+        }
+        for (const auto& [key, value] : overrides.offsets) {
+            out.trusted[key] = value;
+        }
+
+        if (cache && cache->offsets.empty()) {
+            // Earlier versions assumed mxbmrp2.ini matched whatever build they
+            // first saw, so neither its offsets nor its signatures can be trusted
+            LOG_INFO(Memory, "Ignoring offsets cache of an unverified build");
+            cache.reset();
+        }
+        const bool cachedForBuild = cache && cache->build == fingerprint;
+
+        auto vouched = [&] {
+            return std::all_of(OffsetScanner::SCANNABLE_OFFSETS.begin(), OffsetScanner::SCANNABLE_OFFSETS.end(),
+                [&](const std::string& key) { return out.trusted.count(key) != 0; });
+        };
+
+        if (!vouched() && !cache) {
+            // First start: nothing to check mxbmrp2.ini against yet, and its
+            // defaults are the build this release targets
+            for (const auto& key : OffsetScanner::SCANNABLE_OFFSETS) {
+                auto it = configured.find(key);
+                if (it == configured.end() || out.trusted.count(key)) continue;
+                out.trusted[key] = it->second;
+                out.buildOffsets[key] = it->second;
+            }
+            LOG_INFO(Memory, "No offsets cache yet, using the configured offsets for this build");
+        }
+
+        if (!vouched()) {
+            if (cachedForBuild) {
+                out.buildOffsets = cache->offsets;
+                LOG_INFO(Memory, "Using cached offsets for this build ("
+                    + std::to_string(cache->offsets.size()) + (cache->reference ? " verified)" : " discovered)"));
+                return out;
+            }
+            if (!cache || cache->signatures.empty()) {
+                LOG_WARNING(Memory, "Unknown build and no signatures to relocate offsets with, memory fields disabled. "
+                    "Add a [" + fingerprint.toString() + "] section to " + std::string(overrideFileName)
+                    + " with the offsets, or with use_configured_offsets = true if mxbmrp2.ini matches this build");
+                return out;
+            }
+            // Changed build: memory reads stay disabled until the scan relocates them
+            LOG_INFO(Memory, "Build changed since " + cache->build.toString() + ", relocating offsets by signature");
+            out.trusted.clear();
+        }
+        else if (cachedForBuild && !cache->signatures.empty()) {
+            return out;     // signatures already learned on this build
+        }
+        else {
+            LOG_INFO(Memory, "Learning signatures for this build's offsets");
+        }
+
+        out.cache = std::move(cache);
+        out.discover = true;
+        return out;
+    }
+
+} // namespace OffsetDatabase
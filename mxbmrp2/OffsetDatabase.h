@@ -0,0 +1,149 @@
+
+// OffsetDatabase.h
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "OffsetScanner.h"
+
+// Memory offsets, in the order of OffsetDatabase::OFFSET_KEYS
+enum class MemoryOffset : std::size_t {
+    LocalServerName, LocalServerPassword, LocalServerLocation, LocalServerClientsMax,
+    RemoteServerSockaddr, RemoteServerPassword, RemoteServerName, RemoteServerLocation, RemoteServerPing, RemoteServerClientsMax,
+    LocalServerRemainingTearoffs, RemoteServerRemainingTearoffs,
+    TrackDeformation,
+    ServerCategories, ServerTrackId, ServerClients,
+    ConnectionString,
+    Count
+};
+
+namespace OffsetDatabase {
+
+    inline constexpr std::size_t OFFSET_COUNT = 17;
+
+    // Config key of each MemoryOffset
+    inline constexpr std::array<const char*, OFFSET_COUNT> OFFSET_KEYS = {{
+        "local_server_name_offset",
+        "local_server_password_offset",
+        "local_server_location_offset",
+        "local_server_clients_max_offset",
+        "remote_server_sockaddr_offset",
+        "remote_server_password_offset",
+        "remote_server_name_offset",
+        "remote_server_location_offset",
+        "remote_server_ping_offset",
+        "remote_server_clients_max_offset",
+        "local_server_remaining_tearoffs_offset",
+        "remote_server_remaining_tearoffs_offset",
+        "track_deformation_offset",
+        "server_categories_offset",
+        "server_track_id_offset",
+        "server_clients_offset",
+        "connection_string_offset",
+    }};
+
+    static_assert(static_cast<std::size_t>(MemoryOffset::Count) == OFFSET_COUNT);
+
+    inline constexpr const char* key(MemoryOffset offset) {
+        return OFFSET_KEYS[static_cast<std::size_t>(offset)];
+    }
+
+    struct OffsetEntry {
+        const char* key;
+        unsigned long value;
+    };
+
+    // Memory offsets for one build of the game executable
+    struct KnownBuild {
+        const char* label;
+        // As in the log's "Executable build:" line. Offsets are only ever
+        // used for the build that matches exactly; an entry whose fingerprint
+        // isn't recorded yet (zero) matches nothing, and its offsets only
+        // reach a build as the mxbmrp2.ini defaults (see selectForBuild).
+        uint32_t timeDateStamp;
+        uint32_t sizeOfImage;
+        std::array<OffsetEntry, OFFSET_COUNT> offsets;
+    };
+
+    inline constexpr KnownBuild KNOWN_BUILDS[] = {
+        { "beta20b", 0, 0, {{
+            {"local_server_name_offset", 0x9D6768UL},
+            {"local_server_password_offset", 0x9D67ACUL},
+            {"local_server_location_offset", 0x9D67CCUL},
+            {"local_server_clients_max_offset", 0x9D6820UL},
+
+            {"remote_server_sockaddr_offset", 0x58B2BCUL},
+            {"remote_server_password_offset", 0x9BDE04UL},
+            {"remote_server_name_offset", 0x1BUL},
+            {"remote_server_location_offset", 0x75UL},
+            {"remote_server_ping_offset", 0x58B534UL},
+            {"remote_server_clients_max_offset", 0x5DUL},
+
+            {"local_server_remaining_tearoffs_offset", 0x9D78BCUL},
+            {"remote_server_remaining_tearoffs_offset", 0x108BE0CUL},
+
+            {"track_deformation_offset", 0x58B708UL},
+
+            {"server_categories_offset", 0x58B634UL},
+            {"server_track_id_offset", 0x58B5D4UL},
+            {"server_clients_offset", 0xE49F28UL},
+
+            {"connection_string_offset", 0x559DC0UL},
+        }} },
+    };
+
+    // The build this release targets; its offsets are the mxbmrp2.ini defaults
+    inline constexpr const KnownBuild& REFERENCE_BUILD = KNOWN_BUILDS[0];
+
+    // Returns the bundled entry matching `fingerprint`, if any
+    const KnownBuild* findKnownBuild(const OffsetScanner::BuildFingerprint& fingerprint);
+
+    // Returns true if `key` names a memory offset
+    bool isOffsetKey(std::string_view key);
+
+    // What the override file says about one build
+    struct Overrides {
+        OffsetScanner::OffsetMap offsets;
+        bool useConfigured = false;     // `use_configured_offsets = true`: mxbmrp2.ini matches this build
+    };
+
+    // Loads the user overrides for `fingerprint` from the `[TTTTTTTT-SSSSSSSS]`
+    // section of the override file (missing file or section yields nothing)
+    Overrides loadOverrides(
+        const std::filesystem::path& path,
+        const OffsetScanner::BuildFingerprint& fingerprint
+    );
+
+    // Where the scannable offsets for the running build come from
+    struct Selection {
+        OffsetScanner::OffsetMap buildOffsets;      // usable right away
+        OffsetScanner::OffsetMap trusted;           // vouched for, to learn signatures from
+        std::optional<OffsetScanner::Cache> cache;  // for discovery, if it is still usable
+        bool discover = false;                      // learn or relocate in the background
+    };
+
+    // Picks the offsets for `fingerprint`. Scannable offsets are only used
+    // when something vouches for them, in this order:
+    //   1. the override file: offsets, or `use_configured_offsets = true`
+    //      to vouch for the mxbmrp2.ini ones (`configured`)
+    //   2. the bundled table of known builds
+    //   3. on the first start (no offsets cache yet), mxbmrp2.ini, whose
+    //      defaults are REFERENCE_BUILD's
+    //   4. the offsets cache from a previous start on this build
+    //   5. signatures learned on an earlier build, relocated in the background
+    // Offsets that none of these can provide are left out rather than guessed.
+    Selection selectForBuild(
+        const OffsetScanner::BuildFingerprint& fingerprint,
+        const Overrides& overrides,
+        std::optional<OffsetScanner::Cache> cache,
+        const OffsetScanner::OffsetMap& configured,
+        std::string_view overrideFileName
+    );
+
+} // namespace OffsetDatabase
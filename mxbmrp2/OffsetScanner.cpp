@@ -0,0 +1,391 @@
+
+// OffsetScanner.cpp
+
+#include "pch.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#include "OffsetScanner.h"
+
+namespace {
+    // Bytes kept before the disp32 (prefixes, REX, opcode, ModRM)
+    constexpr size_t SIGNATURE_PREFIX = 6;
+
+    // Bytes kept after the disp32 start at this and grow until unique
+    constexpr size_t SIGNATURE_SUFFIX_MIN = 4;
+    constexpr size_t SIGNATURE_SUFFIX_MAX = 32;
+
+    // References tried per offset before giving up on it
+    constexpr int MAX_LEARN_ATTEMPTS = 8;
+
+    // Possible immediate sizes following a [rip+disp32] operand
+    constexpr size_t IMMEDIATE_SIZES[] = { 0, 1, 2, 4 };
+
+    std::string trim(std::string s) {
+        s.erase(0, s.find_first_not_of(" \t\r"));
+        s.erase(s.find_last_not_of(" \t\r") + 1);
+        return s;
+    }
+
+    // Counts matches of `sig` across all sections, stopping at `limit`
+    size_t countMatches(const std::vector<OffsetScanner::CodeSection>& sections,
+        const OffsetScanner::Signature& sig, size_t limit)
+    {
+        size_t total = 0;
+        for (const auto& section : sections) {
+            total += OffsetScanner::findPattern(
+                section.bytes.data(), section.bytes.size(), sig, limit - total).size();
+            if (total >= limit) break;
+        }
+        return total;
+    }
+
+    // Builds the shortest signature around the disp32 at `dispAt` that is unique
+    std::optional<OffsetScanner::Signature> buildUniqueSignature(
+        const std::vector<OffsetScanner::CodeSection>& sections,
+        const OffsetScanner::CodeSection& section,
+        size_t dispAt,
+        size_t immediateSize)
+    {
+        const size_t prefix = (std::min)(dispAt, SIGNATURE_PREFIX);
+        const size_t start = dispAt - prefix;
+
+        for (size_t suffix = SIGNATURE_SUFFIX_MIN + immediateSize;
+            suffix <= SIGNATURE_SUFFIX_MAX;
+            suffix += 4)
+        {
+            const size_t len = prefix + 4 + suffix;
+            if (start + len > section.bytes.size()) break;
+
+            OffsetScanner::Signature sig;
+            sig.bytes.assign(section.bytes.begin() + start, section.bytes.begin() + start + len);
+            sig.mask.assign(len, 1);
+            std::fill(sig.mask.begin() + prefix, sig.mask.begin() + prefix + 4, 0);
+            std::fill(sig.bytes.begin() + prefix, sig.bytes.begin() + prefix + 4, 0);
+            sig.dispPos = prefix;
+            sig.nextInstrPos = prefix + 4 + immediateSize;
+
+            // Call/jmp targets move between builds, so don't pin their rel32
+            for (size_t j = sig.nextInstrPos; j + 1 < len; ++j) {
+                if (sig.bytes[j] == 0xE8 || sig.bytes[j] == 0xE9) {
+                    const size_t relEnd = (std::min)(j + 5, len);
+                    std::fill(sig.mask.begin() + j + 1, sig.mask.begin() + relEnd, 0);
+                    std::fill(sig.bytes.begin() + j + 1, sig.bytes.begin() + relEnd, 0);
+                    j = relEnd - 1;
+                }
+            }
+
+            if (countMatches(sections, sig, 2) == 1) {
+                return sig;
+            }
+        }
+        return std::nullopt;
+    }
+}
+
+namespace OffsetScanner {
+
+    const std::vector<std::string> SCANNABLE_OFFSETS = {
+        "local_server_name_offset",
+        "local_server_password_offset",
+        "local_server_location_offset",
+        "local_server_clients_max_offset",
+        "remote_server_sockaddr_offset",
+        "remote_server_password_offset",
+        "remote_server_ping_offset",
+        "local_server_remaining_tearoffs_offset",
+        "remote_server_remaining_tearoffs_offset",
+        "track_deformation_offset",
+        "server_categories_offset",
+        "server_track_id_offset",
+        "server_clients_offset",
+        "connection_string_offset",
+    };
+
+    std::string BuildFingerprint::toString() const {
+        char buf[20];
+        std::snprintf(buf, sizeof(buf), "%08X-%08X",
+            static_cast<unsigned>(timeDateStamp), static_cast<unsigned>(sizeOfImage));
+        return std::string(buf);
+    }
+
+    std::optional<BuildFingerprint> BuildFingerprint::parse(std::string_view text) {
+        auto dash = text.find('-');
+        if (dash == std::string_view::npos) return std::nullopt;
+        try {
+            size_t pos = 0;
+            std::string ts(text.substr(0, dash));
+            std::string sz(text.substr(dash + 1));
+            BuildFingerprint fp;
+            fp.timeDateStamp = static_cast<uint32_t>(std::stoul(ts, &pos, 16));
+            if (pos != ts.size()) return std::nullopt;
+            fp.sizeOfImage = static_cast<uint32_t>(std::stoul(sz, &pos, 16));
+            if (pos != sz.size()) return std::nullopt;
+            return fp;
+        }
+        catch (...) {
+            return std::nullopt;
+        }
+    }
+
+    std::string Signature::toString() const {
+        std::string out;
+        char hex[4];
+        for (size_t i = 0; i < bytes.size(); ++i) {
+            if (i) out += ' ';
+            if (mask[i]) {
+                std::snprintf(hex, sizeof(hex), "%02X", bytes[i]);
+                out += hex;
+            }
+            else {
+                out += "??";
+            }
+        }
+        out += "|" + std::to_string(dispPos) + "|" + std::to_string(nextInstrPos);
+        return out;
+    }
+
+    std::optional<Signature> Signature::parse(std::string_view text) {
+        auto bar1 = text.find('|');
+        if (bar1 == std::string_view::npos) return std::nullopt;
+        auto bar2 = text.find('|', bar1 + 1);
+        if (bar2 == std::string_view::npos) return std::nullopt;
+
+        Signature sig;
+        std::istringstream ss{ std::string(text.substr(0, bar1)) };
+        std::string tok;
+        try {
+            while (ss >> tok) {
+                if (tok == "??" || tok == "?") {
+                    sig.bytes.push_back(0);
+                    sig.mask.push_back(0);
+                    continue;
+                }
+                size_t pos = 0;
+                unsigned long b = std::stoul(tok, &pos, 16);
+                if (pos != tok.size() || b > 0xFF) return std::nullopt;
+                sig.bytes.push_back(static_cast<uint8_t>(b));
+                sig.mask.push_back(1);
+            }
+            sig.dispPos = std::stoul(std::string(text.substr(bar1 + 1, bar2 - bar1 - 1)));
+            sig.nextInstrPos = std::stoul(std::string(text.substr(bar2 + 1)));
+        }
+        catch (...) {
+            return std::nullopt;
+        }
+
+        // The displacement must be fully inside the pattern, and the pattern
+        // needs at least one concrete byte to anchor the search on
+        if (sig.dispPos + 4 > sig.bytes.size() ||
+            sig.nextInstrPos < sig.dispPos + 4 ||
+            std::find(sig.mask.begin(), sig.mask.end(), 1) == sig.mask.end())
+        {
+            return std::nullopt;
+        }
+        return sig;
+    }
+
+    std::vector<size_t> findPattern(
+        const uint8_t* data,
+        size_t size,
+        const Signature& sig,
+        size_t maxMatches)
+    {
+        std::vector<size_t> matches;
+        const size_t len = sig.bytes.size();
+        if (len == 0 || len > size || maxMatches == 0) return matches;
+
+        // Anchor on the first concrete byte so memchr can skip ahead
+        const size_t anchor = static_cast<size_t>(
+            std::find(sig.mask.begin(), sig.mask.end(), 1) - sig.mask.begin());
+        if (anchor == len) return matches;
+        const uint8_t anchorByte = sig.bytes[anchor];
+
+        const uint8_t* p = data + anchor;
+        const uint8_t* last = data + (size - len) + anchor;
+        while (p <= last) {
+            p = static_cast<const uint8_t*>(std::memchr(p, anchorByte, static_cast<size_t>(last - p) + 1));
+            if (!p) break;
+
+            const uint8_t* candidate = p - anchor;
+            bool ok = true;
+            for (size_t i = 0; i < len; ++i) {
+                if (sig.mask[i] && candidate[i] != sig.bytes[i]) {
+                    ok = false;
+                    break;
+                }
+            }
+            if (ok) {
+                matches.push_back(static_cast<size_t>(candidate - data));
+                if (matches.size() >= maxMatches) break;
+            }
+            ++p;
+        }
+        return matches;
+    }
+
+    SignatureMap learnSignatures(
+        const std::vector<CodeSection>& sections,
+        uintptr_t imageBase,
+        const OffsetMap& known,
+        const std::atomic<bool>& cancel)
+    {
+        // Sorted absolute target address -> key
+        std::vector<std::pair<uintptr_t, const std::string*>> targets;
+        for (const auto& [key, offset] : known) {
+            targets.emplace_back(imageBase + offset, &key);
+        }
+        std::sort(targets.begin(), targets.end());
+
+        SignatureMap out;
+        std::unordered_map<const std::string*, int> attempts;
+
+        for (const auto& section : sections) {
+            const uint8_t* d = section.bytes.data();
+            const size_t n = section.bytes.size();
+
+            for (size_t i = 1; i + 4 <= n; ++i) {
+                // ModRM with mod=00, rm=101 addresses [rip+disp32]
+                if ((d[i - 1] & 0xC7) != 0x05) continue;
+                if ((i & 0xFFFF) == 0 && cancel.load(std::memory_order_relaxed)) return out;
+
+                int32_t disp;
+                std::memcpy(&disp, d + i, sizeof(disp));
+
+                for (size_t imm : IMMEDIATE_SIZES) {
+                    const uintptr_t rip = section.address + i + 4 + imm;
+                    const uintptr_t target = rip + static_cast<intptr_t>(disp);
+
+                    auto it = std::lower_bound(targets.begin(), targets.end(), target,
+                        [](const auto& t, uintptr_t v) { return t.first < v; });
+                    if (it == targets.end() || it->first != target) continue;
+
+                    const std::string* key = it->second;
+                    if (out.count(*key) || attempts[key] >= MAX_LEARN_ATTEMPTS) continue;
+                    ++attempts[key];
+
+                    if (auto sig = buildUniqueSignature(sections, section, i, imm)) {
+                        out.emplace(*key, std::move(*sig));
+                    }
+                }
+            }
+        }
+        return out;
+    }
+
+    OffsetMap resolveOffsets(
+        const std::vector<CodeSection>& sections,
+        uintptr_t imageBase,
+        const SignatureMap& signatures,
+        const std::atomic<bool>& cancel)
+    {
+        OffsetMap out;
+        for (const auto& [key, sig] : signatures) {
+            if (cancel.load(std::memory_order_relaxed)) break;
+
+            // Must match exactly once across all sections
+            const CodeSection* hitSection = nullptr;
+            size_t hitPos = 0;
+            size_t hits = 0;
+            for (const auto& section : sections) {
+                auto matches = findPattern(section.bytes.data(), section.bytes.size(), sig, 2 - hits);
+                if (!matches.empty() && !hitSection) {
+                    hitSection = &section;
+                    hitPos = matches.front();
+                }
+                hits += matches.size();
+                if (hits >= 2) break;
+            }
+            if (hits != 1) continue;
+
+            int32_t disp;
+            std::memcpy(&disp, hitSection->bytes.data() + hitPos + sig.dispPos, sizeof(disp));
+            const uintptr_t rip = hitSection->address + hitPos + sig.nextInstrPos;
+            const uintptr_t target = rip + static_cast<intptr_t>(disp);
+            if (target < imageBase) continue;
+
+            out[key] = static_cast<unsigned long>(target - imageBase);
+        }
+        return out;
+    }
+
+    std::optional<Cache> loadCache(const std::filesystem::path& path) {
+        std::ifstream in(path);
+        if (!in) return std::nullopt;
+
+        Cache cache;
+        bool hasBuild = false;
+        bool hasSource = false;
+        std::string line;
+        while (std::getline(in, line)) {
+            line = trim(line);
+            if (line.empty() || line[0] == '#') continue;
+
+            auto eq = line.find('=');
+            if (eq == std::string::npos) continue;
+            std::string key = trim(line.substr(0, eq));
+            std::string value = trim(line.substr(eq + 1));
+
+            if (key == "build") {
+                if (auto fp = BuildFingerprint::parse(value)) {
+                    cache.build = *fp;
+                    hasBuild = true;
+                }
+            }
+            else if (key == "source") {
+                cache.reference = (value == "reference");
+                hasSource = true;
+            }
+            else if (key.rfind("offset.", 0) == 0) {
+                try {
+                    size_t pos = 0;
+                    unsigned long v = std::stoul(value, &pos, 0);
+                    if (pos == value.size()) cache.offsets[key.substr(7)] = v;
+                }
+                catch (...) {}
+            }
+            else if (key.rfind("signature.", 0) == 0) {
+                if (auto sig = Signature::parse(value)) {
+                    cache.signatures[key.substr(10)] = std::move(*sig);
+                }
+            }
+        }
+
+        if (!hasBuild) return std::nullopt;
+        // Caches written before `source` existed only scanned on changed builds
+        if (!hasSource) cache.reference = cache.offsets.empty();
+        return cache;
+    }
+
+    void saveCache(const std::filesystem::path& path, const Cache& cache) {
+        std::ostringstream out;
+        out << "# mxbmrp2 offsets cache (generated, safe to delete)\n";
+        out << "build=" << cache.build.toString() << "\n";
+        out << "source=" << (cache.reference ? "reference" : "signature") << "\n";
+
+        for (const auto& key : SCANNABLE_OFFSETS) {
+            if (auto it = cache.offsets.find(key); it != cache.offsets.end()) {
+                out << "offset." << key << "=0x" << std::uppercase << std::hex << it->second << std::dec << "\n";
+            }
+        }
+        for (const auto& key : SCANNABLE_OFFSETS) {
+            if (auto it = cache.signatures.find(key); it != cache.signatures.end()) {
+                out << "signature." << key << "=" << it->second.toString() << "\n";
+            }
+        }
+
+        auto tmp = path;
+        tmp += ".tmp";
+        {
+            std::ofstream ofs(tmp, std::ios::trunc);
+            if (!ofs) throw std::runtime_error("Unable to open " + tmp.string());
+            ofs << out.str();
+        }
+        std::filesystem::rename(tmp, path);
+    }
+
+} // namespace OffsetScanner
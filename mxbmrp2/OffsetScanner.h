@@ -0,0 +1,97 @@
+
+// OffsetScanner.h
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Platform-independent signature (AOB) scanning over copies of the game's
+// code sections. MemReader supplies the bytes and owns the background thread.
+namespace OffsetScanner {
+
+    // Identifies a specific build of the game executable (PE header fields)
+    struct BuildFingerprint {
+        uint32_t timeDateStamp = 0;
+        uint32_t sizeOfImage = 0;
+
+        bool operator==(const BuildFingerprint& rhs) const {
+            return timeDateStamp == rhs.timeDateStamp && sizeOfImage == rhs.sizeOfImage;
+        }
+        bool operator!=(const BuildFingerprint& rhs) const {
+            return !(*this == rhs);
+        }
+
+        // "TTTTTTTT-SSSSSSSS" (hex)
+        std::string toString() const;
+        static std::optional<BuildFingerprint> parse(std::string_view text);
+    };
+
+    // Byte pattern with wildcards around a RIP-relative disp32
+    struct Signature {
+        std::vector<uint8_t> bytes;
+        std::vector<uint8_t> mask;  // 0 = wildcard
+        size_t dispPos = 0;         // position of the disp32 within the pattern
+        size_t nextInstrPos = 0;    // position of the next instruction (RIP)
+
+        // "48 8B 05 ?? ?? ?? ?? 85 C0|3|7"
+        std::string toString() const;
+        static std::optional<Signature> parse(std::string_view text);
+    };
+
+    // Copy of an executable section and the address it is mapped at
+    struct CodeSection {
+        uintptr_t address = 0;
+        std::vector<uint8_t> bytes;
+    };
+
+    using OffsetMap = std::unordered_map<std::string, unsigned long>;
+    using SignatureMap = std::unordered_map<std::string, Signature>;
+
+    // Config keys of offsets that are relative to the module base and can be
+    // located by signature (struct-relative offsets are excluded)
+    extern const std::vector<std::string> SCANNABLE_OFFSETS;
+
+    // Returns match positions of `sig` in `data` (stops after `maxMatches`)
+    std::vector<size_t> findPattern(
+        const uint8_t* data,
+        size_t size,
+        const Signature& sig,
+        size_t maxMatches = 2
+    );
+
+    // Derives a unique signature for each offset in `known`, which must be
+    // valid for the build the sections were copied from
+    SignatureMap learnSignatures(
+        const std::vector<CodeSection>& sections,
+        uintptr_t imageBase,
+        const OffsetMap& known,
+        const std::atomic<bool>& cancel
+    );
+
+    // Locates each signature and decodes its displacement into an offset
+    OffsetMap resolveOffsets(
+        const std::vector<CodeSection>& sections,
+        uintptr_t imageBase,
+        const SignatureMap& signatures,
+        const std::atomic<bool>& cancel
+    );
+
+    // Per-build cache stored in the profile directory
+    struct Cache {
+        BuildFingerprint build;
+        bool reference = false;     // offsets were vouched for, not found by scanning
+        OffsetMap offsets;
+        SignatureMap signatures;
+    };
+
+    std::optional<Cache> loadCache(const std::filesystem::path& path);
+    void saveCache(const std::filesystem::path& path, const Cache& cache);
+
+} // namespace OffsetScanner
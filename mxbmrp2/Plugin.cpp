@@ -3,9 +3,11 @@
 
 #include "pch.h"
 
+#include <algorithm>
 #include <filesystem>
 #include <string_view>
 #include <cmath>
+#include <cstdlib>
 #include <cstring>
 #include <mutex>
 
@@ -13,12 +15,18 @@
 #include "Plugin.h"
 #include "PluginHelpers.h"
 #include "Logger.h"
+#include "Tracer.h"
+#include "Metrics.h"
 #include "MemReader.h"
 #include "MemReaderHelpers.h"
 #include "KeyPressHandler.h"
 #include "timeTracker.h"
-#include "HTMLWriter.h"
+#include "htmlWriter.h"
 #include "JSONWriter.h"
+#include "PrometheusWriter.h"
+#include "EventDispatcher.h"
+#include "SteadyState.h"
+#include "Arena.h"
 
 #pragma comment(lib, "ws2_32.lib")
 
@@ -36,7 +44,7 @@ Plugin::Plugin()
 
 // Destructor
 Plugin::~Plugin() {
-	Logger::getInstance().log("Plugin instance destroyed");
+	LOG_INFO(General, "Plugin instance destroyed");
 }
 
 // Initialize the plugin and other classes
@@ -45,7 +53,7 @@ void Plugin::onStartup(const std::string& savePath) {
 	std::filesystem::create_directories(baseDir);
 
 	Logger::getInstance().setLogFileName(baseDir / LOG_FILE);
-	Logger::getInstance().log(
+	LOG_INFO(General,
 		"Initializing " + std::string(PLUGIN_VERSION) +
 		" (" + std::string(BUILD_TYPE) + ") for " + std::string(HOST_VERSION)
 	);
@@ -53,18 +61,48 @@ void Plugin::onStartup(const std::string& savePath) {
 	// Initialize ConfigManager
 	configPath_ = baseDir / CONFIG_FILE;
 	configManager_.loadConfig(configPath_);
+	applyLogConfig();
 
-	// Initialize MemReader
-	memReader_.initialize();
+	// The game asks for the telemetry rate once, through Startup's return value
+	telemetryRate_ = Telemetry::rateCode(configManager_.getValue<unsigned long>("telemetry_rate"));
+	if (telemetryRate_ < 0) {
+		LOG_INFO(General, "Telemetry disabled");
+	}
+	else {
+		LOG_INFO(General, "Telemetry at " + std::to_string(Telemetry::rateHz(telemetryRate_)) + " Hz");
+	}
+
+	// Tracing is decided once per session, the timeline is written on shutdown
+	if (configManager_.getValue<bool>("enable_trace")) {
+		tracePath_ = baseDir / TRACE_FILE;
+		Tracer::getInstance().setEnabled(true);
+		Tracer::getInstance().nameThread("Game");
+		LOG_INFO(General, "Tracing enabled, timeline will be written to " + tracePath_.string());
+	}
 
-	// Initialize displayEnabled_ from hud settings
-	displayEnabled_ = configManager_.getValue<bool>("default_enabled");
+	// Runs are recorded from the telemetry ring on a thread of their own
+	if (telemetryRate_ >= 0 && configManager_.getValue<bool>("enable_telemetry_recording")) {
+		telemetryRecorder_.start(baseDir / TELEMETRY_DIR, Telemetry::rateHz(telemetryRate_));
+	}
 
-	// Now that ConfigManager is loaded, load Draw configuration
-	setDisplayConfig();
+	// live_delta follows the same ring
+	liveDelta_.start(Telemetry::rateHz(telemetryRate_), [this](float delta) { onLiveDelta(delta); });
 
-	// Initialize KeyPressHandler with the toggleDisplay callback
-	keyPressHandler_ = std::make_unique<KeyPressHandler>([this]() { this->toggleDisplay(); }, HOTKEY);
+	// Callbacks are captured from the start of the event thread, which runs after onStartup
+	if (configManager_.getValue<bool>("enable_capture")) {
+		EventDispatcher::getInstance().startCapture(baseDir / CAPTURE_FILE);
+	}
+
+	// Initialize MemReader
+	memReader_.initialize(baseDir / OFFSETS_CACHE_FILE, baseDir / OFFSETS_OVERRIDE_FILE);
+
+	// Initialize displayEnabled_ from hud settings, then load Draw configuration
+	{
+		TimedLock lk(displayMutex_, Histogram::LockDisplayHold);
+		displayEnabled_ = configManager_.getValue<bool>("default_enabled");
+		setDisplayConfig();
+		publishDisplay();
+	}
 
 	// timeTracker
 	TimeTracker::getInstance().initialize(baseDir / DAT_FILE);
@@ -82,7 +120,7 @@ void Plugin::onStartup(const std::string& savePath) {
 	htmlPath_ = baseDir / HTML_FILE;
 
 	if (useHtmlExport_) {
-		Logger::getInstance().log("Exporting HTML to: " + htmlPath_.string());
+		LOG_INFO(IO, "Exporting HTML to: " + htmlPath_.string());
 	}
 
 	// JSON Export
@@ -90,150 +128,416 @@ void Plugin::onStartup(const std::string& savePath) {
 	jsonPath_ = baseDir / JSON_FILE;
 
 	if (useJsonExport_) {
-		Logger::getInstance().log("Exporting JSON to: " + jsonPath_.string());
+		LOG_INFO(IO, "Exporting JSON to: " + jsonPath_.string());
+	}
+
+	// Metrics endpoint
+	applyMetricsConfig();
+
+	// Initialize KeyPressHandler with the toggleDisplay callback, once everything it reloads is set up
+	keyPressHandler_ = std::make_unique<KeyPressHandler>([this]() { this->toggleDisplay(); }, HOTKEY);
+
+	// Start watching memory-derived fields
+	pingWatch_ = memoryWatcher_.addWatch(MemoryOffset::RemoteServerPing,
+		SIZE_REMOTE_SERVER_PING, std::chrono::milliseconds(WATCH_INTERVAL_PING));
+	serverClientsWatch_ = memoryWatcher_.addWatch(MemoryOffset::ServerClients,
+		SIZE_SERVER_CLIENTS, std::chrono::milliseconds(WATCH_INTERVAL_SERVER_CLIENTS),
+		[](const uint8_t* prev, const uint8_t* curr, size_t) {
+			// Only names are decoded, so other slot bytes changing isn't news
+			return ServerRoster::namesDiffer(prev, curr);
+		});
+	localTearoffsWatch_ = memoryWatcher_.addWatch(MemReaderHelpers::getRemainingTearoffsOffset("Host"),
+		SIZE_REMAINING_TEAROFFS, std::chrono::milliseconds(WATCH_INTERVAL_TEAROFFS));
+	remoteTearoffsWatch_ = memoryWatcher_.addWatch(MemReaderHelpers::getRemainingTearoffsOffset("Client"),
+		SIZE_REMAINING_TEAROFFS, std::chrono::milliseconds(WATCH_INTERVAL_TEAROFFS));
+	memoryWatcher_.start([this](const std::vector<MemoryWatcher::Change>& changes) { onMemoryChanges(changes); });
+
+	// Start the server info worker (unused when scans are time-sliced)
+	scanBudgetUs_ = configManager_.getValue<unsigned long>("memory_scan_budget_us");
+	if (scanBudgetUs_ > 0) {
+		LOG_INFO(Memory, "Time-sliced memory scans with a budget of " + std::to_string(scanBudgetUs_) + " us per step");
+	}
+	else {
+		serverInfoWorker_.start();
 	}
 
 	// Start the periodic task thread
 	runPeriodicTask_ = true;
 	periodicTaskThread_ = std::thread(&Plugin::periodicTaskLoop, this);
 
-	Logger::getInstance().log(playerActivity_);
+	LOG_INFO(Callbacks, playerActivity_);
 }
 
 // Shutdown the plugin
 void Plugin::onShutdown() {
-	std::lock_guard<std::mutex> lk(mutex_);
-
-	Logger::getInstance().log("Plugin shutting down");
+	// Stop the other threads first, they take the domain locks
+	serverInfoWorker_.stop();
+	memoryWatcher_.stop();
+	metricsServer_.stop();
+	telemetryRecorder_.stop();
+	liveDelta_.stop();
+
+	LOG_INFO(General, "Plugin shutting down");
 	keyPressHandler_.reset();
 	runPeriodicTask_ = false;
 
 	if (periodicTaskThread_.joinable())
 		periodicTaskThread_.join();
 
+	memReader_.shutdown();
+
 	// Catch ALT-F4 (since onRunStop/onRunDeinit isn't called then)
-	if (!bikeID_.empty() && !trackID_.empty()) {
-		TimeTracker::getInstance().endRun(trackID_, bikeID_);
-		TimeTracker::getInstance().save();
+	{
+		TimedLock lk(sessionMutex_, Histogram::LockSessionHold);
+		bool save = statsDirty_.exchange(false);
+		if (!bikeID_.empty() && !trackID_.empty()) {
+			TimeTracker::getInstance().endRun(trackID_, bikeID_);
+			save = true;
+		}
+		if (save) {
+			TimeTracker::getInstance().save();
+		}
 	}
 
-	// Discord
-	if (useDiscordRichPresence_) {
-		discordManager_.finalize();
+	{
+		TimedLock lk(exportMutex_, Histogram::LockExportHold);
+
+		// Discord
+		if (useDiscordRichPresence_) {
+			discordManager_.finalize();
+		}
+
+		// HTML Export
+		if (useHtmlExport_) {
+			HtmlWriter::atomicWrite(htmlPath_, HtmlWriter::renderNoData());
+		}
 	}
 
-	// HTML Export
-	if (useHtmlExport_) {
-		HtmlWriter::atomicWrite(htmlPath_, HtmlWriter::renderNoData());
+	if (Tracer::getInstance().isEnabled()) {
+		Tracer::getInstance().setEnabled(false);
+		size_t events = Tracer::getInstance().write(tracePath_);
+		LOG_INFO(General, "Wrote " + std::to_string(events) + " trace events to " + tracePath_.string());
 	}
+
+	// Write out queued log messages, anything after this is logged synchronously
+	Logger::getInstance().shutdown();
 }
 
 // Periodic tasks
 void Plugin::periodicTaskLoop() {
-	Logger::getInstance().log("Periodic task thread started with interval: " + std::to_string(PERIODIC_TASK_INTERVAL) + " ms");
+	Tracer::getInstance().nameThread("Periodic tasks");
+	LOG_INFO(General, "Periodic task thread started with interval: " + std::to_string(PERIODIC_TASK_INTERVAL) + " ms");
 
+	auto nextRun = std::chrono::steady_clock::now();
 	while (runPeriodicTask_) {
-		{
-			std::lock_guard<std::mutex> lk(mutex_);
+		ArenaScope arena;
 
-			if (connectionType_ == "Client") {
-				serverPing_ = MemReaderHelpers::getRemoteServerPing();
-			}
-			if (connectionType_ == "Host" || connectionType_ == "Client") {
-				serverClients_ = MemReaderHelpers::getServerClientsCount();
+		// Time-sliced scans are stepped more often than the regular tasks run
+		bool scanning = stepServerNameScan();
 
-				updateDataKeys({
-					{"server_ping", serverPing_},
-					{"server_clients", std::to_string(serverClients_) + "/" + std::to_string(serverClientsMax_)},
-					});
-			}
+		auto now = std::chrono::steady_clock::now();
+		if (now >= nextRun) {
+			runPeriodicTasks();
+			nextRun = now + std::chrono::milliseconds(PERIODIC_TASK_INTERVAL);
+		}
 
-			if (playerActivity_ == "On Track" && !isPaused_) {
-				updateDataKeys({
-					{ "combo_time", TimeTracker::getInstance().getComboTime() },
-					{ "total_time", TimeTracker::getInstance().getTotalTime() },
-					{"remaining_tearoffs", MemReaderHelpers::getRemainingTearoffs(connectionType_)}
-				});
-			}
+		// Laps only mark the stats dirty, the file is written here
+		if (statsDirty_.exchange(false)) {
+			TimeTracker::getInstance().save();
+		}
+
+		auto wakeAt = scanning
+			? std::min<std::chrono::steady_clock::time_point>(nextRun, now + std::chrono::milliseconds(SCAN_STEP_INTERVAL))
+			: nextRun;
+		std::this_thread::sleep_until(wakeAt);
+	}
+
+	LOG_INFO(General, "Periodic task thread stopped");
+}
+
+// Run the once-per-interval tasks
+void Plugin::runPeriodicTasks() {
+	TRACE_SCOPE("periodic", "runPeriodicTasks");
+	METRICS_TIME(Histogram::PeriodicTick);
 
+	bool useJsonExport, useHtmlExport, useDiscordRichPresence;
+	bool online = false;
+	std::string_view playerActivity;
+	std::pmr::unordered_map<std::string_view, std::string_view> dataKeys(Arena::resource());
+	std::pmr::string js(Arena::resource()), html(Arena::resource());
+
+	// Everything up to the rendered exports; writing the files and talking
+	// to Discord allocate (paths, stream buffers, IPC) and come after
+	{
+		STEADY_STATE_SCOPE("tick");
+
+		const char* discordStatus;
+		{
+			TimedLock lk(exportMutex_, Histogram::LockExportHold);
+			discordStatus = discordManager_.getConnectionStateString();
+			useJsonExport = useJsonExport_;
+			useHtmlExport = useHtmlExport_;
+			useDiscordRichPresence = useDiscordRichPresence_;
+		}
+
+		// Percentiles cover the whole session
+		const Metrics& metrics = Metrics::getInstance();
+		FixedString<15> logDropped;
+		logDropped.appendNumber(static_cast<long long>(Logger::getInstance().droppedCount()));
+		updateDataKeys({
+			{"discord_status", discordStatus},
+			{"perf_draw_p99", Metrics::formatMicros(metrics.summarize(Histogram::Draw).p99)},
+			{"perf_tick_p99", Metrics::formatMicros(metrics.summarize(Histogram::PeriodicTick).p99)},
+			{"perf_log_dropped", logDropped}
+		});
+		updateTopSpeed();
+
+		// Ping, clients and tearoffs are published by memoryWatcher_ on change
+		const bool riding = onTrack_ && !isPaused_;
+		if (riding) {
 			updateDataKeys({
-				{"discord_status", discordManager_.getConnectionStateString()}
+				{"combo_time", TimeTracker::getInstance().getComboTime()},
+				{"total_time", TimeTracker::getInstance().getTotalTime()}
 			});
+		}
 
-			// Export JSON
-			if (useJsonExport_) {
-				std::string js = JsonWriter::renderJson(
-					allDataKeys_,
-					configKeyToDisplayNameMap,
-					configManager_);
-
-				if (js != lastJson_) {
-					try {
-						JsonWriter::atomicWrite(jsonPath_, js);
-						lastJson_ = std::move(js);
-					}
-					catch (const std::exception& e) {
-						Logger::getInstance().log(
-							std::string("JSON write failed: ") + e.what());
-					}
-				}
-			}
+		// The exporters are opt-in and render fresh text every tick
+		const bool serveMetrics = metricsServer_.isRunning();
+		if (!useJsonExport && !useHtmlExport && !useDiscordRichPresence && !serveMetrics) return;
 
-			// Export HTML
-			if (useHtmlExport_) {
-				std::string html = HtmlWriter::renderHtml(
-					allDataKeys_,
-					configKeyToDisplayNameMap,
-					configManager_);
-
-				if (html != lastHtml_) {
-					try {
-						HtmlWriter::atomicWrite(htmlPath_, html);
-						lastHtml_ = std::move(html);
-					}
-					catch (const std::exception& e) {
-						Logger::getInstance().log(
-							std::string("HTML write failed: ") + e.what());
-					}
-				}
-			}
+		// Copy what the exporters need from each domain into the Arena, then
+		// render unlocked
+		{
+			TimedLock lk(sessionMutex_, Histogram::LockSessionHold);
+			playerActivity = Arena::copy(playerActivity_);
 		}
 
-		// Discord
-		if (useDiscordRichPresence_) {
-			std::string details = "";
-			std::string state = "";
-			int partySize = 0;
-			int partyMax = 0;
-
-			if (connectionType_ == "Host" || connectionType_ == "Client") {
-				details = allDataKeys_["track_name"] + " (" + allDataKeys_["session_type"] + " : " + allDataKeys_["session_state"] + ")";
-				state = allDataKeys_["server_name"];
-				partySize = serverClients_;
-				partyMax = serverClientsMax_;
+		std::string_view connectionType;
+		ServerRoster::View roster(Arena::resource());
+		{
+			TimedLock lk(serverMutex_, Histogram::LockServerHold);
+			connectionType = Arena::copy(connectionType_);
+			serverRoster_.copyEntries(roster);
+		}
+		online = connectionType == "Host" || connectionType == "Client";
+
+		dataKeys = copyDataKeys();
+
+		// Scrapes are served from the server's own buffers, never from plugin state
+		if (serveMetrics) {
+			const TimeTracker::Totals totals = TimeTracker::getInstance().getTotals();
+			PrometheusWriter::SessionState sessionState;
+			sessionState.onTrack = riding;
+			sessionState.online = online;
+			sessionState.serverPingMs = connectionType == "Client" ? serverPingMs_.load() : -1;
+			sessionState.serverClients = serverClients_;
+			sessionState.serverClientsMax = serverClientsMax_;
+			sessionState.comboTrackSeconds = totals.comboSeconds;
+			sessionState.totalTrackSeconds = totals.totalSeconds;
+			sessionState.sessionBestMs = totals.sessionBestMs;
+			sessionState.alltimeBestMs = totals.alltimeBestMs;
+			sessionState.sessionLaps = totals.sessionLaps;
+			sessionState.comboLaps = totals.comboLaps;
+			sessionState.totalLaps = totals.totalLaps;
+			metricsServer_.publish(PrometheusWriter::render(sessionState));
+		}
+
+		// Render before locking, only the comparison and write need exportMutex_
+		if (useJsonExport) {
+			std::pmr::string metricsJson(Arena::resource());
+			if (configManager_.getValue<bool>("json_metrics")) {
+				metricsJson = Metrics::getInstance().renderJson("    ");
 			}
-			else if (allDataKeys_["event_type"] == "Testing") {
-				details = "Testing: " + allDataKeys_["track_name"];
+			js = JsonWriter::renderJson(dataKeys, configKeyToDisplayNameMap, configManager_, roster, metricsJson);
+		}
+		if (useHtmlExport) {
+			html = HtmlWriter::renderHtml(dataKeys, configKeyToDisplayNameMap, configManager_, roster);
+		}
+	}
+
+	// The flags are checked again in case the config was reloaded meanwhile
+	TimedLock lk(exportMutex_, Histogram::LockExportHold);
+
+	// Export JSON
+	if (useJsonExport && useJsonExport_ && std::string_view(js) != lastJson_) {
+		try {
+			JsonWriter::atomicWrite(jsonPath_, js);
+			lastJson_.assign(js);
+		}
+		catch (const std::exception& e) {
+			LOG_RATE_LIMITED(LogLevel::Error, IO, 0.1, 1,
+				std::string("JSON write failed: ") + e.what());
+		}
+	}
+
+	// Export HTML
+	if (useHtmlExport && useHtmlExport_ && std::string_view(html) != lastHtml_) {
+		try {
+			HtmlWriter::atomicWrite(htmlPath_, html);
+			lastHtml_.assign(html);
+		}
+		catch (const std::exception& e) {
+			LOG_RATE_LIMITED(LogLevel::Error, IO, 0.1, 1,
+				std::string("HTML write failed: ") + e.what());
+		}
+	}
+
+	// Discord
+	if (useDiscordRichPresence && useDiscordRichPresence_) {
+		std::pmr::string details(Arena::resource());
+		std::pmr::string state(Arena::resource());
+		int partySize = 0;
+		int partyMax = 0;
+
+		if (online) {
+			details.append(dataKeys["track_name"]).append(" (").append(dataKeys["session_type"])
+				.append(" : ").append(dataKeys["session_state"]).append(")");
+			state.assign(dataKeys["server_name"]);
+			partySize = serverClients_;
+			partyMax = serverClientsMax_;
+		}
+		else if (dataKeys["event_type"] == "Testing") {
+			details.append("Testing: ").append(dataKeys["track_name"]);
+		}
+		else if (playerActivity == "In Menus") {
+			details = "In Menus";
+		}
+		else {
+			details = "Unkown";
+		}
+
+		discordManager_.tick(details.c_str(), state.c_str(), partySize, partyMax);
+	}
+}
+
+// Fastest speedometer reading since RunInit
+void Plugin::updateTopSpeed() {
+	if (resetTopSpeed_.exchange(false)) {
+		topSpeed_ = 0.0f;
+	}
+
+	const uint64_t skippedBefore = topSpeedReader_.skipped();
+	float topSpeed = topSpeed_;
+	TelemetrySample sample;
+	while (topSpeedReader_.next(sample)) {
+		topSpeed = std::max<float>(topSpeed, sample.bike.m_fSpeedometer);
+	}
+	if (topSpeedReader_.skipped() != skippedBefore) {
+		Metrics::getInstance().add(Counter::TelemetrySkipped, topSpeedReader_.skipped() - skippedBefore);
+	}
+
+	if (topSpeed == topSpeed_) return;
+	topSpeed_ = topSpeed;
+
+	FixedString<15> text;
+	text.appendNumber(std::lround(topSpeed * 3.6f)).append(" km/h");
+	updateDataKeys({ {"top_speed", text} });
+}
+
+// Seconds behind (+) or ahead (-) of the session's best lap
+void Plugin::onLiveDelta(float delta) {
+	FixedString<15> text;
+	if (std::isnan(delta)) {
+		text.append("-.--");
+	}
+	else {
+		const long long hundredths = std::llround(delta * 100.0f);
+		text.append(hundredths < 0 ? '-' : '+')
+			.appendNumber(std::llabs(hundredths) / 100).append('.')
+			.appendNumber(std::llabs(hundredths) % 100, 2);
+	}
+	updateDataKeys({ {"live_delta", text} });
+}
+
+// Enable the memory watches that apply to the current state
+void Plugin::updateMemoryWatches() {
+	// NOTE: call with serverMutex_ held
+	const bool online = (connectionType_ == "Host" || connectionType_ == "Client");
+	const bool riding = (onTrack_ && !isPaused_);
+
+	memoryWatcher_.setEnabled(pingWatch_, connectionType_ == "Client");
+	memoryWatcher_.setEnabled(serverClientsWatch_, online);
+	memoryWatcher_.setEnabled(localTearoffsWatch_, riding && connectionType_ != "Client");
+	memoryWatcher_.setEnabled(remoteTearoffsWatch_, riding && connectionType_ == "Client");
+}
+
+// Publish changed memory values (called on the watcher thread)
+void Plugin::onMemoryChanges(const std::vector<MemoryWatcher::Change>& changes) {
+	FixedString<15> serverPing, serverClients, remainingTearoffs;
+	{
+		TimedLock lk(serverMutex_, Histogram::LockServerHold);
+
+		for (const auto& change : changes) {
+			if (change.id == pingWatch_ && connectionType_ == "Client") {
+				uint16_t ping = 0;
+				std::memcpy(&ping, change.bytes.data(), sizeof(ping));
+				serverPingMs_ = ping;
+				serverPing = {};
+				serverPing.append(MemReaderHelpers::formatRemoteServerPing(ping));
 			}
-			else if (playerActivity_ == "In Menus") {
-				details = "In Menus";
+			else if (change.id == serverClientsWatch_ && (connectionType_ == "Host" || connectionType_ == "Client")) {
+				serverRoster_.update(change.bytes.data(), change.bytes.size());
+				serverClients_ = serverRoster_.count();
+				serverClients = {};
+				serverClients.appendNumber(serverClients_).append('/').appendNumber(serverClientsMax_);
 			}
-			else {
-				details = "Unkown";
+			else if ((change.id == localTearoffsWatch_ || change.id == remoteTearoffsWatch_) && onTrack_) {
+				remainingTearoffs = {};
+				remainingTearoffs.appendNumber(change.bytes[0]);
 			}
+		}
+	}
+
+	if (!serverPing.empty()) updateDataKeys({ {"server_ping", serverPing} });
+	if (!serverClients.empty()) updateDataKeys({ {"server_clients", serverClients} });
+	if (!remainingTearoffs.empty()) updateDataKeys({ {"remaining_tearoffs", remainingTearoffs} });
+}
+
+// Set log levels and rotation from config values
+void Plugin::applyLogConfig() {
+	auto& logger = Logger::getInstance();
+	for (size_t i = 0; i < static_cast<size_t>(LogCategory::Count); ++i) {
+		auto category = static_cast<LogCategory>(i);
+		auto key = Logger::configKey(category);
+		auto value = configManager_.getValue<std::string>(key);
 
-			discordManager_.tick(details, state, partySize, partyMax);
+		if (auto level = Logger::parseLevel(value)) {
+			logger.setLevel(category, *level);
 		}
+		else {
+			LOG_WARNING(General, "Unknown log level '" + value + "' for " + key + ", using info");
+			logger.setLevel(category, LogLevel::Info);
+		}
+	}
 
-		std::this_thread::sleep_for(std::chrono::milliseconds(PERIODIC_TASK_INTERVAL));
+	auto megabytes = [this](const char* key) {
+		return static_cast<uint64_t>(std::max<float>(0.0f, configManager_.getValue<float>(key)) * 1024.0f * 1024.0f);
+	};
+	logger.setRotation(
+		megabytes("log_max_size_mb"),
+		configManager_.getValue<unsigned long>("log_archives"),
+		megabytes("log_max_total_mb"));
+}
+
+// Start, restart or stop the metrics endpoint to match metrics_port
+void Plugin::applyMetricsConfig() {
+	unsigned long port = configManager_.getValue<unsigned long>("metrics_port");
+	if (port > 65535) {
+		LOG_WARNING(IO, "Invalid metrics_port " + std::to_string(port) + ", metrics endpoint disabled");
+		port = 0;
 	}
 
-	Logger::getInstance().log("Periodic task thread stopped");
+	if (metricsServer_.isRunning() && metricsServer_.port() == port) return;
+
+	metricsServer_.stop();
+	if (port > 0) {
+		metricsServer_.start(static_cast<unsigned short>(port));
+	}
 }
 
 // Set Draw-related config values
 void Plugin::setDisplayConfig() {
-	// NOTE: this function is NOT thread-safe on its own!
+	// NOTE: call with displayMutex_ held, then publishDisplay()
 	displayConfig_.fontName = (std::filesystem::path(DATA_DIR) / configManager_.getValue<std::string>("font_name")).string();
 	displayConfig_.fontSize = configManager_.getValue<float>("font_size");
 	displayConfig_.lineHeight = displayConfig_.fontSize * LINE_HEIGHT_MULTIPLIER;
@@ -245,26 +549,93 @@ void Plugin::setDisplayConfig() {
 }
 
 // updateDataKeys
-void Plugin::updateDataKeys(const std::unordered_map<std::string, std::string>& dataKeys) {
-	
-	// Merge in the new values
-	for (const auto& [key, value] : dataKeys)
-		allDataKeys_[key] = value;
+void Plugin::updateDataKeys(std::initializer_list<DataKeyUpdate> updates) {
+	TimedLock lk(displayMutex_, Histogram::LockDisplayHold);
+
+	// Merge in the new values; existing keys are overwritten in place
+	bool changed = false;
+	for (const auto& [key, value] : updates) {
+		dataKeyLookup_.assign(key);
+		auto it = allDataKeys_.find(dataKeyLookup_);
+		if (it == allDataKeys_.end()) {
+			allDataKeys_.emplace(dataKeyLookup_, value);
+			changed = true;
+		}
+		else if (it->second != value) {
+			it->second.assign(value);
+			changed = true;
+		}
+	}
 
-	// Rebuild the display list
-	dataKeysToDisplay_ = PluginHelpers::buildDisplayStrings(
-		allDataKeys_,
-		configKeyToDisplayNameMap,
-		configManager_,
-		MAX_STRING_LENGTH);
+	if (changed) {
+		publishDisplay();
+	}
+}
+
+// Rebuild the display list and swap it in for Draw
+void Plugin::publishDisplay() {
+	// A pooled snapshot only the pool holds is neither published nor being
+	// drawn. The fence pairs with Draw's release of its reference. Taking
+	// them in turn grows all of them early on, not the first time Draw is slow.
+	std::shared_ptr<DisplaySnapshot> snapshot;
+	for (size_t i = 0; i < snapshotPool_.size() && !snapshot; ++i) {
+		auto& pooled = snapshotPool_[nextSnapshot_];
+		nextSnapshot_ = (nextSnapshot_ + 1) % snapshotPool_.size();
+		if (!pooled) {
+			pooled = std::make_shared<DisplaySnapshot>();
+			pooled->lines.reserve(configKeyToDisplayNameMap.size());
+		}
+		if (pooled.use_count() == 1) {
+			std::atomic_thread_fence(std::memory_order_acquire);
+			snapshot = pooled;
+		}
+	}
+	if (!snapshot) {
+		snapshot = std::make_shared<DisplaySnapshot>();
+	}
+
+	snapshot->config = displayConfig_;
+	if (displayEnabled_) {
+		PluginHelpers::buildDisplayStrings(
+			allDataKeys_,
+			configKeyToDisplayNameMap,
+			configManager_,
+			snapshot->lines);
+	}
+	else {
+		snapshot->lines.clear();
+	}
+
+	std::lock_guard<std::mutex> lk(snapshotMutex_);
+	displaySnapshot_ = std::move(snapshot);
+}
+
+// Copy all data keys
+std::pmr::unordered_map<std::string_view, std::string_view> Plugin::copyDataKeys() {
+	std::pmr::unordered_map<std::string_view, std::string_view> copy(Arena::resource());
+	TimedLock lk(displayMutex_, Histogram::LockDisplayHold);
+	copy.reserve(allDataKeys_.size());
+	for (const auto& [key, value] : allDataKeys_) {
+		copy.emplace(Arena::copy(key), Arena::copy(value));
+	}
+	return copy;
+}
+
+// Set the player activity and the flag the other domains read
+void Plugin::setPlayerActivity(std::string_view activity) {
+	// NOTE: call with sessionMutex_ held
+	playerActivity_.assign(activity);
+	onTrack_ = (activity == "On Track");
+	LOG_INFO(Callbacks, playerActivity_);
 }
 
 // Public getter for keys to display
-std::vector<std::string> Plugin::getDisplayKeys() {
-	std::lock_guard<std::mutex> lk(mutex_);
-	return displayEnabled_
-		? dataKeysToDisplay_
-		: std::vector<std::string>{};
+std::shared_ptr<const Plugin::DisplaySnapshot> Plugin::getDisplaySnapshot() {
+	auto waitStart = std::chrono::steady_clock::now();
+	std::lock_guard<std::mutex> lk(snapshotMutex_);
+	Metrics::getInstance().record(Histogram::DisplayKeysWait, static_cast<uint64_t>(
+		std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - waitStart).count()));
+	return displaySnapshot_;
 }
 
 // Maps config keys to display names and sets display order
@@ -299,29 +670,45 @@ const std::vector<std::pair<std::string, std::string>> Plugin::configKeyToDispla
 	{"alltime_pb", "All-time PB" },
     {"combo_laps", "Combo Laps" },
     {"total_laps", "Total Laps" },
-	{"discord_status", "Discord RP Status"}
+	{"discord_status", "Discord RP Status"},
+	{"perf_draw_p99", "Draw p99"},
+	{"perf_tick_p99", "Tick p99"},
+	{"perf_log_dropped", "Log Dropped"},
+	{"top_speed", "Top Speed"},
+	{"live_delta", "Live Delta"}
 };
 
 // stateChange
 void Plugin::onStateChange(int gameState) {
-	std::lock_guard<std::mutex> lk(mutex_);
-	Logger::getInstance().log(std::string(__func__) + " handler triggered");
+	TimedLock session(sessionMutex_, Histogram::LockSessionHold);
+	LOG_DEBUG(Callbacks, std::string(__func__) + " handler triggered");
 
-	playerActivity_ = PluginHelpers::getGameState(gameState);
-	Logger::getInstance().log(playerActivity_);
+	setPlayerActivity(PluginHelpers::getGameState(gameState));
+
+	TimedLock server(serverMutex_, Histogram::LockServerHold);
+	updateMemoryWatches();
 }
 
 // EventInit
 void Plugin::onEventInit(const SPluginsBikeEvent_t& eventData) {
-	std::lock_guard<std::mutex> lk(mutex_);
-	Logger::getInstance().log(std::string(__func__) + " handler triggered");
+	TimedLock session(sessionMutex_, Histogram::LockSessionHold);
+	LOG_DEBUG(Callbacks, std::string(__func__) + " handler triggered");
 
 	trackID_ = eventData.m_szTrackID;	
 	bikeID_ = eventData.m_szBikeID;
 	bikeCategory_ = eventData.m_szCategory;
+	riderName_ = eventData.m_szRiderName;
+	bikeName_ = eventData.m_szBikeName;
+	trackLength_ = eventData.m_fTrackLength;
 
 	// Should not have changed since last onracesession ... 
-	//Logger::getInstance().log(playerActivity_);
+	//LOG_INFO(Callbacks, playerActivity_);
+
+	std::string connectionType;
+	{
+		TimedLock server(serverMutex_, Histogram::LockServerHold);
+		connectionType = connectionType_;
+	}
 
 	updateDataKeys({
 		{"rider_name", eventData.m_szRiderName},
@@ -329,26 +716,28 @@ void Plugin::onEventInit(const SPluginsBikeEvent_t& eventData) {
 		{"bike_id", eventData.m_szBikeID},
 		{"bike_name", eventData.m_szBikeName},
 		{"track_id", eventData.m_szTrackID},
-		{"event_type", PluginHelpers::getEventType(eventData.m_iType, connectionType_)}
+		{"event_type", PluginHelpers::getEventType(eventData.m_iType, connectionType)}
 	});
 }
 
 // RunInit - To Track
 void Plugin::onRunInit(const SPluginsBikeSession_t& sessionData) {
-	std::lock_guard<std::mutex> lk(mutex_);
-	Logger::getInstance().log(std::string(__func__) + " handler triggered");
+	TimedLock session(sessionMutex_, Histogram::LockSessionHold);
+	LOG_DEBUG(Callbacks, std::string(__func__) + " handler triggered");
 
 	isPaused_ = false;
-	playerActivity_ = "On Track";
-	Logger::getInstance().log(playerActivity_);
+	setPlayerActivity("On Track");
 
 	const std::string setupName = std::strlen(sessionData.m_szSetupFileName) > 0 ? std::string(sessionData.m_szSetupFileName).substr(1) : "Default";
 	TimeTracker::getInstance().startRun(trackID_, bikeID_, bikeCategory_, setupName);
+	telemetryRecorder_.beginRun(trackID_, bikeID_, trackLength_);
+	liveDelta_.beginRun(trackLength_);
 
 	// For highlighting the default setup
 	uint64_t nowMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
 	lastRunInitMs_.store(nowMs, std::memory_order_relaxed);
 
+	TimedLock server(serverMutex_, Histogram::LockServerHold);
 	updateDataKeys({
 		{"setup_name", setupName},
 		// Add these here to keep the HUD from growing when called periodically
@@ -357,35 +746,42 @@ void Plugin::onRunInit(const SPluginsBikeSession_t& sessionData) {
 		{"total_time", TimeTracker::getInstance().getTotalTime()},
 		{"session_pb", TimeTracker::getInstance().getSessionPB()},
 		{"alltime_pb", TimeTracker::getInstance().getAlltimePB()},
-        {"combo_laps", TimeTracker::getInstance().getComboLapCount()},
-        {"total_laps", TimeTracker::getInstance().getTotalLapCount()},
-        {"cut_penalty", "0s"}
+		{"combo_laps", TimeTracker::getInstance().getComboLapCount()},
+		{"total_laps", TimeTracker::getInstance().getTotalLapCount()},
+		{"cut_penalty", "0s"},
+		{"top_speed", "0 km/h"},
+		{"live_delta", "-.--"}
 	});
+	resetTopSpeed_ = true;
+
+	updateMemoryWatches();
 }
 
 // RunDeInit - Return to Pit
 void Plugin::onRunDeinit() {
-	std::lock_guard<std::mutex> lk(mutex_);
-	Logger::getInstance().log(std::string(__func__) + " handler triggered");
+	TimedLock session(sessionMutex_, Histogram::LockSessionHold);
+	LOG_DEBUG(Callbacks, std::string(__func__) + " handler triggered");
 
-	playerActivity_ = "In Pits";
-	Logger::getInstance().log(playerActivity_);
+	setPlayerActivity("In Pits");
 
 	TimeTracker::getInstance().endRun(trackID_, bikeID_);
+	telemetryRecorder_.endRun();
+	liveDelta_.endRun();
 
 	lastRunInitMs_.store(0, std::memory_order_relaxed);   // cancel highlight
+
+	TimedLock server(serverMutex_, Histogram::LockServerHold);
+	updateMemoryWatches();
 }
 
 // RaceSession
 void Plugin::onRaceSession(const SPluginsRaceSession_t& raceSession) {
-	std::lock_guard<std::mutex> lk(mutex_);
-	Logger::getInstance().log(std::string(__func__) + " handler triggered");
+	TimedLock session(sessionMutex_, Histogram::LockSessionHold);
+	LOG_DEBUG(Callbacks, std::string(__func__) + " handler triggered");
 
-	playerActivity_ = "In Pits";
 	numLaps_ = raceSession.m_iSessionNumLaps;
 	sessionLength_ = raceSession.m_iSessionLength;
-
-	Logger::getInstance().log(playerActivity_);
+	setPlayerActivity("In Pits");
 
 	updateDataKeys({
 		{"session_type", PluginHelpers::getSessionType(eventType_, raceSession.m_iSession)},
@@ -393,72 +789,225 @@ void Plugin::onRaceSession(const SPluginsRaceSession_t& raceSession) {
 		{"conditions", PluginHelpers::getConditions(raceSession.m_iConditions)},
 		{"air_temperature", std::to_string(std::lround(raceSession.m_fAirTemperature)) + " C"}
 	});
+
+	TimedLock server(serverMutex_, Histogram::LockServerHold);
+	updateMemoryWatches();
 }
 
 // RaceSessionState
 void Plugin::onRaceSessionState(const SPluginsRaceSessionState_t& raceSessionState) {
-	std::lock_guard<std::mutex> lk(mutex_);
-	Logger::getInstance().log(std::string(__func__) + " handler triggered");
+	LOG_DEBUG(Callbacks, std::string(__func__) + " handler triggered");
 
 	updateDataKeys({ {"session_state", PluginHelpers::getSessionState(raceSessionState.m_iSessionState)} });
 }
 
-// onRaceEvent
-void Plugin::onRaceEvent(const SPluginsRaceEvent_t& raceEvent) {
-	std::lock_guard<std::mutex> lk(mutex_);
-	Logger::getInstance().log(std::string(__func__) + " handler triggered");
+// Log the connect URI for a server joined through the browser
+static void logConnectURI(const Plugin::ServerInfo& info) {
+	std::pmr::string connectURIString = PluginHelpers::buildConnectURIString(
+		info.remoteServerIPv6Address,
+		info.serverName,
+		info.serverPassword,
+		MemReaderHelpers::getServerTrackID(),
+		MemReaderHelpers::getServerCategories()
+	);
+
+	LOG_INFO(Callbacks, std::string("connectURIString: ").append(connectURIString));
+}
 
-	eventType_ = raceEvent.m_iType;
+// Identify the connection type and gather server data, except for what needs
+// a server browser memory search (see completeServerInfo)
+static Plugin::ServerInfo readServerInfo(
+	ServerBrowserIndex& browserIndex,
+	MemReaderHelpers::ByteBuf& remoteServerSocketAddress,
+	bool& needsLookup)
+{
+	Plugin::ServerInfo info;
+	needsLookup = false;
 
-	// Identify the connection type and gather data
 	std::string localServerName = MemReaderHelpers::getLocalServerName();
 
 	if (!localServerName.empty()) { // Definitely a host
-		connectionType_ = "Host";
-		serverName_ = localServerName;
-		serverPassword_ = MemReaderHelpers::getLocalServerPassword();
-		serverLocation_ = MemReaderHelpers::getLocalServerLocation();
-		serverClientsMax_ = MemReaderHelpers::getLocalServerClientsMax();
+		info.connectionType = "Host";
+		info.serverName = localServerName;
+		info.serverPassword = MemReaderHelpers::getLocalServerPassword();
+		info.serverLocation = MemReaderHelpers::getLocalServerLocation();
+		info.serverClientsMax = MemReaderHelpers::getLocalServerClientsMax();
 	}
 	else { // Possibly a client
-		auto remoteServerSocketAddress_ = MemReaderHelpers::getRemoteServerSocketAddress();
-		remoteServerIPv6Address_ = PluginHelpers::formatIPv6MappedIPv4(remoteServerSocketAddress_);
+		remoteServerSocketAddress = MemReaderHelpers::getRemoteServerSocketAddress();
+		info.remoteServerIPv6Address = PluginHelpers::formatIPv6MappedIPv4(remoteServerSocketAddress);
 
-		if (!remoteServerSocketAddress_.empty()) { // Definitely a client
-			connectionType_ = "Client";
-			serverPassword_ = MemReaderHelpers::getRemoteServerPassword();
+		if (!remoteServerSocketAddress.empty()) { // Definitely a client
+			info.connectionType = "Client";
+			info.serverPassword = MemReaderHelpers::getRemoteServerPassword();
 
 			std::string connectURIServerName = PluginHelpers::getServerNameFromConnectURI(MemReaderHelpers::getConnectURIString());
 
 			if (!connectURIServerName.empty()) { // Client is using connect URI
-				serverName_ = connectURIServerName;
+				info.serverName = connectURIServerName;
 
 				// Can't get data from server list when using connect URI :(
-				serverLocation_ = "Unknown";
-				serverClientsMax_ = 0;
+				info.serverLocation = "Unknown";
+				info.serverClientsMax = 0;
+			}
+			else if (auto entry = browserIndex.find(remoteServerSocketAddress)) { // Indexed by an earlier search
+				info.remoteServerIPv6AddressMemoryAddress = entry->address;
+				info.serverName = entry->name;
+				info.serverLocation = entry->location;
+				info.serverClientsMax = entry->clientsMax;
+				logConnectURI(info);
 			}
 			else { // Client connected via server browser
-				std::tie(remoteServerIPv6AddressMemoryAddress_, serverName_) =
-					MemReaderHelpers::getRemoteServerNameAndAddress(remoteServerSocketAddress_);
-				if (serverName_.empty()) serverName_ = "Unknown";
-
-				serverLocation_ = MemReaderHelpers::getRemoteServerLocation(remoteServerIPv6AddressMemoryAddress_);
-				serverClientsMax_ = MemReaderHelpers::getRemoteServerClientsMax(remoteServerIPv6AddressMemoryAddress_);
-
-				std::string connectURIString = PluginHelpers::buildConnectURIString(
-					remoteServerIPv6Address_,
-					serverName_,
-					serverPassword_,
-					MemReaderHelpers::getServerTrackID(),
-					MemReaderHelpers::getServerCategories()
-				);
-
-				Logger::getInstance().log("connectURIString: " + connectURIString);
+				needsLookup = true;
 			}
 		}
+		else if (!MemReader::getInstance().isMemoryAvailable()) { // Unsupported game build
+			info.connectionType = "Unknown";
+		}
 		else { // Offline
-			connectionType_ = "Offline";
+			info.connectionType = "Offline";
+		}
+	}
+
+	return info;
+}
+
+// Fill in the server browser data once the remote server name search is done
+static void completeServerInfo(
+	ServerBrowserIndex& browserIndex,
+	Plugin::ServerInfo& info,
+	uintptr_t remoteServerIPv6AddressMemoryAddress,
+	std::string serverName)
+{
+	info.remoteServerIPv6AddressMemoryAddress = remoteServerIPv6AddressMemoryAddress;
+	info.serverName = serverName.empty() ? "Unknown" : std::move(serverName);
+
+	info.serverLocation = MemReaderHelpers::getRemoteServerLocation(info.remoteServerIPv6AddressMemoryAddress);
+	info.serverClientsMax = MemReaderHelpers::getRemoteServerClientsMax(info.remoteServerIPv6AddressMemoryAddress);
+
+	// Index the rest of the browser so later joins and reconnects skip the search
+	if (remoteServerIPv6AddressMemoryAddress != 0) {
+		browserIndex.build(remoteServerIPv6AddressMemoryAddress);
+	}
+
+	logConnectURI(info);
+}
+
+// onRaceEvent
+void Plugin::onRaceEvent(const SPluginsRaceEvent_t& raceEvent) {
+	{
+		TimedLock session(sessionMutex_, Histogram::LockSessionHold);
+		eventType_ = raceEvent.m_iType;
+	}
+	LOG_DEBUG(Callbacks, std::string(__func__) + " handler triggered");
+
+	// Cancelling and the worker's final check both happen under serverMutex_
+	TimedLock server(serverMutex_, Histogram::LockServerHold);
+
+	// The remote server name is found by scanning memory, so resolve off the callback thread
+	connectionType_.clear();
+	updateMemoryWatches();
+
+	std::string trackDeformation = MemReaderHelpers::getTrackDeformation();
+	if (!trackDeformation.empty()) trackDeformation += 'x';
+
+	FixedString<23> trackLength;
+	trackLength.appendNumber(std::lround(raceEvent.m_fTrackLength)).append(" m");
+
+	updateDataKeys({
+		{"server_name", RESOLVING_PLACEHOLDER},
+		{"server_password", RESOLVING_PLACEHOLDER},
+		{"server_location", RESOLVING_PLACEHOLDER},
+		{"connection_type", RESOLVING_PLACEHOLDER},
+		{"track_name", raceEvent.m_szTrackName},
+		{"track_length", trackLength},
+		{"track_deformation", trackDeformation}
+	});
+
+	const int eventType = raceEvent.m_iType;
+	serverNameScan_.reset();
+
+	if (scanBudgetUs_ > 0) {
+		// Time-sliced: only the scan is deferred, stepped from periodicTaskLoop
+		serverInfoWorker_.cancel();
+
+		MemReaderHelpers::ByteBuf remoteServerSocketAddress;
+		bool needsLookup = false;
+		ServerInfo info = readServerInfo(serverBrowserIndex_, remoteServerSocketAddress, needsLookup);
+
+		if (needsLookup) {
+			serverNameScan_ = MemReaderHelpers::beginRemoteServerNameSearch(remoteServerSocketAddress);
+			if (serverNameScan_) {
+				pendingServerInfo_ = std::move(info);
+				pendingEventType_ = eventType;
+				return;
+			}
+			completeServerInfo(serverBrowserIndex_, info, 0, {});
+		}
+		applyServerInfo(info, eventType);
+		return;
+	}
+
+	serverInfoWorker_.submit([this, eventType](const std::atomic<bool>& cancelled) {
+		auto t_start = std::chrono::steady_clock::now();
+
+		MemReaderHelpers::ByteBuf remoteServerSocketAddress;
+		bool needsLookup = false;
+		ServerInfo info = readServerInfo(serverBrowserIndex_, remoteServerSocketAddress, needsLookup);
+
+		if (needsLookup) {
+			auto [address, serverName] = MemReaderHelpers::getRemoteServerNameAndAddress(remoteServerSocketAddress, &cancelled);
+			if (cancelled) return;
+			completeServerInfo(serverBrowserIndex_, info, address, std::move(serverName));
 		}
+
+		// Checked under the lock: a newer RaceEvent or EventDeinit cancels while holding it
+		TimedLock lk(serverMutex_, Histogram::LockServerHold);
+		if (cancelled) {
+			LOG_INFO(Memory, "Server info resolution superseded");
+			return;
+		}
+
+		auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+			std::chrono::steady_clock::now() - t_start).count();
+		LOG_INFO(Memory, "Server info resolved in " + std::to_string(elapsedMs) + " ms: " + info.connectionType);
+
+		applyServerInfo(info, eventType);
+	});
+}
+
+// Advance the time-sliced server name search, if any
+bool Plugin::stepServerNameScan() {
+	TRACE_SCOPE("periodic", "stepServerNameScan");
+	// Held for at most scanBudgetUs_ per step; Draw doesn't wait on it
+	TimedLock lk(serverMutex_, Histogram::LockServerHold);
+	if (!serverNameScan_) return false;
+
+	if (serverNameScan_->step(std::chrono::microseconds(scanBudgetUs_)) == MemoryScan::Status::Running) {
+		return true;
+	}
+
+	auto [address, serverName] = serverNameScan_->result();
+	serverNameScan_.reset();
+
+	completeServerInfo(serverBrowserIndex_, pendingServerInfo_, address, std::move(serverName));
+	applyServerInfo(pendingServerInfo_, pendingEventType_);
+	return false;
+}
+
+// Publish resolved server info
+void Plugin::applyServerInfo(const ServerInfo& info, int eventType) {
+	// NOTE: call with serverMutex_ held
+	connectionType_ = info.connectionType;
+	remoteServerIPv6Address_ = info.remoteServerIPv6Address;
+	remoteServerIPv6AddressMemoryAddress_ = info.remoteServerIPv6AddressMemoryAddress;
+
+	// Offline/unknown keeps whatever server fields were there before, as it always has
+	if (info.connectionType == "Host" || info.connectionType == "Client") {
+		serverName_ = info.serverName;
+		serverPassword_ = info.serverPassword;
+		serverLocation_ = info.serverLocation;
+		serverClientsMax_ = info.serverClientsMax;
 	}
 
 	updateDataKeys({
@@ -466,21 +1015,20 @@ void Plugin::onRaceEvent(const SPluginsRaceEvent_t& raceEvent) {
 		{"server_password", serverPassword_},
 		{"server_location", serverLocation_},
 		{"connection_type", connectionType_},
-		{"event_type", PluginHelpers::getEventType(raceEvent.m_iType, connectionType_)},
-		{"track_name", raceEvent.m_szTrackName},
-		{"track_length", std::to_string(std::lround(raceEvent.m_fTrackLength)) + " m"},
-		{"track_deformation", MemReaderHelpers::getTrackDeformation() + "x"}
+		{"event_type", PluginHelpers::getEventType(eventType, connectionType_)}
 	});
+
+	updateMemoryWatches();
 }
 
 // RaceAddEntry
 void Plugin::onRaceAddEntry(const SPluginsRaceAddEntry_t& raceAddEntry) {
-	std::lock_guard<std::mutex> lk(mutex_);
-	//Logger::getInstance().log(std::string(__func__) + " handler triggered");
+	TimedLock session(sessionMutex_, Histogram::LockSessionHold);
+	//LOG_DEBUG(Callbacks, std::string(__func__) + " handler triggered");
 
 	// Check whether the entry is in fact the local player
-	if (std::string_view{ raceAddEntry.m_szName } == allDataKeys_["rider_name"] &&
-		std::string_view{ raceAddEntry.m_szBikeName } == allDataKeys_["bike_name"])
+	if (std::string_view{ raceAddEntry.m_szName } == riderName_ &&
+		std::string_view{ raceAddEntry.m_szBikeName } == bikeName_)
 	{
 		raceNum_ = raceAddEntry.m_iRaceNum;
 		updateDataKeys({ {"race_number", std::to_string(raceNum_)} });
@@ -489,68 +1037,100 @@ void Plugin::onRaceAddEntry(const SPluginsRaceAddEntry_t& raceAddEntry) {
 
 // RaceRemoveEntry
 void Plugin::onRaceRemoveEntry(const SPluginsRaceRemoveEntry_t& raceRemoveEntry) {
-	//Logger::getInstance().log(std::string(__func__) + " handler triggered");
+	//LOG_DEBUG(Callbacks, std::string(__func__) + " handler triggered");
 }
 
 // RaceClassification
 void Plugin::onRaceClassification(const SPluginsRaceClassification_t& raceClassification) {
-	std::lock_guard<std::mutex> lk(mutex_);
+	STEADY_STATE_SCOPE("classification");
+	TimedLock session(sessionMutex_, Histogram::LockSessionHold);
 
 	sessionTime_ = raceClassification.m_iSessionTime;
 
-    updateDataKeys({ {"session_duration", PluginHelpers::getSessionDuration(numLaps_, sessionLength_, sessionTime_)}});
+	updateDataKeys({ {"session_duration", PluginHelpers::getSessionDuration(numLaps_, sessionLength_, sessionTime_)}});
 }
 
 // EventDeinit
 void Plugin::onEventDeinit() {
-	std::lock_guard<std::mutex> lk(mutex_);
-	Logger::getInstance().log(std::string(__func__) + " handler triggered");
+	TimedLock session(sessionMutex_, Histogram::LockSessionHold);
+	TimedLock server(serverMutex_, Histogram::LockServerHold);
+	LOG_DEBUG(Callbacks, std::string(__func__) + " handler triggered");
+
+	serverInfoWorker_.cancel();
+	serverNameScan_.reset();
 
 	TimeTracker::getInstance().resetSessionPB();
+	liveDelta_.clearBest();
 	TimeTracker::getInstance().save();
 
-	playerActivity_ = DEFAULT_PLAYER_ACTIVITY;
 	raceNum_ = 0;
 	eventType_ = 0;
+	riderName_.clear();
+	bikeName_.clear();
 	trackID_.clear();
 	bikeID_.clear();
 	bikeCategory_.clear();
+	numLaps_ = 0;
+	sessionLength_ = 0;
+	currentLap_ = 0;
+	sessionTime_ = 0;
+	penaltyAccumulated_ = 0;
+
 	remoteServerIPv6Address_.clear();
 	remoteServerIPv6AddressMemoryAddress_ = 0;
 	serverName_.clear();
 	serverPassword_.clear();
 	connectionType_.clear();
 	serverLocation_.clear();
-	serverPing_.clear();
+	serverPingMs_ = -1;
 	serverClients_ = 0;
 	serverClientsMax_ = 0;
-	numLaps_ = 0;
-	sessionLength_ = 0;
-	currentLap_ = 0;
-	sessionTime_ = 0;
-	penaltyAccumulated_ = 0;
-
-	allDataKeys_.clear();
-	dataKeysToDisplay_.clear();
+	serverRoster_.clear();
 
-	updateDataKeys({ { "plugin_banner", PLUGIN_VERSION } });
+	{
+		TimedLock display(displayMutex_, Histogram::LockDisplayHold);
+		// Emptied in place (an empty value isn't shown or exported), so
+		// setting them again next session doesn't allocate
+		for (auto& [key, value] : allDataKeys_) {
+			value.clear();
+		}
+		allDataKeys_["plugin_banner"] = PLUGIN_VERSION;
+		publishDisplay();
+	}
+	updateMemoryWatches();
 
-	Logger::getInstance().log(playerActivity_);
+	setPlayerActivity(DEFAULT_PLAYER_ACTIVITY);
 }
 
 // RunLap
 void Plugin::onRunLap(const SPluginsBikeLap_t& lapData) {
-	std::lock_guard<std::mutex> lk(mutex_);
-	Logger::getInstance().log(
+	STEADY_STATE_SCOPE("lap");
+	LOG_DEBUG(Callbacks,
 		"RunLap handler: lap=" + std::to_string(lapData.m_iLapNum)
 		+ " time=" + std::to_string(lapData.m_iLapTime) + "ms");
 
-	if (!lapData.m_iInvalid && lapData.m_iLapTime > 0) {
-		// Pass cumulative splits captured so far; the game does NOT send a split at S/F,
-		// so we derive the last segment inside TimeTracker from lap time.
-		TimeTracker::getInstance().recordLap(trackID_, bikeID_, lapData.m_iLapTime, currentLapSplitsMs_);
-		TimeTracker::getInstance().save();
+	bool recorded = false;
+	{
+		TimedLock session(sessionMutex_, Histogram::LockSessionHold);
+
+		// Both vectors keep their capacity from lap to lap
+		lapSplitsMs_.assign(currentLapSplitsMs_.begin(), currentLapSplitsMs_.end());
+		currentLapSplitsMs_.clear();
 
+		if (!lapData.m_iInvalid && lapData.m_iLapTime > 0) {
+			// Pass cumulative splits captured so far; the game does NOT send a split at S/F,
+			// so we derive the last segment inside TimeTracker from lap time.
+			if (TimeTracker::getInstance().recordLap(trackID_, bikeID_, lapData.m_iLapTime, lapSplitsMs_)) {
+				liveDelta_.newBest();
+			}
+			recorded = true;
+		}
+	}
+
+	// The stats file is written by periodicTaskLoop, off the callback thread
+	statsDirty_ = true;
+
+	if (recorded) {
 		updateDataKeys({
 			{"session_pb", TimeTracker::getInstance().getSessionPB()},
 			{"alltime_pb", TimeTracker::getInstance().getAlltimePB()},
@@ -558,15 +1138,13 @@ void Plugin::onRunLap(const SPluginsBikeLap_t& lapData) {
 			{"total_laps", TimeTracker::getInstance().getTotalLapCount()}
 		});
 	}
-
-	TimeTracker::getInstance().save();
-	currentLapSplitsMs_.clear();
 }
 
 // RunSplit
 void Plugin::onRunSplit(const SPluginsBikeSplit_t& splitData) {
-	std::lock_guard<std::mutex> lk(mutex_);
-	Logger::getInstance().log(std::string(__func__) + " handler triggered");
+	STEADY_STATE_SCOPE("split");
+	TimedLock session(sessionMutex_, Histogram::LockSessionHold);
+	LOG_DEBUG(Callbacks, std::string(__func__) + " handler triggered");
 
 	size_t idx = static_cast<size_t>(splitData.m_iSplit);
 	if (idx > 10) return; // sanity guard
@@ -575,68 +1153,89 @@ void Plugin::onRunSplit(const SPluginsBikeSplit_t& splitData) {
 }
 
 void Plugin::onRaceCommunication(const SPluginsRaceCommunication_t& raceComm) {
-	std::lock_guard<std::mutex> lk(mutex_);
-	Logger::getInstance().log(std::string(__func__) + " handler triggered");
+	LOG_DEBUG(Callbacks, std::string(__func__) + " handler triggered");
+
+	int raceNum;
+	{
+		TimedLock session(sessionMutex_, Histogram::LockSessionHold);
+		raceNum = raceNum_;
+	}
 
-	if (raceComm.m_iRaceNum == raceNum_) {
-		Logger::getInstance().log("cutting!");
-		penaltyAccumulated_ += raceComm.m_iTime;
-		updateDataKeys({ {"cut_penalty", std::to_string(penaltyAccumulated_) + "s"} });
+	if (raceComm.m_iRaceNum == raceNum) {
+		LOG_INFO(Callbacks, "cutting!");
+		int penalty = penaltyAccumulated_ += raceComm.m_iTime;
+		FixedString<15> cutPenalty;
+		cutPenalty.appendNumber(penalty).append('s');
+		updateDataKeys({ {"cut_penalty", cutPenalty} });
 	}
 }
 
+// RunTelemetry - Called by the game thread itself, so only copies the sample
+void Plugin::onRunTelemetry(const TelemetrySample& sample) {
+	telemetry_.push(sample);
+	Metrics::getInstance().add(Counter::TelemetrySamples);
+}
+
 // RunStart - Start/Resume
 void Plugin::onRunStart() {
-	std::lock_guard<std::mutex> lk(mutex_);
-	Logger::getInstance().log(std::string(__func__) + " handler triggered");
+	LOG_DEBUG(Callbacks, std::string(__func__) + " handler triggered");
 	isPaused_ = false;
+
+	TimedLock server(serverMutex_, Histogram::LockServerHold);
+	updateMemoryWatches();
 }
 
 // RunStop - Pause
 void Plugin::onRunStop() {
-	std::lock_guard<std::mutex> lk(mutex_);
-	Logger::getInstance().log(std::string(__func__) + " handler triggered");
+	LOG_DEBUG(Callbacks, std::string(__func__) + " handler triggered");
 	isPaused_ = true;
+
+	TimedLock server(serverMutex_, Histogram::LockServerHold);
+	updateMemoryWatches();
 }
 
 // Define the KeyPressHandler callback function
 void Plugin::toggleDisplay() {
-	std::lock_guard<std::mutex> lk(mutex_);
-
-	// Toggle the HUD on/off
-	displayEnabled_ = !displayEnabled_;
-	Logger::getInstance().log(
-		displayEnabled_ ? "Display enabled." : "Display disabled."
-	);
-
 	// Reload everything from disk
 	configManager_.loadConfig(configPath_);
-	setDisplayConfig();
+	memReader_.refreshOffsets();
+	applyLogConfig();
 
-	// Rebuild display strings if the HUD is on
-	if (displayEnabled_) {
-		updateDataKeys(allDataKeys_);
+	{
+		TimedLock lk(displayMutex_, Histogram::LockDisplayHold);
+
+		// Toggle the HUD on/off
+		displayEnabled_ = !displayEnabled_;
+		LOG_INFO(General,
+			displayEnabled_ ? "Display enabled." : "Display disabled."
+		);
+
+		// Rebuild display strings with the new settings
+		setDisplayConfig();
+		publishDisplay();
 	}
 
+	TimedLock lk(exportMutex_, Histogram::LockExportHold);
+
 	// Check for config changes
 	bool newUseDiscordRichPresence = configManager_.getValue<bool>("enable_discord_rich_presence");
 	if (newUseDiscordRichPresence && !useDiscordRichPresence_) {
 		discordManager_.initialize(DISCORD_APP_ID);
-		Logger::getInstance().log("Discord Rich Presence enabled.");
+		LOG_INFO(General, "Discord Rich Presence enabled.");
 	}
 	else if (!newUseDiscordRichPresence && useDiscordRichPresence_) {
 		discordManager_.finalize();
-		Logger::getInstance().log("Discord Rich Presence disabled.");
+		LOG_INFO(General, "Discord Rich Presence disabled.");
 	}
 	useDiscordRichPresence_ = newUseDiscordRichPresence;
 
 	bool newUseHtmlExport = configManager_.getValue<bool>("enable_html_export");
 	if (newUseHtmlExport && !useHtmlExport_) {
 		lastHtml_.clear();
-		Logger::getInstance().log("HTML export enabled.");
+		LOG_INFO(General, "HTML export enabled.");
 	}
 	else if (!newUseHtmlExport && useHtmlExport_) {
-		Logger::getInstance().log("HTML export disabled.");
+		LOG_INFO(General, "HTML export disabled.");
 		HtmlWriter::atomicWrite(htmlPath_, HtmlWriter::renderNoData());
 	}
 	useHtmlExport_ = newUseHtmlExport;
@@ -644,12 +1243,14 @@ void Plugin::toggleDisplay() {
 	bool newUseJsonExport = configManager_.getValue<bool>("enable_json_export");
 	if (newUseJsonExport && !useJsonExport_) {
 		lastJson_.clear();
-		Logger::getInstance().log("JSON export enabled.");
+		LOG_INFO(General, "JSON export enabled.");
 	}
 	else if (!newUseJsonExport && useJsonExport_) {
-		Logger::getInstance().log("JSON export disabled.");
+		LOG_INFO(General, "JSON export disabled.");
 		JsonWriter::atomicWrite(jsonPath_, JsonWriter::renderNoData());
 
 	}
 	useJsonExport_ = newUseJsonExport;
+
+	applyMetricsConfig();
 }
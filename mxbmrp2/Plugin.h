@@ -3,7 +3,11 @@
 
 #pragma once
 
+#include <array>
+#include <initializer_list>
 #include <memory>
+#include <memory_resource>
+#include <string_view>
 #include <thread>
 #include <atomic>
 #include <mutex>
@@ -14,13 +18,20 @@
 #include "KeyPressHandler.h"
 #include "Constants.h"
 #include "DiscordManager.h"
+#include "MemoryWatcher.h"
+#include "JobWorker.h"
+#include "ServerRoster.h"
+#include "ServerBrowserIndex.h"
+#include "MetricsServer.h"
+#include "PluginHelpers.h"
+#include "Telemetry.h"
+#include "TelemetryRecorder.h"
+#include "LiveDelta.h"
 
 class Plugin {
 public:
     static Plugin& getInstance();
 
-    mutable std::mutex mutex_;  // protect all non-atomic shared state
-
     // MXB Interface
     void onStartup(const std::string& savePath);
     void onEventInit(const SPluginsBikeEvent_t& eventData);
@@ -40,10 +51,24 @@ public:
     void onRunLap(const SPluginsBikeLap_t& lapData);
     void onRunSplit(const SPluginsBikeSplit_t& splitData);
     void onRaceCommunication(const SPluginsRaceCommunication_t& raceComm);
+    void onRunTelemetry(const TelemetrySample& sample);     // on the game thread
 
-    // Method to retrieve the keys to display
-    std::vector<std::string> getDisplayKeys();
-    std::atomic<uint64_t> lastRunInitMs_{ 0 };
+    // What Startup returns: the telemetry rate picked in the config
+    int getTelemetryRate() const { return telemetryRate_; }
+
+    // Every RunTelemetry sample; readers keep their own TelemetryRing::Reader
+    const TelemetryRing& getTelemetry() const { return telemetry_; }
+
+    // Result of connection type detection (see onRaceEvent)
+    struct ServerInfo {
+        std::string connectionType;
+        std::string serverName;
+        std::string serverPassword;
+        std::string serverLocation;
+        int serverClientsMax = 0;
+        std::string remoteServerIPv6Address;
+        uintptr_t remoteServerIPv6AddressMemoryAddress = 0;
+    };
 
     // Configuration values for Draw
     struct displayConfig {
@@ -57,6 +82,19 @@ public:
         float quadWidth = 0.0f;
     } displayConfig_;
 
+    // What Draw shows, replaced as a whole whenever it changes
+    struct DisplaySnapshot {
+        std::vector<PluginHelpers::DisplayLine> lines;     // empty while the HUD is off
+        displayConfig config;
+    };
+
+    // Method to retrieve the current display, never null after onStartup
+    std::shared_ptr<const DisplaySnapshot> getDisplaySnapshot();
+    std::atomic<uint64_t> lastRunInitMs_{ 0 };
+
+    // Maps internal configuration keys to user-friendly display names.
+    static const std::vector<std::pair<std::string, std::string>> configKeyToDisplayNameMap;
+
 private:
     Plugin();
     ~Plugin();
@@ -74,56 +112,130 @@ private:
     // KeyPressHandler instance
     std::unique_ptr<KeyPressHandler> keyPressHandler_;
 
-    // Helper to process and update draw fields
-    void updateDataKeys(const std::unordered_map<std::string, std::string>& fields);
+    // State is split into domains with a lock each. When a function needs
+    // more than one, they are taken in this order: session, server, display,
+    // export. Hold times are recorded in the lock_*_hold histograms.
 
-    // Method to load Draw-related config values
-    void setDisplayConfig();
-
-    // Custom data keys
+    // Session identity and lap timing, written by the callback handlers
+    std::mutex sessionMutex_;
     std::string playerActivity_ = DEFAULT_PLAYER_ACTIVITY;
+    std::atomic<bool> onTrack_{ false };    // playerActivity_ == "On Track"
+    std::atomic<bool> isPaused_{ false };
     int raceNum_ = 0;
     int eventType_ = 0;
+    std::string riderName_ = "";
+    std::string bikeName_ = "";
     std::string trackID_ = "";
     std::string bikeID_ = "";
     std::string bikeCategory_ = "";
+    float trackLength_ = 0.0f;
+    int numLaps_ = 0;
+    std::vector<int> currentLapSplitsMs_;
+    std::vector<int> lapSplitsMs_;          // the finished lap's, only used by onRunLap
+    int sessionLength_ = 0;
+    int currentLap_ = 0;
+    int sessionTime_ = 0;
+    std::atomic<int> penaltyAccumulated_{ 0 };
+    void setPlayerActivity(std::string_view activity);
+
+    // Server info, written by the handlers, server info resolution and the memory watcher
+    std::mutex serverMutex_;
     std::string remoteServerIPv6Address_ = "";
     uintptr_t remoteServerIPv6AddressMemoryAddress_ = 0;
     std::string serverName_ = "";
     std::string serverPassword_ = "";
     std::string connectionType_ = "";
     std::string serverLocation_ = "";
-    std::string serverPing_ = "";
-    int serverClients_ = 0;
-    int serverClientsMax_ = 0;
-    int numLaps_ = 0;
-    std::vector<int> currentLapSplitsMs_;
-    int sessionLength_ = 0;
-    int currentLap_ = 0;
-    int sessionTime_ = 0;
-    int penaltyAccumulated_ = 0;
+    std::atomic<int> serverPingMs_{ -1 };
+    std::atomic<int> serverClients_{ 0 };
+    std::atomic<int> serverClientsMax_{ 0 };
+    ServerRoster serverRoster_;
 
-    // Stores all key-value pairs of data for processing and display.
+    // Display: every data key, and the snapshot Draw reads
+    std::mutex displayMutex_;
     std::unordered_map<std::string, std::string> allDataKeys_;
+    std::string dataKeyLookup_;     // reused to find keys without allocating
+    bool displayEnabled_ = true;
+    std::mutex snapshotMutex_;  // guards the pointer only
+    std::shared_ptr<const DisplaySnapshot> displaySnapshot_;
 
-    // Maps internal configuration keys to user-friendly display names.
-    static const std::vector<std::pair<std::string, std::string>> configKeyToDisplayNameMap;
+    // Snapshots are rebuilt in place once nothing but the pool holds them,
+    // so publishing doesn't allocate. Three cover the published one and one
+    // Draw may still be reading.
+    std::array<std::shared_ptr<DisplaySnapshot>, 3> snapshotPool_;
+    size_t nextSnapshot_ = 0;
 
-    // Holds the final set of data intended for display in the plugin's user interface
-    std::vector<std::string> dataKeysToDisplay_;
+    // A value for updateDataKeys, only read during the call
+    struct DataKeyUpdate {
+        const char* key;
+        std::string_view value;
+    };
 
-    // Display state flag
-    bool displayEnabled_ = true;
+    // Helper to process and update draw fields, republishes only on change
+    void updateDataKeys(std::initializer_list<DataKeyUpdate> updates);
+
+    // Rebuild and publish the snapshot (displayMutex_ held)
+    void publishDisplay();
+
+    // Copy of every data key in the calling thread's Arena, for the exporters
+    std::pmr::unordered_map<std::string_view, std::string_view> copyDataKeys();
+
+    // Method to load Draw-related config values
+    void setDisplayConfig();
+
+    // Apply the log levels and rotation limits from the config
+    void applyLogConfig();
+
+    // Memory watches (ping, client table, tearoffs)
+    MemoryWatcher memoryWatcher_;
+    MemoryWatcher::WatchId pingWatch_ = 0;
+    MemoryWatcher::WatchId serverClientsWatch_ = 0;
+    MemoryWatcher::WatchId localTearoffsWatch_ = 0;
+    MemoryWatcher::WatchId remoteTearoffsWatch_ = 0;
+    void updateMemoryWatches();
+    void onMemoryChanges(const std::vector<MemoryWatcher::Change>& changes);
+
+    // Server info resolution (memory scans) off the callback thread
+    JobWorker serverInfoWorker_;
+    ServerBrowserIndex serverBrowserIndex_;
+    void applyServerInfo(const ServerInfo& info, int eventType);
+
+    // ...or time-sliced from periodicTaskLoop when memory_scan_budget_us > 0
+    // (server domain)
+    unsigned long scanBudgetUs_ = 0;
+    std::unique_ptr<MemoryScan> serverNameScan_;
+    ServerInfo pendingServerInfo_;
+    int pendingEventType_ = 0;
+    bool stepServerNameScan();
+
+    // Bike telemetry, pushed by the game thread and never waited on
+    TelemetryRing telemetry_;
+    int telemetryRate_ = -1;
+    TelemetryRecorder telemetryRecorder_{ telemetry_ };
+
+    // top_speed, kept by the periodic tasks from every sample since the last tick
+    TelemetryRing::Reader topSpeedReader_{ telemetry_ };
+    float topSpeed_ = 0.0f;
+    std::atomic<bool> resetTopSpeed_{ false };  // set by onRunInit
+    void updateTopSpeed();
+
+    // live_delta, against the session's best lap, as often as samples arrive
+    LiveDelta liveDelta_{ telemetry_ };
+    void onLiveDelta(float delta);
 
     // Periodic tasks
     std::thread periodicTaskThread_;
     std::atomic<bool> runPeriodicTask_{ true };
+    std::atomic<bool> statsDirty_{ false };     // set by onRunLap, saved by periodicTaskLoop
     void periodicTaskLoop();
-    bool isPaused_ = false;
+    void runPeriodicTasks();
 
     // Callback function to toggle display 
     void toggleDisplay();
 
+    // Exporters, used by the periodic tasks and config reloads
+    std::mutex exportMutex_;
+
 	// Discord
     bool useDiscordRichPresence_ = false;
     DiscordManager discordManager_;
@@ -136,5 +248,10 @@ private:
 	// JSON Export
     bool useJsonExport_ = false;
     std::filesystem::path jsonPath_;
+    std::filesystem::path tracePath_;
     std::string lastJson_;
+
+    // Prometheus metrics endpoint
+    MetricsServer metricsServer_;
+    void applyMetricsConfig();
 };
@@ -3,122 +3,129 @@
 
 #include "pch.h"
 
+#include <cstdio>
 #include <cstring>
-#include <sstream>
 
 #include "PluginHelpers.h"
+#include "Arena.h"
 #include "ConfigManager.h"
 
 namespace PluginHelpers {
 
-    std::vector<std::string> buildDisplayStrings(
+    namespace {
+        // One entry of a game enum's names
+        struct NamedValue {
+            int value;
+            std::string_view name;
+        };
+
+        template <size_t N>
+        std::string_view nameOf(const NamedValue (&names)[N], int value) {
+            for (const auto& entry : names) {
+                if (entry.value == value) return entry.name;
+            }
+            return "Unknown";
+        }
+    }
+
+    void buildDisplayStrings(
         const std::unordered_map<std::string, std::string>& allDataKeys,
         const std::vector<std::pair<std::string, std::string>>& configKeyToDisplayNameMap,
         ConfigManager& configManager,
-        size_t maxLength)
+        std::vector<DisplayLine>& lines)
     {
-        std::vector<std::string> displayKeysBuffer;
-
-        auto isEnabled = [&configManager](const std::string& key) {
-            return configManager.getValue<bool>(key);
-            };
+        // Shown in front of the rider name
+        std::string_view raceNumber;
+        if (configManager.getValue<bool>("race_number")) {
+            if (auto it = allDataKeys.find("race_number"); it != allDataKeys.end()) {
+                raceNumber = it->second;
+            }
+        }
 
+        lines.clear();
         for (const auto& [configKey, displayName] : configKeyToDisplayNameMap) {
-            if (isEnabled(configKey)) {
-                auto it = allDataKeys.find(configKey);
-                if (it != allDataKeys.end() && !it->second.empty()) {
-                    std::string displayString;
-
-                    if (configKey == "plugin_banner") {
-                        displayString = it->second;
-                    }
-                    else if (configKey == "rider_name" &&
-                        isEnabled("race_number") &&
-                        allDataKeys.count("race_number") &&
-                        !allDataKeys.at("race_number").empty())
-                    {
-                        displayString = displayName + ": " +
-                            allDataKeys.at("race_number") + " " + it->second;
-                    }
-                    else {
-                        displayString = displayName + ": " + it->second;
-                    }
-
-                    displayKeysBuffer.emplace_back(displayString.substr(0, maxLength));
-                }
+            if (!configManager.getValue<bool>(configKey)) continue;
+
+            auto it = allDataKeys.find(configKey);
+            if (it == allDataKeys.end() || it->second.empty()) continue;
+
+            DisplayLine& line = lines.emplace_back();
+            if (configKey == "plugin_banner") {
+                line.append(it->second);
+                continue;
             }
-        }
 
-        return displayKeysBuffer;
+            line.append(displayName).append(": ");
+            if (configKey == "rider_name" && !raceNumber.empty()) {
+                line.append(raceNumber).append(' ');
+            }
+            line.append(it->second);
+        }
     }
 
-    std::string getGameState(int gameState) {
-        static const std::unordered_map<int, std::string> gameStateMap = {
+    std::string_view getGameState(int gameState) {
+        static constexpr NamedValue GAME_STATES[] = {
             {-1, "In Menus"},
             {0, "On Track"},
             {1, "Spectating"},
             {2, "Watching Replay"}
         };
-
-        auto it = gameStateMap.find(gameState);
-        return it != gameStateMap.end() ? it->second : "Unknown";
+        return nameOf(GAME_STATES, gameState);
     }
 
-    std::string getEventType(int type, const std::string& connectionType) {
-        static const std::unordered_map<int, std::string> eventTypeNames = {
+    std::string_view getEventType(int type, std::string_view connectionType) {
+        static constexpr NamedValue EVENT_TYPES[] = {
             {1, "Testing"},
             {2, "Race"},
             {4, "Straight Rhythm"}
         };
 
         // Edge case: Testing when online is called Open Practice
-        if (type == 1 && connectionType != "Offline") {
+        if (type == 1 && (connectionType == "Host" || connectionType == "Client")) {
             return "Open Practice";
         }
 
-        auto it = eventTypeNames.find(type);
-        return it != eventTypeNames.end() ? it->second : "Unknown";
+        return nameOf(EVENT_TYPES, type);
     }
 
-    std::string getSessionType(int type, int session) {
-        static const std::unordered_map<int, std::unordered_map<int, std::string>> sessionStateNames = {
-            {1, { // Testing / Open Practice
-                {0, "Waiting"},
-                {1, "Practice"}
-            }},
-            {3, { // Qualify Practice}
-                {0, "Waiting"}
-            }},
-            {2, { // Race
-                {0, "Waiting"},
-                {1, "Practice"},
-                {2, "Pre-Qualify"},
-                {3, "Unknown"}, // Not Used?
-                {4, "Qualify"},
-                {5, "Warmup"},
-                {6, "Race 1"},
-                {7, "Race 2"}
-            }},
-            {4, { // Straight Rhythm
-                {0, "Waiting"},
-                {1, "Practice"},
-                {2, "Round"},
-                {3, "Quarter-Finals"},
-                {4, "Semi-Finals"},
-                {5, "Final"}
-            }}
+    std::string_view getSessionType(int type, int session) {
+        static constexpr NamedValue TESTING[] = { // Testing / Open Practice
+            {0, "Waiting"},
+            {1, "Practice"}
+        };
+        static constexpr NamedValue QUALIFY_PRACTICE[] = {
+            {0, "Waiting"}
+        };
+        static constexpr NamedValue RACE[] = {
+            {0, "Waiting"},
+            {1, "Practice"},
+            {2, "Pre-Qualify"},
+            {3, "Unknown"}, // Not Used?
+            {4, "Qualify"},
+            {5, "Warmup"},
+            {6, "Race 1"},
+            {7, "Race 2"}
+        };
+        static constexpr NamedValue STRAIGHT_RHYTHM[] = {
+            {0, "Waiting"},
+            {1, "Practice"},
+            {2, "Round"},
+            {3, "Quarter-Finals"},
+            {4, "Semi-Finals"},
+            {5, "Final"}
         };
 
-        if (auto typeIt = sessionStateNames.find(type); typeIt != sessionStateNames.end()) {
-            if (auto sessionIt = typeIt->second.find(session); sessionIt != typeIt->second.end()) {
-                return sessionIt->second;
-            }
+        switch (type) {
+        case 1: return nameOf(TESTING, session);
+        case 2: return nameOf(RACE, session);
+        case 3: return nameOf(QUALIFY_PRACTICE, session);
+        case 4: return nameOf(STRAIGHT_RHYTHM, session);
+        default: return "Unknown";
         }
-        return "Unknown";
     }
 
-    std::string getSessionState(int sessionState) {
-        static const std::unordered_map<int, std::string> sessionStateNames = {
+    std::string_view getSessionState(int sessionState) {
+        static constexpr NamedValue SESSION_STATES[] = {
             {0, "In Progress"},
             {16, "In Progress"},
             {32, "Completed"},
@@ -128,20 +135,16 @@ namespace PluginHelpers {
             {1024, "Completed"},
             {2048, "Completed"}
         };
-
-        auto it = sessionStateNames.find(sessionState);
-        return it != sessionStateNames.end() ? it->second : "Unknown";
+        return nameOf(SESSION_STATES, sessionState);
     }
 
-    std::string getConditions(int condition) {
-        static const std::unordered_map<int, std::string> conditionsMap = {
+    std::string_view getConditions(int condition) {
+        static constexpr NamedValue CONDITIONS[] = {
             {0, "Clear"},
             {1, "Cloudy"},
             {2, "Rainy"}
         };
-
-        auto it = conditionsMap.find(condition);
-        return it != conditionsMap.end() ? it->second : "Unknown";
+        return nameOf(CONDITIONS, condition);
     }
 
     std::string formatIPv6MappedIPv4(const ByteBuf& ipv6) {
@@ -161,69 +164,77 @@ namespace PluginHelpers {
         hext2 = ntohs(hext2);
         port = ntohs(port);
 
-        std::ostringstream oss;
-        oss << "[::ffff:"
-            << std::hex << hext1 << ":" << hext2
-            << std::dec << "]:" << port
-            << "/[::1]:" << port;
-        return oss.str();
+        char text[48];
+        std::snprintf(text, sizeof(text), "[::ffff:%x:%x]:%d/[::1]:%d", hext1, hext2, port, port);
+        return text;
     }
 
     // mxbikes.exe -connect "mxbikes://ip:port/local_ip:local_port/server name/password/track_id/layout_id/categories"
-    std::string buildConnectURIString(const std::string& formattedIPv6,
-        const std::string& serverName,
-        const std::string& password,
-        const std::string& trackID,
-        const std::string& serverCategories)
+    std::pmr::string buildConnectURIString(std::string_view formattedIPv6,
+        std::string_view serverName,
+        std::string_view password,
+        std::string_view trackID,
+        std::string_view serverCategories)
     {
         char exePath[MAX_PATH] = { 0 };
         GetModuleFileNameA(NULL, exePath, MAX_PATH);
-        std::string passwordFlag = password.empty() ? "0" : "1";
-
-        return "\"" + std::string(exePath) + "\"" + " -connect \"mxbikes://" +
-            formattedIPv6 + "/" +
-            serverName + "/" +
-            passwordFlag + "/" +
-            trackID +
-            "/0/" +
-            serverCategories + "\"";
+        const char* passwordFlag = password.empty() ? "0" : "1";
+
+        std::pmr::string uri(Arena::resource());
+        uri.append("\"").append(exePath).append("\"").append(" -connect \"mxbikes://")
+            .append(formattedIPv6).append("/")
+            .append(serverName).append("/")
+            .append(passwordFlag).append("/")
+            .append(trackID)
+            .append("/0/")
+            .append(serverCategories).append("\"");
+        return uri;
     }
 
-    std::string getServerNameFromConnectURI(const std::string& connStr) {
-        std::istringstream ss(connStr);
-        std::string token;
-
+    std::string getServerNameFromConnectURI(std::string_view connStr) {
         // We need the 5th token (index 4)
-        for (int i = 0; i < 5; ++i) {
-            if (!std::getline(ss, token, '/')) {
+        size_t start = 0;
+        for (int i = 0; i < 4; ++i) {
+            size_t slash = connStr.find('/', start);
+            if (slash == std::string_view::npos) {
                 return {};
             }
+            start = slash + 1;
+        }
+        if (start == connStr.size()) {
+            return {};
         }
 
-        return token;
+        return std::string(connStr.substr(start, connStr.find('/', start) - start));
     }
 
-    std::string getSessionDuration(int numLaps, int sessionLenMs, int sessionTimeMs) {
+    FixedString<31> getSessionDuration(int numLaps, int sessionLenMs, int sessionTimeMs) {
+        FixedString<31> text;
+
         // ms -> mm:ss
-        auto toClock = [](int ms) -> std::string {
+        auto appendClock = [&text](int ms) {
             if (ms < 0) ms = 0;
             int total = ms / 1000;
-            std::ostringstream oss;
-            oss << std::setw(2) << std::setfill('0') << (total / 60)
-                << ':'
-                << std::setw(2) << std::setfill('0') << (total % 60);
-            return oss.str();
+            text.appendNumber(total / 60, 2).append(':').appendNumber(total % 60, 2);
+            };
+        auto appendLaps = [&text](int laps) {
+            text.appendNumber(laps).append(laps == 1 ? " Lap" : " Laps");
             };
 
 		// time-only session (testing/open practice)
-        if (numLaps <= 0)
-            return toClock(sessionTimeMs);
-
+        if (numLaps <= 0) {
+            appendClock(sessionTimeMs);
+        }
         // lap-only race
-        if (sessionLenMs == 0)
-            return numLaps == 1 ? "1 Lap" : std::to_string(numLaps) + " Laps";
-
+        else if (sessionLenMs == 0) {
+            appendLaps(numLaps);
+        }
         // time + lap race
-        return toClock(sessionTimeMs) + " +" + (numLaps == 1 ? "1 Lap" : std::to_string(numLaps) + " Laps");
+        else {
+            appendClock(sessionTimeMs);
+            text.append(" +");
+            appendLaps(numLaps);
+        }
+        return text;
     }
 }
@@ -3,53 +3,63 @@
 
 #pragma once
 
+#include <memory_resource>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
 #include "ConfigManager.h"
+#include "Constants.h"
 #include "MemReaderHelpers.h"
+#include "FixedString.h"
 
 namespace PluginHelpers {
 
-    std::vector<std::string> buildDisplayStrings(
+    // One HUD line, cut at MAX_STRING_LENGTH
+    using DisplayLine = FixedString<MAX_STRING_LENGTH>;
+
+    // Fills `lines` with the HUD text of every enabled, non-empty key, in
+    // display order. Lines have no heap storage, so a vector with room for
+    // every key never allocates.
+    void buildDisplayStrings(
         const std::unordered_map<std::string, std::string>& allDataKeys,
         const std::vector<std::pair<std::string, std::string>>& configKeyToDisplayNameMap,
         ConfigManager& configManager,
-        size_t maxLength
+        std::vector<DisplayLine>& lines
     );
 
     using ByteBuf = MemReaderHelpers::ByteBuf;
 
     // Converts game state
-    std::string getGameState(int gameState);
+    std::string_view getGameState(int gameState);
 
     // Converts event type
-    std::string getEventType(int type, const std::string& connectionType);
+    std::string_view getEventType(int type, std::string_view connectionType);
 
     // Converts session and type
-    std::string getSessionType(int type, int session);
+    std::string_view getSessionType(int type, int session);
 
     // Converts session state
-    std::string getSessionState(int sessionState);
+    std::string_view getSessionState(int sessionState);
 
     // Returns session duration
-    std::string getSessionDuration(int numLaps, int sessionLenMs, int sessionTimeMs);
+    FixedString<31> getSessionDuration(int numLaps, int sessionLenMs, int sessionTimeMs);
 
     // Converts numeric conditions
-    std::string getConditions(int condition);
+    std::string_view getConditions(int condition);
 
     // Formats an IPv6-mapped IPv4 address
     std::string formatIPv6MappedIPv4(const ByteBuf& ipv6);
 
-    // Builds a connection string
-    std::string buildConnectURIString(const std::string& formattedIPv6,
-        const std::string& serverName,
-        const std::string& password,
-        const std::string& trackID,
-        const std::string& serverCategories);
+    // Builds a connection string in the calling thread's Arena
+    std::pmr::string buildConnectURIString(std::string_view formattedIPv6,
+        std::string_view serverName,
+        std::string_view password,
+        std::string_view trackID,
+        std::string_view serverCategories);
 
     // Extracts the server name from the connection string
-    std::string getServerNameFromConnectURI(const std::string& connStr);
+    std::string getServerNameFromConnectURI(std::string_view connStr);
 
 } // namespace PluginHelpers
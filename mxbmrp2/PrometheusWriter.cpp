@@ -0,0 +1,148 @@
+
+// PrometheusWriter.cpp
+
+#include "pch.h"
+
+#include <initializer_list>
+#include <string_view>
+
+#include "Constants.h"
+#include "PrometheusWriter.h"
+#include "Arena.h"
+#include "Metrics.h"
+#include "Logger.h"
+
+namespace {
+    // Nanoseconds as exact decimal seconds
+    struct Seconds {
+        uint64_t nanos;
+    };
+
+    class Page {
+    public:
+        Page() : out_(Arena::resource()) {}
+
+        // Starts a metric family
+        void family(const char* name, const char* type, const char* help) {
+            out_.append("# HELP ").append(name).append(" ").append(help).append("\n");
+            out_.append("# TYPE ").append(name).append(" ").append(type).append("\n");
+        }
+
+        // A sample named by concatenating `name` (metric name and labels)
+        template <typename T>
+        void sample(std::initializer_list<std::string_view> name, T value) {
+            for (std::string_view part : name) out_.append(part);
+            out_ += ' ';
+            append(value);
+            out_ += '\n';
+        }
+
+        // A family with a single unlabelled sample
+        template <typename T>
+        void metric(const char* name, const char* type, const char* help, T value) {
+            family(name, type, help);
+            sample({ name }, value);
+        }
+
+        std::pmr::string take() { return std::move(out_); }
+
+    private:
+        void append(std::string_view text) { out_.append(text); }
+        void append(const char* text) { out_.append(text); }
+
+        void append(Seconds s) {
+            std::string fraction = std::to_string(s.nanos % 1000000000);
+            out_.append(std::to_string(s.nanos / 1000000000)).append(".")
+                .append(9 - fraction.size(), '0').append(fraction);
+        }
+
+        template <typename T>
+        void append(T value) { out_.append(std::to_string(value)); }
+
+        std::pmr::string out_;
+    };
+}
+
+namespace PrometheusWriter {
+
+    std::pmr::string render(const SessionState& state)
+    {
+        Page page;
+
+        page.family("mxbmrp2_info", "gauge", "Plugin version");
+        page.sample({ "mxbmrp2_info{version=\"", PLUGIN_VERSION, "\"}" }, 1);
+
+        // Session
+        page.metric("mxbmrp2_on_track", "gauge", "1 while riding", state.onTrack ? 1 : 0);
+        page.metric("mxbmrp2_session_laps", "gauge", "Laps completed this session", state.sessionLaps);
+        page.metric("mxbmrp2_combo_laps", "gauge", "Laps on the current bike/track combination", state.comboLaps);
+        page.metric("mxbmrp2_laps", "gauge", "Laps across all bike/track combinations", state.totalLaps);
+        if (state.sessionBestMs > 0) {
+            page.metric("mxbmrp2_session_pb_seconds", "gauge", "Personal best in the current session",
+                Seconds{ static_cast<uint64_t>(state.sessionBestMs) * 1000000 });
+        }
+        if (state.alltimeBestMs > 0) {
+            page.metric("mxbmrp2_alltime_pb_seconds", "gauge", "Personal best on the current bike/track combination",
+                Seconds{ static_cast<uint64_t>(state.alltimeBestMs) * 1000000 });
+        }
+        page.metric("mxbmrp2_combo_track_time_seconds", "gauge", "Track time on the current bike/track combination", state.comboTrackSeconds);
+        page.metric("mxbmrp2_track_time_seconds", "gauge", "Track time across all combinations", state.totalTrackSeconds);
+
+        // Server
+        page.metric("mxbmrp2_online", "gauge", "1 while hosting or connected to a server", state.online ? 1 : 0);
+        if (state.serverPingMs >= 0) {
+            page.metric("mxbmrp2_server_ping_seconds", "gauge", "Ping to the remote server",
+                Seconds{ static_cast<uint64_t>(state.serverPingMs) * 1000000 });
+        }
+        if (state.online) {
+            page.metric("mxbmrp2_server_clients", "gauge", "Clients on the server", state.serverClients);
+            page.metric("mxbmrp2_server_clients_max", "gauge", "Client slots on the server", state.serverClientsMax);
+        }
+
+        // Plugin latencies, cumulative for the session
+        const Metrics& metrics = Metrics::getInstance();
+        page.family("mxbmrp2_latency_seconds", "summary", "Time spent in plugin work");
+        for (size_t i = 0; i < static_cast<size_t>(Histogram::Count); ++i) {
+            const Histogram histogram = static_cast<Histogram>(i);
+            const Metrics::Summary s = metrics.summarize(histogram);
+            const char* op = Metrics::name(histogram);
+
+            // Quantiles of an empty summary are NaN by convention
+            auto quantile = [&](const char* q, uint64_t nanos) {
+                if (s.count) page.sample({ "mxbmrp2_latency_seconds{op=\"", op, "\",quantile=\"", q, "\"}" }, Seconds{ nanos });
+                else page.sample({ "mxbmrp2_latency_seconds{op=\"", op, "\",quantile=\"", q, "\"}" }, "NaN");
+                };
+            quantile("0.5", s.p50);
+            quantile("0.9", s.p90);
+            quantile("0.99", s.p99);
+            page.sample({ "mxbmrp2_latency_seconds_sum{op=\"", op, "\"}" }, Seconds{ s.sum });
+            page.sample({ "mxbmrp2_latency_seconds_count{op=\"", op, "\"}" }, s.count);
+        }
+
+        // Exports
+        const struct { const char* label; Counter writes; Counter bytes; } exports[] = {
+            { "json", Counter::JsonWrites, Counter::JsonBytesWritten },
+            { "html", Counter::HtmlWrites, Counter::HtmlBytesWritten },
+            { "stats", Counter::StatsWrites, Counter::StatsBytesWritten },
+        };
+        page.family("mxbmrp2_export_writes_total", "counter", "Export files written");
+        for (const auto& e : exports) {
+            page.sample({ "mxbmrp2_export_writes_total{export=\"", e.label, "\"}" }, metrics.total(e.writes));
+        }
+        page.family("mxbmrp2_export_bytes_total", "counter", "Bytes written to export files");
+        for (const auto& e : exports) {
+            page.sample({ "mxbmrp2_export_bytes_total{export=\"", e.label, "\"}" }, metrics.total(e.bytes));
+        }
+
+        page.metric("mxbmrp2_telemetry_samples_total", "counter", "RunTelemetry samples received",
+            metrics.total(Counter::TelemetrySamples));
+        page.metric("mxbmrp2_telemetry_skipped_total", "counter", "Telemetry samples overwritten before a reader got to them",
+            metrics.total(Counter::TelemetrySkipped));
+
+        page.metric("mxbmrp2_log_dropped_total", "counter", "Log messages dropped because the queue was full",
+            Logger::getInstance().droppedCount());
+
+        return page.take();
+    }
+
+} // namespace PrometheusWriter
@@ -0,0 +1,33 @@
+
+// PrometheusWriter.h
+
+#pragma once
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+
+namespace PrometheusWriter {
+
+    // Plugin state as numbers, copied out of the Plugin lock domains
+    struct SessionState {
+        bool onTrack = false;
+        bool online = false;
+        int serverPingMs = -1;      // -1 unless connected as a client
+        int serverClients = 0;
+        int serverClientsMax = 0;
+
+        int64_t comboTrackSeconds = 0;
+        int64_t totalTrackSeconds = 0;
+        int sessionBestMs = 0;      // 0 until a lap is recorded
+        int alltimeBestMs = 0;
+        int sessionLaps = 0;
+        int comboLaps = 0;
+        int totalLaps = 0;
+    };
+
+    // Prometheus text exposition (version 0.0.4) of the session state and
+    // the plugin's own counters and latencies, rendered in the calling
+    // thread's Arena
+    std::pmr::string render(const SessionState& state);
+
+}
@@ -0,0 +1,235 @@
+
+// RegionMap.cpp
+
+#include "pch.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "RegionMap.h"
+
+#ifdef _WIN32
+
+namespace {
+    bool isEligible(const MEMORY_BASIC_INFORMATION& mbi) {
+        return mbi.State == MEM_COMMIT &&
+            mbi.Type == MEM_PRIVATE &&
+            mbi.Protect == PAGE_READWRITE &&
+            !(mbi.Protect & PAGE_GUARD);
+    }
+
+    class VirtualQueryRegionSource : public RegionSource {
+    public:
+        VirtualQueryRegionSource() {
+            SYSTEM_INFO si;
+            GetSystemInfo(&si);
+            min_ = reinterpret_cast<uintptr_t>(si.lpMinimumApplicationAddress);
+            max_ = reinterpret_cast<uintptr_t>(si.lpMaximumApplicationAddress);
+        }
+
+        uintptr_t minAddress() const override { return min_; }
+        uintptr_t maxAddress() const override { return max_; }
+
+        void enumerate(uintptr_t begin, uintptr_t end, std::vector<MemoryRegion>& out) override {
+            uintptr_t addr = begin;
+            while (addr < end) {
+                MEMORY_BASIC_INFORMATION mbi;
+                if (VirtualQuery(reinterpret_cast<LPCVOID>(addr), &mbi, sizeof(mbi)) == 0)
+                    break;
+
+                uintptr_t base = reinterpret_cast<uintptr_t>(mbi.BaseAddress);
+                if (base >= begin && isEligible(mbi)) {
+                    out.push_back({ base, mbi.RegionSize, 0 });
+                }
+                addr = base + mbi.RegionSize;
+            }
+        }
+
+    private:
+        uintptr_t min_ = 0;
+        uintptr_t max_ = 0;
+    };
+}
+
+std::unique_ptr<RegionSource> createProcessRegionSource() {
+    return std::make_unique<VirtualQueryRegionSource>();
+}
+
+#else
+
+namespace {
+    // The file lists every mapping, so a refresh reads it once and the
+    // enumerate() calls pick their range out of that
+    class ProcMapsRegionSource : public RegionSource {
+    public:
+        uintptr_t minAddress() const override { return 0; }
+        uintptr_t maxAddress() const override { return UINTPTR_MAX; }
+
+        void beginRefresh() override {
+            regions_.clear();
+            std::ifstream in("/proc/self/maps");
+            parseProcMaps(in, 0, UINTPTR_MAX, regions_);
+            loaded_ = true;
+        }
+
+        void endRefresh() override {
+            loaded_ = false;
+        }
+
+        void enumerate(uintptr_t begin, uintptr_t end, std::vector<MemoryRegion>& out) override {
+            if (!loaded_) {
+                std::ifstream in("/proc/self/maps");
+                parseProcMaps(in, begin, end, out);
+                return;
+            }
+
+            // The kernel lists mappings in address order
+            auto it = std::lower_bound(regions_.begin(), regions_.end(), begin,
+                [](const MemoryRegion& r, uintptr_t address) { return r.base < address; });
+            for (; it != regions_.end() && it->base < end; ++it) {
+                out.push_back(*it);
+            }
+        }
+
+    private:
+        std::vector<MemoryRegion> regions_;     // the whole file, while refreshing
+        bool loaded_ = false;
+    };
+}
+
+std::unique_ptr<RegionSource> createProcessRegionSource() {
+    return std::make_unique<ProcMapsRegionSource>();
+}
+
+#endif
+
+// Parse /proc/<pid>/maps
+void parseProcMaps(std::istream& in, uintptr_t begin, uintptr_t end, std::vector<MemoryRegion>& out) {
+    // 7f1c2a000000-7f1c2a021000 rw-p 00000000 00:00 0    [heap]
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream iss(line);
+        std::string range, perms, offset, dev;
+        unsigned long inode = 0;
+        if (!(iss >> range >> perms >> offset >> dev >> inode)) continue;
+
+        // Anonymous private read/write, the equivalent of MEM_PRIVATE + PAGE_READWRITE
+        if (perms != "rw-p" || inode != 0) continue;
+
+        size_t dash = range.find('-');
+        if (dash == std::string::npos) continue;
+
+        uintptr_t lo = 0, hi = 0;
+        try {
+            lo = static_cast<uintptr_t>(std::stoull(range.substr(0, dash), nullptr, 16));
+            hi = static_cast<uintptr_t>(std::stoull(range.substr(dash + 1), nullptr, 16));
+        }
+        catch (...) {
+            continue;
+        }
+
+        if (hi <= lo || lo < begin || lo >= end) continue;
+        out.push_back({ lo, hi - lo, 0 });
+    }
+}
+
+// Constructor
+RegionMap::RegionMap(std::unique_ptr<RegionSource> source, std::chrono::milliseconds rescanInterval)
+    : source_(std::move(source)),
+      rescanInterval_(rescanInterval),
+      current_(std::make_shared<Snapshot>()) {
+}
+
+// Refresh the map
+std::shared_ptr<const RegionMap::Snapshot> RegionMap::refresh(bool rescanGaps) {
+    std::lock_guard<std::mutex> lk(mutex_);
+
+    const auto now = std::chrono::steady_clock::now();
+    const Snapshot& old = *current_;
+    const uint64_t generation = old.generation + 1;
+
+    if (old.regions.empty() || now - lastRescan_ >= rescanInterval_) {
+        rescanGaps = true;
+    }
+
+    bool changed = false;
+    std::vector<MemoryRegion> regions;
+    regions.reserve(old.regions.size());
+    source_->beginRefresh();
+
+    // Re-query known regions; unchanged ones keep their generation
+    std::vector<MemoryRegion> found;
+    for (const auto& region : old.regions) {
+        found.clear();
+        source_->enumerate(region.base, region.end(), found);
+
+        if (found.size() == 1 && found[0].base == region.base && found[0].size == region.size) {
+            regions.push_back(region);
+            continue;
+        }
+
+        changed = true;
+        for (auto& r : found) {
+            r.generation = generation;
+            regions.push_back(r);
+        }
+    }
+
+    // Walk the gaps between known regions
+    if (rescanGaps) {
+        const size_t known = regions.size();
+        uintptr_t gapStart = source_->minAddress();
+        for (size_t i = 0; i <= known; ++i) {
+            uintptr_t gapEnd = (i < known) ? regions[i].base : source_->maxAddress();
+            if (gapStart < gapEnd) {
+                found.clear();
+                source_->enumerate(gapStart, gapEnd, found);
+                for (auto& r : found) {
+                    r.generation = generation;
+                    regions.push_back(r);
+                }
+                changed = changed || !found.empty();
+            }
+            if (i < known) {
+                gapStart = std::max<uintptr_t>(gapStart, regions[i].end());
+            }
+        }
+        lastRescan_ = now;
+    }
+    source_->endRefresh();
+
+    if (!changed) {
+        return current_;
+    }
+
+    // Sort and drop overlaps (a region that grew may also show up in a gap)
+    std::sort(regions.begin(), regions.end(),
+        [](const MemoryRegion& a, const MemoryRegion& b) { return a.base < b.base; });
+
+    auto next = std::make_shared<Snapshot>();
+    next->generation = generation;
+    next->regions.reserve(regions.size());
+    for (const auto& r : regions) {
+        if (!next->regions.empty() && r.base < next->regions.back().end()) continue;
+        next->regions.push_back(r);
+    }
+
+    current_ = std::move(next);
+    return current_;
+}
+
+// Current map
+std::shared_ptr<const RegionMap::Snapshot> RegionMap::snapshot() const {
+    std::lock_guard<std::mutex> lk(mutex_);
+    return current_;
+}
+
+// Drop everything
+void RegionMap::invalidate() {
+    std::lock_guard<std::mutex> lk(mutex_);
+    auto empty = std::make_shared<Snapshot>();
+    empty->generation = current_->generation + 1;
+    current_ = std::move(empty);
+}
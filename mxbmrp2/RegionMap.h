@@ -0,0 +1,81 @@
+
+// RegionMap.h
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <chrono>
+#include <istream>
+#include <vector>
+
+// Committed, private, read/write memory region eligible for pattern scans
+struct MemoryRegion {
+    uintptr_t base = 0;
+    size_t size = 0;
+    uint64_t generation = 0;    // map generation the region was first seen in
+
+    uintptr_t end() const { return base + size; }
+};
+
+// Enumerates eligible regions of the current process
+class RegionSource {
+public:
+    virtual ~RegionSource() = default;
+
+    // Address range worth scanning
+    virtual uintptr_t minAddress() const = 0;
+    virtual uintptr_t maxAddress() const = 0;
+
+    // Appends eligible regions that start in [begin, end), in address order
+    virtual void enumerate(uintptr_t begin, uintptr_t end, std::vector<MemoryRegion>& out) = 0;
+
+    // Bracket the enumerate() calls of one RegionMap::refresh, so a source
+    // that lists the whole process at once only has to do it once
+    virtual void beginRefresh() {}
+    virtual void endRefresh() {}
+};
+
+// VirtualQuery on Windows, /proc/self/maps elsewhere
+std::unique_ptr<RegionSource> createProcessRegionSource();
+
+// Parses /proc/<pid>/maps lines, keeping anonymous private rw-p mappings
+void parseProcMaps(std::istream& in, uintptr_t begin, uintptr_t end, std::vector<MemoryRegion>& out);
+
+// Cached list of eligible regions shared by all scans
+//
+// refresh() re-queries the regions already known, which is cheap, and only
+// walks the gaps between them when asked to (or when the map is empty or
+// older than the rescan interval). Scans hold on to a snapshot, so a refresh
+// never invalidates a scan in progress.
+class RegionMap {
+public:
+    struct Snapshot {
+        uint64_t generation = 0;
+        std::vector<MemoryRegion> regions;  // sorted by base
+    };
+
+    explicit RegionMap(
+        std::unique_ptr<RegionSource> source,
+        std::chrono::milliseconds rescanInterval = std::chrono::seconds(30)
+    );
+
+    // Refresh and return the current map
+    std::shared_ptr<const Snapshot> refresh(bool rescanGaps = false);
+
+    // Current map without refreshing (empty until the first refresh)
+    std::shared_ptr<const Snapshot> snapshot() const;
+
+    // Drop everything (e.g. after a level load frees most of the heap)
+    void invalidate();
+
+private:
+    std::unique_ptr<RegionSource> source_;
+    std::chrono::milliseconds rescanInterval_;
+
+    mutable std::mutex mutex_;
+    std::shared_ptr<const Snapshot> current_;
+    std::chrono::steady_clock::time_point lastRescan_{};
+};
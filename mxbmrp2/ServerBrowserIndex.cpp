@@ -0,0 +1,168 @@
+
+// ServerBrowserIndex.cpp
+
+#include "pch.h"
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+
+#include "ServerBrowserIndex.h"
+#include "Arena.h"
+#include "MemReader.h"
+#include "Logger.h"
+#include "Constants.h"
+
+namespace {
+    struct FieldOffsets {
+        unsigned long name;
+        unsigned long location;
+        unsigned long clientsMax;
+
+        size_t entrySize() const {
+            return std::max<size_t>({ name + SIZE_REMOTE_SERVER_NAME,
+                              location + SIZE_REMOTE_SERVER_LOCATION,
+                              clientsMax + SIZE_REMOTE_SERVER_CLIENTS_MAX });
+        }
+    };
+
+    std::optional<FieldOffsets> getFieldOffsets() {
+        auto& memReader = MemReader::getInstance();
+        auto name = memReader.getOffset(MemoryOffset::RemoteServerName);
+        auto location = memReader.getOffset(MemoryOffset::RemoteServerLocation);
+        auto clientsMax = memReader.getOffset(MemoryOffset::RemoteServerClientsMax);
+        if (!name || !location || !clientsMax) return std::nullopt;
+        return FieldOffsets{ *name, *location, *clientsMax };
+    }
+
+    std::string readField(const uint8_t* p, size_t maxLen) {
+        const char* s = reinterpret_cast<const char*>(p);
+        return std::string(s, strnlen(s, maxLen));
+    }
+
+    // Same test the memory search uses to accept a server name
+    bool looksLikeName(const uint8_t* p, size_t maxLen) {
+        const uint8_t* end = p + maxLen;
+        const uint8_t* nul = std::find(p, end, 0);
+        if (nul == end || nul - p < 3) return false;
+        return std::all_of(p, nul, [](unsigned char c) { return c >= 32 && c <= 125; });
+    }
+
+    // An entry starts with the FF FF of its IPv6-mapped address and has a name
+    bool looksLikeEntry(const uint8_t* p, const FieldOffsets& off) {
+        return p[0] == 0xFF && p[1] == 0xFF && looksLikeName(p + off.name, SIZE_REMOTE_SERVER_NAME);
+    }
+}
+
+// Pack the 8-byte key into an integer for hashing
+std::optional<uint64_t> ServerBrowserIndex::packKey(const uint8_t* key, size_t size) {
+    if (size != KEY_SIZE) return std::nullopt;
+    uint64_t packed = 0;
+    std::memcpy(&packed, key, KEY_SIZE);
+    return packed;
+}
+
+// Lookup
+std::optional<ServerBrowserIndex::Entry> ServerBrowserIndex::find(const std::vector<uint8_t>& key) {
+    auto packed = packKey(key.data(), key.size());
+    if (!packed) return std::nullopt;
+
+    std::lock_guard<std::mutex> lk(mutex_);
+    auto it = entries_.find(*packed);
+    if (it == entries_.end()) return std::nullopt;
+
+    // A browser refresh rebuilds the array, after which the whole index is stale
+    auto current = MemReader::getInstance().read<uint64_t>(false, it->second.address);
+    if (!current || *current != *packed) {
+        LOG_INFO(Memory, "Server browser index is stale, dropping "
+            + std::to_string(entries_.size()) + " entries");
+        entries_.clear();
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+// Index the browser array around `foundAddress`
+void ServerBrowserIndex::build(uintptr_t foundAddress) {
+    auto off = getFieldOffsets();
+    if (!off || foundAddress == 0) return;
+
+    auto& memReader = MemReader::getInstance();
+    auto region = memReader.findRegion(foundAddress);
+    if (!region) return;
+
+    // Copy a window of the array's region in one read
+    const uintptr_t lo = std::max<uintptr_t>(region->base, foundAddress > SEARCH_WINDOW ? foundAddress - SEARCH_WINDOW : 0);
+    const uintptr_t hi = std::min<uintptr_t>(region->end(), foundAddress + SEARCH_WINDOW);
+    const size_t entrySize = off->entrySize();
+    if (hi <= lo || hi - foundAddress < entrySize) return;
+
+    std::vector<uint8_t> window(hi - lo);
+    if (!memReader.readInto(false, lo, window.data(), window.size())) return;
+
+    const size_t found = foundAddress - lo;
+    if (!looksLikeEntry(window.data() + found, *off)) return;
+
+    // Infer the array stride from the spacing of entry-shaped records
+    std::pmr::vector<size_t> candidates(Arena::resource());
+    for (size_t p = 0; p + entrySize <= window.size(); ++p) {
+        if (looksLikeEntry(window.data() + p, *off)) {
+            candidates.push_back(p);
+        }
+    }
+
+    std::pmr::map<size_t, int> spacing(Arena::resource());
+    for (size_t i = 1; i < candidates.size(); ++i) {
+        size_t d = candidates[i] - candidates[i - 1];
+        if (d >= entrySize) spacing[d]++;
+    }
+
+    size_t stride = 0;
+    int best = 1;   // need the same spacing at least twice
+    for (const auto& [d, n] : spacing) {
+        if (n > best) {
+            best = n;
+            stride = d;
+        }
+    }
+
+    std::lock_guard<std::mutex> lk(mutex_);
+    entries_.clear();
+    stride_ = stride;
+
+    auto add = [&](size_t p) {
+        const uint8_t* e = window.data() + p;
+        Entry entry;
+        entry.address = lo + p;
+        entry.name = readField(e + off->name, SIZE_REMOTE_SERVER_NAME);
+        entry.location = readField(e + off->location, SIZE_REMOTE_SERVER_LOCATION);
+        entry.clientsMax = e[off->clientsMax];
+        entries_[*packKey(e, KEY_SIZE)] = std::move(entry);
+    };
+
+    add(found);
+    if (stride_ != 0) {
+        for (size_t p = found + stride_; p + entrySize <= window.size() && looksLikeEntry(window.data() + p, *off); p += stride_) {
+            add(p);
+        }
+        for (size_t p = found; p >= stride_ && looksLikeEntry(window.data() + p - stride_, *off); p -= stride_) {
+            add(p - stride_);
+        }
+    }
+
+    LOG_INFO(Memory, "Server browser index: " + std::to_string(entries_.size())
+        + " entries, stride " + std::to_string(stride_));
+}
+
+// Forget all entries
+void ServerBrowserIndex::clear() {
+    std::lock_guard<std::mutex> lk(mutex_);
+    entries_.clear();
+    stride_ = 0;
+}
+
+// Number of indexed entries
+size_t ServerBrowserIndex::size() const {
+    std::lock_guard<std::mutex> lk(mutex_);
+    return entries_.size();
+}
@@ -0,0 +1,46 @@
+
+// ServerBrowserIndex.h
+
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Server browser entries keyed by their 8-byte IPv6-mapped address + port
+// (FF FF, IPv4, port), as returned by getRemoteServerSocketAddress().
+//
+// The first join through the browser still needs a memory scan to find an
+// entry. From there the surrounding array is indexed in one pass, so joins
+// and reconnects to any server that was listed are hash lookups.
+class ServerBrowserIndex {
+public:
+    struct Entry {
+        uintptr_t address = 0;      // start of the key in the browser array
+        std::string name;
+        std::string location;
+        int clientsMax = 0;
+    };
+
+    // Entry for `key`, if indexed and still at the same address
+    std::optional<Entry> find(const std::vector<uint8_t>& key);
+
+    // Index the browser array around an entry found by a memory scan
+    void build(uintptr_t foundAddress);
+
+    void clear();
+    size_t size() const;
+
+private:
+    static constexpr size_t KEY_SIZE = 8;
+    static constexpr size_t SEARCH_WINDOW = 256 * 1024;     // each side of the found entry
+
+    static std::optional<uint64_t> packKey(const uint8_t* key, size_t size);
+
+    mutable std::mutex mutex_;
+    std::unordered_map<uint64_t, Entry> entries_;
+    size_t stride_ = 0;     // 0 until the array layout has been inferred
+};
@@ -0,0 +1,107 @@
+
+// ServerRoster.cpp
+
+#include "pch.h"
+
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define ROSTER_USE_SSE2 1
+#endif
+
+#include "ServerRoster.h"
+#include "Arena.h"
+
+static_assert(SIZE_SERVER_CLIENTS_BLOCK == 64, "diffSlots compares 64-byte slots");
+
+// Compare slot by slot, four 16-byte lanes per slot
+uint64_t ServerRoster::diffSlots(const uint8_t* a, const uint8_t* b) {
+    uint64_t mask = 0;
+    for (size_t slot = 0; slot < SLOT_COUNT; ++slot) {
+        const uint8_t* pa = a + slot * SIZE_SERVER_CLIENTS_BLOCK;
+        const uint8_t* pb = b + slot * SIZE_SERVER_CLIENTS_BLOCK;
+
+#ifdef ROSTER_USE_SSE2
+        __m128i eq = _mm_and_si128(
+            _mm_and_si128(
+                _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pa)),
+                               _mm_loadu_si128(reinterpret_cast<const __m128i*>(pb))),
+                _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pa + 16)),
+                               _mm_loadu_si128(reinterpret_cast<const __m128i*>(pb + 16)))),
+            _mm_and_si128(
+                _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pa + 32)),
+                               _mm_loadu_si128(reinterpret_cast<const __m128i*>(pb + 32))),
+                _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pa + 48)),
+                               _mm_loadu_si128(reinterpret_cast<const __m128i*>(pb + 48)))));
+        bool changed = _mm_movemask_epi8(eq) != 0xFFFF;
+#else
+        bool changed = std::memcmp(pa, pb, SIZE_SERVER_CLIENTS_BLOCK) != 0;
+#endif
+        if (changed) {
+            mask |= (uint64_t{ 1 } << slot);
+        }
+    }
+    return mask;
+}
+
+// Compare names of the slots whose bytes changed
+bool ServerRoster::namesDiffer(const uint8_t* a, const uint8_t* b) {
+    uint64_t changed = diffSlots(a, b);
+    for (size_t slot = 0; changed != 0; ++slot, changed >>= 1) {
+        if (!(changed & 1)) continue;
+
+        const char* na = reinterpret_cast<const char*>(a + slot * SIZE_SERVER_CLIENTS_BLOCK);
+        const char* nb = reinterpret_cast<const char*>(b + slot * SIZE_SERVER_CLIENTS_BLOCK);
+        size_t la = strnlen(na, SIZE_SERVER_CLIENTS_BLOCK);
+        if (la != strnlen(nb, SIZE_SERVER_CLIENTS_BLOCK) || std::memcmp(na, nb, la) != 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Decode changed slots
+bool ServerRoster::update(const uint8_t* block, size_t size) {
+    if (size < SIZE_SERVER_CLIENTS) return false;
+
+    uint64_t changed = diffSlots(snapshot_.data(), block);
+    if (changed == 0) return false;
+
+    bool rosterChanged = false;
+    for (size_t slot = 0; slot < SLOT_COUNT; ++slot) {
+        if (!(changed & (uint64_t{ 1 } << slot))) continue;
+
+        const char* raw = reinterpret_cast<const char*>(block + slot * SIZE_SERVER_CLIENTS_BLOCK);
+        std::string name(raw, strnlen(raw, SIZE_SERVER_CLIENTS_BLOCK));
+        if (name != names_[slot]) {
+            names_[slot] = std::move(name);
+            rosterChanged = true;
+        }
+    }
+    std::memcpy(snapshot_.data(), block, SIZE_SERVER_CLIENTS);
+
+    if (rosterChanged) {
+        entries_.clear();
+        for (size_t slot = 0; slot < SLOT_COUNT; ++slot) {
+            if (!names_[slot].empty()) {
+                entries_.push_back({ static_cast<int>(slot), names_[slot] });
+            }
+        }
+    }
+    return rosterChanged;
+}
+
+void ServerRoster::copyEntries(View& out) const {
+    out.reserve(out.size() + entries_.size());
+    for (const auto& entry : entries_) {
+        out.push_back({ entry.slot, Arena::copy(entry.name) });
+    }
+}
+
+// Forget all slots
+void ServerRoster::clear() {
+    snapshot_.fill(0);
+    for (auto& name : names_) name.clear();
+    entries_.clear();
+}
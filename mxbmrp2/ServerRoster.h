@@ -0,0 +1,60 @@
+
+// ServerRoster.h
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Constants.h"
+
+// Decodes the server_clients block: one 64-byte slot per remote client,
+// empty slots are zeroed. Only the name at the start of each slot is
+// known; the rest of the slot layout (ping etc.) hasn't been mapped.
+class ServerRoster {
+public:
+    static constexpr size_t SLOT_COUNT = SIZE_SERVER_CLIENTS / SIZE_SERVER_CLIENTS_BLOCK;
+    static_assert(SLOT_COUNT <= 64, "slot mask must fit in 64 bits");
+
+    struct Entry {
+        int slot = 0;
+        std::string name;
+    };
+
+    // An entry copied out for one tick, see copyEntries
+    struct EntryView {
+        int slot = 0;
+        std::string_view name;
+    };
+    using View = std::pmr::vector<EntryView>;
+
+    // Bit i is set if slot i differs between the two blocks
+    static uint64_t diffSlots(const uint8_t* a, const uint8_t* b);
+
+    // True if any slot's name differs (other slot bytes are ignored)
+    static bool namesDiffer(const uint8_t* a, const uint8_t* b);
+
+    // Re-decode the slots that changed since the last update. Returns true if
+    // the decoded roster changed.
+    bool update(const uint8_t* block, size_t size);
+
+    void clear();
+
+    // Occupied slots, in slot order
+    const std::vector<Entry>& entries() const { return entries_; }
+
+    // Appends entries() to `out`, the names copied into the calling thread's Arena
+    void copyEntries(View& out) const;
+
+    // Remote clients plus the local player
+    int count() const { return static_cast<int>(entries_.size()) + 1; }
+
+private:
+    std::array<uint8_t, SIZE_SERVER_CLIENTS> snapshot_{};
+    std::array<std::string, SLOT_COUNT> names_;
+    std::vector<Entry> entries_;
+};
@@ -0,0 +1,68 @@
+
+// SpscQueue.h
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+// Bounded lock-free single-producer / single-consumer ring. Each side owns
+// one index and keeps a cached copy of the other's, so a push or pop only
+// touches the shared cache line when the cached view says full or empty.
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+        "Capacity must be a power of two");
+
+public:
+    SpscQueue() = default;
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    // Producer thread only. Returns false if the queue is full.
+    bool tryPush(const T& value) {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - headCache_ == Capacity) {
+            headCache_ = head_.load(std::memory_order_acquire);
+            if (tail - headCache_ == Capacity) return false;
+        }
+
+        slots_[tail & MASK] = value;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer thread only. The oldest element, or nullptr if empty; it
+    // stays valid until pop().
+    T* front() {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tailCache_) {
+            tailCache_ = tail_.load(std::memory_order_acquire);
+            if (head == tailCache_) return nullptr;
+        }
+        return &slots_[head & MASK];
+    }
+
+    // Consumer thread only, after front() returned an element
+    void pop() {
+        head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    bool empty() const {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+
+    static constexpr size_t capacity() { return Capacity; }
+
+private:
+    static constexpr size_t MASK = Capacity - 1;
+
+    std::array<T, Capacity> slots_;
+
+    alignas(64) std::atomic<size_t> tail_{ 0 };     // written by the producer
+    size_t headCache_ = 0;
+    alignas(64) std::atomic<size_t> head_{ 0 };     // written by the consumer
+    size_t tailCache_ = 0;
+};
@@ -0,0 +1,49 @@
+
+// SteadyState.h
+
+#pragma once
+
+#include <cstdint>
+
+// Marks work that repeats for as long as a session runs (the callback
+// handlers, the periodic tick) and must not allocate once warmed up.
+// Builds that define MXBMRP2_ALLOCATION_CHECKS (the simulator) count each
+// scope's allocations on the calling thread; in the plugin the macro
+// compiles to nothing.
+#ifdef MXBMRP2_ALLOCATION_CHECKS
+
+// Provided by whatever replaces the global operator new
+namespace AllocationCounter {
+    // operator new calls made by the calling thread so far
+    uint64_t threadAllocations();
+
+    // Called as each steady-state scope exits
+    void steadyStateScopeEnded(const char* scope, uint64_t allocations);
+}
+
+class SteadyStateScope {
+public:
+    explicit SteadyStateScope(const char* scope)
+        : scope_(scope), start_(AllocationCounter::threadAllocations()) {}
+
+    ~SteadyStateScope() {
+        AllocationCounter::steadyStateScopeEnded(scope_, AllocationCounter::threadAllocations() - start_);
+    }
+
+    SteadyStateScope(const SteadyStateScope&) = delete;
+    SteadyStateScope& operator=(const SteadyStateScope&) = delete;
+
+private:
+    const char* scope_;
+    uint64_t start_;
+};
+
+#define STEADY_STATE_CONCAT_(a, b) a##b
+#define STEADY_STATE_CONCAT(a, b) STEADY_STATE_CONCAT_(a, b)
+#define STEADY_STATE_SCOPE(scope) SteadyStateScope STEADY_STATE_CONCAT(steadyStateScope_, __LINE__)(scope)
+
+#else
+
+#define STEADY_STATE_SCOPE(scope) do {} while (0)
+
+#endif
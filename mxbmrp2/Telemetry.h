@@ -0,0 +1,41 @@
+
+// Telemetry.h
+
+#pragma once
+
+#include "MXB_interface.h"
+#include "BroadcastRing.h"
+#include "Constants.h"
+
+// One RunTelemetry call
+struct TelemetrySample {
+    SPluginsBikeData_t bike;
+    float time;         // seconds on track
+    float trackPos;     // position on the centerline, 0 to 1
+};
+
+// Written by the game thread, read by the HUD fields and exporters
+using TelemetryRing = BroadcastRing<TelemetrySample, TELEMETRY_RING_CAPACITY>;
+
+namespace Telemetry {
+    // Startup's return value for the fastest rate the game offers at or
+    // below `hz` (100, 50, 20 or 10 Hz), -1 for no telemetry
+    constexpr int rateCode(unsigned long hz) {
+        if (hz == 0) return -1;
+        if (hz >= 100) return 0;
+        if (hz >= 50) return 1;
+        if (hz >= 20) return 2;
+        return 3;
+    }
+
+    // Samples per second for one of Startup's return values
+    constexpr int rateHz(int code) {
+        switch (code) {
+        case 0: return 100;
+        case 1: return 50;
+        case 2: return 20;
+        case 3: return 10;
+        default: return 0;
+        }
+    }
+}
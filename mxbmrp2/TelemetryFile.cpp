@@ -0,0 +1,454 @@
+
+// TelemetryFile.cpp
+
+#include "pch.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "TelemetryFile.h"
+#include "Lz4.h"
+#include "Logger.h"
+
+namespace {
+    constexpr size_t NAME_SIZE = 100;
+    constexpr size_t HEADER_SIZE = sizeof(TelemetryFile::MAGIC) + 3 * sizeof(uint32_t) + sizeof(float) + 2 * NAME_SIZE;
+    constexpr size_t CHUNK_HEADER_SIZE = (1 + TelemetryFile::COLUMNS) * sizeof(uint32_t);
+    constexpr size_t TRAILER_SIZE = 2 * sizeof(uint64_t) + 2 * sizeof(uint32_t) + sizeof(TelemetryFile::TRAILER_MAGIC);
+    constexpr size_t COLUMN_BYTES = TelemetryFile::CHUNK_SAMPLES * sizeof(uint32_t);
+    constexpr size_t WRITE_BUFFER_SIZE = 64 * 1024;
+    constexpr uint32_t UNCOMPRESSED_COLUMN = 0x80000000;
+
+    // How each Row field is stored: as a fixed-point integer of `bytes`
+    // bytes (value * scale, rounded and clamped to the width), then as the
+    // difference from the previous sample. Quantized values move by small,
+    // repeating steps where the float bits would differ in every mantissa
+    // bit.
+    struct ColumnFormat {
+        bool isFloat;
+        double scale;
+        size_t bytes;
+        bool isSigned;
+    };
+    constexpr ColumnFormat FORMATS[TelemetryFile::COLUMNS] = {
+        { true,  1000.0,  4, true  },   // time, ms
+        { true,  100.0,   2, false },   // speed, cm/s up to 655 m/s
+        { false, 1.0,     2, false },   // rpm
+        { false, 1.0,     1, true  },   // gear
+        { true,  65535.0, 2, false },   // throttle, 16 bits
+        { true,  65535.0, 2, false },   // brake, 16 bits
+        { true,  1000.0,  4, true  },   // posX, mm
+        { true,  1000.0,  4, true  },   // posY, mm
+        { true,  1000.0,  4, true  },   // posZ, mm
+        { true,  1000.0,  4, true  },   // distance, mm
+    };
+
+    // Lowest and highest stored value of a column
+    int64_t minStored(const ColumnFormat& f) {
+        return f.isSigned ? -(int64_t{ 1 } << (8 * f.bytes - 1)) : 0;
+    }
+
+    int64_t maxStored(const ColumnFormat& f) {
+        return f.isSigned ? (int64_t{ 1 } << (8 * f.bytes - 1)) - 1 : (int64_t{ 1 } << (8 * f.bytes)) - 1;
+    }
+
+    // The low `bytes` bytes of v, sign-extended
+    int64_t signExtend(uint64_t v, size_t bytes) {
+        const unsigned shift = static_cast<unsigned>(64 - 8 * bytes);
+        return static_cast<int64_t>(v << shift) >> shift;
+    }
+
+    uint64_t widthMask(size_t bytes) {
+        return bytes == 8 ? ~uint64_t{ 0 } : (uint64_t{ 1 } << (8 * bytes)) - 1;
+    }
+
+    int64_t quantize(const TelemetryFile::Row& row, size_t column) {
+        const ColumnFormat& f = FORMATS[column];
+        const char* field = reinterpret_cast<const char*>(&row) + column * sizeof(uint32_t);
+        double value;
+        if (f.isFloat) {
+            float v;
+            std::memcpy(&v, field, sizeof(v));
+            value = std::isfinite(v) ? std::round(static_cast<double>(v) * f.scale) : 0.0;
+        }
+        else {
+            int32_t v;
+            std::memcpy(&v, field, sizeof(v));
+            value = v;
+        }
+        return static_cast<int64_t>(std::clamp<double>(value,
+            static_cast<double>(minStored(f)), static_cast<double>(maxStored(f))));
+    }
+
+    void dequantize(TelemetryFile::Row& row, size_t column, int64_t stored) {
+        const ColumnFormat& f = FORMATS[column];
+        char* field = reinterpret_cast<char*>(&row) + column * sizeof(uint32_t);
+        if (f.isFloat) {
+            const float v = static_cast<float>(static_cast<double>(stored) / f.scale);
+            std::memcpy(field, &v, sizeof(v));
+        }
+        else {
+            const int32_t v = static_cast<int32_t>(stored);
+            std::memcpy(field, &v, sizeof(v));
+        }
+    }
+
+    // The difference from the previous value, wrapped to the column width,
+    // with small negative steps as small positive numbers
+    uint64_t encodeDelta(int64_t value, int64_t prev, size_t bytes) {
+        const int64_t delta = signExtend(static_cast<uint64_t>(value - prev), bytes);
+        return ((static_cast<uint64_t>(delta) << 1) ^ static_cast<uint64_t>(delta >> 63)) & widthMask(bytes);
+    }
+
+    int64_t decodeDelta(uint64_t encoded, int64_t prev, const ColumnFormat& f) {
+        const int64_t delta = static_cast<int64_t>((encoded >> 1) ^ (0 - (encoded & 1)));
+        const uint64_t value = static_cast<uint64_t>(prev + delta) & widthMask(f.bytes);
+        return f.isSigned ? signExtend(value, f.bytes) : static_cast<int64_t>(value);
+    }
+
+    // Both targets are little-endian, so values are stored as they are in memory
+    template <typename T>
+    void put(char*& p, T value) {
+        std::memcpy(p, &value, sizeof(T));
+        p += sizeof(T);
+    }
+
+    template <typename T>
+    T get(const uint8_t*& p) {
+        T value;
+        std::memcpy(&value, p, sizeof(T));
+        p += sizeof(T);
+        return value;
+    }
+
+    void putName(char*& p, const std::string& name) {
+        std::memset(p, 0, NAME_SIZE);
+        std::memcpy(p, name.data(), std::min<size_t>(name.size(), NAME_SIZE - 1));
+        p += NAME_SIZE;
+    }
+
+    std::string getName(const uint8_t*& p) {
+        const char* s = reinterpret_cast<const char*>(p);
+        p += NAME_SIZE;
+        return std::string(s, strnlen(s, NAME_SIZE));
+    }
+}
+
+namespace TelemetryFile {
+
+    Row toRow(const TelemetrySample& sample, float trackLength) {
+        const SPluginsBikeData_t& bike = sample.bike;
+        return {
+            sample.time, bike.m_fSpeedometer, bike.m_iRPM, bike.m_iGear,
+            bike.m_fThrottle, bike.m_fFrontBrake,
+            bike.m_fPosX, bike.m_fPosY, bike.m_fPosZ,
+            sample.trackPos * trackLength
+        };
+    }
+
+    // Writer
+
+    Writer::Writer()
+        : rows_(std::make_unique<std::array<Row, CHUNK_SAMPLES>>()) {
+        planes_.resize(COLUMN_BYTES);
+        compressed_.reserve(COLUMN_BYTES + COLUMN_BYTES / 255 + 16);
+        laps_.reserve(256);
+    }
+
+    Writer::~Writer() {
+        close();
+    }
+
+    bool Writer::open(const std::filesystem::path& path, const Info& info) {
+        close();
+
+        // Set before opening, or the stream may ignore it
+        buffer_.resize(WRITE_BUFFER_SIZE);
+        out_.rdbuf()->pubsetbuf(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+        out_.open(path, std::ios::binary | std::ios::trunc);
+        if (!out_) {
+            LOG_ERROR(IO, "Unable to write telemetry recording: " + path.string());
+            return false;
+        }
+
+        char header[HEADER_SIZE];
+        char* p = header;
+        std::memcpy(p, MAGIC, sizeof(MAGIC));
+        p += sizeof(MAGIC);
+        put<uint32_t>(p, VERSION);
+        put<uint32_t>(p, static_cast<uint32_t>(CHUNK_SAMPLES));
+        put<uint32_t>(p, info.rateHz);
+        put<float>(p, info.trackLength);
+        putName(p, info.trackId);
+        putName(p, info.bikeId);
+        out_.write(header, sizeof(header));
+
+        rowCount_ = 0;
+        laps_.clear();
+        lapPending_ = true;
+        samples_ = 0;
+        offset_ = sizeof(header);
+        chunks_ = 0;
+        return true;
+    }
+
+    void Writer::beginLap() {
+        lapPending_ = true;
+    }
+
+    void Writer::append(const Row& row) {
+        if (!out_.is_open()) return;
+
+        if (lapPending_) {
+            if (!laps_.empty()) endLap(true, row.time);
+
+            LapEntry lap{};
+            lap.lap = static_cast<uint32_t>(laps_.size());
+            lap.firstSample = samples_;
+            lap.chunkOffset = offset_;
+            laps_.push_back(lap);
+            lapStartTime_ = row.time;
+            lapPending_ = false;
+        }
+
+        (*rows_)[rowCount_++] = row;
+        ++samples_;
+        if (rowCount_ == CHUNK_SAMPLES) {
+            writeChunk();
+        }
+    }
+
+    // Lap 0 starts wherever the run does, so only later laps ending at the line are timed
+    void Writer::endLap(bool atLine, float endTime) {
+        LapEntry& lap = laps_.back();
+        lap.samples = static_cast<uint32_t>(samples_ - lap.firstSample);
+        if (atLine && lap.lap > 0) {
+            lap.flags |= LAP_TIMED;
+            lap.lapTimeMs = static_cast<int32_t>(std::lround((endTime - lapStartTime_) * 1000.0f));
+        }
+    }
+
+    // Encode, split into byte planes and compress each column
+    void Writer::writeChunk() {
+        if (rowCount_ == 0) return;
+
+        char header[CHUNK_HEADER_SIZE];
+        char* sizes = header + sizeof(uint32_t);
+        {
+            char* p = header;
+            put<uint32_t>(p, static_cast<uint32_t>(rowCount_));
+        }
+
+        const size_t planeSize = rowCount_;
+        uint64_t chunkBytes = sizeof(header);
+        const std::streampos headerAt = out_.tellp();
+        out_.write(header, sizeof(header));
+
+        for (size_t column = 0; column < COLUMNS; ++column) {
+            const size_t bytes = FORMATS[column].bytes;
+            int64_t prev = 0;
+            for (size_t i = 0; i < rowCount_; ++i) {
+                const int64_t value = quantize((*rows_)[i], column);
+                const uint64_t encoded = encodeDelta(value, prev, bytes);
+                prev = value;
+                for (size_t b = 0; b < bytes; ++b) {
+                    planes_[b * planeSize + i] = static_cast<uint8_t>(encoded >> (8 * b));
+                }
+            }
+
+            const size_t rawSize = planeSize * bytes;
+            compressed_.clear();
+            uint32_t stored;
+            if (Lz4::compressBlock(planes_.data(), rawSize, compressed_)) {
+                out_.write(reinterpret_cast<const char*>(compressed_.data()), static_cast<std::streamsize>(compressed_.size()));
+                stored = static_cast<uint32_t>(compressed_.size());
+            }
+            else {
+                out_.write(reinterpret_cast<const char*>(planes_.data()), static_cast<std::streamsize>(rawSize));
+                stored = static_cast<uint32_t>(rawSize) | UNCOMPRESSED_COLUMN;
+            }
+            chunkBytes += stored & ~UNCOMPRESSED_COLUMN;
+            put<uint32_t>(sizes, stored);
+        }
+
+        // Sizes are only known now
+        out_.seekp(headerAt);
+        out_.write(header, sizeof(header));
+        out_.seekp(0, std::ios::end);
+
+        offset_ += chunkBytes;
+        ++chunks_;
+        rowCount_ = 0;
+    }
+
+    uint64_t Writer::close() {
+        if (!out_.is_open()) return 0;
+
+        if (!laps_.empty()) endLap(false, 0.0f);
+        writeChunk();
+
+        const uint64_t lapsOffset = offset_;
+        out_.write(reinterpret_cast<const char*>(laps_.data()), static_cast<std::streamsize>(laps_.size() * sizeof(LapEntry)));
+
+        char trailer[TRAILER_SIZE];
+        char* p = trailer;
+        put<uint64_t>(p, lapsOffset);
+        put<uint64_t>(p, samples_);
+        put<uint32_t>(p, static_cast<uint32_t>(laps_.size()));
+        put<uint32_t>(p, chunks_);
+        std::memcpy(p, TRAILER_MAGIC, sizeof(TRAILER_MAGIC));
+        out_.write(trailer, sizeof(trailer));
+
+        out_.close();
+        if (out_.fail()) {
+            LOG_ERROR(IO, "Telemetry recording may be incomplete, the write failed");
+        }
+        out_.clear();
+
+        const uint64_t samples = samples_;
+        samples_ = 0;
+        return samples;
+    }
+
+    // Reader
+
+    Reader::~Reader() {
+        close();
+    }
+
+    bool Reader::open(const std::filesystem::path& path) {
+        close();
+
+        file_ = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        LARGE_INTEGER size{};
+        if (file_ == INVALID_HANDLE_VALUE || !GetFileSizeEx(file_, &size) || size.QuadPart < static_cast<LONGLONG>(HEADER_SIZE + TRAILER_SIZE)) {
+            LOG_ERROR(IO, "Unable to open telemetry recording: " + path.string());
+            close();
+            return false;
+        }
+
+        mapping_ = CreateFileMappingW(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        data_ = mapping_ ? static_cast<const uint8_t*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+        if (!data_) {
+            LOG_ERROR(IO, "Unable to map telemetry recording: " + path.string());
+            close();
+            return false;
+        }
+        size_ = static_cast<uint64_t>(size.QuadPart);
+
+        const uint8_t* p = data_;
+        if (std::memcmp(p, MAGIC, sizeof(MAGIC)) != 0) {
+            LOG_ERROR(IO, "Not a telemetry recording: " + path.string());
+            close();
+            return false;
+        }
+        p += sizeof(MAGIC);
+        const uint32_t version = get<uint32_t>(p);
+        const uint32_t chunkSamples = get<uint32_t>(p);
+        if (version != VERSION || chunkSamples != CHUNK_SAMPLES) {
+            LOG_ERROR(IO, "Unsupported telemetry recording version " + std::to_string(version) + ": " + path.string());
+            close();
+            return false;
+        }
+        info_.rateHz = get<uint32_t>(p);
+        info_.trackLength = get<float>(p);
+        info_.trackId = getName(p);
+        info_.bikeId = getName(p);
+
+        p = data_ + size_ - TRAILER_SIZE;
+        const uint64_t lapsOffset = get<uint64_t>(p);
+        samples_ = get<uint64_t>(p);
+        const uint32_t lapCount = get<uint32_t>(p);
+        get<uint32_t>(p);
+        if (std::memcmp(p, TRAILER_MAGIC, sizeof(TRAILER_MAGIC)) != 0
+            || lapsOffset < HEADER_SIZE || lapsOffset + uint64_t{ lapCount } * sizeof(LapEntry) != size_ - TRAILER_SIZE) {
+            LOG_ERROR(IO, "Telemetry recording has no lap index (was the game closed mid-run?): " + path.string());
+            close();
+            return false;
+        }
+
+        laps_.resize(lapCount);
+        std::memcpy(laps_.data(), data_ + lapsOffset, lapCount * sizeof(LapEntry));
+        return true;
+    }
+
+    void Reader::close() {
+        if (data_) UnmapViewOfFile(data_);
+        if (mapping_) CloseHandle(mapping_);
+        if (file_ != INVALID_HANDLE_VALUE) CloseHandle(file_);
+        data_ = nullptr;
+        mapping_ = nullptr;
+        file_ = INVALID_HANDLE_VALUE;
+        size_ = 0;
+        samples_ = 0;
+        laps_.clear();
+    }
+
+    bool Reader::readLap(size_t lap, std::vector<Row>& rows) const {
+        rows.clear();
+        if (lap >= laps_.size()) return false;
+        const LapEntry& entry = laps_[lap];
+
+        // Every chunk but the last is full, so the lap starts this far into its first one
+        size_t skip = static_cast<size_t>(entry.firstSample % CHUNK_SAMPLES);
+        uint64_t offset = entry.chunkOffset;
+        std::vector<Row> chunk;
+
+        while (rows.size() < entry.samples) {
+            uint64_t next;
+            if (!decodeChunk(offset, chunk, next) || skip > chunk.size()) {
+                LOG_ERROR(IO, "Damaged telemetry chunk at offset " + std::to_string(offset));
+                return false;
+            }
+            const size_t take = std::min<size_t>(chunk.size() - skip, entry.samples - rows.size());
+            rows.insert(rows.end(), chunk.begin() + skip, chunk.begin() + skip + take);
+            skip = 0;
+            offset = next;
+        }
+        return true;
+    }
+
+    bool Reader::decodeChunk(uint64_t offset, std::vector<Row>& rows, uint64_t& next) const {
+        if (offset + CHUNK_HEADER_SIZE > size_) return false;
+
+        const uint8_t* p = data_ + offset;
+        const uint32_t count = get<uint32_t>(p);
+        if (count == 0 || count > CHUNK_SAMPLES) return false;
+
+        rows.resize(count);
+        std::vector<uint8_t> planes(count * sizeof(uint32_t));
+        const uint8_t* column = data_ + offset + CHUNK_HEADER_SIZE;
+
+        for (size_t c = 0; c < COLUMNS; ++c) {
+            const ColumnFormat& format = FORMATS[c];
+            const size_t rawSize = count * format.bytes;
+            const uint32_t stored = get<uint32_t>(p);
+            const size_t size = stored & ~UNCOMPRESSED_COLUMN;
+            if (static_cast<uint64_t>(column - data_) + size > size_) return false;
+
+            if (stored & UNCOMPRESSED_COLUMN) {
+                if (size != rawSize) return false;
+                std::memcpy(planes.data(), column, size);
+            }
+            else if (!Lz4::decompressBlock(column, size, planes.data(), rawSize)) {
+                return false;
+            }
+            column += size;
+
+            int64_t prev = 0;
+            for (size_t i = 0; i < count; ++i) {
+                uint64_t encoded = 0;
+                for (size_t b = 0; b < format.bytes; ++b) {
+                    encoded |= static_cast<uint64_t>(planes[b * count + i]) << (8 * b);
+                }
+                prev = decodeDelta(encoded, prev, format);
+                dequantize(rows[i], c, prev);
+            }
+        }
+
+        next = static_cast<uint64_t>(column - data_);
+        return true;
+    }
+
+} // namespace TelemetryFile
@@ -0,0 +1,150 @@
+
+// TelemetryFile.h
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Telemetry.h"
+
+// Columnar recording of one run's telemetry, written as it is ridden and
+// read back a lap at a time.
+//
+// Samples are grouped into chunks of CHUNK_SAMPLES. Within a chunk each
+// column is narrowed to a fixed-point integer of one to four bytes (see
+// Row), stored as the difference from the previous sample, split into byte
+// planes so the mostly-zero high bytes line up, and compressed as one LZ4
+// block. The first sample of a chunk is encoded against zero, so every
+// chunk decodes on its own.
+//
+// Layout, little-endian:
+//   header   char[8] "MXBTEL\0\0", uint32 version, uint32 chunk samples,
+//            uint32 rate (Hz), float track length (m), char[100] track ID,
+//            char[100] bike ID
+//   chunk    uint32 samples, uint32 size of each column (top bit set if
+//            stored uncompressed), column data
+//   laps     LapEntry per lap
+//   trailer  uint64 offset of the laps, uint64 samples, uint32 laps,
+//            uint32 chunks, char[8] "MXBTELIX"
+//
+// The lap index is only written when the run ends; a file without one
+// (the game crashed) is rejected.
+namespace TelemetryFile {
+
+    inline constexpr char MAGIC[8] = { 'M', 'X', 'B', 'T', 'E', 'L', '\0', '\0' };
+    inline constexpr char TRAILER_MAGIC[8] = { 'M', 'X', 'B', 'T', 'E', 'L', 'I', 'X' };
+    inline constexpr uint32_t VERSION = 2;
+    inline constexpr size_t CHUNK_SAMPLES = 4096;   // 41 s at 100 Hz
+
+    // One sample as recorded, and the precision it is stored with
+    struct Row {
+        float time;                 // seconds on track, to the millisecond
+        float speed;                // meters/second, to 0.01 (16 bits)
+        int32_t rpm;                // 16 bits
+        int32_t gear;               // 0 = neutral (8 bits)
+        float throttle;             // 0 to 1 (16 bits)
+        float brake;                // front, 0 to 1 (16 bits)
+        float posX, posY, posZ;     // world position, to the millimeter
+        float distance;             // meters along the centerline, to the millimeter
+    };
+
+    inline constexpr size_t COLUMNS = sizeof(Row) / sizeof(uint32_t);
+
+    Row toRow(const TelemetrySample& sample, float trackLength);
+
+    struct Info {
+        std::string trackId;
+        std::string bikeId;
+        float trackLength = 0.0f;
+        uint32_t rateHz = 0;
+    };
+
+    // Where a lap is in the file. Lap 0 starts when the run does; the
+    // others start as the bike crosses the line.
+    struct LapEntry {
+        uint32_t lap;
+        uint32_t flags;
+        uint64_t firstSample;
+        uint64_t chunkOffset;       // file offset of the chunk holding firstSample
+        uint32_t samples;
+        int32_t lapTimeMs;          // from the sample times, 0 unless timed
+    };
+    static_assert(sizeof(LapEntry) == 32);
+
+    inline constexpr uint32_t LAP_TIMED = 1;     // started and ended at the line
+
+    class Writer {
+    public:
+        Writer();
+        ~Writer();
+        Writer(const Writer&) = delete;
+        Writer& operator=(const Writer&) = delete;
+
+        bool open(const std::filesystem::path& path, const Info& info);
+        bool isOpen() const { return out_.is_open(); }
+
+        // The next row appended starts a lap
+        void beginLap();
+        void append(const Row& row);
+
+        // Writes the last chunk and the lap index, returns the number of samples
+        uint64_t close();
+
+    private:
+        void endLap(bool atLine, float endTime);
+        void writeChunk();
+
+        std::ofstream out_;
+        std::vector<char> buffer_;
+        std::unique_ptr<std::array<Row, CHUNK_SAMPLES>> rows_;
+        size_t rowCount_ = 0;
+        std::vector<uint8_t> planes_;
+        std::vector<uint8_t> compressed_;
+
+        std::vector<LapEntry> laps_;
+        bool lapPending_ = false;
+        float lapStartTime_ = 0.0f;
+        uint64_t samples_ = 0;
+        uint64_t offset_ = 0;           // bytes written so far
+        uint32_t chunks_ = 0;
+    };
+
+    // Maps a finished recording and decodes the chunks a lap spans
+    class Reader {
+    public:
+        Reader() = default;
+        ~Reader();
+        Reader(const Reader&) = delete;
+        Reader& operator=(const Reader&) = delete;
+
+        bool open(const std::filesystem::path& path);
+        void close();
+
+        const Info& info() const { return info_; }
+        uint64_t samples() const { return samples_; }
+        uint64_t fileSize() const { return size_; }
+        const std::vector<LapEntry>& laps() const { return laps_; }
+
+        // Every row of `lap`, false if the file is damaged
+        bool readLap(size_t lap, std::vector<Row>& rows) const;
+
+    private:
+        bool decodeChunk(uint64_t offset, std::vector<Row>& rows, uint64_t& next) const;
+
+        HANDLE file_ = INVALID_HANDLE_VALUE;
+        HANDLE mapping_ = nullptr;
+        const uint8_t* data_ = nullptr;
+        uint64_t size_ = 0;
+
+        Info info_;
+        uint64_t samples_ = 0;
+        std::vector<LapEntry> laps_;
+    };
+
+} // namespace TelemetryFile
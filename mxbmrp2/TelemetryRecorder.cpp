@@ -0,0 +1,163 @@
+
+// TelemetryRecorder.cpp
+
+#include "pch.h"
+
+#include <chrono>
+#include <cstring>
+#include <ctime>
+
+#include "TelemetryRecorder.h"
+#include "Constants.h"
+#include "Logger.h"
+#include "Metrics.h"
+#include "Tracer.h"
+#include "SteadyState.h"
+
+namespace {
+    // e.g. 2025-06-21_18-04-09_sim_track_sim_bike.mxbtel
+    std::filesystem::path recordingName(const TelemetryFile::Info& info) {
+        const std::time_t t = std::time(nullptr);
+        std::tm tm{};
+        localtime_s(&tm, &t);
+        char stamp[32];
+        std::strftime(stamp, sizeof(stamp), "%Y-%m-%d_%H-%M-%S", &tm);
+
+        std::string name = std::string(stamp) + "_" + info.trackId + "_" + info.bikeId;
+        for (char& c : name) {
+            if (std::strchr("<>:\"/\\|?*", c) || static_cast<unsigned char>(c) < 32) c = '_';
+        }
+        return name + TELEMETRY_FILE_EXTENSION;
+    }
+}
+
+TelemetryRecorder::TelemetryRecorder(const TelemetryRing& ring)
+    : ring_(ring), reader_(ring) {
+    requests_.reserve(8);
+    applying_.reserve(8);
+}
+
+TelemetryRecorder::~TelemetryRecorder() {
+    stop();
+}
+
+// Start the recorder thread
+void TelemetryRecorder::start(const std::filesystem::path& dir, int rateHz) {
+    std::lock_guard<std::mutex> lk(mutex_);
+    if (running_) return;
+
+    dir_ = dir;
+    rateHz_ = rateHz;
+    std::error_code ec;
+    std::filesystem::create_directories(dir_, ec);
+
+    reader_ = TelemetryRing::Reader(ring_);
+    running_ = true;
+    thread_ = std::thread(&TelemetryRecorder::run, this);
+    LOG_INFO(IO, "Recording telemetry to " + dir_.string());
+}
+
+// Record what's left and finish the open recording
+void TelemetryRecorder::stop() {
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        if (!running_) return;
+        running_ = false;
+    }
+    cv_.notify_one();
+
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void TelemetryRecorder::beginRun(const std::string& trackId, const std::string& bikeId, float trackLength) {
+    std::lock_guard<std::mutex> lk(mutex_);
+    if (!running_) return;
+    requests_.push_back({ ring_.written(), true, { trackId, bikeId, trackLength, static_cast<uint32_t>(rateHz_) } });
+}
+
+void TelemetryRecorder::endRun() {
+    std::lock_guard<std::mutex> lk(mutex_);
+    if (!running_) return;
+    requests_.push_back({ ring_.written(), false, {} });
+}
+
+// Recorder loop
+void TelemetryRecorder::run() {
+    Tracer::getInstance().nameThread("Telemetry recorder");
+
+    std::unique_lock<std::mutex> lk(mutex_);
+    while (running_) {
+        lk.unlock();
+        drain();
+        lk.lock();
+        cv_.wait_for(lk, std::chrono::milliseconds(TELEMETRY_RECORD_INTERVAL), [this] { return !running_; });
+    }
+    lk.unlock();
+
+    drain();
+    apply({ ring_.written(), false, {} });
+}
+
+// Record every sample pushed since the last call, starting and ending runs
+// at the samples they were requested at
+void TelemetryRecorder::drain() {
+    TRACE_SCOPE("telemetry", "drain");
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        applying_.swap(requests_);
+    }
+
+    const uint64_t skippedBefore = reader_.skipped();
+    TelemetrySample sample;
+    for (const Request& request : applying_) {
+        while (reader_.position() < request.atSample && reader_.next(sample)) {
+            record(sample);
+        }
+        apply(request);
+    }
+    applying_.clear();
+
+    {
+        STEADY_STATE_SCOPE("recorder");
+        while (reader_.next(sample)) {
+            record(sample);
+        }
+    }
+
+    if (reader_.skipped() != skippedBefore) {
+        Metrics::getInstance().add(Counter::TelemetrySkipped, reader_.skipped() - skippedBefore);
+    }
+}
+
+void TelemetryRecorder::record(const TelemetrySample& sample) {
+    if (!writer_.isOpen()) return;
+
+    // Position on the centerline wraps from 1 to 0 at the line
+    if (lastTrackPos_ >= 0.0f && sample.trackPos + 0.5f < lastTrackPos_) {
+        writer_.beginLap();
+    }
+    lastTrackPos_ = sample.trackPos;
+    writer_.append(TelemetryFile::toRow(sample, trackLength_));
+}
+
+void TelemetryRecorder::apply(const Request& request) {
+    if (writer_.isOpen()) {
+        const uint64_t samples = writer_.close();
+        if (samples > 0) {
+            LOG_INFO(IO, "Recorded " + std::to_string(samples) + " telemetry samples to " + path_.string());
+        }
+        else {
+            // In and out of the pits without riding
+            std::error_code ec;
+            std::filesystem::remove(path_, ec);
+        }
+    }
+    if (!request.begin) return;
+
+    path_ = dir_ / recordingName(request.info);
+    trackLength_ = request.info.trackLength;
+    lastTrackPos_ = -1.0f;
+    writer_.open(path_, request.info);
+}
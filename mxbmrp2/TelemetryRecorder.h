@@ -0,0 +1,68 @@
+
+// TelemetryRecorder.h
+
+#pragma once
+
+#include <condition_variable>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Telemetry.h"
+#include "TelemetryFile.h"
+
+// Records each run's telemetry to its own TelemetryFile, on a thread that
+// follows the telemetry ring. Memory stays bounded: one chunk being filled
+// plus the ring itself; if the thread falls more than the ring behind,
+// samples are skipped and counted as telemetry_skipped.
+//
+// Runs are started and ended from the callback handlers. Each request is
+// tied to the number of samples pushed when it was made, so samples from
+// before a run don't end up in it however late the thread gets to them.
+class TelemetryRecorder {
+public:
+    explicit TelemetryRecorder(const TelemetryRing& ring);
+    ~TelemetryRecorder();
+
+    TelemetryRecorder(const TelemetryRecorder&) = delete;
+    TelemetryRecorder& operator=(const TelemetryRecorder&) = delete;
+
+    // Recordings go to `dir`, one file per run
+    void start(const std::filesystem::path& dir, int rateHz);
+    void stop();    // finishes the open recording
+
+    void beginRun(const std::string& trackId, const std::string& bikeId, float trackLength);
+    void endRun();
+
+private:
+    struct Request {
+        uint64_t atSample;
+        bool begin;
+        TelemetryFile::Info info;
+    };
+
+    void run();
+    void drain();
+    void record(const TelemetrySample& sample);
+    void apply(const Request& request);
+
+    const TelemetryRing& ring_;
+    TelemetryRing::Reader reader_;
+
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool running_ = false;
+    std::vector<Request> requests_;     // guarded by mutex_
+
+    // Recorder thread only
+    std::filesystem::path dir_;
+    int rateHz_ = 0;
+    std::vector<Request> applying_;
+    TelemetryFile::Writer writer_;
+    std::filesystem::path path_;
+    float trackLength_ = 0.0f;
+    float lastTrackPos_ = -1.0f;
+};
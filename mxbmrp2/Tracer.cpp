@@ -0,0 +1,113 @@
+
+// Tracer.cpp
+
+#include "pch.h"
+
+#include <fstream>
+
+#include "Tracer.h"
+#include "Logger.h"
+
+// Singleton instance
+Tracer& Tracer::getInstance() {
+    static Tracer instance;
+    return instance;
+}
+
+// Constructor
+Tracer::Tracer()
+    : epoch_(std::chrono::steady_clock::now()) {
+}
+
+// Turn recording on or off
+void Tracer::setEnabled(bool enabled) {
+    enabled_.store(enabled, std::memory_order_relaxed);
+}
+
+// Label the calling thread
+void Tracer::nameThread(const char* name) {
+    if (!isEnabled()) return;
+    localBuffer().name.store(name, std::memory_order_relaxed);
+}
+
+void Tracer::begin(const char* category, const char* name) {
+    record(category, name, 'B');
+}
+
+void Tracer::end(const char* category, const char* name) {
+    record(category, name, 'E');
+}
+
+// The calling thread's ring, created on its first event
+Tracer::ThreadBuffer& Tracer::localBuffer() {
+    thread_local ThreadBuffer* buffer = nullptr;
+    if (!buffer) {
+        auto created = std::make_unique<ThreadBuffer>();
+        created->threadId = static_cast<uint32_t>(GetCurrentThreadId());
+        created->events = std::make_unique<Event[]>(EVENTS_PER_THREAD);
+        buffer = created.get();
+
+        std::lock_guard<std::mutex> lk(buffersMutex_);
+        buffers_.push_back(std::move(created));
+    }
+    return *buffer;
+}
+
+// Append one event, overwriting the oldest once the ring is full
+void Tracer::record(const char* category, const char* name, char phase) {
+    ThreadBuffer& buffer = localBuffer();
+    const int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - epoch_).count();
+
+    const uint64_t head = buffer.head.load(std::memory_order_relaxed);
+    buffer.events[head & (EVENTS_PER_THREAD - 1)] = { category, name, now, phase };
+    buffer.head.store(head + 1, std::memory_order_release);
+}
+
+// Write all rings as trace-event JSON
+size_t Tracer::write(const std::filesystem::path& path) {
+    std::ofstream out(path, std::ios::trunc);
+    if (!out) {
+        LOG_ERROR(IO, "Unable to write trace: " + path.string());
+        return 0;
+    }
+
+    std::lock_guard<std::mutex> lk(buffersMutex_);
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+    size_t written = 0;
+    auto separator = [&]() -> const char* { return written++ ? ",\n" : ""; };
+
+    for (const auto& buffer : buffers_) {
+        if (const char* name = buffer->name.load(std::memory_order_relaxed)) {
+            out << separator()
+                << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->threadId
+                << ",\"args\":{\"name\":\"" << name << "\"}}";
+        }
+
+        uint64_t head = buffer->head.load(std::memory_order_acquire);
+        uint64_t first = head > EVENTS_PER_THREAD ? head - EVENTS_PER_THREAD : 0;
+        std::vector<Event> events;
+        events.reserve(static_cast<size_t>(head - first));
+        for (uint64_t i = first; i < head; ++i) {
+            events.push_back(buffer->events[i & (EVENTS_PER_THREAD - 1)]);
+        }
+
+        // If the thread is still recording, skip slots it overwrote during the copy
+        uint64_t headAfter = buffer->head.load(std::memory_order_acquire);
+        size_t skip = headAfter - first > EVENTS_PER_THREAD
+            ? static_cast<size_t>(headAfter - first - EVENTS_PER_THREAD) : 0;
+
+        for (size_t i = skip; i < events.size(); ++i) {
+            const Event& e = events[i];
+            out << separator()
+                << "{\"name\":\"" << e.name << "\",\"cat\":\"" << e.category
+                << "\",\"ph\":\"" << e.phase << "\",\"pid\":1,\"tid\":" << buffer->threadId
+                << ",\"ts\":" << e.timeNs / 1000 << '.' << static_cast<char>('0' + e.timeNs % 1000 / 100)
+                << static_cast<char>('0' + e.timeNs % 100 / 10) << static_cast<char>('0' + e.timeNs % 10) << '}';
+        }
+    }
+
+    out << "\n]}\n";
+    return written;
+}
@@ -0,0 +1,90 @@
+
+// Tracer.h
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Opt-in timeline of plugin work, written as Chrome trace-event JSON for
+// chrome://tracing or ui.perfetto.dev. Every thread records begin/end
+// events into its own ring, so recording takes no locks; only the most
+// recent EVENTS_PER_THREAD events of each thread are kept.
+class Tracer {
+public:
+    static Tracer& getInstance();
+
+    void setEnabled(bool enabled);
+    bool isEnabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+    // Label the calling thread in the timeline
+    void nameThread(const char* name);
+
+    // `category` and `name` must be string literals (they are stored as pointers)
+    void begin(const char* category, const char* name);
+    void end(const char* category, const char* name);
+
+    // Write everything recorded so far. Returns the number of events written.
+    size_t write(const std::filesystem::path& path);
+
+private:
+    static constexpr size_t EVENTS_PER_THREAD = size_t{ 1 } << 16;
+
+    struct Event {
+        const char* category;
+        const char* name;
+        int64_t timeNs;     // since epoch_
+        char phase;         // 'B' or 'E'
+    };
+
+    // Written only by its own thread; read by write()
+    struct ThreadBuffer {
+        uint32_t threadId = 0;
+        std::atomic<const char*> name{ nullptr };
+        std::unique_ptr<Event[]> events;
+        std::atomic<uint64_t> head{ 0 };
+    };
+
+    Tracer();
+    Tracer(const Tracer&) = delete;
+    Tracer& operator=(const Tracer&) = delete;
+
+    ThreadBuffer& localBuffer();
+    void record(const char* category, const char* name, char phase);
+
+    std::atomic<bool> enabled_{ false };
+    const std::chrono::steady_clock::time_point epoch_;
+
+    std::mutex buffersMutex_;   // taken once per thread, on its first event
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers_;
+};
+
+// Records a begin event now and the matching end event at scope exit
+class TraceScope {
+public:
+    TraceScope(const char* category, const char* name)
+        : category_(category), name_(name), active_(Tracer::getInstance().isEnabled()) {
+        if (active_) Tracer::getInstance().begin(category_, name_);
+    }
+
+    ~TraceScope() {
+        if (active_) Tracer::getInstance().end(category_, name_);
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* category_;
+    const char* name_;
+    bool active_;
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(category, name) TraceScope TRACE_CONCAT(traceScope_, __LINE__)(category, name)
@@ -7,14 +7,15 @@
 #include <fstream>
 
 #include "Constants.h"
-#include "HTMLWriter.h"
+#include "htmlWriter.h"
+#include "Arena.h"
 #include "ConfigManager.h"
+#include "Tracer.h"
+#include "Metrics.h"
 
 namespace {
-    // Escape XML special characters
-    std::string escapeXml(std::string_view s) {
-        std::string out;
-        out.reserve(s.size());
+    // Append `s` with XML special characters escaped
+    void appendEscaped(std::pmr::string& out, std::string_view s) {
         for (char c : s) {
             switch (c) {
             case '&':  out += "&amp;"; break;
@@ -25,20 +26,20 @@ namespace {
             default:    out += c;
             }
         }
-        return out;
     }
 }
 
 namespace HtmlWriter {
 
     // Build the HTML page
-    std::string renderHtml(
-        const std::unordered_map<std::string, std::string>& all,
+    std::pmr::string renderHtml(
+        const std::pmr::unordered_map<std::string_view, std::string_view>& all,
         const std::vector<std::pair<std::string, std::string>>& order,
-        ConfigManager& cfg)
+        ConfigManager& cfg,
+        const ServerRoster::View& roster)
     {
-        std::ostringstream body;
-        body << "<div class=\"data\">\n";
+        std::pmr::string body(Arena::resource());
+        body += "<div class=\"data\">\n";
 
         bool hasRealData = false;   // ignored if we only have the banner
 
@@ -50,33 +51,47 @@ namespace HtmlWriter {
             if (key != "plugin_banner")
                 hasRealData = true;
 
-            body << "  <div class=\"data__item " << key << "\">\n";
+            body.append("  <div class=\"data__item ").append(key).append("\">\n");
 
             if (key == "plugin_banner") {
-                body << "    <span class=\"data__value " << key << "\">"
-                    << escapeXml(it->second) << "</span>\n";
+                body.append("    <span class=\"data__value ").append(key).append("\">");
+                appendEscaped(body, it->second);
+                body += "</span>\n";
             }
             else {
-                body << "    <span class=\"data__label " << key << "\">"
-                    << escapeXml(displayName) << " </span>\n"
-                    << "    <span class=\"data__value " << key << "\">"
-                    << escapeXml(it->second) << "</span>\n";
+                body.append("    <span class=\"data__label ").append(key).append("\">");
+                appendEscaped(body, displayName);
+                body.append(" </span>\n")
+                    .append("    <span class=\"data__value ").append(key).append("\">");
+                appendEscaped(body, it->second);
+                body += "</span>\n";
+            }
+            body += "  </div>\n";
+        }
+
+        // Remote clients, listed along with server_clients
+        if (!roster.empty() && cfg.getValue<bool>("server_clients")) {
+            body += "  <ul class=\"data__list server_roster\">\n";
+            for (const auto& entry : roster) {
+                body += "    <li>";
+                appendEscaped(body, entry.name);
+                body += "</li>\n";
             }
-            body << "  </div>\n";
+            body += "  </ul>\n";
         }
 
         // If we only have the banner, add a placeholder line
         if (!hasRealData) {
-            body << "  <span class=\"data__value no_data\">No data</span>\n";
+            body += "  <span class=\"data__value no_data\">No data</span>\n";
         }
 
-        body << "</div>\n";
+        body += "</div>\n";
 
         // Splice into the shared template
-        std::string out = HTML_TEMPLATE;
+        std::pmr::string out(HTML_TEMPLATE, Arena::resource());
 
         // replace BODY
-        out.replace(out.find("{{BODY}}"), 8, body.str());
+        out.replace(out.find("{{BODY}}"), 8, body);
 
         // replace INTERVAL
         out.replace(out.find("{{INTERVAL}}"), 12, std::to_string(PERIODIC_TASK_INTERVAL));
@@ -101,8 +116,9 @@ namespace HtmlWriter {
         return out;
     }
 
-    void atomicWrite(const std::filesystem::path& path, const std::string& data)
+    void atomicWrite(const std::filesystem::path& path, std::string_view data)
     {
+        TRACE_SCOPE("io", "HtmlWriter::atomicWrite");
         auto tmp = path;
         tmp += ".tmp";
 
@@ -111,6 +127,8 @@ namespace HtmlWriter {
         ofs.close();
 
         std::filesystem::rename(tmp, path);
+        Metrics::getInstance().add(Counter::HtmlWrites);
+        Metrics::getInstance().add(Counter::HtmlBytesWritten, data.size());
     }
 
 } // namespace HtmlWriter
@@ -3,27 +3,31 @@
 
 #pragma once
 
+#include <memory_resource>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 #include <filesystem>
 
-#include "configManager.h"
+#include "ConfigManager.h"
 #include "Constants.h"
+#include "ServerRoster.h"
 
 namespace HtmlWriter {
 
-    // Render the page
-    std::string renderHtml(
-        const std::unordered_map<std::string, std::string>& all,
+    // Render the page in the calling thread's Arena
+    std::pmr::string renderHtml(
+        const std::pmr::unordered_map<std::string_view, std::string_view>& all,
         const std::vector<std::pair<std::string, std::string>>& order,
-        ConfigManager& cfg);
+        ConfigManager& cfg,
+        const ServerRoster::View& roster = {});
 
     // "No data" placeholder
     std::string renderNoData();
 
     // Write data to disk
     void atomicWrite(const std::filesystem::path& path,
-        const std::string& data);
+        std::string_view data);
 
 }
@@ -43,13 +43,13 @@ void KeyPressHandler::messageLoop() {
     // 3) Register the hotkey
     const UINT hotkeyId = 0xBEEF;
     if (!RegisterHotKey(nullptr, hotkeyId, MOD_CONTROL, hotkey_)) {
-        Logger::getInstance().log(
+        LOG_ERROR(General,
             std::string("Failed to register hotkey: CTRL + ")
             + static_cast<char>(hotkey_)
         );
     }
     else {
-        Logger::getInstance().log(
+        LOG_INFO(General,
             std::string("KeyPressHandler thread started with hotkey: CTRL + ")
             + static_cast<char>(hotkey_)
         );
@@ -83,5 +83,5 @@ void KeyPressHandler::messageLoop() {
     }
 
     UnregisterHotKey(nullptr, hotkeyId);
-    Logger::getInstance().log("KeyPressHandler thread stopped");
+    LOG_INFO(General, "KeyPressHandler thread stopped");
 }
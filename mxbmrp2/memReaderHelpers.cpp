@@ -3,141 +3,150 @@
 
 #include "pch.h"
 
+#include <sstream>
+
 #include "MemReaderHelpers.h"
 #include "MemReader.h"
 #include "ConfigManager.h"
 #include "Constants.h"
 
 namespace {
-    auto& configManager = ConfigManager::getInstance();
     auto& memReader = MemReader::getInstance();
-}
 
-namespace MemReaderHelpers {
-
-    // Generic helper: read raw bytes, find first 0x00, return string up to that point
-    std::string readNullTermString(
-        bool relative,
-        std::uintptr_t offset,
-        std::size_t size,
-        const char* callerName
-    ) {
-        // New reader returns an empty vector on error
-        auto raw = memReader.readRawBytesAtAddress(relative, offset, size, callerName);
-        if (raw.empty()) {
-            return {};  // failed or zero-length
+    // Append a byte buffer as a hex string
+    void appendHex(std::string& out, const uint8_t* data, size_t size) {
+        static constexpr char DIGITS[] = "0123456789ABCDEF";
+        size_t pos = out.size();
+        out.resize(pos + size * 2);
+        for (size_t i = 0; i < size; ++i) {
+            out[pos++] = DIGITS[data[i] >> 4];
+            out[pos++] = DIGITS[data[i] & 0x0F];
         }
-
-        auto term = std::find(raw.begin(), raw.end(), 0);
-        return std::string(raw.begin(), term);
     }
+}
+
+namespace MemReaderHelpers {
 
     // getConnectURIString
     std::string getConnectURIString() {
-        return readNullTermString(
+        auto offset = memReader.getOffset(MemoryOffset::ConnectionString);
+        if (!offset) return {};
+
+        return readNullTermString<SIZE_CONNECTION_STRING>(
             true,
-            configManager.getValue<unsigned long>("connection_string_offset"),
-            SIZE_CONNECTION_STRING,
+            *offset,
             __func__
         );
     }
 
     // getLocalServerName
     std::string getLocalServerName() {
-        return readNullTermString(
+        auto offset = memReader.getOffset(MemoryOffset::LocalServerName);
+        if (!offset) return {};
+
+        return readNullTermString<SIZE_LOCAL_SERVER_NAME>(
             true,
-            configManager.getValue<unsigned long>("local_server_name_offset"),
-            SIZE_LOCAL_SERVER_NAME,
+            *offset,
             __func__
         );
     }
 
     // getServerCategories
     std::string getServerCategories() {
-        return readNullTermString(
+        auto offset = memReader.getOffset(MemoryOffset::ServerCategories);
+        if (!offset) return {};
+
+        return readNullTermString<SIZE_SERVER_CATEGORIES>(
             true,
-            configManager.getValue<unsigned long>("server_categories_offset"),
-            SIZE_SERVER_CATEGORIES,
+            *offset,
             __func__
         );
     }
 
     // getServerTrackID
     std::string getServerTrackID() {
-        return readNullTermString(
+        auto offset = memReader.getOffset(MemoryOffset::ServerTrackId);
+        if (!offset) return {};
+
+        return readNullTermString<SIZE_SERVER_TRACK_ID>(
             true,
-            configManager.getValue<unsigned long>("server_track_id_offset"),
-            SIZE_SERVER_TRACK_ID,
+            *offset,
             __func__
         );
     }
     // getLocalServerPassword
     std::string getLocalServerPassword() {
-        return readNullTermString(
+        auto offset = memReader.getOffset(MemoryOffset::LocalServerPassword);
+        if (!offset) return {};
+
+        return readNullTermString<SIZE_LOCAL_SERVER_PASSWORD>(
             true,
-            configManager.getValue<unsigned long>("local_server_password_offset"),
-            SIZE_LOCAL_SERVER_PASSWORD,
+            *offset,
             __func__
         );
     }
 
     // getLocalServerLocation
     std::string getLocalServerLocation() {
-        return readNullTermString(
+        auto offset = memReader.getOffset(MemoryOffset::LocalServerLocation);
+        if (!offset) return {};
+
+        return readNullTermString<SIZE_LOCAL_SERVER_LOCATION>(
             true,
-            configManager.getValue<unsigned long>("local_server_location_offset"),
-            SIZE_LOCAL_SERVER_LOCATION,
+            *offset,
             __func__
         );
     }
 
 	// getTrackDeformation
     std::string getTrackDeformation() {
-        auto raw = memReader.readRawBytesAtAddress(
+        auto offset = memReader.getOffset(MemoryOffset::TrackDeformation);
+        if (!offset) return {};
+
+        static_assert(SIZE_TRACK_DEFORMATION == sizeof(float));
+        auto v = memReader.read<float>(
             true,
-            configManager.getValue<unsigned long>("track_deformation_offset"),
-            SIZE_TRACK_DEFORMATION,
+            *offset,
             __func__
         );
 
-        if (raw.size() != sizeof(float))
+        if (!v)
             return "0.0";
 
-        float v;
-        std::memcpy(&v, raw.data(), sizeof(v));
-
         char buf[16];
         // Rounds to one decimal
-        std::snprintf(buf, sizeof(buf), "%.2f", v);
+        std::snprintf(buf, sizeof(buf), "%.2f", *v);
         return std::string(buf);
     }
 
     // getLocalServerClientsMax
     int getLocalServerClientsMax() {
-        // Read raw bytes directly at the module-relative offset
-        auto raw = memReader.readRawBytesAtAddress(
-            true,
-            configManager.getValue<unsigned long>("local_server_clients_max_offset"),
-            SIZE_LOCAL_SERVER_CLIENTS_MAX,
-            __func__
-        );
-
-        if (raw.empty()) {
-            return 0;
-        }
+        auto offset = memReader.getOffset(MemoryOffset::LocalServerClientsMax);
+        if (!offset) return 0;
 
         // The first byte is your client count
-        return raw[0];
+        static_assert(SIZE_LOCAL_SERVER_CLIENTS_MAX == sizeof(uint8_t));
+        return memReader.read<uint8_t>(
+            true,
+            *offset,
+            __func__
+        ).value_or(0);
     }
 
     // getRemoteServerSocketAddress
     ByteBuf getRemoteServerSocketAddress() {
-        ByteBuf raw = memReader.readRawBytesAtAddress(
+        auto offset = memReader.getOffset(MemoryOffset::RemoteServerSockaddr);
+        if (!offset) return {};
+
+        std::array<uint8_t, SIZE_REMOTE_SERVER_SOCKADDR> raw{};
+        if (!memReader.readInto(
             true,
-            configManager.getValue<unsigned long>("remote_server_sockaddr_offset"),
-            SIZE_REMOTE_SERVER_SOCKADDR,
-            __func__
-        );
+            *offset,
+            raw,
+            __func__))
+        {
+            return {};
+        }
 
         // All zeroes, not online
         if (std::all_of(raw.begin(), raw.end(), [](auto b) { return b == 0; })) {
@@ -146,7 +155,7 @@ namespace MemReaderHelpers {
 
         // Not implemented yet
         if (raw[22] != 0xFF || raw[23] != 0xFF) {
-            Logger::getInstance().log("Not an IPv6-mapped-IPv4 address. Won't be able do determine server name, etc!");
+            LOG_WARNING(Memory, "Not an IPv6-mapped-IPv4 address. Won't be able do determine server name, etc!");
             return {};
         }
 
@@ -166,9 +175,10 @@ namespace MemReaderHelpers {
 
     // getRemoteServerNameAndAddress
     std::tuple<uintptr_t, std::string>
-        getRemoteServerNameAndAddress(const ByteBuf& remoteIPv6Hex)
+        getRemoteServerNameAndAddress(const ByteBuf& remoteIPv6Hex, const std::atomic<bool>* cancel)
     {
-        if (remoteIPv6Hex.empty()) {
+        auto offset = memReader.getOffset(MemoryOffset::RemoteServerName);
+        if (remoteIPv6Hex.empty() || !offset) {
             return { 0, {} };
         }
 
@@ -178,7 +188,24 @@ namespace MemReaderHelpers {
         // invoke the new raw search
         return memReader.searchMemoryRaw(
             pattern,
-            configManager.getValue<unsigned long>("remote_server_name_offset"),
+            *offset,
+            SIZE_REMOTE_SERVER_NAME,
+            __func__,
+            cancel
+        );
+    }
+
+    // beginRemoteServerNameSearch
+    std::unique_ptr<MemoryScan> beginRemoteServerNameSearch(const ByteBuf& remoteIPv6Hex)
+    {
+        auto offset = memReader.getOffset(MemoryOffset::RemoteServerName);
+        if (remoteIPv6Hex.empty() || !offset) {
+            return nullptr;
+        }
+
+        return memReader.beginSearch(
+            remoteIPv6Hex,
+            *offset,
             SIZE_REMOTE_SERVER_NAME,
             __func__
         );
@@ -186,70 +213,82 @@ namespace MemReaderHelpers {
 
     // getRemoteServerPassword
     std::string getRemoteServerPassword() {
-        return readNullTermString(
+        auto offset = memReader.getOffset(MemoryOffset::RemoteServerPassword);
+        if (!offset) return {};
+
+        return readNullTermString<SIZE_REMOTE_SERVER_PASSWORD>(
             true,
-            configManager.getValue<unsigned long>("remote_server_password_offset"),
-            SIZE_REMOTE_SERVER_PASSWORD,
+            *offset,
             __func__
         );
     }
 
     // getRemoteServerLocation
     std::string getRemoteServerLocation(uintptr_t remoteIPv6MemoryAddress) {
-        return readNullTermString(
+        auto offset = memReader.getOffset(MemoryOffset::RemoteServerLocation);
+        if (!offset) return {};
+
+        return readNullTermString<SIZE_REMOTE_SERVER_LOCATION>(
             false,
-            configManager.getValue<unsigned long>("remote_server_location_offset") + remoteIPv6MemoryAddress,
-            SIZE_REMOTE_SERVER_LOCATION,
+            *offset + remoteIPv6MemoryAddress,
             __func__
         );
     }
 
     // getRemoteServerClientsMax
     int getRemoteServerClientsMax(uintptr_t remoteIPv6MemoryAddress) {
-        auto raw = memReader.readRawBytesAtAddress(
+        auto offset = memReader.getOffset(MemoryOffset::RemoteServerClientsMax);
+        if (!offset) return 0;
+
+        static_assert(SIZE_REMOTE_SERVER_CLIENTS_MAX == sizeof(uint8_t));
+        return memReader.read<uint8_t>(
             false,
-            configManager.getValue<unsigned long>("remote_server_clients_max_offset") + remoteIPv6MemoryAddress,
-            SIZE_REMOTE_SERVER_CLIENTS_MAX,
+            *offset + remoteIPv6MemoryAddress,
             __func__
-        );
-
-        if (raw.empty()) {
-            return 0;
-        }
-
-        return raw[0];
+        ).value_or(0);
     }
 
     // getRemoteServerPing
     std::string getRemoteServerPing() {
-        auto raw = memReader.readRawBytesAtAddress(
-            true,
-            configManager.getValue<unsigned long>("remote_server_ping_offset"),
-            SIZE_REMOTE_SERVER_PING
-        );
+        auto offset = memReader.getOffset(MemoryOffset::RemoteServerPing);
+        if (!offset) return {};
 
-        if (raw.empty()) {
+        static_assert(SIZE_REMOTE_SERVER_PING == sizeof(uint16_t));
+        auto ping = memReader.read<uint16_t>(true, *offset);
+
+        if (!ping) {
             return "?";
         }
 
-        uint16_t ping = static_cast<uint16_t>(raw[0]) | (static_cast<uint16_t>(raw[1]) << 8);
-        return std::to_string(ping) + " ms";
+        return formatRemoteServerPing(*ping);
+    }
+
+    // formatRemoteServerPing
+    std::string formatRemoteServerPing(uint16_t ping) {
+        // "65535 ms" fits the small-string buffer, so this doesn't allocate
+        char buf[16];
+        std::snprintf(buf, sizeof(buf), "%u ms", static_cast<unsigned>(ping));
+        return std::string(buf);
     }
 
     // getServerClientsCount
     int getServerClientsCount() {
-        auto raw = memReader.readRawBytesAtAddress(
-            true,
-            configManager.getValue<unsigned long>("server_clients_offset"),
-            SIZE_SERVER_CLIENTS
-        );
+        auto offset = memReader.getOffset(MemoryOffset::ServerClients);
+        if (!offset) return 0;
 
-        if (raw.empty()) {
+        std::array<uint8_t, SIZE_SERVER_CLIENTS> raw;
+        if (!memReader.readInto(true, *offset, raw))
+        {
             return 0;
         }
 
+        return countServerClients(raw.data(), raw.size());
+    }
+
+    // countServerClients
+    int countServerClients(const uint8_t* raw, size_t size) {
         int count = 1; // Local player is always present
-        for (size_t i = 0; i + SIZE_SERVER_CLIENTS_BLOCK <= raw.size(); i += SIZE_SERVER_CLIENTS_BLOCK) {
+        for (size_t i = 0; i + SIZE_SERVER_CLIENTS_BLOCK <= size; i += SIZE_SERVER_CLIENTS_BLOCK) {
             if (raw[i] != 0) {
                 ++count;
             }
@@ -259,21 +298,49 @@ namespace MemReaderHelpers {
 
     // getRemainingTearoffs
     std::string getRemainingTearoffs(const std::string& connectionType) {
+        auto offset = memReader.getOffset(getRemainingTearoffsOffset(connectionType));
+        if (!offset) return {};
 
-        std::string offset = (connectionType == "Client")
-            ? "remote_server_remaining_tearoffs_offset"
-            : "local_server_remaining_tearoffs_offset";
+        static_assert(SIZE_REMAINING_TEAROFFS == sizeof(uint8_t));
+        auto tearoffs = memReader.read<uint8_t>(true, *offset);
 
-        auto raw = memReader.readRawBytesAtAddress(
-            true,
-            configManager.getValue<unsigned long>(offset),
-            SIZE_REMAINING_TEAROFFS
-        );
-
-        if (raw.empty()) {
+        if (!tearoffs) {
             return {};
         }
 
-        return std::to_string(static_cast<int>(raw[0]));
+        return std::to_string(static_cast<int>(*tearoffs));
+    }
+
+    // getRemainingTearoffsOffset
+    MemoryOffset getRemainingTearoffsOffset(const std::string& connectionType) {
+        return (connectionType == "Client")
+            ? MemoryOffset::RemoteServerRemainingTearoffs
+            : MemoryOffset::LocalServerRemainingTearoffs;
+    }
+
+    // addressToHex
+    std::string addressToHex(uintptr_t address) {
+        std::ostringstream oss;
+        oss << "0x" << std::hex << std::uppercase << address;
+        return oss.str();
+    }
+
+    // Hex-dump message, only built once the logger has accepted it
+    std::string formatHexDump(
+        const char* fnName,
+        uintptr_t addr,
+        const uint8_t* data,
+        size_t size,
+        const char* suffix
+    ) {
+        std::string out = std::string(fnName) + "() @ " + addressToHex(addr)
+            + " [" + std::to_string(size) + " bytes]";
+        if (suffix) {
+            out += ' ';
+            out += suffix;
+        }
+        out += ": ";
+        appendHex(out, data, size);
+        return out;
     }
 }
@@ -6,9 +6,10 @@
 #include "Constants.h"
 #include "timeTracker.h"
 #include "Logger.h"
+#include "Tracer.h"
+#include "Metrics.h"
 
 #include <fstream>
-#include <iomanip>
 #include <sstream>
 #include <vector>
 #include <filesystem>
@@ -36,7 +37,7 @@ void TimeTracker::initialize(const std::filesystem::path& datPath) {
     std::lock_guard lk(_mtx);
     _datPath = datPath;
     load();
-    Logger::getInstance().log("TimeTracker initialized with file: " + _datPath.string());
+    LOG_INFO(IO, "TimeTracker initialized with file: " + _datPath.string());
 }
 
 void TimeTracker::load() {
@@ -77,7 +78,7 @@ void TimeTracker::load() {
     // Must at least have track & bike columns
     int track = idx("track"), bike = idx("bike");
     if (track < 0 || bike < 0) {
-        Logger::getInstance().log("TimeTracker: missing track/bike columns, skipping load.");
+        LOG_WARNING(IO, "TimeTracker: missing track/bike columns, skipping load.");
         return;
     }
 
@@ -160,7 +161,7 @@ void TimeTracker::load() {
             }
         }
         catch (const std::exception& e) {
-            Logger::getInstance().log(
+            LOG_RATE_LIMITED(LogLevel::Warning, IO, 1, 10,
                 "TimeTracker: skipped bad line: \"" + line2 + "\" (" + e.what() + ")");
             continue;
         }
@@ -206,36 +207,24 @@ void TimeTracker::resetSessionPB() {
     _sessionLapCount = 0;
 }
 
-// Helper to format seconds as "HHh MMm SSs"
-static std::string fmtHMS(Rep seconds) {
-    Rep h = seconds / 3600;
-    Rep m = (seconds % 3600) / 60;
-    Rep s = seconds % 60;
-    std::ostringstream oss;
-    oss << std::setfill('0')
-        << std::setw(2) << h << "h "
-        << std::setw(2) << m << "m "
-        << std::setw(2) << s << "s";
-
-    std::string str = oss.str();
-    // No one cares about seconds
-    return str.substr(0, str.size() - 4);
+// Helper to format seconds as "HHh MMm" (no one cares about seconds)
+static FixedString<15> fmtHMS(Rep seconds) {
+    FixedString<15> text;
+    text.appendNumber(seconds / 3600, 2).append("h ")
+        .appendNumber((seconds % 3600) / 60, 2).append('m');
+    return text;
 }
 
 // Helper to format milliseconds as "M:SS.mmm"
-static std::string formatMs(int milliseconds) {
-    int m = milliseconds / 60000;
-    int s = (milliseconds % 60000) / 1000;
-    int ms = milliseconds % 1000;
-    std::ostringstream oss;
-    oss
-        << m << ':'
-        << std::setw(2) << std::setfill('0') << s << '.'
-        << std::setw(3) << std::setfill('0') << ms;
-    return oss.str();
+static FixedString<15> formatMs(int milliseconds) {
+    FixedString<15> text;
+    text.appendNumber(milliseconds / 60000).append(':')
+        .appendNumber((milliseconds % 60000) / 1000, 2).append('.')
+        .appendNumber(milliseconds % 1000, 3);
+    return text;
 }
 
-std::string TimeTracker::getComboTime() const {
+FixedString<15> TimeTracker::getComboTime() const {
     std::lock_guard lk(_mtx);
     Rep base = 0;
     if (auto it = _comboTotals.find(_activeKey); it != _comboTotals.end())
@@ -245,7 +234,7 @@ std::string TimeTracker::getComboTime() const {
     return fmtHMS(base);
 }
 
-std::string TimeTracker::getTotalTime() const {
+FixedString<15> TimeTracker::getTotalTime() const {
     std::lock_guard lk(_mtx);
     Rep secs = _total.count();
     if (_isRunning)
@@ -253,13 +242,14 @@ std::string TimeTracker::getTotalTime() const {
     return fmtHMS(secs);
 }
 
-void TimeTracker::recordLap(const std::string& trackID, const std::string& bikeID, int lapTimeMs, const std::vector<int>& cumulativeSplitsMs) {
+bool TimeTracker::recordLap(const std::string& trackID, const std::string& bikeID, int lapTimeMs, const std::vector<int>& cumulativeSplitsMs) {
     std::lock_guard lk(_mtx);
-    ComboKey key{ trackID, bikeID };
-    if (!_isRunning || key != _activeKey) return;
+    if (!_isRunning || trackID != _activeKey.track || bikeID != _activeKey.bike) return false;
+    const ComboKey& key = _activeKey;
 
     // Session PB
-    if (_sessionBestLapMs == (std::numeric_limits<int>::max)() || lapTimeMs < _sessionBestLapMs) {
+    const bool sessionBest = _sessionBestLapMs == (std::numeric_limits<int>::max)() || lapTimeMs < _sessionBestLapMs;
+    if (sessionBest) {
         _sessionBestLapMs = lapTimeMs;
     }
 
@@ -297,36 +287,64 @@ void TimeTracker::recordLap(const std::string& trackID, const std::string& bikeI
     // Laps
     _alltimeLapCount[key] += 1;
     _sessionLapCount += 1;
+    return sessionBest;
 }
 
-std::string TimeTracker::getSessionPB() const {
+FixedString<15> TimeTracker::getSessionPB() const {
     std::lock_guard lk(_mtx);
-    if (_sessionBestLapMs == (std::numeric_limits<int>::max)()) return "0:00.000";
+    if (_sessionBestLapMs == (std::numeric_limits<int>::max)()) return formatMs(0);
     return formatMs(_sessionBestLapMs);
 }
 
-std::string TimeTracker::getAlltimePB() const {
+FixedString<15> TimeTracker::getAlltimePB() const {
     std::lock_guard lk(_mtx);
     auto it = _alltimeBestLapMs.find(_activeKey);
-    if (it == _alltimeBestLapMs.end()) return "0:00.000";
+    if (it == _alltimeBestLapMs.end()) return formatMs(0);
     return formatMs(it->second);
 }
 
-std::string TimeTracker::getComboLapCount() const {
+FixedString<15> TimeTracker::getComboLapCount() const {
     std::lock_guard lk(_mtx);
     auto it = _alltimeLapCount.find(_activeKey);
     int laps = (it == _alltimeLapCount.end()) ? 0 : it->second;
-    return std::to_string(laps);
+    FixedString<15> text;
+    text.appendNumber(laps);
+    return text;
 }
 
-std::string TimeTracker::getTotalLapCount() const {
+FixedString<15> TimeTracker::getTotalLapCount() const {
     std::lock_guard lk(_mtx);
     int sum = 0;
     for (const auto& kv : _alltimeLapCount) sum += kv.second;
-    return std::to_string(sum);
+    FixedString<15> text;
+    text.appendNumber(sum);
+    return text;
+}
+
+TimeTracker::Totals TimeTracker::getTotals() const {
+    std::lock_guard lk(_mtx);
+    Totals t;
+
+    Rep running = _isRunning ? std::chrono::duration_cast<Seconds>(Clock::now() - _runStart).count() : 0;
+    if (auto it = _comboTotals.find(_activeKey); it != _comboTotals.end())
+        t.comboSeconds = it->second.count();
+    t.comboSeconds += running;
+    t.totalSeconds = _total.count() + running;
+
+    if (_sessionBestLapMs != (std::numeric_limits<int>::max)())
+        t.sessionBestMs = _sessionBestLapMs;
+    if (auto it = _alltimeBestLapMs.find(_activeKey); it != _alltimeBestLapMs.end())
+        t.alltimeBestMs = it->second;
+
+    t.sessionLaps = _sessionLapCount;
+    if (auto it = _alltimeLapCount.find(_activeKey); it != _alltimeLapCount.end())
+        t.comboLaps = it->second;
+    for (const auto& kv : _alltimeLapCount) t.totalLaps += kv.second;
+    return t;
 }
 
 void TimeTracker::save() const {
+    TRACE_SCOPE("io", "TimeTracker::save");
     std::lock_guard lk(_mtx);
 
     // Build content
@@ -383,6 +401,8 @@ void TimeTracker::save() const {
         ofs.write(buf.data(), buf.size());
     }
     std::filesystem::rename(tmp, _datPath);
+    Metrics::getInstance().add(Counter::StatsWrites);
+    Metrics::getInstance().add(Counter::StatsBytesWritten, txt.size() + buf.size());
 
-    Logger::getInstance().log("Stats updated");
+    LOG_INFO(IO, "Stats updated");
 }
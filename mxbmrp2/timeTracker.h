@@ -4,6 +4,7 @@
 #pragma once
 
 #include <chrono>
+#include <cstdint>
 #include <filesystem>
 #include <mutex>
 #include <string>
@@ -13,21 +14,37 @@
 #include <array>
 #include <vector>
 
+#include "FixedString.h"
+
 class TimeTracker {
 public:
+    // The getters' values as numbers, for the metrics endpoint
+    struct Totals {
+        int64_t comboSeconds = 0;
+        int64_t totalSeconds = 0;
+        int sessionBestMs = 0;      // 0 until a lap is recorded
+        int alltimeBestMs = 0;
+        int sessionLaps = 0;
+        int comboLaps = 0;
+        int totalLaps = 0;
+    };
+
     static TimeTracker& getInstance();
 
     void initialize(const std::filesystem::path& csvPath);
     void startRun(const std::string & trackID, const std::string & bikeID, const std::string & bikeCategory, const std::string & setupName);
-    void recordLap(const std::string& trackID, const std::string& bikeID, int lapTimeMs, const std::vector<int>& cumulativeSplitsMs);
+    // True if the lap is the session's best so far
+    bool recordLap(const std::string& trackID, const std::string& bikeID, int lapTimeMs, const std::vector<int>& cumulativeSplitsMs);
     void endRun(const std::string& trackID, const std::string& bikeID);
 
-    std::string getComboTime() const;
-    std::string getTotalTime() const;
-    std::string getSessionPB() const;
-    std::string getAlltimePB() const;
-    std::string getComboLapCount() const;
-    std::string getTotalLapCount() const;
+    // HUD text, formatted without allocating
+    FixedString<15> getComboTime() const;
+    FixedString<15> getTotalTime() const;
+    FixedString<15> getSessionPB() const;
+    FixedString<15> getAlltimePB() const;
+    FixedString<15> getComboLapCount() const;
+    FixedString<15> getTotalLapCount() const;
+    Totals getTotals() const;
     void resetSessionPB();
 
     void save() const;
@@ -0,0 +1,15 @@
+
+// DiscordStub.cpp
+//
+// The Discord SDK ships no library for this platform. On Windows the plugin
+// loads discord_game_sdk.dll at runtime; here LoadLibraryW always fails, so
+// DiscordManager gives up before the SDK is called. This only satisfies the
+// linker for the SDK's C++ wrapper.
+
+#include "ffi.h"
+
+extern "C" enum EDiscordResult DISCORD_API DiscordCreate(DiscordVersion,
+                                                         struct DiscordCreateParams*,
+                                                         struct IDiscordCore**) {
+    return DiscordResult_InternalError;
+}
@@ -0,0 +1,258 @@
+
+// windows.h
+//
+// Stand-in for the Win32 surface the plugin sources use, so the simulator,
+// the bench and the tests build with GCC or Clang (see CMakeLists.txt). The
+// plugin itself only builds for Windows. There is no game process here:
+// GetModuleHandle returns null, so the memory reader stays disabled as on a
+// build it has no offsets for, and memory queries find nothing.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <map>
+#include <mutex>
+
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+typedef int BOOL;
+typedef unsigned char BYTE;
+typedef unsigned short WORD;
+typedef unsigned long DWORD;
+typedef long LONG;
+typedef long long LONGLONG;
+typedef unsigned int UINT;
+typedef uintptr_t ULONG_PTR;
+typedef size_t SIZE_T;
+typedef void* HANDLE;
+typedef void* HMODULE;
+typedef void* LPVOID;
+typedef const void* LPCVOID;
+
+typedef union {
+    struct {
+        DWORD LowPart;
+        LONG HighPart;
+    };
+    LONGLONG QuadPart;
+} LARGE_INTEGER;
+
+#define TRUE 1
+#define FALSE 0
+#define APIENTRY
+#define __declspec(attribute)   // the exports link statically into each host
+#define WINAPI
+#define MAX_PATH 260
+#define _TRUNCATE (static_cast<size_t>(-1))
+
+// Structured exception handling. Only MemReader::safeMemcpy uses it, which
+// here only ever reads the process's own buffers.
+#define __try try
+#define __except(filter) catch (...)
+#define EXCEPTION_EXECUTE_HANDLER 1
+
+// Threads
+
+#define THREAD_PRIORITY_LOWEST (-2)
+#define THREAD_PRIORITY_BELOW_NORMAL (-1)
+
+inline HANDLE GetCurrentThread() { return nullptr; }
+inline BOOL SetThreadPriority(HANDLE, int) { return TRUE; }
+inline DWORD GetCurrentThreadId() { return static_cast<DWORD>(syscall(SYS_gettid)); }
+inline void Sleep(DWORD ms) { usleep(static_cast<useconds_t>(ms) * 1000); }
+inline void YieldProcessor() { sched_yield(); }
+
+// Modules
+
+inline HMODULE GetModuleHandle(const char*) { return nullptr; }
+inline HMODULE GetModuleHandleA(const char*) { return nullptr; }
+inline HMODULE LoadLibraryW(const wchar_t*) { return nullptr; }
+
+inline DWORD GetModuleFileNameA(HMODULE, char* buffer, DWORD size) {
+    ssize_t n = readlink("/proc/self/exe", buffer, size ? size - 1 : 0);
+    if (n < 0) n = 0;
+    if (size) buffer[n] = '\0';
+    return static_cast<DWORD>(n);
+}
+
+// Virtual memory. RegionMap reads /proc/self/maps instead of VirtualQuery.
+
+#define MEM_COMMIT 0x1000
+#define MEM_PRIVATE 0x20000
+#define MEM_IMAGE 0x1000000
+#define PAGE_NOACCESS 0x01
+#define PAGE_READONLY 0x02
+#define PAGE_READWRITE 0x04
+#define PAGE_GUARD 0x100
+
+typedef struct {
+    void* BaseAddress;
+    void* AllocationBase;
+    DWORD AllocationProtect;
+    SIZE_T RegionSize;
+    DWORD State;
+    DWORD Protect;
+    DWORD Type;
+} MEMORY_BASIC_INFORMATION;
+
+typedef struct {
+    void* lpMinimumApplicationAddress;
+    void* lpMaximumApplicationAddress;
+    DWORD dwPageSize;
+} SYSTEM_INFO;
+
+inline SIZE_T VirtualQuery(LPCVOID, MEMORY_BASIC_INFORMATION*, SIZE_T) { return 0; }
+inline void GetSystemInfo(SYSTEM_INFO* si) { std::memset(si, 0, sizeof(*si)); }
+
+// PE headers, the leading fields up to the ones MemReader reads (PE32+ layout)
+
+#define IMAGE_DOS_SIGNATURE 0x5A4D
+#define IMAGE_NT_SIGNATURE 0x00004550
+#define IMAGE_SCN_CNT_CODE 0x00000020
+#define IMAGE_SCN_MEM_EXECUTE 0x20000000
+
+typedef struct {
+    WORD e_magic;
+    WORD e_reserved[29];
+    LONG e_lfanew;
+} IMAGE_DOS_HEADER;
+
+typedef struct {
+    WORD Machine;
+    WORD NumberOfSections;
+    DWORD TimeDateStamp;
+    DWORD PointerToSymbolTable;
+    DWORD NumberOfSymbols;
+    WORD SizeOfOptionalHeader;
+    WORD Characteristics;
+} IMAGE_FILE_HEADER;
+
+typedef struct {
+    WORD Magic;
+    BYTE Reserved[54];
+    DWORD SizeOfImage;
+    DWORD SizeOfHeaders;
+    DWORD CheckSum;
+} IMAGE_OPTIONAL_HEADER;
+
+typedef struct {
+    DWORD Signature;
+    IMAGE_FILE_HEADER FileHeader;
+    IMAGE_OPTIONAL_HEADER OptionalHeader;
+} IMAGE_NT_HEADERS;
+
+typedef struct {
+    BYTE Name[8];
+    union {
+        DWORD VirtualSize;
+    } Misc;
+    DWORD VirtualAddress;
+    DWORD SizeOfRawData;
+    DWORD PointerToRawData;
+    DWORD PointerToRelocations;
+    DWORD PointerToLinenumbers;
+    WORD NumberOfRelocations;
+    WORD NumberOfLinenumbers;
+    DWORD Characteristics;
+} IMAGE_SECTION_HEADER;
+
+// Read-only file mappings (TelemetryFile::Reader). A handle is the file
+// descriptor plus one, so that null stays invalid.
+
+#define INVALID_HANDLE_VALUE (reinterpret_cast<HANDLE>(static_cast<intptr_t>(-1)))
+#define GENERIC_READ 0x80000000
+#define FILE_SHARE_READ 0x00000001
+#define OPEN_EXISTING 3
+#define FILE_ATTRIBUTE_NORMAL 0x80
+#define FILE_MAP_READ 0x0004
+
+namespace posix {
+    inline int fd(HANDLE h) { return static_cast<int>(reinterpret_cast<intptr_t>(h)) - 1; }
+    inline HANDLE handle(int fd) { return reinterpret_cast<HANDLE>(static_cast<intptr_t>(fd) + 1); }
+}
+
+inline HANDLE CreateFileW(const char* path, DWORD, DWORD, void*, DWORD, DWORD, HANDLE) {
+    int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    return fd < 0 ? INVALID_HANDLE_VALUE : posix::handle(fd);
+}
+
+inline BOOL GetFileSizeEx(HANDLE file, LARGE_INTEGER* size) {
+    struct stat st;
+    if (fstat(posix::fd(file), &st) != 0) return FALSE;
+    size->QuadPart = st.st_size;
+    return TRUE;
+}
+
+// The mapping handle is a duplicate of the file's
+inline HANDLE CreateFileMappingW(HANDLE file, void*, DWORD, DWORD, DWORD, const wchar_t*) {
+    int fd = dup(posix::fd(file));
+    return fd < 0 ? nullptr : posix::handle(fd);
+}
+
+namespace posix {
+    // Windows unmaps a view by its address alone
+    inline std::map<LPCVOID, size_t>& viewSizes(std::unique_lock<std::mutex>& lk) {
+        static std::mutex mutex;
+        static std::map<LPCVOID, size_t> sizes;
+        lk = std::unique_lock<std::mutex>(mutex);
+        return sizes;
+    }
+}
+
+// Views are always of the whole file
+inline LPVOID MapViewOfFile(HANDLE mapping, DWORD, DWORD, DWORD, SIZE_T) {
+    struct stat st;
+    int fd = posix::fd(mapping);
+    if (fstat(fd, &st) != 0 || st.st_size == 0) return nullptr;
+    void* view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    if (view == MAP_FAILED) return nullptr;
+
+    std::unique_lock<std::mutex> lk;
+    posix::viewSizes(lk)[view] = static_cast<size_t>(st.st_size);
+    return view;
+}
+
+inline BOOL UnmapViewOfFile(LPCVOID view) {
+    std::unique_lock<std::mutex> lk;
+    auto& sizes = posix::viewSizes(lk);
+    auto it = sizes.find(view);
+    if (it == sizes.end()) return FALSE;
+    munmap(const_cast<void*>(view), it->second);
+    sizes.erase(it);
+    return TRUE;
+}
+
+inline BOOL CloseHandle(HANDLE h) { return ::close(posix::fd(h)) == 0; }
+
+// CRT
+
+inline void* _aligned_malloc(size_t size, size_t alignment) {
+    void* p = nullptr;
+    if (alignment < sizeof(void*)) alignment = sizeof(void*);
+    return posix_memalign(&p, alignment, size) == 0 ? p : nullptr;
+}
+
+inline void _aligned_free(void* p) { std::free(p); }
+
+inline int localtime_s(std::tm* out, const std::time_t* time) {
+    return localtime_r(time, out) ? 0 : 1;
+}
+
+inline int strncpy_s(char* dest, size_t destSize, const char* src, size_t count) {
+    if (!dest || destSize == 0) return 1;
+    size_t n = std::strlen(src);
+    if (count != _TRUNCATE && count < n) n = count;
+    if (n >= destSize) n = destSize - 1;
+    std::memcpy(dest, src, n);
+    dest[n] = '\0';
+    return 0;
+}
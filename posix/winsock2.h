@@ -0,0 +1,49 @@
+
+// winsock2.h
+//
+// Stand-in for the Winsock surface MetricsServer uses, on BSD sockets.
+
+#pragma once
+
+#include "windows.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+typedef int SOCKET;
+
+#define INVALID_SOCKET (-1)
+#define SOCKET_ERROR (-1)
+#define SD_SEND SHUT_WR
+#define MAKEWORD(low, high) (static_cast<WORD>(((low) & 0xff) | (((high) & 0xff) << 8)))
+
+struct WSADATA {
+    WORD wVersion;
+};
+
+inline int WSAStartup(WORD version, WSADATA* data) {
+    data->wVersion = version;
+    return 0;
+}
+
+inline int WSACleanup() { return 0; }
+inline int closesocket(SOCKET s) { return ::close(s); }
+
+namespace posix {
+    // SO_RCVTIMEO is a DWORD of milliseconds on Windows, a timeval here
+    inline int setsockopt(SOCKET s, int level, int name, const char* value, socklen_t size) {
+        if (level == SOL_SOCKET && name == SO_RCVTIMEO && size == sizeof(DWORD)) {
+            DWORD ms;
+            std::memcpy(&ms, value, sizeof(ms));
+            timeval tv{ static_cast<time_t>(ms / 1000), static_cast<suseconds_t>((ms % 1000) * 1000) };
+            return ::setsockopt(s, level, name, &tv, sizeof(tv));
+        }
+        return ::setsockopt(s, level, name, value, size);
+    }
+}
+
+#define setsockopt posix::setsockopt